@@ -9,6 +9,7 @@
 #include "RandomNumberFactory.h"
 #include "RandomNumberGenerator.h"
 #include "AbstractFileMonitor.h"
+#include "BufferPool.h"
 #include "DagNode.h"
 #include "MonteCarloAnalysis.h"
 #include "MonteCarloSampler.h"
@@ -25,6 +26,7 @@
 #include "RbVector.h"
 #include "RbVectorImpl.h"
 #include "StoppingRule.h"
+#include "ThreadPool.h"
 #include "Trace.h"
 
 
@@ -39,7 +41,8 @@ using namespace RevBayesCore;
 MonteCarloAnalysis::MonteCarloAnalysis(MonteCarloSampler *m, size_t r, MonteCarloAnalysisOptions::TraceCombinationTypes tc) : Cloneable(), Parallelizable(),
     replicates( r ),
     runs(r,NULL),
-    trace_combination( tc )
+    trace_combination( tc ),
+    parallel_replicates( false )
 {
     
     runs[0] = m;
@@ -58,7 +61,8 @@ MonteCarloAnalysis::MonteCarloAnalysis(MonteCarloSampler *m, size_t r, MonteCarl
 MonteCarloAnalysis::MonteCarloAnalysis(const MonteCarloAnalysis &a) : Cloneable(), Parallelizable(a),
     replicates( a.replicates ),
     runs(a.replicates,NULL),
-    trace_combination( a.trace_combination )
+    trace_combination( a.trace_combination ),
+    parallel_replicates( a.parallel_replicates )
 {
     
     // create replicate Monte Carlo samplers
@@ -114,6 +118,7 @@ MonteCarloAnalysis& MonteCarloAnalysis::operator=(const MonteCarloAnalysis &a)
         
         replicates          = a.replicates;
         trace_combination   = a.trace_combination;
+        parallel_replicates = a.parallel_replicates;
         
         // create replicate Monte Carlo samplers
         for (size_t i=0; i < replicates; ++i)
@@ -278,6 +283,25 @@ void MonteCarloAnalysis::disableScreenMonitors(bool all)
 }
 
 
+/**
+ * Write all buffered output of the monitors of all replicates to their files.
+ */
+void MonteCarloAnalysis::flushMonitors( void )
+{
+    
+    for (size_t i=0; i<replicates; ++i)
+    {
+        
+        if ( runs[i] != NULL )
+        {
+            runs[i]->flushMonitors();
+        }
+        
+    }
+    
+}
+
+
 size_t MonteCarloAnalysis::getCurrentGeneration( void ) const
 {
     
@@ -312,6 +336,37 @@ const Model& MonteCarloAnalysis::getModel( void ) const
 }
 
 
+/**
+ * Get the next generation after gen at which concurrently running replicates need to wait for each other.
+ * These are the generations at which we write a checkpoint, check a convergence rule, or a threshold rule tells us to stop.
+ * Time based rules can only be checked between two synchronizations, so we synchronize at least every 100 generations.
+ */
+size_t MonteCarloAnalysis::getNextSynchronizationGeneration( size_t gen, RbVector<StoppingRule> &rules, size_t checkpoint_interval ) const
+{
+    
+    const size_t max_generations_between_synchronizations = 100;
+    
+    size_t last_gen = gen + max_generations_between_synchronizations;
+    for (size_t g = gen+1; g < last_gen; ++g)
+    {
+        if ( checkpoint_interval != 0 && (g % checkpoint_interval) == 0 )
+        {
+            return g;
+        }
+        
+        for (size_t i=0; i<rules.size(); ++i)
+        {
+            if ( rules[i].checkAtIteration(g) == true && (rules[i].isConvergenceRule() == true || rules[i].stop(g) == true) )
+            {
+                return g;
+            }
+        }
+    }
+    
+    return last_gen;
+}
+
+
 void MonteCarloAnalysis::initializeFromCheckpoint(const path &checkpoint_file)
 {
     
@@ -666,6 +721,16 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
         RBOUT( ss.str() );
     }
     
+    // reset the stopping rules
+    // this needs to happen before the monitors are started, so that the monitors see which files the rules observe
+    for (size_t i=0; i<rules.size(); ++i)
+    {
+        
+        rules[i].setNumberOfRuns( replicates );
+        rules[i].runStarted();
+        
+    }
+    
     // Start monitor(s)
     for (size_t i=0; i<replicates; ++i)
     {
@@ -723,13 +788,13 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
         
     }
     
-    // reset the stopping rules
-    for (size_t i=0; i<rules.size(); ++i)
+    // if the replicates run concurrently, then each replicate draws from its own random number stream
+    // we split the streams even if there is only one thread so that the results do not depend on the number of threads
+    bool concurrent_replicates = parallel_replicates == true && replicates > 1;
+    std::vector<RandomNumberGenerator*> replicate_rngs;
+    if ( concurrent_replicates == true )
     {
-        
-        rules[i].setNumberOfRuns( replicates );
-        rules[i].runStarted();
-        
+        replicate_rngs = GLOBAL_RNG->split( replicates );
     }
     
     // Run the chain
@@ -737,32 +802,58 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
     bool converged = false;
     do {
         
-        ++gen;
-        for (size_t i=0; i<replicates; ++i)
-        {            
-            if ( runs[i] != NULL )
+        if ( concurrent_replicates == true )
+        {
+            // every replicate runs on its own thread until the next generation at which we need to check the stopping rules
+            size_t first_gen = gen + 1;
+            size_t last_gen  = getNextSynchronizationGeneration( gen, rules, checkpoint_interval );
+            
+            try
             {
-                
-                // @todo: #thread
-                // This part should be done on several threads if possible
-                // Sebastian: this call is very slow; a lot of work happens in nextCycle()
-                runs[i]->nextCycle(true);
-                
-                // Monitor
-                runs[i]->monitor(gen);
-                
-                // check for autotuning
-                if ( tuning_interval != 0 && (gen % tuning_interval) == 0 )
-                {                   
-                    runs[i]->tune();                   
+                ThreadPool::threadPoolInstance().parallelFor( replicates, [&](size_t i) {
+                    
+                    if ( runs[i] != NULL )
+                    {
+                        RandomNumberStreamScope rng_scope( replicate_rngs[i] );
+                        for (size_t g = first_gen; g <= last_gen; ++g)
+                        {
+                            nextReplicateCycle( i, g, tuning_interval, checkpoint_interval );
+                        }
+                    }
+                    
+                });
+            }
+            catch (...)
+            {
+                for (size_t i=0; i<replicate_rngs.size(); ++i)
+                {
+                    delete replicate_rngs[i];
                 }
-                
-                // check for autotuning
-                if ( checkpoint_interval != 0 && (gen % checkpoint_interval) == 0 )
-                {                    
-                    runs[i]->checkpoint();                    
-                }             
-            }           
+                throw;
+            }
+            
+            gen = last_gen;
+        }
+        else
+        {
+            ++gen;
+            for (size_t i=0; i<replicates; ++i)
+            {
+                if ( runs[i] != NULL )
+                {
+                    nextReplicateCycle( i, gen, tuning_interval, checkpoint_interval );
+                }
+            }
+        }
+        
+        // the convergence rules read the monitor files, so these need to be complete
+        for (size_t i=0; i<rules.size(); ++i)
+        {
+            if ( rules[i].isConvergenceRule() == true && rules[i].checkAtIteration(gen) == true )
+            {
+                flushMonitors();
+                break;
+            }
         }
         
         converged = true;
@@ -788,6 +879,11 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
         
     } while ( finished == false && converged == false);
     
+    for (size_t i=0; i<replicate_rngs.size(); ++i)
+    {
+        delete replicate_rngs[i];
+    }
+    
 #ifdef RB_MPI
     // wait until all replicates complete
     MPI_Barrier( analysis_comm );
@@ -815,6 +911,36 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
     MpiUtilities::synchronizeRNG(  );
 #endif
     
+    // free the likelihood buffers that the samplers released during the run
+    BufferPool::bufferPoolInstance().clear();
+    
+}
+
+
+/**
+ * Advance the i-th replicate by one cycle and then call its monitors, tuning and checkpointing for generation gen.
+ */
+void MonteCarloAnalysis::nextReplicateCycle( size_t i, size_t gen, size_t tuning_interval, size_t checkpoint_interval )
+{
+    
+    runs[i]->nextCycle(true);
+    
+    // Monitor
+    runs[i]->monitor(gen);
+    
+    // check for autotuning
+    if ( tuning_interval != 0 && (gen % tuning_interval) == 0 )
+    {
+        runs[i]->tune();
+    }
+    
+    // check for checkpointing
+    if ( checkpoint_interval != 0 && (gen % checkpoint_interval) == 0 )
+    {
+        runs[i]->flushMonitors();
+        runs[i]->checkpoint();
+    }
+    
 }
 
 
@@ -864,6 +990,16 @@ void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingR
     }
     
     
+    // reset the stopping rules
+    // this needs to happen before the monitors are started, so that the monitors see which files the rules observe
+    for (size_t i=0; i<rules.size(); ++i)
+    {
+        
+        rules[i].setNumberOfRuns( replicates );
+        rules[i].runStarted();
+        
+    }
+    
     // Start monitor(s)
     for (size_t i=0; i<replicates; ++i)
     {
@@ -916,13 +1052,6 @@ void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingR
         }
     }
     
-    // reset the stopping rules
-    for (size_t i=0; i<rules.size(); ++i)
-    {
-        rules[i].setNumberOfRuns( replicates );
-        rules[i].runStarted();
-    }
-    
     
     // Run the chain
     bool finished = false;
@@ -949,6 +1078,16 @@ void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingR
 
         }
         
+        // the convergence rules read the monitor files, so these need to be complete
+        for (size_t i=0; i<rules.size(); ++i)
+        {
+            if ( rules[i].isConvergenceRule() == true && rules[i].checkAtIteration(gen) == true )
+            {
+                flushMonitors();
+                break;
+            }
+        }
+        
         converged = true;
         size_t numConvergenceRules = 0;
         // do the stopping test
@@ -1005,6 +1144,16 @@ void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingR
 }
 
 
+/**
+ * Set whether the replicates run concurrently, each with its own random number stream.
+ */
+void MonteCarloAnalysis::setParallelReplicates(bool tf)
+{
+    
+    parallel_replicates = tf;
+}
+
+
 /**
  * Set the active PID of this specific Monte Carlo analysis.
  */
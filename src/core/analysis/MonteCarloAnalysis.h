@@ -27,6 +27,10 @@ namespace RevBayesCore {
      * The Monte Carlo Analysis object is mostly used to run independent MonteCarloSamplers
      * and check for convergence between them.
      *
+     * The replicates of a process may run concurrently on the threads of the ThreadPool.
+     * Then each replicate draws from its own random number stream and the replicates only wait for
+     * each other when we write checkpoints or check the stopping rules.
+     *
      *
      * @copyright Copyright 2009-
      * @author The RevBayes Development Core Team (Sebastian Hoehna)
@@ -70,6 +74,7 @@ namespace RevBayesCore {
 #else
         void                                                setModel(Model *m, bool redraw);
 #endif
+        void                                                setParallelReplicates(bool tf);                                 //!< Set if the replicates of this process run concurrently on several threads
         
     protected:
         void                                                setActivePIDSpecialized(size_t i, size_t n);                    //!< Set the number of processes for this class.
@@ -78,10 +83,14 @@ namespace RevBayesCore {
 #else
         void                                                resetReplicates(void);
 #endif
+        void                                                flushMonitors(void);                                            //!< Write all buffered output of the monitors of all replicates
+        size_t                                              getNextSynchronizationGeneration(size_t g, RbVector<StoppingRule> &r, size_t ci) const;     //!< The next generation at which concurrent replicates wait for each other
+        void                                                nextReplicateCycle(size_t i, size_t g, size_t ti, size_t ci);   //!< Advance the i-th replicate by one cycle (including monitoring, tuning and checkpointing)
 
         size_t                                              replicates;
         std::vector<MonteCarloSampler*>                     runs;
         MonteCarloAnalysisOptions::TraceCombinationTypes    trace_combination;
+        bool                                                parallel_replicates;                                            //!< Run the replicates concurrently, each with its own random number stream
     };
     
     // Global functions using the class
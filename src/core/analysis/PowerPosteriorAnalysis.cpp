@@ -1,20 +1,25 @@
 #include <cstddef>
 #include <cmath>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "BufferPool.h"
 #include "MonteCarloSampler.h"
 #include "MoveSchedule.h"
 #include "MpiUtilities.h"
 #include "PowerPosteriorAnalysis.h"
 #include "ProgressBar.h"
+#include "RandomNumberFactory.h"
+#include "RandomNumberGenerator.h"
 #include "RbException.h"
 #include "RbFileManager.h"
 #include "Cloneable.h"
 #include "MonteCarloAnalysisOptions.h"
 #include "Parallelizable.h"
 #include "StringUtilities.h"
+#include "ThreadPool.h"
 
 
 #ifdef RB_MPI
@@ -28,7 +33,8 @@ PowerPosteriorAnalysis::PowerPosteriorAnalysis(MonteCarloSampler *m, const path
     powers(),
     sampler( m ),
     sampleFreq( 100 ),
-    processors_per_likelihood( k )
+    processors_per_likelihood( k ),
+    parallel_stones( false )
 {
     
     initMPI();
@@ -40,7 +46,8 @@ PowerPosteriorAnalysis::PowerPosteriorAnalysis(const PowerPosteriorAnalysis &a)
     powers( a.powers ),
     sampler( a.sampler->clone() ),
     sampleFreq( a.sampleFreq ),
-    processors_per_likelihood( a.processors_per_likelihood )
+    processors_per_likelihood( a.processors_per_likelihood ),
+    parallel_stones( a.parallel_stones )
 {
     
 }
@@ -71,6 +78,7 @@ PowerPosteriorAnalysis& PowerPosteriorAnalysis::operator=(const PowerPosteriorAn
         sampler                         = a.sampler->clone();
         sampleFreq                      = a.sampleFreq;
         processors_per_likelihood       = a.processors_per_likelihood;
+        parallel_stones                 = a.parallel_stones;
         
     }
     
@@ -189,13 +197,20 @@ void PowerPosteriorAnalysis::runAll(size_t gen, double burnin_fraction, size_t p
     size_t stone_block_start =  floor( ( floor( pid   /double(processors_per_likelihood)) / (double(num_processes) / processors_per_likelihood) ) * powers.size() );
     size_t stone_block_end   =  floor( ( ceil( (pid+1)/double(processors_per_likelihood)) / (double(num_processes) / processors_per_likelihood) ) * powers.size() );
     
-    // Run the chain
-    for (size_t i = stone_block_start; i < stone_block_end; ++i)
+    if ( parallel_stones == true && stone_block_end - stone_block_start > 1 )
     {
-    
-        // run the i-th stone
-        runStone(i, gen, burnin_fraction, pre_burnin_generations, tuning_interval);
+        runStonesConcurrently(stone_block_start, stone_block_end, gen, burnin_fraction, pre_burnin_generations, tuning_interval);
+    }
+    else
+    {
+        // Run the chain
+        for (size_t i = stone_block_start; i < stone_block_end; ++i)
+        {
         
+            // run the i-th stone
+            runStone(i, gen, burnin_fraction, pre_burnin_generations, tuning_interval);
+            
+        }
     }
     
 #ifdef RB_MPI
@@ -213,11 +228,26 @@ void PowerPosteriorAnalysis::runAll(size_t gen, double burnin_fraction, size_t p
         summarizeStones();
     }
     
+    // free the likelihood buffers that the stones released
+    BufferPool::bufferPoolInstance().clear();
+    
 }
 
 
 
 void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_fraction, size_t pre_burnin_generations, size_t tuning_interval)
+{
+    
+    runStone(*sampler, idx, gen, burnin_fraction, pre_burnin_generations, tuning_interval, true);
+}
+
+
+/**
+ * Run a single stone with the given sampler.
+ * The sampler continues from its current state. If print_progress is false, then we do not print the
+ * progress of this stone to the screen (e.g., because several stones run at the same time).
+ */
+void PowerPosteriorAnalysis::runStone(MonteCarloSampler &s, size_t idx, size_t gen, double burnin_fraction, size_t pre_burnin_generations, size_t tuning_interval, bool print_progress)
 {
     // create the directory if necessary
     if (filename.filename().empty() or filename.filename_is_dot() or filename.filename_is_dot_dot())
@@ -234,7 +264,7 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
     outStream << "state\t" << "power\t" << "likelihood" << std::endl;
 
     // reset the sampler
-    sampler->reset();
+    s.reset();
 
     size_t burnin = size_t( ceil( burnin_fraction*gen ) );
     
@@ -242,7 +272,7 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
     size_t digits = size_t( ceil( log10( powers.size() ) ) );
     
     // print output for users
-    if ( process_active ==true )
+    if ( process_active == true && print_progress == true )
     {
         std::cout << "Step ";
         for (size_t d = size_t( ceil( log10( idx+1.1 ) ) ); d < digits; d++ )
@@ -255,34 +285,34 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
     }
     
     // set the power of this sampler
-    sampler->setLikelihoodHeat( powers[idx] );
+    s.setLikelihoodHeat( powers[idx] );
     
-    sampler->addFileMonitorExtension( stone_tag, false);
+    s.addFileMonitorExtension( stone_tag, false);
     
     // let's do a pre-burnin
     for (size_t k=1; k<=pre_burnin_generations; k++)
     {
         
-        sampler->nextCycle(false);
+        s.nextCycle(false);
         
         // check for autotuning
         if ( k % tuning_interval == 0 && k != pre_burnin_generations )
         {
-            sampler->tune();
+            s.tune();
         }
         
     }
     
     // Monitor
-    sampler->startMonitors(gen, false);
-    sampler->writeMonitorHeaders( false );
-    sampler->monitor(0);
+    s.startMonitors(gen, false);
+    s.writeMonitorHeaders( false );
+    s.monitor(0);
     
     double p = powers[idx];
     for (size_t k=1; k<=gen; ++k)
     {
         
-        if ( process_active == true )
+        if ( process_active == true && print_progress == true )
         {
             if ( k % printInterval == 0 )
             {
@@ -291,22 +321,22 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
             }
         }
         
-        sampler->nextCycle( true );
+        s.nextCycle( true );
 
         // Monitor
-        sampler->monitor(k);
+        s.monitor(k);
         
         // sample the likelihood
         if ( k > burnin && k % sampleFreq == 0 )
         {
             // compute the joint likelihood
-            double likelihood = sampler->getModelLnProbability(true);
+            double likelihood = s.getModelLnProbability(true);
             outStream << k << "\t" << p << "\t" << likelihood << std::endl;
         }
             
     }
     
-    if ( process_active == true )
+    if ( process_active == true && print_progress == true )
     {
         std::cout << std::endl;
     }
@@ -314,7 +344,86 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
     outStream.close();
     
     // Monitor
-    sampler->finishMonitors( 1, MonteCarloAnalysisOptions::NONE );
+    s.finishMonitors( 1, MonteCarloAnalysisOptions::NONE );
+    
+}
+
+
+/**
+ * Run the stones [first,last) concurrently on the threads of the thread pool.
+ * Every stone runs on its own copy of the sampler, which starts from the current state of our sampler (i.e., after the burn-in),
+ * so the pre-burnin of each stone equilibrates the chain at the power of the stone.
+ * Each stone draws from its own random number stream. We split all streams from the global generator before we start,
+ * so the results do not depend on the order in which the threads execute the stones.
+ */
+void PowerPosteriorAnalysis::runStonesConcurrently(size_t first, size_t last, size_t gen, double burnin_fraction, size_t pre_burnin_generations, size_t tuning_interval)
+{
+    
+    size_t num_stones = last - first;
+    
+    std::vector<RandomNumberGenerator*> stone_rngs = GLOBAL_RNG->split( num_stones );
+    
+    if ( process_active == true )
+    {
+        std::cout << "Running " << num_stones << " stones on " << ThreadPool::threadPoolInstance().getNumberOfThreads() << " threads." << std::endl;
+    }
+    
+    std::mutex sampler_mutex;
+    std::mutex print_mutex;
+    size_t num_finished_stones = 0;
+    
+    try
+    {
+        ThreadPool::threadPoolInstance().parallelFor(num_stones, [&](size_t i) {
+            
+            size_t idx = first + i;
+            
+            // copying the sampler reads the model, so we do not copy several samplers at the same time
+            MonteCarloSampler* stone_sampler = NULL;
+            {
+                std::lock_guard<std::mutex> lock( sampler_mutex );
+                stone_sampler = sampler->clone();
+            }
+            
+            // the stones run at the same time, so they must not print to the screen
+            // (our sampler has no enabled screen monitors at this point, but we do not rely on its copies)
+            stone_sampler->disableScreenMonitor( true, 0 );
+            
+            try
+            {
+                RandomNumberStreamScope rng_scope( stone_rngs[i] );
+                runStone(*stone_sampler, idx, gen, burnin_fraction, pre_burnin_generations, tuning_interval, false);
+            }
+            catch (...)
+            {
+                delete stone_sampler;
+                throw;
+            }
+            
+            delete stone_sampler;
+            
+            if ( process_active == true )
+            {
+                std::lock_guard<std::mutex> lock( print_mutex );
+                ++num_finished_stones;
+                std::cout << "Finished step " << (idx+1) << " (" << num_finished_stones << " / " << num_stones << " done)" << std::endl;
+            }
+            
+        });
+    }
+    catch (...)
+    {
+        for (size_t i = 0; i < num_stones; ++i)
+        {
+            delete stone_rngs[i];
+        }
+        throw;
+    }
+    
+    for (size_t i = 0; i < num_stones; ++i)
+    {
+        delete stone_rngs[i];
+    }
     
 }
 
@@ -366,6 +475,12 @@ void PowerPosteriorAnalysis::summarizeStones( void )
 }
 
 
+void PowerPosteriorAnalysis::setParallelStones(bool tf)
+{
+    parallel_stones = tf;
+}
+
+
 void PowerPosteriorAnalysis::setPowers(const std::vector<double> &p)
 {
     powers = p;
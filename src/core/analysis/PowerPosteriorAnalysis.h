@@ -17,6 +17,10 @@ namespace RevBayesCore {
      * where the likelihood during each analysis run is raised to the given power.
      * The likelihood values and the current powers are stored in a file.
      *
+     * The stones may also run concurrently on the threads of the ThreadPool. Then each stone runs
+     * on its own copy of the sampler (starting from the state after the burn-in) and draws from its own
+     * random number stream, which is split from the global generator before the stones start.
+     *
      *
      * @copyright Copyright 2009-
      * @author The RevBayes Development Core Team (Sebastian Hoehna)
@@ -38,12 +42,15 @@ namespace RevBayesCore {
         void                                    runAll(size_t g, double burn_frac, size_t preburn_gen, size_t tune_int);
         void                                    runStone(size_t idx, size_t g, double burn_frac, size_t preburn_gen, size_t tune_int);
         void                                    summarizeStones(void);
+        void                                    setParallelStones(bool tf);                                                                     //!< Set if the stones of this process run concurrently on several threads
         void                                    setPowers(const std::vector<double> &p);
         void                                    setSampleFreq(size_t sf);
         
     private:
         
         void                                    initMPI(void);
+        void                                    runStone(MonteCarloSampler &s, size_t idx, size_t g, double burn_frac, size_t preburn_gen, size_t tune_int, bool print_progress);
+        void                                    runStonesConcurrently(size_t first, size_t last, size_t g, double burn_frac, size_t preburn_gen, size_t tune_int);
         
         // members
         path                                    filename;
@@ -51,6 +58,7 @@ namespace RevBayesCore {
         MonteCarloSampler*                      sampler;
         size_t                                  sampleFreq;                                                                     //!< The rate of the distribution
         size_t                                  processors_per_likelihood;
+        bool                                    parallel_stones;                                                                //!< Run the stones concurrently, each on its own copy of the sampler
 
     };
     
@@ -351,6 +351,26 @@ void Mcmc::finishMonitors( size_t n_reps, MonteCarloAnalysisOptions::TraceCombin
 }
 
 
+/**
+ * Write all output of the monitors that is still buffered (e.g., by the I/O thread),
+ * so that the files are complete before we write a checkpoint or a stopping rule reads them.
+ */
+void Mcmc::flushMonitors( void )
+{
+    
+    for (size_t i=0; i<monitors.size(); ++i)
+    {
+        
+        if ( chain_active == true && process_active == true )
+        {
+            monitors[i].flushStream();
+        }
+        
+    }
+    
+}
+
+
 /**
  * Get the heat of the likelihood of this chain.
  */
@@ -44,6 +44,7 @@ namespace RevBayesCore {
         Mcmc*                                               clone(void) const;
         void                                                checkpoint(void) const;
         void                                                finishMonitors(size_t n, MonteCarloAnalysisOptions::TraceCombinationTypes ct);          //!< Finish the monitors
+        void                                                flushMonitors(void);                                                                    //!< Write all buffered output of the monitors
         double                                              getChainLikelihoodHeat(void) const;                                                     //!< Get the heat for this chain
         double                                              getChainPosteriorHeat(void) const;                                                      //!< Get the heat for this chain
         double                                              getChainPriorHeat(void) const;
@@ -28,6 +28,7 @@
 #include "RbVector.h"
 #include "RbVectorImpl.h"
 #include "StringUtilities.h"
+#include "ThreadPool.h"
 
 #ifdef RB_MPI
 #include <mpi.h>
@@ -66,7 +67,7 @@ using namespace RevBayesCore;
 
 using std::string;
 
-Mcmcmc::Mcmcmc(const Model& m, const RbVector<Move> &mv, const RbVector<Monitor> &mn, std::string sT, size_t nc, size_t si, double dt, size_t ntries, bool th, double tht, std::string sm, std::string smo) : MonteCarloSampler( ),
+Mcmcmc::Mcmcmc(const Model& m, const RbVector<Move> &mv, const RbVector<Monitor> &mn, std::string sT, size_t nc, size_t si, double dt, size_t ntries, bool th, double tht, std::string sm, std::string smo, bool pc) : MonteCarloSampler( ),
     num_chains(nc),
     schedule_type(sT),
     current_generation(0),
@@ -80,7 +81,8 @@ Mcmcmc::Mcmcmc(const Model& m, const RbVector<Move> &mv, const RbVector<Monitor>
     tune_heat_target(tht),
     useNeighborSwapping(true),
     useRandomSwapping(false),
-    swap_mode(smo)
+    swap_mode(smo),
+    parallel_chains(pc)
 {
     
     // initialize container sizes
@@ -135,6 +137,7 @@ Mcmcmc::Mcmcmc(const Mcmcmc &m) : MonteCarloSampler(m)
     swap_interval       = m.swap_interval;
     swap_interval2      = m.swap_interval2;
     swap_mode           = m.swap_mode;
+    parallel_chains     = m.parallel_chains;
     tune_heat           = m.tune_heat;
     tune_heat_target    = m.tune_heat_target;
     useNeighborSwapping = m.useNeighborSwapping;
@@ -171,6 +174,9 @@ Mcmcmc::Mcmcmc(const Mcmcmc &m) : MonteCarloSampler(m)
     current_generation      = m.current_generation;
     base_chain              = m.base_chain->clone();
     
+    // the random number generators of the chains are created again when the copy runs in parallel
+    chain_rngs.clear();
+    
 }
 
 Mcmcmc::~Mcmcmc(void)
@@ -184,6 +190,11 @@ Mcmcmc::~Mcmcmc(void)
     }
     chains.clear();
     delete base_chain;
+    
+    for (size_t i = 0; i < chain_rngs.size(); ++i)
+    {
+        delete chain_rngs[i];
+    }
 }
 
 
@@ -299,6 +310,21 @@ void Mcmcmc::finishMonitors( size_t n_reps, MonteCarloAnalysisOptions::TraceComb
 
 
 
+void Mcmcmc::flushMonitors( void )
+{
+    
+    for (size_t i = 0; i < num_chains; ++i)
+    {
+        
+        if ( chains[i] != NULL )
+        {
+            chains[i]->flushMonitors();
+        }
+    }
+    
+}
+
+
 /**
  * Get the model instance.
  */
@@ -397,6 +423,28 @@ bool Mcmcmc::isColdChain(int i) const
 }
 
 
+/**
+ * Split one independent random number stream per chain from the global random number generator.
+ * The stream of chain i only depends on the state of the global generator and on i.
+ * We create a stream for every chain, including the chains of other processes,
+ * so that all processes draw the same key from the global generator.
+ * The streams are not stored in checkpoints (neither is the global generator). A run that is resumed
+ * from a checkpoint splits new streams from the global generator, so it does not continue the random numbers
+ * of the interrupted run.
+ */
+void Mcmcmc::initializeChainRandomNumberGenerators(void)
+{
+    
+    for (size_t i = 0; i < chain_rngs.size(); ++i)
+    {
+        delete chain_rngs[i];
+    }
+    
+    chain_rngs = GLOBAL_RNG->split( num_chains );
+    
+}
+
+
 void Mcmcmc::initializeChains(void)
 {
     
@@ -502,21 +550,40 @@ void Mcmcmc::monitor(unsigned long g)
 void Mcmcmc::nextCycle(bool advanceCycle)
 {
     
-    // run each chain for this process
-    for (size_t i = 0; i < num_chains; ++i)
+    if ( parallel_chains == true )
     {
-        
-        if ( chains[i] != NULL )
+        if ( chain_rngs.size() != num_chains )
         {
-            // @todo: #thread
-            // This part should be done on several threads if possible
-            // Sebastian: this call is very slow; a lot of work happens in nextCycle()
-
-            // advance chain j by a single cycle
-            chains[i]->nextCycle( advanceCycle );
+            initializeChainRandomNumberGenerators();
         }
         
-    } // loop over chains for this process
+        // advance the chains of this process concurrently
+        // each chain draws from its own random number generator so that the chains do not race on the global one
+        // the swaps below wait for all chains and thus act as the barrier between two cycles
+        ThreadPool::threadPoolInstance().parallelFor(num_chains, [&](size_t i) {
+            
+            if ( chains[i] != NULL )
+            {
+                RandomNumberStreamScope rng_scope( chain_rngs[i] );
+                chains[i]->nextCycle( advanceCycle );
+            }
+            
+        });
+    }
+    else
+    {
+        // run each chain for this process
+        for (size_t i = 0; i < num_chains; ++i)
+        {
+            
+            if ( chains[i] != NULL )
+            {
+                // advance chain j by a single cycle
+                chains[i]->nextCycle( advanceCycle );
+            }
+            
+        } // loop over chains for this process
+    }
     
     if ( advanceCycle == true )
     {
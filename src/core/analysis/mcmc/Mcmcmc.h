@@ -11,12 +11,18 @@
 
 namespace RevBayesCore {
     
+    class RandomNumberGenerator;
+    
     /**
      * @brief Parallel Metropolis-Coupled Markov chain Monte Carlo (MCMCMC) algorithm class.
      *
      * This file contains the declaration of the Markov chain Monte Carlo (MCMC) algorithm class.
      * An MCMC object manages the MCMC analysis by setting up the chain, calling the moves, the monitors and etc.
      *
+     * If parallel chains are enabled, then the chains of this process advance concurrently on the
+     * threads of the ThreadPool between two swap points. Each chain then draws from its own random number
+     * stream, which is split from the global generator. The chain swaps are performed afterwards on the calling thread.
+     *
      *
      *
      * @copyright Copyright 2009-
@@ -34,7 +40,7 @@ namespace RevBayesCore {
             intermediate
         };
 
-        Mcmcmc(const Model& m, const RbVector<Move> &mv, const RbVector<Monitor> &mn, std::string sT="random", size_t nc=4, size_t si=100, double dt=0.1, size_t ntries=1000, bool th=true, double tht=0.23, std::string sm="neighbor", std::string smo="multiple");
+        Mcmcmc(const Model& m, const RbVector<Move> &mv, const RbVector<Monitor> &mn, std::string sT="random", size_t nc=4, size_t si=100, double dt=0.1, size_t ntries=1000, bool th=true, double tht=0.23, std::string sm="neighbor", std::string smo="multiple", bool pc=false);
         Mcmcmc(const Mcmcmc &m);
         virtual                                ~Mcmcmc(void);                                                                   //!< Virtual destructor
         
@@ -45,6 +51,7 @@ namespace RevBayesCore {
         Mcmcmc*                                 clone(void) const;
         void                                    checkpoint(void) const;
         void                                    finishMonitors(size_t n, MonteCarloAnalysisOptions::TraceCombinationTypes ct);  //!< Finish the monitors
+        void                                    flushMonitors(void);                                                            //!< Write all buffered output of the monitors
         const Model&                            getModel(void) const;
         double                                  getModelLnProbability(bool likelihood_only);
         RbVector<Monitor>&                      getMonitors( void );
@@ -78,6 +85,7 @@ namespace RevBayesCore {
 
         
     private:
+        void                                    initializeChainRandomNumberGenerators(void);                                    //!< Split one random number stream per chain from the global generator (parallel chains only)
         void                                    initializeChains(void);
         void                                    swapChains(const std::string swap_method);
         void                                    swapMovesTuningInfo(RbVector<Move> &mvsj, RbVector<Move> &mvsk);
@@ -102,6 +110,7 @@ namespace RevBayesCore {
         std::vector<Mcmc*>                      chains;
         std::vector<double>                     chain_values;
         std::vector<double>                     chain_heats;
+        std::vector<RandomNumberGenerator*>     chain_rngs;                                         // the random number generators of the chains, if the chains run in parallel (not checkpointed)
 
         std::vector<boundary>                   chain_prev_boundary;                                // has the chain most recently visited the hottest or coldest temperature
         std::vector<int>                        chain_half_trips;                                   // how many trips has the chain made from hottest -> coldest or coldest to hottest
@@ -121,6 +130,7 @@ namespace RevBayesCore {
         bool                                    useNeighborSwapping;
         bool                                    useRandomSwapping;
         std::string                             swap_mode;                                          // whether making a single attempt per swap interval or attempt multiple (= nchains or nchains^2 for neighbor or random swaps, respectively) times.
+        bool                                    parallel_chains;                                    // if the chains of this process advance concurrently on several threads
         
         Mcmc*                                   base_chain;
         
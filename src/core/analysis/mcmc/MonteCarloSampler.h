@@ -48,6 +48,7 @@ namespace RevBayesCore {
         virtual void                            checkpoint(void) const = 0;                                 //!< Perform checkpointing by writing the current values to a file.
 //        virtual void                            run(size_t g) = 0;
         virtual void                            finishMonitors(size_t n, MonteCarloAnalysisOptions::TraceCombinationTypes ct) = 0; //!< Finish the monitors
+        virtual void                            flushMonitors(void) = 0;                                    //!< Write all buffered output of the monitors
         virtual const Model&                    getModel(void) const = 0;
         virtual double                          getModelLnProbability(bool like_only) = 0;
         virtual RbVector<Monitor>&              getMonitors() = 0;
@@ -11,6 +11,7 @@
 
 #include "RbMathLogic.h"
 #include "Cloneable.h"
+#include "OnlineTraceStatistics.h"
 #include "TraceNumeric.h"
 
 using namespace RevBayesCore;
@@ -57,3 +58,32 @@ size_t EssMax::estimateBurnin(const TraceNumeric& trace)
     // return the best burnin
     return best_burnin;
 }
+
+
+/**
+ * Estimate the burnin from the running statistics of a trace.
+ * Here the possible burnins are the boundaries of the batches instead of the blocks.
+ */
+size_t EssMax::estimateBurnin(const OnlineTraceStatistics& trace)
+{
+    
+    // init
+    double  max_ess     = 0;
+    size_t  best_batch  = 0;
+    size_t  n_batches   = trace.getNumberOfBatches();
+    
+    // iterate over possible burnins
+    for (size_t i=0; i<frac*n_batches; ++i) {
+        // analyse trace for this burnin
+        double ess = trace.getESS(i, n_batches);
+        
+        // check if the new ess is better than any previous ones
+        if (RbMath::isFinite(ess) && max_ess < ess) {
+            max_ess = ess;
+            best_batch = i;
+        }
+    }
+    
+    // return the best burnin
+    return best_batch * trace.getBatchSize();
+}
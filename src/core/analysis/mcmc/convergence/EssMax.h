@@ -6,6 +6,7 @@
 #include "BurninEstimatorContinuous.h"
 
 namespace RevBayesCore {
+class OnlineTraceStatistics;
 class TraceNumeric;
 
     class EssMax : public BurninEstimatorContinuous {
@@ -15,6 +16,7 @@ class TraceNumeric;
     
         EssMax*         clone(void) const;                                              //!< Clone function. This is similar to the copy constructor but useful in inheritance.
         std::size_t     estimateBurnin(const TraceNumeric& trace);
+        std::size_t     estimateBurnin(const OnlineTraceStatistics& trace);
     
     private:
     
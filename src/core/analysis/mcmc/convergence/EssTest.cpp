@@ -2,6 +2,7 @@
 
 
 #include "Cloner.h"
+#include "OnlineTraceStatistics.h"
 #include "TraceNumeric.h"
 
 using namespace RevBayesCore;
@@ -22,3 +23,9 @@ bool EssTest::assessConvergence(const TraceNumeric& trace)
     return  trace.getESS() > k;
 }
 
+
+bool EssTest::assessConvergence(const OnlineTraceStatistics& trace)
+{
+    
+    return  trace.getESS() > k;
+}
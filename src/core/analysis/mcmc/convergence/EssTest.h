@@ -26,6 +26,7 @@ class TraceNumeric;
         
         // implementen functions from convergence diagnostic
         bool        assessConvergence(const TraceNumeric& trace);
+        bool        assessConvergence(const OnlineTraceStatistics& trace);
         
     private:
         
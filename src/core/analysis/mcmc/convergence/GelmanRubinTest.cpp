@@ -2,6 +2,7 @@
 
 
 #include "Cloner.h"
+#include "OnlineTraceStatistics.h"
 #include "TraceNumeric.h"
 
 using namespace RevBayesCore;
@@ -86,3 +87,37 @@ bool GelmanRubinTest::assessConvergence(const std::vector<TraceNumeric>& traces)
     
     return psrf < R;
 }
+
+
+bool GelmanRubinTest::assessConvergence(const std::vector<OnlineTraceStatistics>& traces)
+{
+    
+    double within_chain_variance     = 0;
+    double between_chain_variance    = 0;
+    double total_mean                = 0;
+    size_t total_sample_size         = 0;
+    
+    // get number of chains
+    size_t nChains = traces.size();
+    
+    // get the mean of each chain
+    std::vector<double> chain_means  = std::vector< double >(nChains,0.0);
+    for (size_t i=0; i<nChains; i++)
+    {
+        chain_means[i] = traces[i].getMean();
+        total_mean += chain_means[i]*traces[i].size(true);
+        total_sample_size += traces[i].size(true);
+    }
+    total_mean /= double(total_sample_size);
+    
+    // the sums of squares follow from the running statistics of each chain
+    for (size_t i=0; i<nChains; i++)
+    {
+        within_chain_variance     += traces[i].getSumOfSquaredDeviations( chain_means[i] );
+        between_chain_variance    += traces[i].getSumOfSquaredDeviations( total_mean );
+    }
+    
+    double psrf = ((total_sample_size-nChains) / (total_sample_size-1.0)) * (between_chain_variance/within_chain_variance);
+    
+    return psrf < R;
+}
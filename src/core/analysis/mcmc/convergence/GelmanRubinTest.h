@@ -32,6 +32,7 @@ class TraceNumeric;
         // implementen functions from convergence diagnostic
         bool                assessConvergence(const TraceNumeric& trace);
         bool                assessConvergence(const std::vector<TraceNumeric>& traces);
+        bool                assessConvergence(const std::vector<OnlineTraceStatistics>& traces);
     
     private:
     
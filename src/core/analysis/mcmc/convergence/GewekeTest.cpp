@@ -5,6 +5,7 @@
 
 #include "DistributionNormal.h"
 #include "Cloner.h"
+#include "OnlineTraceStatistics.h"
 #include "TraceNumeric.h"
 
 using namespace RevBayesCore;
@@ -48,3 +49,42 @@ bool GewekeTest::assessConvergence(const TraceNumeric& trace)
     
     return cdf > p/2.0 && cdf < (1.0 - p/2.0);
 }
+
+
+/**
+ * Geweke's test from the running statistics of a trace.
+ * The windows are rounded to the batches of the statistics.
+ */
+bool GewekeTest::assessConvergence(const OnlineTraceStatistics& trace)
+{
+    
+    // get the number of batches after the burnin
+    size_t first_batch  = trace.getFirstBatch();
+    size_t n_batches    = trace.getNumberOfBatches();
+    size_t sample_size  = n_batches - first_batch;
+    
+    // set the indices for start and end of the first window
+    size_t startWindow1 = first_batch;
+    size_t endWindow1   = size_t(sample_size * frac1) + first_batch;
+    
+    // get mean and variance of the first window
+    double meanWindow1  = trace.getMean(startWindow1, endWindow1);
+    double varWindow1   = trace.getSEM(startWindow1, endWindow1);
+    varWindow1 *= varWindow1;
+    
+    // set the indices for start and end of the second window
+    size_t startWindow2 = n_batches - size_t(sample_size * frac2);
+    size_t endWindow2   = n_batches;
+    
+    // get mean and variance of the second window
+    double meanWindow2  = trace.getMean(startWindow2, endWindow2);
+    double varWindow2   = trace.getSEM(startWindow2, endWindow2);
+    varWindow2 *= varWindow2;
+    
+    // get z
+    double z            = (meanWindow1 - meanWindow2)/sqrt(varWindow1 + varWindow2);
+    
+    // check if z is standard normally distributed
+    double cdf          = RbStatistics::Normal::cdf(z);
+    return cdf > p/2.0 && cdf < (1.0 - p/2.0);
+}
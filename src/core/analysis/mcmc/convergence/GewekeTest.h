@@ -26,6 +26,7 @@ class TraceNumeric;
     
         // implementen functions from convergence diagnostic
         bool        assessConvergence(const TraceNumeric& trace);
+        bool        assessConvergence(const OnlineTraceStatistics& trace);
     
         // setters
         void        setFraction1(double f1) { frac1 = f1; }
@@ -12,6 +12,7 @@
 #include "RbConstants.h"
 #include "RbMathLogic.h"
 #include "Cloneable.h"
+#include "OnlineTraceStatistics.h"
 #include "TraceNumeric.h"
 
 using namespace RevBayesCore;
@@ -60,3 +61,29 @@ size_t SemMin::estimateBurnin(const TraceNumeric& trace) {
     // return the best burnin
     return best_burnin;
 }
+
+
+/**
+ * Estimate the burnin from the running statistics of a trace.
+ * Here the possible burnins are the boundaries of the batches instead of the blocks.
+ */
+size_t SemMin::estimateBurnin(const OnlineTraceStatistics& trace) {
+    // init
+    double  min_sem     = RbConstants::Double::max;
+    size_t  best_batch  = 0;
+    size_t  n_batches   = trace.getNumberOfBatches();
+    
+    // iterate over possible burnins
+    for (size_t i=0; i<n_batches; ++i) {
+        double sem = trace.getSEM(i, n_batches);
+        
+        // check if the new sem is better than any previous ones
+        if (RbMath::isFinite(sem) && sem > 0 && min_sem > sem) {
+            min_sem = sem;
+            best_batch = i;
+        }
+    }
+    
+    // return the best burnin
+    return best_batch * trace.getBatchSize();
+}
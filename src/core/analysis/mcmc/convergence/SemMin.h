@@ -13,6 +13,7 @@
 #include "BurninEstimatorContinuous.h"
 
 namespace RevBayesCore {
+class OnlineTraceStatistics;
 class TraceNumeric;
     
     class SemMin : public BurninEstimatorContinuous {
@@ -23,6 +24,7 @@ class TraceNumeric;
     
         SemMin*         clone(void) const;                                              //!< Clone function. This is similar to the copy constructor but useful in inheritance.
         std::size_t     estimateBurnin(const TraceNumeric& trace);
+        std::size_t     estimateBurnin(const OnlineTraceStatistics& trace);
     
     private:
     
@@ -4,6 +4,7 @@
 
 #include "DistributionNormal.h"
 #include "Cloner.h"
+#include "OnlineTraceStatistics.h"
 #include "TraceNumeric.h"
 
 using namespace RevBayesCore;
@@ -93,3 +94,44 @@ bool StationarityTest::assessConvergence(const std::vector<TraceNumeric>& traces
     
     return true;
 }
+
+
+bool StationarityTest::assessConvergence(const std::vector<OnlineTraceStatistics>& traces)
+{
+    
+    // get number of chains
+    size_t nChains = traces.size();
+    
+    // get the mean between all traces
+    double total_mean = 0.0;
+    size_t total_sample_size = 0;
+    
+    // get the mean and standard error for each chain
+    std::vector<double> chainMeans =  std::vector<double>(nChains,0.0);
+    std::vector<double> chainSem =  std::vector<double>(nChains,0.0);
+    for (size_t i=0; i<nChains; i++)
+    {
+        chainMeans[i] = traces[i].getMean();
+        chainSem[i]   = traces[i].getSEM();
+        total_mean += chainMeans[i]*traces[i].size(true);
+        total_sample_size += traces[i].size(true);
+    }
+    total_mean /= double(total_sample_size);
+    
+    // use correction for multiple sampling
+    double p_corrected = pow(1.0-p, 1.0/nChains);
+    
+    for (size_t i=0; i<nChains; i++)
+    {
+        // get the quantile of a normal with mu=0, var=sem and p=(1-p_corrected)/2
+        double quantile = RbStatistics::Normal::quantile(0.0, chainSem[i], p_corrected);
+        
+        // check if the trace mean is outside this confidence interval
+        if (chainMeans[i]-quantile > total_mean || chainMeans[i]+quantile < total_mean)
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
@@ -30,6 +30,7 @@ class TraceNumeric;
         // implementen functions from convergence diagnostic
         bool            assessConvergence(const TraceNumeric& trace);
         bool            assessConvergence(const std::vector<TraceNumeric>& traces);
+        bool            assessConvergence(const std::vector<OnlineTraceStatistics>& traces);
     
         // setters
         void            setNBlocks(std::size_t n) { nBlocks = n; }
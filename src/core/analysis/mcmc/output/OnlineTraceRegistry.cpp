@@ -0,0 +1,34 @@
+#include "OnlineTraceRegistry.h"
+
+using namespace RevBayesCore;
+
+
+std::shared_ptr<OnlineTrace> OnlineTraceRegistry::getTrace(const path &fn)
+{
+
+    std::lock_guard<std::mutex> lock( mutex );
+
+    std::map<std::string, std::shared_ptr<OnlineTrace> >::const_iterator it = traces.find( absolute(fn).string() );
+    if ( it == traces.end() )
+    {
+        return NULL;
+    }
+
+    return it->second;
+}
+
+
+/**
+ * Observe the file with a new online trace. A previous online trace of this file is replaced,
+ * but remains valid for those who still hold it.
+ */
+std::shared_ptr<OnlineTrace> OnlineTraceRegistry::observe(const path &fn)
+{
+
+    std::lock_guard<std::mutex> lock( mutex );
+
+    std::shared_ptr<OnlineTrace> t = std::make_shared<OnlineTrace>();
+    traces[ absolute(fn).string() ] = t;
+
+    return t;
+}
@@ -0,0 +1,62 @@
+#ifndef OnlineTraceRegistry_H
+#define OnlineTraceRegistry_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "OnlineTraceStatistics.h"
+#include "RbFileManager.h"
+
+namespace RevBayesCore {
+
+    /**
+     * @brief The running statistics of all columns of a trace file (except the iteration).
+     *
+     * A monitor that writes the file adds every sample, so that readers (e.g., the convergence stopping rules)
+     * do not need to read the file. The trace is only used while it is active.
+     */
+    struct OnlineTrace {
+
+        enum State { WAITING, ACTIVE, FAILED };
+
+        OnlineTrace(void) : state( WAITING ) {}
+
+        std::vector<OnlineTraceStatistics>          columns;
+        State                                       state;                                                                                  //!< Waiting for the first sample, active, or failed because the columns changed
+    };
+
+
+    /**
+     * @brief OnlineTraceRegistry class declaration
+     * The class OnlineTraceRegistry connects the readers of trace files with the monitors that write these files.
+     * A reader observes a file before the monitors are started. A monitor that opens an observed file adds
+     * all its samples to the online trace of the file.
+     *
+     */
+    class OnlineTraceRegistry {
+
+    public:
+        static OnlineTraceRegistry&                 onlineTraceRegistryInstance(void)                                                       //!< Return a reference to the singleton registry
+                                                    {
+                                                        static OnlineTraceRegistry singleOnlineTraceRegistry;
+                                                        return singleOnlineTraceRegistry;
+                                                    }
+
+        std::shared_ptr<OnlineTrace>                getTrace(const path &fn);                                                               //!< The online trace of the file, or NULL if nobody observes the file
+        std::shared_ptr<OnlineTrace>                observe(const path &fn);                                                                //!< Start a new online trace for the file
+
+    private:
+                                                    OnlineTraceRegistry(void) {}                                                            //!< Default constructor
+                                                    OnlineTraceRegistry(const OnlineTraceRegistry&);                                        //!< Copy constructor
+                                                    OnlineTraceRegistry& operator=(const OnlineTraceRegistry&);                             //!< Assignment operator
+
+        std::map<std::string, std::shared_ptr<OnlineTrace> >    traces;
+        std::mutex                                  mutex;
+    };
+
+}
+
+#endif
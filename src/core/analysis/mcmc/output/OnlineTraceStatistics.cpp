@@ -0,0 +1,316 @@
+#include "OnlineTraceStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "RbConstants.h"
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    // the number of batches at which neighbouring batches are merged.
+    // Geweke's windows cover 10% of the batches, so they need at least a dozen batches for a stable standard error.
+    const size_t max_batches = 256;
+
+}
+
+
+OnlineTraceStatistics::OnlineTraceStatistics( void ) :
+    batch_size( 1 ),
+    burnin( 0 ),
+    current_batch(),
+    current_batch_size( 0 ),
+    num_values( 0 ),
+    shift( 0.0 )
+{
+
+}
+
+
+/**
+ * Add the next value. If this completes the last batch and there are max_batches batches,
+ * then we merge the batches pairwise.
+ */
+void OnlineTraceStatistics::addValue( double x )
+{
+
+    if ( num_values == 0 )
+    {
+        shift = x;
+    }
+    ++num_values;
+
+    double y = x - shift;
+    if ( current_batch_size == 0 )
+    {
+        current_batch.sum               = y;
+        current_batch.sum_of_squares    = y * y;
+        current_batch.sum_of_products   = 0.0;
+        current_batch.first             = y;
+    }
+    else
+    {
+        current_batch.sum               += y;
+        current_batch.sum_of_squares    += y * y;
+        current_batch.sum_of_products   += current_batch.last * y;
+    }
+    current_batch.last = y;
+    ++current_batch_size;
+
+    if ( current_batch_size < batch_size )
+    {
+        return;
+    }
+
+    batches.push_back( current_batch );
+    current_batch_size = 0;
+
+    if ( batches.size() == max_batches )
+    {
+        for (size_t i=0; i<max_batches/2; ++i)
+        {
+            batches[i] = merge( batches[2*i], batches[2*i+1] );
+        }
+        batches.resize( max_batches/2 );
+        batch_size *= 2;
+    }
+
+}
+
+
+void OnlineTraceStatistics::clear( void )
+{
+
+    batches.clear();
+    batch_size          = 1;
+    burnin              = 0;
+    current_batch_size  = 0;
+    num_values          = 0;
+    shift               = 0.0;
+}
+
+
+/**
+ * The autocorrelation time of the batches [begin,end). We take the larger of two estimates:
+ * the batch-means estimate, which is consistent for long traces, and the estimate from the lag-1 autocorrelation
+ * under an AR(1) model, which still works if the batches are not much longer than the autocorrelation.
+ */
+double OnlineTraceStatistics::getAutocorrelationTime(size_t begin, size_t end) const
+{
+
+    double gamma0 = getVariance( begin, end );
+    if ( end < begin + 2 || (gamma0 > 0.0) == false )
+    {
+        return RbConstants::Double::nan;
+    }
+
+    size_t m = end - begin;
+    double n = double(m * batch_size);
+
+    double sum = 0.0;
+    double sum_of_products = 0.0;
+    for (size_t i=begin; i<end; ++i)
+    {
+        sum             += batches[i].sum;
+        sum_of_products += batches[i].sum_of_products;
+        if ( i+1 < end )
+        {
+            sum_of_products += batches[i].last * batches[i+1].first;
+        }
+    }
+    double mean = sum / n;
+
+    // the batch-means estimate
+    double batch_variance = 0.0;
+    for (size_t i=begin; i<end; ++i)
+    {
+        double d = batches[i].sum / batch_size - mean;
+        batch_variance += d * d;
+    }
+    batch_variance *= double(batch_size) / double(m - 1);
+    double act_batch_means = batch_variance / gamma0;
+
+    // the lag-1 estimate
+    double gamma1 = (sum_of_products - mean * (2.0 * sum - batches[begin].first - batches[end-1].last)) / (n - 1.0) + mean * mean;
+    double rho = gamma1 / gamma0;
+    double act_lag_one = 1.0;
+    if ( rho >= 1.0 )
+    {
+        act_lag_one = RbConstants::Double::inf;
+    }
+    else if ( rho > 0.0 )
+    {
+        act_lag_one = (1.0 + rho) / (1.0 - rho);
+    }
+
+    return std::max( act_batch_means, act_lag_one );
+}
+
+
+size_t OnlineTraceStatistics::getBatchSize( void ) const
+{
+
+    return batch_size;
+}
+
+
+size_t OnlineTraceStatistics::getBurnin( void ) const
+{
+
+    return burnin;
+}
+
+
+double OnlineTraceStatistics::getESS( void ) const
+{
+
+    return getESS( getFirstBatch(), batches.size() );
+}
+
+
+/**
+ * The effective sample size of the batches [begin,end). We need at least two batches and a non-constant trace,
+ * otherwise the effective sample size is 0 or not a number.
+ */
+double OnlineTraceStatistics::getESS(size_t begin, size_t end) const
+{
+
+    if ( end < begin + 2 )
+    {
+        return 0.0;
+    }
+
+    return double((end - begin) * batch_size) / getAutocorrelationTime( begin, end );
+}
+
+
+size_t OnlineTraceStatistics::getFirstBatch( void ) const
+{
+
+    return std::min( (burnin + batch_size - 1) / batch_size, batches.size() );
+}
+
+
+double OnlineTraceStatistics::getMean( void ) const
+{
+
+    return getMean( getFirstBatch(), batches.size() );
+}
+
+
+double OnlineTraceStatistics::getMean(size_t begin, size_t end) const
+{
+
+    if ( end <= begin )
+    {
+        return RbConstants::Double::nan;
+    }
+
+    double sum = 0.0;
+    for (size_t i=begin; i<end; ++i)
+    {
+        sum += batches[i].sum;
+    }
+
+    return shift + sum / double((end - begin) * batch_size);
+}
+
+
+size_t OnlineTraceStatistics::getNumberOfBatches( void ) const
+{
+
+    return batches.size();
+}
+
+
+double OnlineTraceStatistics::getSEM( void ) const
+{
+
+    return getSEM( getFirstBatch(), batches.size() );
+}
+
+
+double OnlineTraceStatistics::getSEM(size_t begin, size_t end) const
+{
+
+    if ( end < begin + 2 )
+    {
+        return RbConstants::Double::nan;
+    }
+
+    return sqrt( getVariance( begin, end ) * getAutocorrelationTime( begin, end ) / double((end - begin) * batch_size) );
+}
+
+
+double OnlineTraceStatistics::getSumOfSquaredDeviations( double m ) const
+{
+
+    double sum = 0.0;
+    double sum_of_squares = 0.0;
+    for (size_t i=getFirstBatch(); i<batches.size(); ++i)
+    {
+        sum             += batches[i].sum;
+        sum_of_squares  += batches[i].sum_of_squares;
+    }
+
+    double c = m - shift;
+    return sum_of_squares - 2.0 * c * sum + double(size(true)) * c * c;
+}
+
+
+double OnlineTraceStatistics::getVariance(size_t begin, size_t end) const
+{
+
+    if ( end <= begin )
+    {
+        return RbConstants::Double::nan;
+    }
+
+    double sum = 0.0;
+    double sum_of_squares = 0.0;
+    for (size_t i=begin; i<end; ++i)
+    {
+        sum             += batches[i].sum;
+        sum_of_squares  += batches[i].sum_of_squares;
+    }
+
+    double n = double((end - begin) * batch_size);
+    double mean = sum / n;
+
+    return sum_of_squares / n - mean * mean;
+}
+
+
+OnlineTraceStatistics::Batch OnlineTraceStatistics::merge(const Batch &a, const Batch &b)
+{
+
+    Batch m;
+    m.sum               = a.sum + b.sum;
+    m.sum_of_squares    = a.sum_of_squares + b.sum_of_squares;
+    m.sum_of_products   = a.sum_of_products + b.sum_of_products + a.last * b.first;
+    m.first             = a.first;
+    m.last              = b.last;
+
+    return m;
+}
+
+
+void OnlineTraceStatistics::setBurnin( size_t b )
+{
+
+    burnin = b;
+}
+
+
+size_t OnlineTraceStatistics::size( bool post ) const
+{
+
+    if ( post == true )
+    {
+        return (batches.size() - getFirstBatch()) * batch_size;
+    }
+
+    return num_values;
+}
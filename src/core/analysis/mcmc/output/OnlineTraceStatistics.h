@@ -0,0 +1,74 @@
+#ifndef OnlineTraceStatistics_H
+#define OnlineTraceStatistics_H
+
+#include <cstddef>
+#include <vector>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Running summary statistics of a numeric trace.
+     *
+     * The statistics are updated with every new value and use constant memory. The values are collected in
+     * batches of equal size: for each batch we keep the sum, the sum of squares and the sum of the products of
+     * consecutive values. Whenever there are max_batches complete batches, neighbouring batches are merged
+     * and the batch size doubles. Hence, there are always between max_batches/2 and max_batches batches.
+     *
+     * From the batches we compute the mean, the variance, the batch-means estimate of the variance of the mean
+     * and the lag-1 autocorrelation of any window of complete batches, independent of the length of the trace.
+     * The most recent values that do not complete a batch yet are not part of these statistics.
+     * The burn-in is given in values (as for the TraceNumeric) and rounded up to the next batch boundary.
+     *
+     * The sums are taken over the differences to the first value, so that large values (e.g., the posterior)
+     * do not lose their precision.
+     */
+    class OnlineTraceStatistics {
+
+    public:
+        OnlineTraceStatistics(void);
+
+        void                                        addValue(double x);                                         //!< Add the next value of the trace
+        void                                        clear(void);                                                //!< Remove all values
+
+        size_t                                      getBatchSize(void) const;
+        size_t                                      getBurnin(void) const;                                      //!< The burn-in in values
+        size_t                                      getFirstBatch(void) const;                                  //!< The first batch after the burn-in
+        size_t                                      getNumberOfBatches(void) const;                             //!< The number of complete batches
+
+        double                                      getESS(void) const;                                         //!< The effective sample size after the burn-in
+        double                                      getESS(size_t begin, size_t end) const;                     //!< The effective sample size of the batches [begin,end)
+        double                                      getMean(void) const;                                        //!< The mean after the burn-in
+        double                                      getMean(size_t begin, size_t end) const;                    //!< The mean of the batches [begin,end)
+        double                                      getSEM(void) const;                                         //!< The standard error of the mean after the burn-in
+        double                                      getSEM(size_t begin, size_t end) const;                     //!< The standard error of the mean of the batches [begin,end)
+        double                                      getSumOfSquaredDeviations(double m) const;                  //!< The sum of (x-m)^2 over the values after the burn-in
+
+        void                                        setBurnin(size_t b);
+        size_t                                      size(bool post = false) const;                              //!< The number of values (in complete batches after the burn-in if post is true)
+
+    private:
+
+        struct Batch {
+            double                                  sum;
+            double                                  sum_of_squares;
+            double                                  sum_of_products;                                            //!< The sum of the products of consecutive values within the batch
+            double                                  first;
+            double                                  last;
+        };
+
+        static Batch                                merge(const Batch &a, const Batch &b);
+        double                                      getAutocorrelationTime(size_t begin, size_t end) const;
+        double                                      getVariance(size_t begin, size_t end) const;                //!< The variance (divided by the number of values) of the batches [begin,end)
+
+        std::vector<Batch>                          batches;                                                    //!< The complete batches
+        size_t                                      batch_size;
+        size_t                                      burnin;
+        Batch                                       current_batch;
+        size_t                                      current_batch_size;                                         //!< The number of values in the current, incomplete batch
+        size_t                                      num_values;
+        double                                      shift;                                                      //!< The first value, which is subtracted from all values
+    };
+
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <vector>
 #include <ostream>
+#include <utility>
 
 #include "AbstractTrace.h"
 #include "RbVector.h"
@@ -34,8 +35,10 @@ namespace RevBayesCore {
         virtual void                    addValueFromString(const std::string &s);
         virtual Trace*                  clone(void) const;                              //!< Clone object
 
-        const valueType&                objectAt(size_t index, bool post = false) const { return post ? values.at(index + burnin) : values.at(index); }
-        long                            size(bool post = false) const                   { return post ? values.size() - burnin : values.size(); }
+        // the returned reference is only valid until the next call of objectAt,
+        // because traces that stream their samples from a file (e.g., TraceTree) only keep the last sample
+        virtual const valueType&        objectAt(size_t index, bool post = false) const { return post ? values.at(index + burnin) : values.at(index); }
+        virtual long                    size(bool post = false) const                   { return post ? values.size() - burnin : values.size(); }
 
         virtual void                    addObject(const valueType& d);
         virtual void                    addObject(valueType&& d);
@@ -51,7 +54,7 @@ namespace RevBayesCore {
         const std::vector<valueType>&   getValues() const                               { return values; }
 
         virtual void                    setBurnin(long b);
-        void                            setValues(std::vector<valueType> v)             { values = v; }
+        void                            setValues(std::vector<valueType> v)             { values = std::move(v); valuesChanged(); }
         
 
         // getters and setters
@@ -63,6 +66,8 @@ namespace RevBayesCore {
         
     protected:
         
+        virtual void                    valuesChanged(void)                             { dirty = true; }   //!< The values were added, removed or replaced
+        
         size_t                          burnin = 0;
         path                            fileName;
         std::string                     parmName;
@@ -115,7 +120,7 @@ template <class valueType>
 void RevBayesCore::Trace<valueType>::addObject(const valueType& t)
 {
     values.push_back(t);
-    dirty = true;
+    valuesChanged();
 }
 
 
@@ -123,7 +128,7 @@ template <class valueType>
 void RevBayesCore::Trace<valueType>::addObject(valueType&& t)
 {
     values.push_back( std::move(t) );
-    dirty = true;
+    valuesChanged();
 }
 
 
@@ -168,7 +173,7 @@ void RevBayesCore::Trace<valueType>::removeObjectAtIndex (int index)
 {
     // remove the element
     values.erase(values.begin() + index);
-    dirty = true;
+    valuesChanged();
 }
 
 
@@ -177,7 +182,7 @@ void RevBayesCore::Trace<valueType>::removeLastObject()
 {
     // remove object from list
     values.pop_back();
-    dirty = true;
+    valuesChanged();
 }
 
 
@@ -1,6 +1,8 @@
 #include "TraceNumeric.h"
 
 #include <math.h>
+#include <algorithm>
+#include <complex>
 #include <cstddef>
 #include <vector>
 
@@ -8,12 +10,72 @@
 #include "StationarityTest.h"
 #include "Cloner.h"
 #include "RbConstants.h" // IWYU pragma: keep
+#include "RbException.h"
 
 using namespace RevBayesCore;
 using namespace std;
 
 #define MAX_LAG 1000
 
+
+namespace {
+    
+    /**
+     * In-place radix-2 fast Fourier transform. The size of the vector must be a power of 2.
+     */
+    void fourierTransform(std::vector< std::complex<double> > &a, bool inverse)
+    {
+        size_t n = a.size();
+        
+        // reorder the elements by bit-reversed index
+        for (size_t i = 1, j = 0; i < n; ++i)
+        {
+            size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1)
+            {
+                j ^= bit;
+            }
+            j ^= bit;
+            
+            if (i < j)
+            {
+                std::swap(a[i], a[j]);
+            }
+        }
+        
+        // the roots of unity are computed directly instead of by repeated multiplication to keep their precision
+        std::vector< std::complex<double> > roots(n / 2);
+        for (size_t k = 0; k < n / 2; ++k)
+        {
+            roots[k] = std::polar(1.0, (inverse ? 2.0 : -2.0) * RbConstants::PI * k / n);
+        }
+        
+        for (size_t len = 2; len <= n; len <<= 1)
+        {
+            size_t step = n / len;
+            for (size_t i = 0; i < n; i += len)
+            {
+                for (size_t j = 0; j < len / 2; ++j)
+                {
+                    std::complex<double> u = a[i + j];
+                    std::complex<double> v = a[i + j + len / 2] * roots[j * step];
+                    a[i + j]           = u + v;
+                    a[i + j + len / 2] = u - v;
+                }
+            }
+        }
+        
+        if ( inverse == true )
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                a[i] /= double(n);
+            }
+        }
+    }
+    
+}
+
 /**
  * 
  */
@@ -43,9 +105,14 @@ TraceNumeric* TraceNumeric::clone() const
 }
 
 
+/**
+ * Compute the mean, ESS and SEM of the values after the burnin, so that they are cached when they are needed.
+ */
 void TraceNumeric::computeStatistics( void )
 {
 
+    update();
+
     // Sebastian (20210519): The convergence test are currently broken and don't work anymore.
 //    // test stationarity within chain
 //    size_t nBlocks = 10;
@@ -90,13 +157,9 @@ double TraceNumeric::getMean(long inbegin, long inend) const
         begin = inbegin;
         end = inend;
 
-        double m = 0;
-        for (size_t i=begin; i<end; i++)
-        {
-            m += values.at(i);
-        }
-
-        meanw = m/(end-begin);
+        // the workspace keeps the sum of the window
+        moveWorkspace(begin, end);
+        meanw = workspace.shift + workspace.sum/(end-begin);
 
         statsw_dirty = true;
     }
@@ -160,117 +223,247 @@ double TraceNumeric::getSEM() const
 
 
 /**
- * Analyze trace
+ * Compute the effective sample size and the standard error of the mean of the values [begin,end) with mean m.
  *
+ * We sum the autocovariances in pairs of consecutive lags until a pair is not positive (Geyer's initial positive sequence),
+ * but at most up to lag MAX_LAG. The autocovariances are computed from the lagged products in the workspace,
+ * which are only computed for as many lags as we need.
  */
-void TraceNumeric::update() const
+void TraceNumeric::computeCorrelationStatistics(long b, long e, double m, double &e_ss, double &s_em) const
 {
-    // if we have not yet calculated the mean, do this now
-
-    getMean();
-
-    if( stats_dirty == false ) return;
-
-    size_t samples = values.size() - burnin;
-    size_t maxLag = (samples - 1 < MAX_LAG ? samples - 1 : MAX_LAG);
-
-    double* gammaStat = new double[maxLag];
-    // setting values to 0
-    for (size_t i=0; i<maxLag; i++)
+    
+    size_t samples = (e > b ? e - b : 0);
+    if ( samples < 2 )
     {
-        gammaStat[i] = 0;
+        e_ss = RbConstants::Double::nan;
+        s_em = RbConstants::Double::nan;
+        return;
     }
+    
+    moveWorkspace(b, e);
+    
+    size_t maxLag = (samples - 1 < MAX_LAG ? samples - 1 : MAX_LAG);
+    double mw = m - workspace.shift;
+    
+    // the sums of the shifted values y[j] for j in [b,e-lag) and j in [b+lag,e)
+    double sum_first = workspace.sum;
+    double sum_last  = workspace.sum;
+    
+    double gamma0 = 0.0;
+    double previous_gamma = 0.0;
     double varStat = 0.0;
-
-    for (size_t lag = 0; lag < maxLag; lag++) {
-        for (size_t j = 0; j < samples - lag; j++) {
-            double del1 = values.at(burnin + j) - mean;
-            double del2 = values.at(burnin + j + lag) - mean;
-            gammaStat[lag] += (del1 * del2);
+    
+    size_t lag = 0;
+    for (; lag < maxLag; lag++)
+    {
+        if ( lag >= workspace.products.size() )
+        {
+            // compute twice as many lags as before, but at least 16
+            computeLagProducts( std::min( maxLag, std::max( std::max( size_t(16), 2 * workspace.products.size() ), lag + 1 ) ) );
         }
-
-        gammaStat[lag] /= ((double) (samples - lag));
-
+        
+        if ( lag > 0 )
+        {
+            sum_first -= double(values[e - lag]) - workspace.shift;
+            sum_last  -= double(values[b + lag - 1]) - workspace.shift;
+        }
+        
+        double n = double(samples - lag);
+        double gamma = (workspace.products[lag] - mw * (sum_first + sum_last) + n * mw * mw) / n;
+        
         if (lag == 0) {
-            varStat = gammaStat[0];
+            gamma0 = gamma;
+            varStat = gamma;
         } else if (lag % 2 == 0) {
             // fancy stopping criterion :)
-            if (gammaStat[lag - 1] + gammaStat[lag] > 0) {
-                varStat += 2.0 * (gammaStat[lag - 1] + gammaStat[lag]);
+            if (previous_gamma + gamma > 0) {
+                varStat += 2.0 * (previous_gamma + gamma);
             }
             // stop
             else
-                maxLag = lag;
+                break;
         }
+        
+        previous_gamma = gamma;
     }
-
+    
+    // we only keep updating the lags that we are likely to need for the next window
+    if ( workspace.products.size() > 2 * (lag + 1) )
+    {
+        workspace.products.resize( 2 * (lag + 1) );
+    }
+    
     // standard error of mean
-    sem = sqrt(varStat / samples);
-
+    s_em = sqrt(varStat / samples);
+    
     // auto correlation time
-    double act = varStat / gammaStat[0];
-
+    double act = varStat / gamma0;
+    
     // effective sample size
-    ess = samples / act;
+    e_ss = samples / act;
+}
 
-    stats_dirty = false;
 
-    delete[] gammaStat;
+/**
+ * Compute the lagged products of the current window for all lags below n.
+ * If we need many new lags, then one fast Fourier transform of the window is cheaper than summing over the window for each lag.
+ */
+void TraceNumeric::computeLagProducts(size_t n) const
+{
+    
+    size_t first_lag = workspace.products.size();
+    if ( n <= first_lag )
+    {
+        return;
+    }
+    
+    size_t b = workspace.begin;
+    size_t samples = workspace.end - workspace.begin;
+    workspace.products.resize( n, 0.0 );
+    
+    size_t fft_size = 1;
+    size_t log_fft_size = 0;
+    while ( fft_size < samples + n )
+    {
+        fft_size <<= 1;
+        ++log_fft_size;
+    }
+    
+    if ( (n - first_lag) * samples > 5 * fft_size * log_fft_size )
+    {
+        // the zero padding makes the circular autocorrelation equal to the sums of the lagged products for all lags below n
+        std::vector< std::complex<double> > a( fft_size, 0.0 );
+        for (size_t j = 0; j < samples; ++j)
+        {
+            a[j] = double(values[b + j]) - workspace.shift;
+        }
+        
+        fourierTransform( a, false );
+        for (size_t j = 0; j < fft_size; ++j)
+        {
+            a[j] = std::norm( a[j] );
+        }
+        fourierTransform( a, true );
+        
+        for (size_t lag = first_lag; lag < n; ++lag)
+        {
+            workspace.products[lag] = a[lag].real();
+        }
+    }
+    else
+    {
+        for (size_t lag = first_lag; lag < n; ++lag)
+        {
+            double p = 0.0;
+            for (size_t j = b; j + lag < workspace.end; ++j)
+            {
+                p += (values[j] - workspace.shift) * (values[j + lag] - workspace.shift);
+            }
+            workspace.products[lag] = p;
+        }
+    }
+    
 }
 
+
 /**
- * Analyze trace within a range of values
- *
+ * Move the workspace to the values [b,e).
+ * If only the begin of the window moved forward, then we remove the values that left the window from the sums.
+ * Otherwise we start from scratch and compute the lagged products again when they are needed.
  */
-void TraceNumeric::update(long inbegin, long inend) const
+void TraceNumeric::moveWorkspace(long b, long e) const
 {
-    // if we have not yet calculated the mean, do this now
-    getMean(inbegin, inend);
+    
+    if ( b < 0 || e < b || size_t(e) > values.size() )
+    {
+        throw RbException()<<"Cannot compute the statistics of the values from "<<b<<" to "<<e<<" of a trace with "<<values.size()<<" values.";
+    }
+    
+    if ( workspace.end != e || workspace.begin > b || workspace.begin == workspace.end )
+    {
+        workspace.begin      = b;
+        workspace.end        = e;
+        workspace.products.clear();
+        
+        double m = 0.0;
+        for (long j = b; j < e; ++j)
+        {
+            m += values[j];
+        }
+        workspace.shift = (e > b ? m / (e - b) : 0.0);
+        
+        workspace.sum = 0.0;
+        for (long j = b; j < e; ++j)
+        {
+            workspace.sum += values[j] - workspace.shift;
+        }
+        
+        return;
+    }
+    
+    for (long j = workspace.begin; j < b; ++j)
+    {
+        double y = values[j] - workspace.shift;
+        workspace.sum -= y;
+        
+        for (size_t lag = 0; lag < workspace.products.size() && j + long(lag) < e; ++lag)
+        {
+            workspace.products[lag] -= y * (values[j + lag] - workspace.shift);
+        }
+    }
+    workspace.begin = b;
+    
+}
 
-    if( statsw_dirty == false ) return;
 
-    size_t samples = end - begin;
-    size_t maxLag = (samples - 1 < MAX_LAG ? samples - 1 : MAX_LAG);
+/**
+ * The values were added, removed or replaced.
+ * The statistics of the window and the lagged products in the workspace belong to the old values,
+ * so we compute them from scratch the next time they are needed.
+ */
+void TraceNumeric::valuesChanged( void )
+{
+    
+    Trace<double>::valuesChanged();
+    
+    workspace = AutocovarianceWorkspace();
+    
+    begin = -1;
+    end   = -1;
+    statsw_dirty = true;
+    
+}
 
-    double* gammaStat = new double[maxLag];
-    // setting values to 0
-    for (size_t i=0; i<maxLag; i++) {
-        gammaStat[i] = 0;
-    }
-    double varStat = 0.0;
 
-    for (size_t lag = 0; lag < maxLag; lag++) {
-        for (size_t j = 0; j < samples - lag; j++) {
-            double del1 = values.at(begin + j) - meanw;
-            double del2 = values.at(begin + j + lag) - meanw;
-            gammaStat[lag] += (del1 * del2);
-        }
+/**
+ * Analyze trace
+ *
+ */
+void TraceNumeric::update() const
+{
+    // if we have not yet calculated the mean, do this now
 
-        gammaStat[lag] /= ((double) (samples - lag));
+    getMean();
 
-        if (lag == 0) {
-            varStat = gammaStat[0];
-        } else if (lag % 2 == 0) {
-            // fancy stopping criterion :)
-            if (gammaStat[lag - 1] + gammaStat[lag] > 0) {
-                varStat += 2.0 * (gammaStat[lag - 1] + gammaStat[lag]);
-            }
-            // stop
-            else
-                maxLag = lag;
-        }
-    }
+    if( stats_dirty == false ) return;
 
-    // standard error of mean
-    semw = sqrt(varStat / samples);
+    computeCorrelationStatistics(burnin, values.size(), mean, ess, sem);
 
-    // auto correlation time
-    double act = varStat / gammaStat[0];
+    stats_dirty = false;
+}
 
-    // effective sample size
-    essw = samples / act;
+/**
+ * Analyze trace within a range of values
+ *
+ */
+void TraceNumeric::update(long inbegin, long inend) const
+{
+    // if we have not yet calculated the mean, do this now
+    getMean(inbegin, inend);
+
+    if( statsw_dirty == false ) return;
 
-    delete[] gammaStat;
+    computeCorrelationStatistics(begin, end, meanw, essw, semw);
 
     statsw_dirty = false;
 }
@@ -1,6 +1,8 @@
 #ifndef TraceNumeric_H
 #define TraceNumeric_H
 
+#include <vector>
+
 #include "Trace.h"
 
 namespace RevBayesCore {
@@ -21,7 +23,7 @@ namespace RevBayesCore {
         double                  getESS(long begin, long end) const;             //!< compute the effective sample size with begin and end indices of the values
         double                  getSEM(long begin, long end) const;             //!< compute the effective sample size with begin and end indices of the values
 
-        void                    computeStatistics(void);
+        void                    computeStatistics(void);                        //!< compute the mean, ess and sem after the burnin
 
         //int                     hasConverged() const                            { return converged; }
         int                     hasPassedGewekeTest() const                     { return passedGewekeTest; }
@@ -36,6 +38,25 @@ namespace RevBayesCore {
         void                    update() const;                                 //!< compute the correlation statistics (act,ess,sem,...)
         void                    update(long begin, long end) const;             //!< compute the correlation statistics (act,ess,sem,...)
 
+        void                    computeCorrelationStatistics(long begin, long end, double m, double &e, double &s) const;  //!< compute the ess and sem of the values [begin,end) with mean m
+        void                    computeLagProducts(size_t n) const;             //!< compute the lagged products of the workspace up to (excluding) lag n
+        void                    moveWorkspace(long begin, long end) const;      //!< move the autocovariance workspace to the values [begin,end)
+        void                    valuesChanged(void);                            //!< forget the statistics and the workspace of the old values
+
+        /**
+         * The sums needed for the autocovariances of the values [begin,end).
+         * The values are shifted by the mean of the first window, so that the sums do not lose precision.
+         * When the window only moves its begin forward (e.g., for the burnin candidates of EssMax),
+         * the sums are updated by removing the values that left the window.
+         */
+        struct AutocovarianceWorkspace {
+            long                begin = 0;
+            long                end = 0;
+            double              shift = 0.0;
+            double              sum = 0.0;                                      //!< the sum of the shifted values in the window
+            std::vector<double> products;                                       //!< products[lag] is the sum of y[j]*y[j+lag] over the window
+        };
+
         // variable holding the data
         mutable double          ess;                                            //!< effective sample size
         mutable double          mean;                                           //!< mean of trace
@@ -57,6 +78,8 @@ namespace RevBayesCore {
         //int                     passedIidBetweenChainsStatistic;                //!< Whether this parameter passed the iid test of chains.
         //int                     passedGelmanRubinTest;                          //!< Whether this parameter passed the Gelman-Rubin statistic.
 
+        mutable AutocovarianceWorkspace workspace;
+
         mutable bool            stats_dirty;
         mutable bool            statsw_dirty;
     
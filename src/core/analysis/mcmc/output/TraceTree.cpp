@@ -11,6 +11,18 @@ TraceTree::TraceTree( bool c ) : TreeSummary(this, c)
 }
 
 
+/*
+ * TraceTree constructor for a trace that streams its trees from a file.
+ * Only the positions of the samples are kept in memory and every tree is parsed when it is accessed.
+ */
+TraceTree::TraceTree( bool c, const std::shared_ptr<TreeTraceReader>& r ) : TreeSummary(this, c),
+    reader( r )
+{
+    setFileName( reader->getFileName() );
+    setParameterName( reader->getParameterName() );
+}
+
+
 /*
  * TraceTree copy constructor
  */
@@ -20,6 +32,12 @@ TraceTree::TraceTree(const TraceTree& t ) : TreeSummary(this, t.isClock())
 
     traces.clear();
     traces.push_back(this);
+
+    // the reader is not thread safe, so every copy reads the file through its own reader
+    if ( t.reader != nullptr )
+    {
+        reader = std::make_shared<TreeTraceReader>( *t.reader );
+    }
 }
 
 
@@ -35,3 +53,29 @@ TraceTree* TraceTree::clone(void) const
     
     return new TraceTree(*this);
 }
+
+
+const Tree& TraceTree::objectAt(size_t index, bool post) const
+{
+
+    if ( reader == nullptr )
+    {
+        return Trace<Tree>::objectAt(index, post);
+    }
+
+    // the reference is only valid until the next tree is accessed
+    return reader->getTree( post ? index + burnin : index );
+}
+
+
+long TraceTree::size(bool post) const
+{
+
+    if ( reader == nullptr )
+    {
+        return Trace<Tree>::size(post);
+    }
+
+    long n = long( reader->getNumberOfSamples() );
+    return post ? n - burnin : n;
+}
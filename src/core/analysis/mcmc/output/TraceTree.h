@@ -1,10 +1,13 @@
 #ifndef TraceTree_H
 #define TraceTree_H
 
+#include <memory>
+
 #include "Clade.h"
 #include "Trace.h"
 #include "Tree.h"
 #include "TreeSummary.h"
+#include "TreeTraceReader.h"
 
 namespace RevBayesCore {
 
@@ -16,15 +19,24 @@ namespace RevBayesCore {
          * Declaration of the TreeTrace class
          */
         TraceTree( bool c = true );
+        TraceTree( bool c, const std::shared_ptr<TreeTraceReader>& r );                   //!< Trace that streams its trees from a file
         TraceTree(const TraceTree& t );
         virtual ~TraceTree(){}
 
         TraceTree*                                 clone(void) const;
 
+        const Tree&                                objectAt(size_t index, bool post = false) const;      //!< Only valid until the next call if streaming
+        long                                       size(bool post = false) const;
+        bool                                       isStreaming(void) const { return reader != nullptr; };     //!< Are the trees parsed from the file on demand?
+
         int                                        isCoveredInInterval(const std::string &v, double size, bool verbose){ return (TreeSummary::isCoveredInInterval(v,size,verbose) ? 0 : -1); };
         int                                        isCoveredInInterval(const Tree &t, double size, bool verbose){ return (TreeSummary::isCoveredInInterval(t,size,verbose) ? 0 : -1); };
         bool                                       isDirty(void) const { return Trace<Tree>::isDirty(); };
         void                                       setDirty(bool d) { Trace<Tree>::setDirty(d); };
+
+        private:
+
+        std::shared_ptr<TreeTraceReader>           reader;                                 //!< The file the trees are read from, if streaming
     };
 
 }
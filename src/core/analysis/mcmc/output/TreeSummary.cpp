@@ -3,9 +3,11 @@
 #include <iomanip>
 #include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <iterator>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <set>
 #include <string>
@@ -23,6 +25,7 @@
 #include "RbMathCombinatorialFunctions.h"
 #include "RbVectorUtilities.h"
 #include "RlUserInterface.h"
+#include "RobinsonFouldsDistances.h"
 #include "StringUtilities.h"
 #include "TopologyNode.h"
 #include "TreeSummary.h"
@@ -31,6 +34,7 @@
 #include "RbBitSet.h"
 #include "Taxon.h"
 #include "TaxonMap.h"
+#include "ThreadPool.h"
 #include "Trace.h"
 #include "TraceTree.h"
 #include "Tree.h"
@@ -79,6 +83,53 @@ TreeSummary::TreeSummary( std::vector<TraceTree* > t, bool c ) :
 }
 
 
+/*
+ * TreeSummary copy constructor
+ */
+TreeSummary::TreeSummary( const TreeSummary& ts )
+{
+    *this = ts;
+}
+
+
+/*
+ * TreeSummary assignment operator.
+ * The sorted clade samples point to the keys of our own clade table, so we cannot copy them directly.
+ */
+TreeSummary& TreeSummary::operator=( const TreeSummary& ts )
+{
+    if ( this != &ts )
+    {
+        traces                  = ts.traces;
+        clock                   = ts.clock;
+        rooted                  = ts.rooted;
+        computed                = ts.computed;
+
+        clade_counts            = ts.clade_counts;
+        sampled_ancestor_counts = ts.sampled_ancestor_counts;
+        topology_ids            = ts.topology_ids;
+        topology_newicks        = ts.topology_newicks;
+        tree_counts             = ts.tree_counts;
+        tree_samples            = ts.tree_samples;
+
+        clade_ages              = ts.clade_ages;
+        conditional_clade_ages  = ts.conditional_clade_ages;
+        tree_clade_ages         = ts.tree_clade_ages;
+
+        outgroup                = ts.outgroup;
+
+        clade_samples.clear();
+        clade_samples.reserve( ts.clade_samples.size() );
+        for (auto& [clade, count]: ts.clade_samples)
+        {
+            clade_samples.push_back( Sample<const Split*>( &clade_counts.find( *clade )->first, count ) );
+        }
+    }
+
+    return *this;
+}
+
+
 /**
  * The clone function is a convenience function to create proper copies of inherited objected.
  * E.g. a.clone() will create a clone of the correct type even if 'a' is of derived type 'b'.
@@ -93,11 +144,27 @@ TreeSummary* TreeSummary::clone(void) const
 }
 
 
+size_t TreeSummary::SplitHash::operator()(const Split& s) const
+{
+
+    // combine the hashes as in boost::hash_combine
+    size_t h = RbBitSetHash()( s.first );
+
+    for (auto& taxon: s.second)
+    {
+        h ^= std::hash<std::string>()( taxon.getName() ) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+
+    return h;
+}
+
+
 // annotate the MAP node/branch parameters
 void TreeSummary::mapParameters( Tree &tree, bool verbose ) const
 {
 
-    const Tree& sample_tree = traces.front()->objectAt( 0 );
+    // copy the sample tree because a streamed trace only keeps the most recently accessed tree
+    const Tree sample_tree = traces.front()->objectAt( 0 );
 
     // first we annotate the node parameters
     // we need an internal node because the root might not have all parameter (e.g. rates)
@@ -644,13 +711,50 @@ void TreeSummary::mapContinuous(Tree &tree, const std::string &n, size_t paramIn
 }
 
 
+/*
+ * Add a single sampled tree to the tables.
+ * The tree is rerooted if necessary, so the caller passes a copy that it owns.
+ */
+void TreeSummary::addTreeSample( Tree &tree, const std::string &default_outgroup, SampleTables &tables ) const
+{
+
+    if ( rooted == false )
+    {
+        if ( outgroup )
+        {
+            tree.reroot( *outgroup, false, true );
+        }
+        else
+        {
+            tree.reroot( default_outgroup, false, true );
+        }
+    }
+
+    auto [it, inserted] = tables.topology_ids.emplace( tree.getPlainNewickRepresentation(), tables.topology_newicks.size() );
+    size_t topology = it->second;
+    if ( inserted == true )
+    {
+        tables.topology_newicks.push_back( it->first );
+        tables.tree_counts.push_back( 0 );
+        tables.tree_clade_ages.push_back( SplitAges() );
+    }
+
+    tables.tree_counts[topology]++;
+
+    // get the clades for this tree
+    RbBitSet b( tree.getNumberOfTips(), false );
+    collectTreeSample(tree.getRoot(), b, topology, tables);
+
+}
+
+
 void TreeSummary::annotateTree( Tree &tree, AnnotationReport report, bool verbose )
 {
     summarize( verbose );
 
     RBOUT("Annotating tree ...");
 
-    std::string newick;
+    long topology = -1;
 
     if ( report.conditional_tree_ages )
     {
@@ -683,11 +787,12 @@ void TreeSummary::annotateTree( Tree &tree, AnnotationReport report, bool verbos
             throw(RbException("Rooting of input tree differs from the tree sample"));
         }
 
-        newick = tmp_tree->getPlainNewickRepresentation();
+        auto it = topology_ids.find( tmp_tree->getPlainNewickRepresentation() );
+        topology = ( it == topology_ids.end() ? -1 : long(it->second) );
 
         delete tmp_tree;
 
-        if ( tree_clade_ages.find(newick) == tree_clade_ages.end() )
+        if ( topology < 0 )
         {
             throw(RbException("Could not find input tree in tree sample"));
         }
@@ -731,7 +836,7 @@ void TreeSummary::annotateTree( Tree &tree, AnnotationReport report, bool verbos
             Clade parent_clade = n->getParent().getClade();
             Split parent_split = Split( parent_clade.getBitRepresentation(), parent_clade.getMrca(), rooted);
 
-            std::map<Split, std::vector<double> >& condCladeAges = conditional_clade_ages[parent_split];
+            SplitAges& condCladeAges = conditional_clade_ages[parent_split];
             node_ages = report.conditional_clade_ages ? condCladeAges[split] : clade_ages[split];
 
             // annotate CCPs
@@ -749,7 +854,7 @@ void TreeSummary::annotateTree( Tree &tree, AnnotationReport report, bool verbos
 
         if ( report.conditional_tree_ages )
         {
-            node_ages = tree_clade_ages[newick][split];
+            node_ages = tree_clade_ages[topology][split];
         }
 
         // set the node ages/branch lengths
@@ -876,7 +981,7 @@ double TreeSummary::cladeProbability(const Clade &c, bool verbose )
 }
 
 
-TreeSummary::Split TreeSummary::collectTreeSample(const TopologyNode& n, RbBitSet& intaxa, std::string newick, std::map<Split, long>& cladeCountMap)
+TreeSummary::Split TreeSummary::collectTreeSample(const TopologyNode& n, RbBitSet& intaxa, size_t topology, SampleTables& tables) const
 {
     double age = (clock ? n.getAge() : n.getBranchLength() );
 
@@ -891,7 +996,7 @@ TreeSummary::Split TreeSummary::collectTreeSample(const TopologyNode& n, RbBitSe
 
         if ( rooted && n.isSampledAncestorTip() )
         {
-            sampled_ancestor_counts[n.getTaxon()]++;
+            tables.sampled_ancestor_counts[n.getTaxon()]++;
 
             mrca.insert( n.getTaxon() );
         }
@@ -902,7 +1007,7 @@ TreeSummary::Split TreeSummary::collectTreeSample(const TopologyNode& n, RbBitSe
         {
             const TopologyNode &child_node = n.getChild(i);
 
-            child_splits.push_back( collectTreeSample(child_node, taxa, newick, cladeCountMap) );
+            child_splits.push_back( collectTreeSample(child_node, taxa, topology, tables) );
 
             if ( rooted && child_node.isSampledAncestorTip() )
             {
@@ -918,20 +1023,20 @@ TreeSummary::Split TreeSummary::collectTreeSample(const TopologyNode& n, RbBitSe
     if ( taxa.size() > 0 )
     {
         // store the age for this split
-        clade_ages[parent_split].push_back( age );
+        tables.clade_ages[parent_split].push_back( age );
 
         // increment split count
-        cladeCountMap[parent_split]++;
+        tables.clade_counts[parent_split]++;
 
         // add conditional clade ages
         for (auto& child_split: child_splits)
         {
             // inserts new entries if doesn't already exist
-            conditional_clade_ages[parent_split][child_split].push_back( clade_ages[child_split].back() );
+            tables.conditional_clade_ages[parent_split][child_split].push_back( tables.clade_ages[child_split].back() );
         }
 
         // store the age for this split, conditional on the tree topology
-        tree_clade_ages[newick][parent_split].push_back( age );
+        tables.tree_clade_ages[topology][parent_split].push_back( age );
     }
 
     return parent_split;
@@ -947,7 +1052,7 @@ MatrixReal TreeSummary::computeConnectivity(double credible_interval_size, const
     NewickConverter converter;
     double total_prob = 0;
     double total_samples = sampleSize(true);
-    for (auto& [newick, count]: tree_samples | views::reverse)
+    for (auto& [topology, count]: tree_samples | views::reverse)
     {
         double freq = count;
         double p = freq/total_samples;
@@ -955,7 +1060,7 @@ MatrixReal TreeSummary::computeConnectivity(double credible_interval_size, const
 
         sample_count.push_back( freq );
 
-        Tree* current_tree = converter.convertFromNewick( newick );
+        Tree* current_tree = converter.convertFromNewick( topology_newicks[topology] );
         current_tree->makeInternalNodesBifurcating(true, true);
         unique_trees.push_back( current_tree );
         
@@ -1012,7 +1117,7 @@ double TreeSummary::computeEntropy( double credible_interval_size, int num_taxa,
     double total_samples = sampleSize(true);
     double entropy = 0.0;
     /*double tree_count = 0.0;*/
-    for (auto& [newick, count]: tree_samples | views::reverse )
+    for (auto& [topology, count]: tree_samples | views::reverse )
     {
         double freq = count;
         double p = freq/total_samples;
@@ -1037,72 +1142,16 @@ double TreeSummary::computeEntropy( double credible_interval_size, int num_taxa,
 std::vector<double> TreeSummary::computePairwiseRFDistance( double credible_interval_size, bool verbose )
 {
     summarize( verbose );
-    std::vector<Tree*> unique_trees;
-    std::vector< std::vector<RbBitSet>* > unique_trees_bs;
-    std::vector<size_t> sample_count;
-    NewickConverter converter;
-    double total_prob = 0;
-    double total_samples = sampleSize(true);
-    for (auto& [newick, count]: tree_samples | views::reverse)
-    {
-        double freq = count;
-        double p = freq/total_samples;
-        total_prob += p;
-
-        sample_count.push_back( freq );
-
-        Tree* current_tree = converter.convertFromNewick( newick );
-        current_tree->makeInternalNodesBifurcating(true, true);
-        unique_trees.push_back( current_tree );
-        
-        std::vector<RbBitSet>* this_clade_bs = new std::vector<RbBitSet>();
-        current_tree->getRoot().getAllClades(*this_clade_bs, current_tree->getNumberOfTips(), true);
-        unique_trees_bs.push_back( this_clade_bs );
-        
-        if ( total_prob >= credible_interval_size )
-        {
-            break;
-        }
-
-    }
-    
-    std::vector<double> rf_distances;
-    for (size_t i=0; i<unique_trees.size(); ++i)
-    {
-        // The unique tree occurs sample_count[i] times.
-        // Here we are treating them as coming in one continuous block, which is annoying.
-
-        for(int rep = 0;rep<sample_count[i];rep++)
-        {
-            // first we need to compare the tree to subsequent copies of itself
-            for (size_t k=rep+1; k<sample_count[i]; ++k )
-            {
-                rf_distances.push_back( 0.0 );
-            }
-
-            // then we compare it to copies of other trees
-            for (size_t j=i+1; j<unique_trees.size(); ++j)
-            {
-                std::vector<RbBitSet>* a = unique_trees_bs[i];
-                std::vector<RbBitSet>* b = unique_trees_bs[j];
-                double rf = TreeUtilities::computeRobinsonFouldDistance(*a, *b, true);
 
-                for (size_t k=0; k<sample_count[j]; ++k )
-                    rf_distances.push_back( rf );
-            }
-        }
-    }
+    return credibleSetRFDistances( credible_interval_size ).computeDistances();
+}
 
-    for (size_t i=0; i<unique_trees.size(); ++i)
-    {
-        Tree* tmp = unique_trees[i];
-        std::vector<RbBitSet>* this_clade_bs = unique_trees_bs[i];
 
-        delete tmp;
-        delete this_clade_bs;
-    }
+std::vector<double> TreeSummary::computePairwiseRFDistanceDistribution( double credible_interval_size, bool verbose )
+{
+    summarize( verbose );
 
-    return rf_distances;
+    return credibleSetRFDistances( credible_interval_size ).computeDistanceDistribution();
 }
 
 
@@ -1125,6 +1174,36 @@ std::vector<double> TreeSummary::computeTreeLengths( void )
 }
 
 
+/*
+ * Collect the most frequent topologies up to the given credible set size, weighted by their counts.
+ */
+RobinsonFouldsDistances TreeSummary::credibleSetRFDistances( double credible_interval_size ) const
+{
+    RobinsonFouldsDistances rf_distances;
+    NewickConverter converter;
+    double total_prob = 0;
+    double total_samples = sampleSize(true);
+    for (auto& [topology, count]: tree_samples | views::reverse)
+    {
+        double p = count/total_samples;
+        total_prob += p;
+
+        Tree* current_tree = converter.convertFromNewick( topology_newicks[topology] );
+        current_tree->makeInternalNodesBifurcating(true, true);
+        rf_distances.addTree( *current_tree, count );
+        delete current_tree;
+
+        if ( total_prob >= credible_interval_size )
+        {
+            break;
+        }
+
+    }
+
+    return rf_distances;
+}
+
+
 void TreeSummary::enforceNonnegativeBranchLengths(TopologyNode& node) const
 {
     std::vector<TopologyNode*> children = node.getChildren();
@@ -1239,16 +1318,16 @@ long TreeSummary::getTopologyCount(const RevBayesCore::Tree &tree, bool verbose)
 
     std::string newick = t.getPlainNewickRepresentation();
 
-    auto iter = tree_counts.find(newick);
-    if (iter == tree_counts.end())
+    auto it = topology_ids.find(newick);
+    if (it == topology_ids.end())
         return 0;
     else
-        return iter->second;
+        return tree_counts[it->second];
 }
 
 double TreeSummary::getTopologyFrequency(const RevBayesCore::Tree &tree, bool verbose)
 {
-    return getTopologyCount(tree,verbose)/sampleSize(true);
+    return double( getTopologyCount(tree,verbose) ) / sampleSize(true);
 }
 
 std::vector<Clade> TreeSummary::getUniqueClades( double min_clade_prob, bool non_trivial_only, bool verbose )
@@ -1262,8 +1341,9 @@ std::vector<Clade> TreeSummary::getUniqueClades( double min_clade_prob, bool non
     VectorUtilities::sort( ordered_taxa );
     size_t num_taxa = ordered_taxa.size();
 
-    for (auto& [clade, count]: clade_samples | views::reverse)
+    for (auto& [split, count]: clade_samples | views::reverse)
     {
+        const Split& clade = *split;
 
         double freq = count;
         double p    = freq/total_samples;
@@ -1296,13 +1376,13 @@ std::vector<Tree> TreeSummary::getUniqueTrees( double credible_interval_size, bo
     NewickConverter converter;
     double total_prob = 0;
     double total_samples = sampleSize(true);
-    for (auto& [newick, count]: tree_samples | views::reverse)
+    for (auto& [topology, count]: tree_samples | views::reverse)
     {
         double freq = count;
         double p =freq/total_samples;
         total_prob += p;
 
-        Tree* current_tree = converter.convertFromNewick( newick );
+        Tree* current_tree = converter.convertFromNewick( topology_newicks[topology] );
         current_tree->makeInternalNodesBifurcating(true, true);
         unique_trees.push_back( *current_tree );
         delete current_tree;
@@ -1350,7 +1430,8 @@ bool TreeSummary::isCoveredInInterval(const Tree &tree, double ci_size, bool ver
 
     RandomNumberGenerator *rng = GLOBAL_RNG;
 
-    std::string newick = tree.getPlainNewickRepresentation();
+    auto it = topology_ids.find( tree.getPlainNewickRepresentation() );
+    long topology = ( it == topology_ids.end() ? -1 : long(it->second) );
 
     double totalSamples = sampleSize(true);
     double totalProb = 0.0;
@@ -1364,7 +1445,7 @@ bool TreeSummary::isCoveredInInterval(const Tree &tree, double ci_size, bool ver
 
         if ( include_prob > rng->uniform01() )
         {
-            if ( newick == current_sample )
+            if ( topology == long(current_sample) )
             {
                 return true;
             }
@@ -1498,19 +1579,22 @@ double TreeSummary::maxdiff( bool verbose )
         throw RbException("At least 2 traces are required to compute maxdiff");
     }
 
-    std::set<Sample<Split> > splits_union;
+    std::set<Split> splits_union;
 
     for (auto& trace: traces)
     {
         trace->summarize(verbose);
 
-        splits_union.insert(trace->clade_samples.begin(), trace->clade_samples.end());
+        for (auto& [split, count]: trace->clade_samples)
+        {
+            splits_union.insert( *split );
+        }
     }
 
 
     double maxdiff = 0;
 
-    for (auto& [split, count]: splits_union)
+    for (auto& split: splits_union)
     {
         std::vector<double> split_freqs;
 
@@ -1548,7 +1632,7 @@ Tree* TreeSummary::mapTree( AnnotationReport report, bool verbose )
     summarize( verbose );
 
     // get the tree with the highest posterior probability
-    std::string bestNewick = tree_samples.rbegin()->first;
+    const std::string& bestNewick = topology_newicks[ tree_samples.rbegin()->first ];
     NewickConverter converter;
     Tree* tmp_best_tree = converter.convertFromNewick( bestNewick );
     tmp_best_tree->makeInternalNodesBifurcating(true,true);
@@ -1589,11 +1673,13 @@ Tree* TreeSummary::mccTree( AnnotationReport report, bool verbose )
     std::optional<double> max_cc;
 
     // find the clade credibility score for each tree
-    for (const auto& [newick, count]: tree_samples)
+    for (const auto& [topology, count]: tree_samples)
     {
+        const std::string& newick = topology_newicks[topology];
+
         // find the product of the clade frequencies
         double cc = 0;
-        for (auto& [clade, age]: tree_clade_ages.at(newick))
+        for (auto& [clade, age]: tree_clade_ages[topology])
             cc += log( splitFrequency(clade) );
 
         if (not max_cc or cc > *max_cc)
@@ -1628,6 +1714,82 @@ Tree* TreeSummary::mccTree( AnnotationReport report, bool verbose )
 }
 
 
+/*
+ * Merge the tables of a block of samples into the summary.
+ * Blocks must be merged in the order of the samples so that the ages are stored in sample order.
+ * The tables of the block are emptied.
+ */
+void TreeSummary::mergeSampleTables( SampleTables &t )
+{
+
+    // the first block can simply be taken over
+    if ( clade_counts.empty() == true && topology_newicks.empty() == true )
+    {
+        std::swap( clade_counts, t.clade_counts );
+        std::swap( sampled_ancestor_counts, t.sampled_ancestor_counts );
+        std::swap( topology_ids, t.topology_ids );
+        std::swap( topology_newicks, t.topology_newicks );
+        std::swap( tree_counts, t.tree_counts );
+        std::swap( clade_ages, t.clade_ages );
+        std::swap( conditional_clade_ages, t.conditional_clade_ages );
+        std::swap( tree_clade_ages, t.tree_clade_ages );
+
+        return;
+    }
+
+    for (auto& [clade, count]: t.clade_counts)
+    {
+        clade_counts[clade] += count;
+    }
+
+    for (auto& [taxon, count]: t.sampled_ancestor_counts)
+    {
+        sampled_ancestor_counts[taxon] += count;
+    }
+
+    for (auto& [clade, ages]: t.clade_ages)
+    {
+        std::vector<double>& all_ages = clade_ages[clade];
+        all_ages.insert( all_ages.end(), ages.begin(), ages.end() );
+    }
+
+    for (auto& [parent, children]: t.conditional_clade_ages)
+    {
+        SplitAges& all_children = conditional_clade_ages[parent];
+        for (auto& [child, ages]: children)
+        {
+            std::vector<double>& all_ages = all_children[child];
+            all_ages.insert( all_ages.end(), ages.begin(), ages.end() );
+        }
+    }
+
+    // the topology IDs of the block are translated into the IDs of the summary
+    for (size_t i = 0; i < t.topology_newicks.size(); ++i)
+    {
+        auto [it, inserted] = topology_ids.emplace( t.topology_newicks[i], topology_newicks.size() );
+        size_t topology = it->second;
+        if ( inserted == true )
+        {
+            topology_newicks.push_back( it->first );
+            tree_counts.push_back( 0 );
+            tree_clade_ages.push_back( SplitAges() );
+        }
+
+        tree_counts[topology] += t.tree_counts[i];
+
+        SplitAges& all_clades = tree_clade_ages[topology];
+        for (auto& [clade, ages]: t.tree_clade_ages[i])
+        {
+            std::vector<double>& all_ages = all_clades[clade];
+            all_ages.insert( all_ages.end(), ages.begin(), ages.end() );
+        }
+    }
+
+    t = SampleTables();
+
+}
+
+
 Tree* TreeSummary::mrTree(AnnotationReport report, double cutoff, bool verbose)
 {
     if (cutoff < 0.0 || cutoff > 1.0) cutoff = 0.5;
@@ -1662,8 +1824,10 @@ Tree* TreeSummary::mrTree(AnnotationReport report, double cutoff, bool verbose)
 
     double totalSamples = sampleSize(true);
 
-    for (const auto& [clade, count]: clade_samples | views::reverse)
+    for (const auto& [split, count]: clade_samples | views::reverse)
     {
+        const Split& clade = *split;
+
         float cladeFreq = count / totalSamples;
         if (cladeFreq < cutoff)  break;
 
@@ -1794,8 +1958,10 @@ void TreeSummary::printCladeSummary(std::ostream &o, double minCladeProbability,
     std::vector<Taxon> ordered_taxa = traces.front()->objectAt(0).getTaxa();
     VectorUtilities::sort( ordered_taxa );
 
-    for (auto& [clade, count]: clade_samples | views::reverse)
+    for (auto& [split, count]: clade_samples | views::reverse)
     {
+        const Split& clade = *split;
+
         Clade c(clade.first, ordered_taxa);
         c.setMrca(clade.second);
 
@@ -1882,7 +2048,7 @@ void TreeSummary::printTreeSummary(std::ostream &o, double credibleIntervalSize,
     o << "----------------------------------------------------------------" << std::endl;
     double totalSamples = sampleSize(true);
     double totalProb = 0.0;
-    for (auto& [newick, count]: tree_samples | views::reverse)
+    for (auto& [topology, count]: tree_samples | views::reverse)
     {
         double freq = count;
         double p = freq/totalSamples;
@@ -1912,7 +2078,7 @@ void TreeSummary::printTreeSummary(std::ostream &o, double credibleIntervalSize,
          StringUtilities::fillWithSpaces(s, 16, true);
          o << s;*/
 
-        o << newick;
+        o << topology_newicks[topology];
         o << std::endl;
 
         if ( totalProb >= credibleIntervalSize )
@@ -1982,6 +2148,8 @@ void TreeSummary::summarize( bool verbose )
     tree_clade_ages.clear();
 
     clade_counts.clear();
+    topology_ids.clear();
+    topology_newicks.clear();
     tree_counts.clear();
 
     ProgressBar progress = ProgressBar(sampleSize(true));
@@ -1992,68 +2160,105 @@ void TreeSummary::summarize( bool verbose )
         progress.start();
     }
 
-    size_t count = 0;
+    // split the samples of all traces into contiguous blocks
+    // each block is summarized into its own tables, which are merged in order afterwards
+    struct SampleBlock
+    {
+        TraceTree*  trace;
+        size_t      begin;
+        size_t      end;
+    };
 
+    ThreadPool& pool = ThreadPool::threadPoolInstance();
+    size_t num_blocks_per_trace = ( pool.isWorkerThread() ? 1 : 4 * pool.getNumberOfThreads() );
+
+    std::vector<SampleBlock> blocks;
     for (auto& trace: traces)
     {
-        for (size_t i = trace->getBurnin(); i < trace->size(); ++i)
+        size_t first = trace->getBurnin();
+        size_t last  = trace->size();
+        size_t block_size = (last - first + num_blocks_per_trace - 1) / num_blocks_per_trace;
+        for (size_t begin = first; begin < last; begin += block_size)
+        {
+            blocks.push_back( { trace, begin, std::min(begin + block_size, last) } );
+        }
+    }
+
+    std::vector<SampleTables> block_tables( blocks.size() );
+
+    // streamed traces keep only one parsed tree and therefore are read one tree at a time
+    std::mutex read_mutex;
+    std::mutex progress_mutex;
+    size_t count = 0;
+
+    pool.parallelFor( blocks.size(), [&](size_t b)
+    {
+        const SampleBlock& block = blocks[b];
+
+        for (size_t i = block.begin; i < block.end; ++i)
         {
             if ( verbose )
             {
+                std::lock_guard<std::mutex> lock( progress_mutex );
                 progress.update(count);
                 count++;
             }
 
-            Tree tree = trace->objectAt(i);
-
-            if ( rooted == false )
+            std::unique_lock<std::mutex> read_lock( read_mutex, std::defer_lock );
+            if ( block.trace->isStreaming() == true )
             {
-                if ( outgroup )
-                {
-                    tree.reroot( *outgroup, false, true );
-                }
-                else
-                {
-                    tree.reroot( this_outgroup, false, true );
-                }
+                read_lock.lock();
             }
 
-            std::string newick = tree.getPlainNewickRepresentation();
+            Tree tree = block.trace->objectAt(i);
 
-            tree_counts[newick]++;
+            if ( read_lock.owns_lock() == true )
+            {
+                read_lock.unlock();
+            }
 
-            // get the clades for this tree
-            RbBitSet b( tree.getNumberOfTips(), false );
-            collectTreeSample(tree.getRoot(), b, newick, clade_counts);
+            addTreeSample( tree, this_outgroup, block_tables[b] );
         }
+    });
+
+    for (auto& tables: block_tables)
+    {
+        mergeSampleTables( tables );
     }
 
     // FIXME: Lots of the loops we do use reverse iterators.
     //
     //        so maybe sort in order of descending frequency instead?
 
-    // FIXME: Storing a second copy of everything just to know the order  wastes memory.
-    //
-    //        Possibly store the clades (and trees) in a vector, and then make
-    //        clade_counts/clade_samples (and tree_counts/tree_samples) just refer to the
-    //        index in the vector.
-    
     // sort the clade samples in ascending frequency
+    // the samples point to the splits in clade_counts, so every split is stored only once
+    clade_samples.reserve( clade_counts.size() );
     for (auto& [clade, count]: clade_counts)
     {
-//        if ( it->first.first.count() > 0 )
-//        if ( it->first.first.count() > 0 && it->first.first.count() < (num_taxa-1) )
-        {
-            clade_samples.insert( Sample<Split>(clade, count) );
-        }
-
+        clade_samples.push_back( Sample<const Split*>(&clade, count) );
     }
+    std::sort( clade_samples.begin(), clade_samples.end(), [](const Sample<const Split*>& a, const Sample<const Split*>& b)
+    {
+        if ( a.second == b.second )
+            return *a.first < *b.first;
+        else
+            return a.second < b.second;
+    });
 
     // sort the tree samples in ascending frequency
-    for (auto& [tree, count]: tree_counts)
+    // trees with the same frequency are ordered by their newick string
+    tree_samples.reserve( tree_counts.size() );
+    for (size_t i = 0; i < tree_counts.size(); ++i)
     {
-        tree_samples.insert( {tree, count} );
+        tree_samples.push_back( Sample<size_t>(i, tree_counts[i]) );
     }
+    std::sort( tree_samples.begin(), tree_samples.end(), [&](const Sample<size_t>& a, const Sample<size_t>& b)
+    {
+        if ( a.second == b.second )
+            return topology_newicks[a.first] < topology_newicks[b.first];
+        else
+            return a.second < b.second;
+    });
 
     // finish progress bar
     if ( verbose )
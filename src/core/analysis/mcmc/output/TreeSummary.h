@@ -1,7 +1,12 @@
 #ifndef TreeSummary_H
 #define TreeSummary_H
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "Clade.h"
+#include "RobinsonFouldsDistances.h"
 #include "Trace.h"
 #include "Tree.h"
 
@@ -42,6 +47,17 @@ namespace RevBayesCore {
             }
         };
 
+        /*
+         * This struct computes a 64-bit hash of a split from the blocks of its bitset and its sampled ancestors.
+         * Hash tables compare the splits themselves on collision.
+         */
+        struct SplitHash
+        {
+            size_t operator()(const Split& s) const;
+        };
+
+        typedef std::unordered_map<Split, std::vector<double>, SplitHash>    SplitAges;
+
     public:
 
         /*
@@ -68,14 +84,18 @@ namespace RevBayesCore {
          */
         TreeSummary( TraceTree* t, bool c = true );
         TreeSummary( std::vector<TraceTree* > t, bool c = true );
+        TreeSummary( const TreeSummary& ts );
         virtual ~TreeSummary(){}
 
+        TreeSummary&                               operator=(const TreeSummary& ts);
+
         TreeSummary*                               clone(void) const;
         void                                       annotateTree(Tree &inputTree, AnnotationReport report, bool verbose );
         double                                     cladeProbability(const Clade &c, bool verbose);
         MatrixReal                                 computeConnectivity( double credible_interval_size, const std::string& m, bool verbose );
         double                                     computeEntropy( double credible_interval_size, int num_taxa, bool verbose );
         std::vector<double>                        computePairwiseRFDistance( double credible_interval_size, bool verbose );
+        std::vector<double>                        computePairwiseRFDistanceDistribution( double credible_interval_size, bool verbose );     //!< The number of sample pairs for each RF distance
         std::vector<double>                        computeTreeLengths(void);
         std::vector<Clade>                         getUniqueClades(double ci=0.95, bool non_trivial_only=true, bool verbose=true);
         std::vector<Tree>                          getUniqueTrees(double ci=0.95, bool verbose=true);
@@ -97,13 +117,31 @@ namespace RevBayesCore {
 
     protected:
 
-        Split                                      collectTreeSample(const TopologyNode&, RbBitSet&, std::string, std::map<Split, long>&);
+        /*
+         * The clade and tree tables collected from a contiguous block of samples
+         */
+        struct SampleTables
+        {
+            std::unordered_map<Split, long, SplitHash>                      clade_counts;
+            std::map<Taxon, long >                                          sampled_ancestor_counts;
+            std::unordered_map<std::string, size_t>                         topology_ids;
+            std::vector<std::string>                                        topology_newicks;
+            std::vector<long>                                               tree_counts;
+            SplitAges                                                       clade_ages;
+            std::unordered_map<Split, SplitAges, SplitHash>                 conditional_clade_ages;
+            std::vector<SplitAges>                                          tree_clade_ages;
+        };
+
+        void                                       addTreeSample(Tree& tree, const std::string& default_outgroup, SampleTables& tables) const;
+        Split                                      collectTreeSample(const TopologyNode&, RbBitSet&, size_t, SampleTables&) const;
+        RobinsonFouldsDistances                    credibleSetRFDistances(double credible_interval_size) const;
         void                                       enforceNonnegativeBranchLengths(TopologyNode& tree) const;
         TopologyNode*                              findParentNode(TopologyNode&, const Split &, std::vector<TopologyNode*>&, RbBitSet& ) const;
         double                                     jointSplitFrequency(const std::vector<Split>& s) const;
         void                                       mapContinuous(Tree &inputTree, const std::string &n, size_t paramIndex, double hpd, bool np, bool verbose ) const;
         void                                       mapDiscrete(Tree &inputTree, const std::string &n, size_t paramIndex, size_t num, bool np, bool verbose ) const;
         void                                       mapParameters(Tree &inputTree, bool verbose) const;
+        void                                       mergeSampleTables(SampleTables& t);
         long                                       splitCount(const Split &n) const;
         double                                     splitFrequency(const Split &n) const;
         void                                       summarize(bool verbose);
@@ -114,15 +152,17 @@ namespace RevBayesCore {
         bool                                       rooted;
 
         bool                                       computed = false;
-        std::map<Split, long>                      clade_counts;
-        std::set<Sample<Split> >                   clade_samples;
+        std::unordered_map<Split, long, SplitHash> clade_counts;
+        std::vector<Sample<const Split*> >         clade_samples;                          //!< The sampled splits in ascending frequency (pointing to the keys of clade_counts)
         std::map<Taxon, long >                     sampled_ancestor_counts;
-        std::map<std::string, long>                tree_counts;
-        std::set<Sample<std::string> >             tree_samples;
-
-        std::map<Split, std::vector<double> >                           clade_ages;
-        std::map<Split, std::map<Split, std::vector<double> > >         conditional_clade_ages;
-        std::map<std::string, std::map<Split, std::vector<double> > >   tree_clade_ages;
+        std::unordered_map<std::string, size_t>    topology_ids;                           //!< The ID of each sampled topology, by its newick string
+        std::vector<std::string>                   topology_newicks;                       //!< The newick string of each topology ID
+        std::vector<long>                          tree_counts;                            //!< The count of each topology ID
+        std::vector<Sample<size_t> >               tree_samples;                           //!< The topology IDs in ascending frequency
+
+        SplitAges                                                       clade_ages;
+        std::unordered_map<Split, SplitAges, SplitHash>                 conditional_clade_ages;
+        std::vector<SplitAges>                                          tree_clade_ages;        //!< The split ages of each topology ID
 
         boost::optional<Clade>                     outgroup;
     };
@@ -0,0 +1,258 @@
+#include "TreeTraceReader.h"
+
+#include "BinaryTraceReader.h"
+#include "NewickConverter.h"
+#include "RbException.h"
+#include "StringUtilities.h"
+#include "Tree.h"
+#include "TreeUtilities.h"
+
+using namespace RevBayesCore;
+
+
+/**
+ * Construct the reader and index the retained samples.
+ *
+ * The header is read to find the tree column, which is the first column that is not
+ * the posterior, likelihood, prior or replicate ID. Samples are retained using the same
+ * offset and thinning as when the whole trace is read into memory.
+ */
+TreeTraceReader::TreeTraceReader(const path &fn, const std::string &d, bool c, bool u, long thinning, long offset) :
+    clock( c ),
+    unroot_nonclock( u ),
+    delimiter( d ),
+    file_name( fn ),
+    tree_column( 0 ),
+    current_tree( NULL ),
+    current_index( 0 )
+{
+
+    if ( BinaryTraceReader::isBinaryTraceFile(fn) == true )
+    {
+        binary_reader = std::make_unique<BinaryTraceReader>( fn );
+
+        const std::vector<std::string> &columns = binary_reader->getColumnNames();
+        for (size_t j=1; j<columns.size(); j++)
+        {
+            const std::string &parm_name = columns[j];
+            if ( parm_name == "Posterior" || parm_name == "Likelihood" || parm_name == "Prior" || parm_name == "Replicate_ID")
+            {
+                continue;
+            }
+            tree_column = j;
+            parameter_name = parm_name;
+
+            break;
+        }
+
+        for (size_t n_samples = 1; n_samples <= binary_reader->getNumberOfRows(); ++n_samples)
+        {
+            if ( (double(n_samples)-offset) <= 0 || (n_samples-1-offset) % thinning > 0 )
+            {
+                continue;
+            }
+
+            sample_positions.push_back( std::streamoff(n_samples - 1) );
+        }
+
+        return;
+    }
+
+    in_file.open( fn.string() );
+
+    if ( !in_file )
+    {
+        throw RbException()<<"Could not open file "<<fn;
+    }
+
+    bool has_header_been_read = false;
+    size_t n_samples = 0;
+
+    while ( in_file.good() )
+    {
+        // remember where this line starts
+        std::streamoff pos = in_file.tellg();
+
+        std::string line;
+        safeGetline(in_file, line);
+
+        // skip empty lines and comments
+        if ( line.length() == 0 || line[0] == '#' )
+        {
+            continue;
+        }
+
+        // we assume a header at the first line of the file
+        if ( has_header_been_read == false )
+        {
+            std::vector<std::string> columns;
+            StringUtilities::stringSplit(line, delimiter, columns);
+
+            for (size_t j=1; j<columns.size(); j++)
+            {
+                const std::string &parm_name = columns[j];
+                if ( parm_name == "Posterior" || parm_name == "Likelihood" || parm_name == "Prior" || parm_name == "Replicate_ID")
+                {
+                    continue;
+                }
+                tree_column = j;
+                parameter_name = parm_name;
+
+                break;
+            }
+
+            has_header_been_read = true;
+
+            continue;
+        }
+
+        // increase our sample counter
+        ++n_samples;
+
+        // we need to check if we skip this sample in case of skipping.
+        if ( (double(n_samples)-offset) <= 0 )
+        {
+            continue;
+        }
+
+        // we need to check if we skip this sample in case of thinning.
+        if ( (n_samples-1-offset) % thinning > 0 )
+        {
+            continue;
+        }
+
+        sample_positions.push_back( pos );
+    }
+
+    // clear the end-of-file state so that we can seek to the samples
+    in_file.clear();
+
+}
+
+
+/**
+ * Copy the reader.
+ * The copy reuses the index of the samples, but reads them through its own file stream and keeps its own parsed tree.
+ */
+TreeTraceReader::TreeTraceReader(const TreeTraceReader &r) :
+    clock( r.clock ),
+    unroot_nonclock( r.unroot_nonclock ),
+    delimiter( r.delimiter ),
+    file_name( r.file_name ),
+    tree_column( r.tree_column ),
+    parameter_name( r.parameter_name ),
+    sample_positions( r.sample_positions ),
+    current_tree( NULL ),
+    current_index( 0 )
+{
+
+    if ( r.binary_reader != NULL )
+    {
+        binary_reader = std::make_unique<BinaryTraceReader>( file_name );
+        return;
+    }
+
+    in_file.open( file_name.string() );
+
+    if ( !in_file )
+    {
+        throw RbException()<<"Could not open file "<<file_name;
+    }
+
+}
+
+
+TreeTraceReader::~TreeTraceReader( void )
+{
+
+    delete current_tree;
+
+}
+
+
+const path& TreeTraceReader::getFileName( void ) const
+{
+    return file_name;
+}
+
+
+size_t TreeTraceReader::getNumberOfSamples( void ) const
+{
+    return sample_positions.size();
+}
+
+
+const std::string& TreeTraceReader::getParameterName( void ) const
+{
+    return parameter_name;
+}
+
+
+/**
+ * Get the i-th retained tree.
+ * The returned reference stays valid until a different tree is requested.
+ */
+const Tree& TreeTraceReader::getTree(size_t i) const
+{
+
+    if ( i >= sample_positions.size() )
+    {
+        throw RbException()<<"Cannot access tree "<<(i+1)<<" because the trace of file "<<file_name<<" only has "<<sample_positions.size()<<" trees.";
+    }
+
+    if ( current_tree != NULL && current_index == i )
+    {
+        return *current_tree;
+    }
+
+    Tree *tau = NULL;
+    if ( binary_reader != NULL )
+    {
+        tau = parseTree( binary_reader->getString( size_t(sample_positions[i]), tree_column ) );
+    }
+    else
+    {
+        in_file.clear();
+        in_file.seekg( sample_positions[i] );
+
+        std::string line;
+        safeGetline(in_file, line);
+
+        std::vector<std::string> columns;
+        StringUtilities::stringSplit(line, delimiter, columns);
+
+        if ( tree_column >= columns.size() )
+        {
+            throw RbException()<<"Could not find the tree of sample "<<(i+1)<<" in file "<<file_name;
+        }
+
+        tau = parseTree( columns[tree_column] );
+    }
+
+    delete current_tree;
+    current_tree  = tau;
+    current_index = i;
+
+    return *current_tree;
+}
+
+
+Tree* TreeTraceReader::parseTree(const std::string &newick) const
+{
+
+    NewickConverter c;
+    Tree *tau = c.convertFromNewick( newick );
+
+    if ( clock == true )
+    {
+        Tree *bl_tree = tau;
+        tau = TreeUtilities::convertTree( *bl_tree );
+        delete bl_tree;
+    }
+    else if ( unroot_nonclock == true )
+    {
+        tau->removeRootIfDegree2();
+    }
+
+    return tau;
+}
@@ -0,0 +1,65 @@
+#ifndef TreeTraceReader_H
+#define TreeTraceReader_H
+
+#include <cstddef>
+#include <fstream>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "RbFileManager.h"
+
+namespace RevBayesCore {
+
+    class BinaryTraceReader;
+    class Tree;
+
+    /**
+     * @brief Lazy reader for delimited and binary tree trace files.
+     *
+     * The reader scans the file once and only remembers the position of every retained line
+     * (i.e., after the offset and thinning were applied). Lines that are skipped are never split
+     * or parsed, and a tree is only parsed from its newick string when it is requested.
+     * For binary traces the row of every retained sample is remembered instead and the newick strings
+     * are decompressed one block at a time.
+     * The most recently requested tree is kept, so a trace of any length is summarized in bounded memory.
+     *
+     * The reader keeps an open file stream and a cached tree and is therefore not thread safe.
+     * A copy shares nothing with the original but opens its own stream, so copies can be used concurrently.
+     */
+    class TreeTraceReader {
+
+    public:
+        TreeTraceReader(const path &fn, const std::string &d, bool c, bool u, long thinning, long offset);     //!< Index the samples of the file
+        TreeTraceReader(const TreeTraceReader &r);                                                              //!< Reuse the index but open a new stream
+        virtual                                    ~TreeTraceReader(void);
+
+        const path&                                 getFileName(void) const;
+        size_t                                      getNumberOfSamples(void) const;                             //!< The number of retained samples
+        const std::string&                          getParameterName(void) const;                               //!< The name of the tree column
+        const Tree&                                 getTree(size_t i) const;                                    //!< Get the i-th retained tree (parsed on demand)
+
+    private:
+        TreeTraceReader&                            operator=(const TreeTraceReader &r);                        //!< The stream cannot be assigned
+
+        Tree*                                       parseTree(const std::string &newick) const;
+
+        bool                                        clock;
+        bool                                        unroot_nonclock;
+        std::string                                 delimiter;
+        path                                        file_name;
+        size_t                                      tree_column;
+        std::string                                 parameter_name;
+        std::vector<std::streamoff>                 sample_positions;                                           //!< The position of each retained line in the file (or its row in a binary trace)
+
+        std::unique_ptr<BinaryTraceReader>          binary_reader;                                              //!< The reader of a binary trace (NULL for delimited files)
+
+        mutable std::ifstream                       in_file;
+        mutable Tree*                               current_tree;
+        mutable size_t                              current_index;
+    };
+
+}
+
+#endif
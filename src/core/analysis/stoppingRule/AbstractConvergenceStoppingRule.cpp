@@ -4,6 +4,9 @@
 #include "AbstractConvergenceStoppingRule.h"
 #include "BurninEstimatorContinuous.h"
 #include "StoppingRule.h"
+#include "StringUtilities.h"
+#include "TraceContinuousReader.h"
+#include "TraceNumeric.h"
 
 
 using namespace RevBayesCore;
@@ -23,7 +26,8 @@ AbstractConvergenceStoppingRule::AbstractConvergenceStoppingRule(const AbstractC
     burninEst( sr.burninEst->clone() ),
     checkFrequency( sr.checkFrequency ),
     filename( sr.filename ),
-    numReplicates( sr.numReplicates )
+    numReplicates( sr.numReplicates ),
+    online_traces( sr.online_traces )
 {
     
 }
@@ -51,6 +55,7 @@ AbstractConvergenceStoppingRule& AbstractConvergenceStoppingRule::operator=(cons
         checkFrequency  = sr.checkFrequency;
         filename        = sr.filename;
         numReplicates   = sr.numReplicates;
+        online_traces   = sr.online_traces;
         
     }
     
@@ -69,6 +74,73 @@ bool AbstractConvergenceStoppingRule::checkAtIteration(size_t g) const
 }
 
 
+/**
+ * Get the name of the trace file of the i-th replicate (starting at 1).
+ */
+path AbstractConvergenceStoppingRule::getReplicateFileName(size_t i) const
+{
+    
+    if ( numReplicates > 1 )
+    {
+        return appendToStem(filename, "_run_" + StringUtilities::to_string(i));
+    }
+    
+    return filename;
+}
+
+
+/**
+ * Get the statistics of all columns of the trace of the i-th replicate (starting at 1).
+ * We use the running statistics of the monitor if possible and otherwise read the trace file.
+ * The burnin of all columns is set to the largest burnin estimate.
+ */
+std::vector<OnlineTraceStatistics>& AbstractConvergenceStoppingRule::getReplicateStatistics(size_t i)
+{
+    
+    std::vector<OnlineTraceStatistics>* statistics = &file_statistics;
+    if ( i <= online_traces.size() && online_traces[i-1]->state == OnlineTrace::ACTIVE )
+    {
+        statistics = &online_traces[i-1]->columns;
+    }
+    else
+    {
+        TraceContinuousReader reader = TraceContinuousReader( getReplicateFileName(i) );
+        std::vector<TraceNumeric> &data = reader.getTraces();
+        
+        file_statistics.clear();
+        file_statistics.resize( data.size() );
+        for ( size_t j = 0; j < data.size(); ++j)
+        {
+            for (double v: data[j].getValues())
+            {
+                file_statistics[j].addValue( v );
+            }
+        }
+    }
+    
+    size_t maxBurnin = 0;
+    
+    // find the max burnin
+    for ( size_t j = 0; j < statistics->size(); ++j)
+    {
+        size_t b = burninEst->estimateBurnin( (*statistics)[j] );
+        
+        if ( maxBurnin < b )
+        {
+            maxBurnin = b;
+        }
+    }
+    
+    // set the burnins
+    for ( size_t j = 0; j < statistics->size(); ++j)
+    {
+        (*statistics)[j].setBurnin( maxBurnin );
+    }
+    
+    return *statistics;
+}
+
+
 /**
  * Is this a stopping rule? Yes!
  */
@@ -79,11 +151,18 @@ bool AbstractConvergenceStoppingRule::isConvergenceRule( void ) const
 
 
 /**
- * The run just started. For this rule we do not need to do anything.
+ * The run just started. We observe the trace file of each replicate,
+ * so that the monitors that write these files keep the running statistics for us.
  */
 void AbstractConvergenceStoppingRule::runStarted( void )
 {
-    // nothing to do
+    
+    online_traces.clear();
+    for ( size_t i = 1; i <= numReplicates; ++i)
+    {
+        online_traces.push_back( OnlineTraceRegistry::onlineTraceRegistryInstance().observe( getReplicateFileName(i) ) );
+    }
+    
 }
 
 
@@ -2,9 +2,12 @@
 #define AbstractConvergenceStoppingRule_H
 
 #include "BurninEstimatorContinuous.h"
+#include "OnlineTraceRegistry.h"
+#include "OnlineTraceStatistics.h"
 #include "StoppingRule.h"
 #include "RbFileManager.h"
 
+#include <memory>
 #include <vector>
 
 namespace RevBayesCore {
@@ -15,6 +18,11 @@ namespace RevBayesCore {
      * This class provides the abstract base class for (all) convergence stopping rules.
      * This is, we provide some common member variables and some common virtual function.
      *
+     * The rules observe the trace file of each replicate (see OnlineTraceRegistry) when the run starts.
+     * Then the monitor that writes the file keeps running statistics of all samples, and a check needs
+     * neither to read the file nor to look at every sample. If no monitor of this process writes the file
+     * (e.g., because the replicate runs on another process), the file is read instead.
+     *
      *
      * @copyright Copyright 2009-
      * @author The RevBayes Development Core Team (Sebastian Hoehna)
@@ -33,7 +41,7 @@ namespace RevBayesCore {
         // public methods
         virtual bool                                        checkAtIteration(size_t g) const;                           //!< Should we check for convergence at the given iteration?
         virtual bool                                        isConvergenceRule(void) const;                              //!< No, this is a threshold rule.
-        virtual void                                        runStarted(void);                                           //!< The run just started. Here we do not need to do anything.
+        virtual void                                        runStarted(void);                                           //!< The run just started. Here we observe the trace files.
         virtual void                                        setNumberOfRuns(size_t n);                                  //!< Set how many runs/replicates there are.
 
         virtual AbstractConvergenceStoppingRule*            clone(void) const = 0;                                          //!< Clone function. This is similar to the copy constructor but useful in inheritance.
@@ -41,10 +49,15 @@ namespace RevBayesCore {
         
     protected:
         
+        path                                                getReplicateFileName(size_t i) const;                       //!< The trace file of the i-th replicate (starting at 1)
+        std::vector<OnlineTraceStatistics>&                 getReplicateStatistics(size_t i);                           //!< The statistics of the i-th replicate (starting at 1) with the estimated burnin
+        
         BurninEstimatorContinuous*                          burninEst;                                                  //!< The method for estimating the burnin
         size_t                                              checkFrequency;                                             //!< The frequency for checking for convergence
         path                                                filename;                                                   //!< The filename from which to read in the data
+        std::vector<OnlineTraceStatistics>                  file_statistics;                                            //!< The statistics of the last trace file that we had to read
         size_t                                              numReplicates;
+        std::vector< std::shared_ptr<OnlineTrace> >         online_traces;                                              //!< The running statistics of each replicate
         
     };
     
@@ -5,13 +5,10 @@
 
 #include "EssTest.h"
 #include "MinEssStoppingRule.h"
-#include "RbFileManager.h"
-#include "StringUtilities.h"
-#include "TraceContinuousReader.h"
 #include "AbstractConvergenceStoppingRule.h"
 #include "BurninEstimatorContinuous.h"
 #include "Cloner.h"
-#include "TraceNumeric.h"
+#include "OnlineTraceStatistics.h"
 
 
 using namespace RevBayesCore;
@@ -55,35 +52,13 @@ bool MinEssStoppingRule::stop( size_t g )
     
     for ( size_t i = 1; i <= numReplicates; ++i)
     {
-        path fn = filename;
-        if ( numReplicates > 1 )
-            fn = appendToStem(filename, "_run_" + StringUtilities::to_string(i));
-        
-        TraceContinuousReader reader = TraceContinuousReader( fn );
-    
-        // get the vector of traces from the reader
-        std::vector<TraceNumeric> &data = reader.getTraces();
-    
-        size_t maxBurnin = 0;
-    
-        // find the max burnin
-        for ( size_t j = 0; j < data.size(); ++j)
-        {
-            size_t b = burninEst->estimateBurnin( data[j] );
-
-            if ( maxBurnin < b )
-            {
-                maxBurnin = b;
-            }
-        }
+        std::vector<OnlineTraceStatistics> &data = getReplicateStatistics( i );
     
         EssTest essTest = EssTest( minEss );
         
-        // set the burnins and conduct the tests
+        // conduct the tests
         for ( size_t j = 0; j < data.size(); ++j)
         {
-            data[j].setBurnin( maxBurnin );
-        
             passed &= essTest.assessConvergence( data[j] );
         }
         
@@ -6,13 +6,10 @@
 #include "StationarityTest.h"
 #include "StationarityStoppingRule.h"
 #include "RbException.h"
-#include "RbFileManager.h"
-#include "StringUtilities.h"
-#include "TraceContinuousReader.h"
 #include "AbstractConvergenceStoppingRule.h"
 #include "BurninEstimatorContinuous.h"
 #include "Cloner.h"
-#include "TraceNumeric.h"
+#include "OnlineTraceStatistics.h"
 
 
 using namespace RevBayesCore;
@@ -72,37 +69,9 @@ bool StationarityStoppingRule::stop( size_t g )
 
     bool passed = true;
     
-    std::vector<std::vector<std::vector<double> > > values;
-    std::vector<std::vector<size_t> > burnins;
     for ( size_t i = 1; i <= numReplicates; ++i)
     {
-        path fn = filename;
-        if ( numReplicates > 1 )
-            fn = appendToStem(filename, "_run_" + StringUtilities::to_string(i));
-        
-        TraceContinuousReader reader = TraceContinuousReader( fn );
-        
-        // get the vector of traces from the reader
-        std::vector<TraceNumeric> &data = reader.getTraces();
-        
-        size_t maxBurnin = 0;
-        
-        // find the max burnin
-        for ( size_t j = 0; j < data.size(); ++j)
-        {
-            size_t b = burninEst->estimateBurnin( data[j] );
-
-            if ( maxBurnin < b )
-            {
-                maxBurnin = b;
-            }
-        }
-        
-        // set the burnins
-        for ( size_t j = 0; j < data.size(); ++j)
-        {
-            data[j].setBurnin( maxBurnin );
-        }
+        std::vector<OnlineTraceStatistics> &data = getReplicateStatistics( i );
 
         // conduct the test
         passed &= sTest.assessConvergence(data);
@@ -623,6 +623,16 @@ bool DagNode::isIntegratedOut( void ) const
 }
 
 
+/**
+ * Append the value of this variable as real numbers (one per flattened element) to the vector.
+ * Returns false if the value is not numeric, in which case the vector is not changed.
+ */
+bool DagNode::getValueAsNumbers( std::vector<double> & /*v*/ ) const
+{
+    return false;
+}
+
+
 /**
  * Is this variable a simple numeric variable?
  * This is asked for example by the model monitor that only wants to monitor simple numeric variable
@@ -1108,3 +1118,16 @@ void DagNode::touchAffected(bool touchAll)
         child->touchMe( this, touchAll );
     }
 }
+
+
+/**
+ * Bring the value of this node up to date.
+ * Only deterministic nodes compute their value lazily, so by default there is nothing to do.
+ * After this call the value can be read concurrently by several threads (e.g. by children that compute their probabilities in parallel),
+ * unless we return false because the value is recomputed at every access.
+ */
+bool DagNode::updateValue( void ) const
+{
+    
+    return true;
+}
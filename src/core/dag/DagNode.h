@@ -89,6 +89,7 @@ template <class valueType> class RbOrderedSet;
         virtual std::vector<const DagNode*>                         getParents(void) const;                                                                     //!< Get the set of parents (empty set here)
         size_t                                                      getReferenceCount(void) const;                                                              //!< Get the reference count for reference counting in smart pointers
         const std::set<size_t>&                                     getTouchedElementIndices(void) const;                                                       //!< Get the indices of the touches elements. If the set is empty, then all elements might have changed.
+        virtual bool                                                getValueAsNumbers(std::vector<double> &v) const;                                            //!< Append the value as real numbers if it is numeric, e.g., for binary monitors
         bool                                                        getVisitFlag(const size_t flagType) const;
         void                                                        incrementReferenceCount(void) const;                                                        //!< Increment the reference count for reference counting in smart pointers
         void                                                        initiateGetAffectedNodes(RbOrderedSet<DagNode *>& affected);                                        //!< get affected nodes
@@ -125,6 +126,7 @@ template <class valueType> class RbOrderedSet;
         virtual void                                                swapParent(const DagNode *oldP, const DagNode *newP);                                       //!< Exchange the parent node which includes setting myself as a child of the new parent and removing myself from my old parents children list
         void                                                        touch(bool touchAll=false);
         virtual void                                                touchAffected(bool touchAll=false);                                                         //!< Touch affected nodes (flag for recalculation)
+        virtual bool                                                updateValue(void) const;                                                                    //!< Bring a lazily computed value up to date. Returns false if the value is recomputed at every access.
 
     protected:
                                                                     DagNode(const std::string &n);                                                              //!< Constructor
@@ -33,6 +33,7 @@ namespace RevBayesCore {
         void                                                setMcmcMode(bool tf);                                                       //!< Set the modus of the DAG node to MCMC mode.
         void                                                setValueFromFile(const path &dir);                                          //!< Set value from string.
         void                                                setValueFromString(const std::string &v);                                   //!< Set value from string.
+        bool                                                updateValue(void) const;                                                    //!< Bring the lazily computed value up to date
 
         // Parent DAG nodes management functions
         virtual std::vector<const DagNode*>                 getParents(void) const;                                                     //!< Get the set of parents
@@ -505,4 +506,19 @@ void RevBayesCore::DeterministicNode<valueType>::touchMe( const DagNode *toucher
 }
 
 
+/**
+ * Bring our value up to date so that it can be read concurrently.
+ * This also updates all deterministic ancestors because the function reads the values of its parameters.
+ * If the function forces an update at every access, then concurrent reads are not safe and we return false.
+ */
+template<class valueType>
+bool RevBayesCore::DeterministicNode<valueType>::updateValue( void ) const
+{
+
+    getValue();
+
+    return force_update == false;
+}
+
+
 #endif
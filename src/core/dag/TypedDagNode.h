@@ -27,6 +27,7 @@ namespace RevBayesCore {
         virtual size_t                                      getNumberOfElements(void) const;                                                                            //!< Get the number of elements for this value
         virtual std::string                                 getValueAsString(void) const;
         virtual nlohmann::json                              getValueAsJSON(void) const;
+        virtual bool                                        getValueAsNumbers(std::vector<double> &v) const;                                                            //!< Append the value as real numbers if it is numeric
         virtual bool                                        isSimpleNumeric(void) const;                                                                                //!< Is this variable a simple numeric variable? Currently only integer and real number are.
         virtual void                                        printName(std::ostream &o, const std::string &sep, int l=-1, bool left=true, bool fv=true) const;           //!< Monitor/Print this variable
         virtual void                                        printValue(std::ostream &o, const std::string &sep, int l=-1, bool left=true, bool user=true, bool simple=true, bool flatten=true) const;  //!< Monitor/Print this variable
@@ -162,6 +163,30 @@ nlohmann::json RevBayesCore::TypedDagNode<valueType>::getValueAsJSON(void) const
 }
 
 
+template <class valueType>
+bool RevBayesCore::TypedDagNode<valueType>::getValueAsNumbers(std::vector<double> &v) const
+{
+    if constexpr (std::is_arithmetic_v<valueType>)
+    {
+        v.push_back( double(getValue()) );
+        return true;
+    }
+    else if constexpr (std::is_base_of_v<std::vector<double>,valueType> || std::is_base_of_v<std::vector<long>,valueType>)
+    {
+        const valueType& x = getValue();
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            v.push_back( double(x[i]) );
+        }
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+
 template<class valueType>
 bool RevBayesCore::TypedDagNode<valueType>::isSimpleNumeric( void ) const
 {
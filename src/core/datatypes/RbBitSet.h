@@ -2,14 +2,34 @@
 #define RbRbBitSet_H
 
 #include <cstddef>
+#include <functional>
 #include <ostream>
 #include <vector>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/iterator/function_output_iterator.hpp>
 
 namespace RevBayesCore {
-    
+
     using RbBitSet = boost::dynamic_bitset<>;
 
+    /**
+     * Hash function for bitsets, e.g., to use bipartitions as keys of hash tables.
+     * The blocks of the bitset are combined as in boost::hash_combine.
+     */
+    struct RbBitSetHash
+    {
+        size_t operator()(const RbBitSet& b) const
+        {
+            size_t h = std::hash<size_t>()( b.size() );
+            boost::to_block_range( b, boost::make_function_output_iterator( [&h](RbBitSet::block_type block)
+            {
+                h ^= std::hash<RbBitSet::block_type>()( block ) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            }) );
+
+            return h;
+        }
+    };
+
 }
 
 #endif
@@ -651,6 +651,59 @@ void AbstractRateMatrix::exponentiateMatrixByScalingAndSquaring(double t,  Trans
     }
 }
 
+/**
+ * Compute a batch of transition probability matrices from a real eigen decomposition,
+ * where c_ijk[(i*n+j)*n+k] = ev[i][k] * iev[k][j] and P[b] = exp(Q * rates[b] * (start_ages[b]-end_ages[b])).
+ * We first compute exp(eigenvalue*t) for all matrices into one table. Then we reuse each row of c_ijk
+ * for all matrices of the batch while it is in the cache. The inner products have unit stride (and are vectorized).
+ */
+void AbstractRateMatrix::tiProbsEigensBatch(const std::vector<double>& eigen_values, const std::vector<double>& c_ijk, const std::vector<double>& start_ages, const std::vector<double>& end_ages, const std::vector<double>& rates, const std::vector<TransitionProbabilityMatrix*>& P, bool normalize) const
+{
+
+    const size_t n          = num_states;
+    const size_t num_matrix = P.size();
+
+    // precalculate the exponential of the product of the eigenvalues and the branch lengths for all matrices
+    std::vector<double> eigen_values_exp( num_matrix * n );
+    for (size_t b = 0; b < num_matrix; ++b)
+    {
+        double t = rates[b] * (start_ages[b] - end_ages[b]);
+        double* e = eigen_values_exp.data() + b*n;
+        for (size_t s = 0; s < n; ++s)
+        {
+            e[s] = exp(eigen_values[s] * t);
+        }
+    }
+
+    // calculate the transition probabilities
+    const double* c = c_ijk.data();
+    for (size_t ij = 0; ij < n*n; ++ij, c += n)
+    {
+        const double* e = eigen_values_exp.data();
+        for (size_t b = 0; b < num_matrix; ++b, e += n)
+        {
+            double sum = 0.0;
+            for (size_t s = 0; s < n; ++s)
+            {
+                sum += c[s] * e[s];
+            }
+
+            P[b]->theMatrix[ij] = (sum < 0.0) ? 0.0 : sum;
+        }
+    }
+
+    // normalize the transition probabilities of each row to sum to 1.0
+    if ( normalize == true )
+    {
+        for (size_t b = 0; b < num_matrix; ++b)
+        {
+            normalize_rows( *P[b] );
+        }
+    }
+
+}
+
+
 /** Set the diagonal of the rate matrix such that each row sums to zero */
 void AbstractRateMatrix::setDiagonal(void)
 {
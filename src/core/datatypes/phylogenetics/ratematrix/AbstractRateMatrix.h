@@ -73,6 +73,7 @@ namespace RevBayesCore {
         virtual void                        computeStochasticMatrix(size_t n);
         virtual void                        computeDominatingRate(void);
         void                                exponentiateMatrixByScalingAndSquaring(double t,  TransitionProbabilityMatrix& p) const;
+        void                                tiProbsEigensBatch(const std::vector<double>& eigen_values, const std::vector<double>& c_ijk, const std::vector<double>& start_ages, const std::vector<double>& end_ages, const std::vector<double>& rates, const std::vector<TransitionProbabilityMatrix*>& P, bool normalize) const;    //!< Calculate several transition matrices from a real eigen system
         
         // protected members available for derived classes
         MatrixReal*                         the_rate_matrix;                                                                            //!< Holds the rate matrix
@@ -53,6 +53,21 @@ void RateGenerator::calculateTransitionProbabilities(double t, TransitionProbabi
     calculateTransitionProbabilities(t, 0.0, 1.0, P);
 }
 
+/**
+ * Calculate the transition probability matrices P[i] for the time intervals [start_ages[i],end_ages[i]] scaled by rates[i].
+ * By default we compute each matrix separately; derived classes can override this
+ * to share work between the matrices (e.g., the eigen decomposition).
+ */
+void RateGenerator::calculateTransitionProbabilitiesBatch(const std::vector<double>& start_ages, const std::vector<double>& end_ages, const std::vector<double>& rates, const std::vector<TransitionProbabilityMatrix*>& P) const
+{
+
+    for (size_t i = 0; i < P.size(); ++i)
+    {
+        calculateTransitionProbabilities(start_ages[i], end_ages[i], rates[i], *P[i]);
+    }
+
+}
+
 size_t RateGenerator::getNumberOfStates( void ) const
 {
     return num_states;
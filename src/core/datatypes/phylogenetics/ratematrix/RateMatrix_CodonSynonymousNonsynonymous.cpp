@@ -134,6 +134,20 @@ void RateMatrix_CodonSynonymousNonsynonymous::calculateCijk(void)
 }
 
 
+/** Calculate the transition probabilities for several branches at once, sharing the eigen system */
+void RateMatrix_CodonSynonymousNonsynonymous::calculateTransitionProbabilitiesBatch(const std::vector<double>& start_ages, const std::vector<double>& end_ages, const std::vector<double>& rates, const std::vector<TransitionProbabilityMatrix*>& P) const
+{
+    if ( eigen_system->isComplex() == false )
+    {
+        tiProbsEigensBatch(eigen_system->getRealEigenvalues(), c_ijk, start_ages, end_ages, rates, P, false);
+    }
+    else
+    {
+        TimeReversibleRateMatrix::calculateTransitionProbabilitiesBatch(start_ages, end_ages, rates, P);
+    }
+}
+
+
 /** Calculate the transition probabilities */
 void RateMatrix_CodonSynonymousNonsynonymous::calculateTransitionProbabilities(double startAge, double endAge, double rate, TransitionProbabilityMatrix& P) const
 {
@@ -42,6 +42,7 @@ namespace RevBayesCore {
         // RateMatrix functions
         virtual RateMatrix_CodonSynonymousNonsynonymous&        assign(const Assignable &m);                                                                                            //!< Assign operation that can be called on a base class instance.
         void                                                    calculateTransitionProbabilities(double startAge, double endAge, double rate, TransitionProbabilityMatrix& P) const;    //!< Calculate the transition matrix
+        void                                                    calculateTransitionProbabilitiesBatch(const std::vector<double>& start_ages, const std::vector<double>& end_ages, const std::vector<double>& rates, const std::vector<TransitionProbabilityMatrix*>& P) const;  //!< Calculate several transition matrices at once
         RateMatrix_CodonSynonymousNonsynonymous*                clone(void) const;
         void                                                    setCodonFrequencies(const std::vector<double> &f);                                 //!< Set the nucleotide frequencies
         void                                                    setOmega(double o);
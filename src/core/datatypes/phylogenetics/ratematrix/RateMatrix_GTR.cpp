@@ -144,6 +144,20 @@ void RateMatrix_GTR::calculateTransitionProbabilities(double startAge, double en
 }
 
 
+/** Calculate the transition probabilities for several branches at once, sharing the eigen system */
+void RateMatrix_GTR::calculateTransitionProbabilitiesBatch(const std::vector<double>& start_ages, const std::vector<double>& end_ages, const std::vector<double>& rates, const std::vector<TransitionProbabilityMatrix*>& P) const
+{
+    if ( theEigenSystem->isComplex() == false )
+    {
+        tiProbsEigensBatch(theEigenSystem->getRealEigenvalues(), c_ijk, start_ages, end_ages, rates, P, true);
+    }
+    else
+    {
+        TimeReversibleRateMatrix::calculateTransitionProbabilitiesBatch(start_ages, end_ages, rates, P);
+    }
+}
+
+
 RateMatrix_GTR* RateMatrix_GTR::clone( void ) const
 {
     return new RateMatrix_GTR( *this );
@@ -32,6 +32,7 @@ namespace RevBayesCore {
         // RateMatrix functions
         virtual RateMatrix_GTR&             assign(const Assignable &m);                                                                                            //!< Assign operation that can be called on a base class instance.
         void                                calculateTransitionProbabilities(double startAge, double endAge, double rate, TransitionProbabilityMatrix& P) const;    //!< Calculate the transition matrix
+        void                                calculateTransitionProbabilitiesBatch(const std::vector<double>& start_ages, const std::vector<double>& end_ages, const std::vector<double>& rates, const std::vector<TransitionProbabilityMatrix*>& P) const;  //!< Calculate several transition matrices at once
         RateMatrix_GTR*                     clone(void) const;
         void                                update(void);
         virtual void                        initFromString( const std::string &s );                                             //!< Serialize (resurrect) the object from a string value
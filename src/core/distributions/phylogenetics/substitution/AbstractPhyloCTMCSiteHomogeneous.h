@@ -2,6 +2,7 @@
 #define AbstractPhyloCTMCSiteHomogeneous_H
 
 #include "AbstractHomologousDiscreteCharacterData.h"
+#include "BufferPool.h"
 #include "ConstantNode.h"
 #include "DiscreteTaxonData.h"
 #include "DnaState.h"
@@ -13,12 +14,16 @@
 #include "RbVector.h"
 #include "RateGenerator.h"
 #include "Simplex.h"
+#include "ThreadPool.h"
 #include "TopologyNode.h"
 #include "TransitionProbabilityMatrix.h"
+#include "TransitionProbabilityMatrixCache.h"
 #include "Tree.h"
 #include "TreeChangeEventListener.h"
 #include "TypedDistribution.h"
 
+#include <algorithm>
+#include <functional>
 #include <memory.h>
 
 namespace RevBayesCore {
@@ -119,7 +124,9 @@ namespace RevBayesCore {
         void                                                                setSiteRates(const TypedDagNode< RbVector< double > > *r);
         void                                                                setSiteRatesProbs(const TypedDagNode< Simplex > *rp);
         void                                                                setUseMarginalLikelihoods(bool tf);
+        void                                                                setUseSinglePrecision(bool tf);                                                             //!< Store the partial likelihoods in single precision?
         void                                                                setUseSiteMatrices(bool sm, const TypedDagNode< Simplex > *s = NULL);
+        void                                                                setTransitionProbabilityCacheSize(size_t n);                                                 //!< Cache up to n transition probability matrices (0 disables the cache)
         void                                                                swap_taxon_name_2_tip_index(std::string tip1, std::string tip2);
 
         bool                                                                hasSiteRateMixture();
@@ -131,6 +138,13 @@ namespace RevBayesCore {
         // helper method for this and derived classes
         void                                                                recursivelyFlagNodeDirty(const TopologyNode& n);
         void                                                                flagNodeDirtyPmatrix(size_t node_idx);
+        void                                                                forEachPatternBlock(const std::function<void(size_t, size_t)> &kernel) const;   //!< Apply the kernel to blocks [start,end) of the patterns, possibly in parallel
+        template <class realType>
+        void                                                                scalePatternsLazily(realType* p_node, double* node_scaling, const double* left_scaling, const double* right_scaling, const double* middle_scaling, size_t pattern_start, size_t pattern_end) const;   //!< Rescale the sites [start,end) of a node by a power of two if they are close to underflow
+        size_t                                                              getPartialLikelihoodBufferSize(void) const;                                     //!< The number of doubles we need to store the partial likelihoods
+        double*                                                             getRootPartialLikelihoods(size_t root_index) const;                             //!< The (double precision) partial likelihoods of the root
+        float*                                                              getSinglePrecisionPartialLikelihoods(size_t node_index) const;                  //!< The partial likelihoods of a node if we use single precision
+        virtual bool                                                        useLazyScaling(void) const;                                                     //!< Do we only rescale the likelihoods when they are close to underflow?
         virtual void                                                        resizeLikelihoodVectors(void);
         virtual void                                                        setActivePIDSpecialized(size_t i, size_t n);                                                          //!< Set the number of processes for this distribution.
         virtual void                                                        updateTransitionProbabilities(size_t node_idx);
@@ -194,7 +208,7 @@ namespace RevBayesCore {
         std::vector<size_t>                                                 activeLikelihood;
         double*                                                             marginalLikelihoods;
 
-        std::vector< std::vector< std::vector<double> > >                   perNodeSiteLogScalingFactors;
+        double*                                                             perNodeSiteLogScalingFactors;
 
         // the data
         std::vector<std::vector<RbBitSet> >                                 ambiguous_char_matrix;
@@ -218,6 +232,8 @@ namespace RevBayesCore {
         size_t                                                              nodeOffset;
         size_t                                                              mixtureOffset;
         size_t                                                              siteOffset;
+        size_t                                                              activeScalingFactorOffset;
+        size_t                                                              scalingFactorNodeOffset;
 
         // flags
         bool                                                                using_ambiguous_characters;
@@ -228,6 +244,8 @@ namespace RevBayesCore {
 
         bool                                                                useMarginalLikelihoods;
         mutable bool                                                        in_mcmc_mode;
+        bool                                                                scaled_in_kernel;                               //!< Did the last likelihood kernel already rescale the node (lazy scaling)?
+        bool                                                                use_single_precision;                           //!< Are the partial likelihoods (except for the root) stored as float?
 
         // members
         const TypedDagNode< double >*                                       homogeneous_clock_rate;
@@ -262,6 +280,12 @@ namespace RevBayesCore {
         size_t                                                              sampled_site_rate_component;
         size_t                                                              sampled_site_matrix_component;
 
+        // cache of the transition probability matrices
+        TransitionProbabilityMatrixCache                                    pmatrix_cache;
+        size_t                                                              rate_matrix_generation;                         //!< Changes whenever the rate matrices change (part of the key of the cached matrices)
+        size_t                                                              stored_rate_matrix_generation;
+        size_t                                                              num_rate_matrix_generations;
+
     private:
 
         // private methods
@@ -272,6 +296,9 @@ namespace RevBayesCore {
         virtual void                                                        scale(size_t i, size_t l, size_t r, size_t m);
         virtual void                                                        simulate(const TopologyNode& node, std::vector< DiscreteTaxonData< charType > > &t, const std::vector<bool> &inv, const std::vector<size_t> &perSiteRates);
         virtual void                                                        updateTransitionProbabilityMatrix(size_t node_idx);
+        void                                                                updateTransitionProbabilityMatrices(const std::vector<size_t> &branches);    //!< Compute the matrices of several branches at once
+        void                                                                getBranchAgesAndRate(size_t node_idx, double &start_age, double &end_age, double &rate) const;
+        const RateGenerator*                                                getRateGenerator(size_t index, const RateGenerator* jc) const;     //!< The rate matrix of a mixture component (or branch)
         
         
         
@@ -313,7 +340,7 @@ partialLikelihoods( NULL ),
 activeLikelihood( std::vector<size_t>(num_nodes, 0) ),
 //    marginalLikelihoods( new double[num_nodes*num_site_mixtures*num_sites*num_chars] ),
 marginalLikelihoods( NULL ),
-perNodeSiteLogScalingFactors( std::vector<std::vector< std::vector<double> > >(2, std::vector<std::vector<double> >(num_nodes, std::vector<double>(num_sites, 0.0) ) ) ),
+perNodeSiteLogScalingFactors( NULL ),
 ambiguous_char_matrix(),
 char_matrix(),
 gap_matrix(),
@@ -333,6 +360,8 @@ treatAmbiguousAsGaps( false ),
 using_weighted_characters( wd ),
 useMarginalLikelihoods( false ),
 in_mcmc_mode( false ),
+scaled_in_kernel( false ),
+use_single_precision( false ),
 pattern_block_start( 0 ),
 pattern_block_end( num_patterns ),
 pattern_block_size( num_patterns ),
@@ -341,7 +370,11 @@ gap_match_clamped( gapmatch ),
 template_state(),
 has_ancestral_states(false),
 sampled_site_rate_component( 0 ),
-sampled_site_matrix_component( 0 )
+sampled_site_matrix_component( 0 ),
+pmatrix_cache( 0 ),
+rate_matrix_generation( 0 ),
+stored_rate_matrix_generation( 0 ),
+num_rate_matrix_generations( 0 )
 
 {
 
@@ -368,6 +401,11 @@ sampled_site_matrix_component( 0 )
     nodeOffset                  =  num_site_mixtures*pattern_block_size*num_chars;
     mixtureOffset               =  pattern_block_size*num_chars;
     siteOffset                  =  num_chars;
+    activeScalingFactorOffset   =  num_nodes*pattern_block_size;
+    scalingFactorNodeOffset     =  pattern_block_size;
+
+    perNodeSiteLogScalingFactors = BufferPool::bufferPoolInstance().allocate( 2*activeScalingFactorOffset );
+    std::fill(perNodeSiteLogScalingFactors, perNodeSiteLogScalingFactors + 2*activeScalingFactorOffset, 0.0);
     
     activePmatrixOffset         =  num_nodes * num_site_mixtures;
     pmatNodeOffset              =  num_site_mixtures;
@@ -415,7 +453,7 @@ partialLikelihoods( NULL ),
 activeLikelihood( n.activeLikelihood ),
 //    marginalLikelihoods( new double[num_nodes*num_site_mixtures*num_sites*num_chars] ),
 marginalLikelihoods( NULL ),
-perNodeSiteLogScalingFactors( n.perNodeSiteLogScalingFactors ),
+perNodeSiteLogScalingFactors( NULL ),
 ambiguous_char_matrix( n.ambiguous_char_matrix ),
 char_matrix( n.char_matrix ),
 gap_matrix( n.gap_matrix ),
@@ -435,6 +473,8 @@ treatAmbiguousAsGaps( n.treatAmbiguousAsGaps ),
 using_weighted_characters( n.using_weighted_characters ),
 useMarginalLikelihoods( n.useMarginalLikelihoods ),
 in_mcmc_mode( n.in_mcmc_mode ),
+scaled_in_kernel( false ),
+use_single_precision( n.use_single_precision ),
 pattern_block_start( n.pattern_block_start ),
 pattern_block_end( n.pattern_block_end ),
 pattern_block_size( n.pattern_block_size ),
@@ -443,7 +483,11 @@ gap_match_clamped( n.gap_match_clamped ),
 template_state( n.template_state ),
 has_ancestral_states( n.has_ancestral_states ),
 sampled_site_rate_component( n.sampled_site_rate_component ),
-sampled_site_matrix_component( n.sampled_site_matrix_component )
+sampled_site_matrix_component( n.sampled_site_matrix_component ),
+pmatrix_cache( n.pmatrix_cache ),
+rate_matrix_generation( n.rate_matrix_generation ),
+stored_rate_matrix_generation( n.stored_rate_matrix_generation ),
+num_rate_matrix_generations( n.num_rate_matrix_generations )
 {
 
     // initialize with default parameters
@@ -461,6 +505,11 @@ sampled_site_matrix_component( n.sampled_site_matrix_component )
     nodeOffset                  =  n.nodeOffset;
     mixtureOffset               =  n.mixtureOffset;
     siteOffset                  =  n.siteOffset;
+    activeScalingFactorOffset   =  n.activeScalingFactorOffset;
+    scalingFactorNodeOffset     =  n.scalingFactorNodeOffset;
+
+    perNodeSiteLogScalingFactors = BufferPool::bufferPoolInstance().allocate( 2*activeScalingFactorOffset );
+    memcpy(perNodeSiteLogScalingFactors, n.perNodeSiteLogScalingFactors, 2*activeScalingFactorOffset*sizeof(double));
     
     activePmatrixOffset         =  n.activePmatrixOffset;
     pmatNodeOffset              =  n.pmatNodeOffset;
@@ -479,14 +528,14 @@ sampled_site_matrix_component( n.sampled_site_matrix_component )
     // copy the partial likelihoods if necessary
     if ( in_mcmc_mode == true )
     {
-        partialLikelihoods = new double[2*activeLikelihoodOffset];
-        memcpy(partialLikelihoods, n.partialLikelihoods, 2*activeLikelihoodOffset*sizeof(double));
+        partialLikelihoods = BufferPool::bufferPoolInstance().allocate( getPartialLikelihoodBufferSize() );
+        memcpy(partialLikelihoods, n.partialLikelihoods, getPartialLikelihoodBufferSize()*sizeof(double));
     }
 
     // copy the marginal likelihoods if necessary
     if ( useMarginalLikelihoods == true )
     {
-        marginalLikelihoods = new double[activeLikelihoodOffset];
+        marginalLikelihoods = BufferPool::bufferPoolInstance().allocate( activeLikelihoodOffset );
         memcpy(marginalLikelihoods, n.marginalLikelihoods, activeLikelihoodOffset*sizeof(double));
     }
 }
@@ -509,8 +558,9 @@ RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::~AbstractPhyloCTMCSite
     }
 
     // free the partial likelihoods
-    delete [] partialLikelihoods;
-    delete [] marginalLikelihoods;
+    BufferPool::bufferPoolInstance().release( partialLikelihoods );
+    BufferPool::bufferPoolInstance().release( marginalLikelihoods );
+    BufferPool::bufferPoolInstance().release( perNodeSiteLogScalingFactors );
 }
 
 
@@ -895,12 +945,11 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::compress( void )
 template<class charType>
 double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeLnProbability( void )
 {
-    // @todo: #thread
-    // This part should be done on several threads if possible
-    // That means we should probabily call this function as a job,
-    // where a job is defined as computing the lnProbability for a subset of the data (block)
+    // Note: the per-node kernels (tips, internal nodes, root and scaling) split the patterns of this process
+    // into blocks which are computed on several threads if the user set the option "numThreads" (see forEachPatternBlock).
+    // This is independent of, and can be combined with, the MPI split of the patterns into pattern_block_start/end.
     // Sebastian: this call is very slow; a lot of work happens in nextCycle()
-    
+
 
     // we need to check here if we still are listining to this tree for change events
     // the tree could have been replaced without telling us
@@ -917,7 +966,7 @@ double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeLnProbab
     // if we are not in MCMC mode, then we need to (temporarily) allocate memory
     if ( in_mcmc_mode == false )
     {
-        partialLikelihoods = new double[2*activeLikelihoodOffset];
+        partialLikelihoods = BufferPool::bufferPoolInstance().allocate( getPartialLikelihoodBufferSize() );
     }
 
     // compute the ln probability by recursively calling the probability calculation for each node
@@ -973,7 +1022,7 @@ double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeLnProbab
     if ( in_mcmc_mode == false )
     {
         // free the partial likelihoods
-        delete [] partialLikelihoods;
+        BufferPool::bufferPoolInstance().release( partialLikelihoods );
         partialLikelihoods = NULL;
     }
 
@@ -1217,6 +1266,11 @@ template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::drawJointConditionalAncestralStates(std::vector<std::vector<charType> >& startStates, std::vector<std::vector<charType> >& endStates)
 {
 
+    if ( use_single_precision == true )
+    {
+        throw RbException("Ancestral states cannot be sampled with single-precision partial likelihoods.");
+    }
+
 	// if we already have ancestral states, don't make new ones
     
     // MJL 181028: Disabling this flag to allow multiple monitors to work for same dnPhyloCTMC (e.g. ancestral states + stochastic mapping)
@@ -1356,7 +1410,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::drawSiteMixtureAl
     size_t node_index = root.getIndex();
 
     // get the pointers to the partial likelihoods and the marginal likelihoods
-    double*         p_node  = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+    double*         p_node  = this->getRootPartialLikelihoods( node_index );
 
     // get pointers the likelihood for both subtrees
     const double*   p_site           = p_node;
@@ -1663,7 +1717,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         if ( in_mcmc_mode == false )
         {
             delete_partial_likelihoods = true;
-            partialLikelihoods = new double[2*activeLikelihoodOffset];
+            partialLikelihoods = BufferPool::bufferPoolInstance().allocate( getPartialLikelihoodBufferSize() );
             in_mcmc_mode = true;
 
             for (std::vector<bool>::iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it)
@@ -1683,7 +1737,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         if ( delete_partial_likelihoods == true )
         {
             // free the partial likelihoods
-            delete [] partialLikelihoods;
+            BufferPool::bufferPoolInstance().release( partialLikelihoods );
             partialLikelihoods = NULL;
             in_mcmc_mode = false;
         }
@@ -1714,7 +1768,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         if ( in_mcmc_mode == false )
         {
             delete_partial_likelihoods = true;
-            partialLikelihoods = new double[2*activeLikelihoodOffset];
+            partialLikelihoods = BufferPool::bufferPoolInstance().allocate( getPartialLikelihoodBufferSize() );
             in_mcmc_mode = true;
 
             for (std::vector<bool>::iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it)
@@ -1753,7 +1807,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         if ( delete_partial_likelihoods == true )
         {
             // free the partial likelihoods
-            delete [] partialLikelihoods;
+            BufferPool::bufferPoolInstance().release( partialLikelihoods );
             partialLikelihoods = NULL;
             in_mcmc_mode = false;
         }
@@ -1821,6 +1875,13 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         }
 
     }
+    else if ( n == "transitionMatrixCacheStatistics" )
+    {
+        // the number of hits and misses of the transition probability matrix cache
+        rv = RbVector<double>(2, 0.0);
+        rv[0] = pmatrix_cache.getNumberOfHits();
+        rv[1] = pmatrix_cache.getNumberOfMisses();
+    }
     else
     {
         throw RbException("The PhyloCTMC process does not have a member method called '" + n + "'.");
@@ -1842,7 +1903,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         if ( in_mcmc_mode == false )
         {
             delete_partial_likelihoods = true;
-            partialLikelihoods = new double[2*activeLikelihoodOffset];
+            partialLikelihoods = BufferPool::bufferPoolInstance().allocate( getPartialLikelihoodBufferSize() );
             in_mcmc_mode = true;
 
             for (std::vector<bool>::iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it)
@@ -1870,7 +1931,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         if ( delete_partial_likelihoods == true )
         {
             // free the partial likelihoods
-            delete [] partialLikelihoods;
+            BufferPool::bufferPoolInstance().release( partialLikelihoods );
             partialLikelihoods = NULL;
             in_mcmc_mode = false;
         }
@@ -1896,7 +1957,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         if ( in_mcmc_mode == false )
         {
             delete_partial_likelihoods = true;
-            partialLikelihoods = new double[2*activeLikelihoodOffset];
+            partialLikelihoods = BufferPool::bufferPoolInstance().allocate( getPartialLikelihoodBufferSize() );
             in_mcmc_mode = true;
 
             for (std::vector<bool>::iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it)
@@ -1924,7 +1985,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         if ( delete_partial_likelihoods == true )
         {
             // free the partial likelihoods
-            delete [] partialLikelihoods;
+            BufferPool::bufferPoolInstance().release( partialLikelihoods );
             partialLikelihoods = NULL;
             in_mcmc_mode = false;
         }
@@ -2210,6 +2271,45 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::flagNodeDirtyPmat
 }
 
 
+/**
+ * Apply the kernel to the patterns of this process, split into blocks [pattern_start, pattern_end).
+ * The blocks are computed on the threads of the global thread pool if the user asked for more than one thread
+ * (option "numThreads") and there are enough patterns to make this worthwhile. Otherwise the kernel is
+ * applied once to the full pattern range.
+ * Kernels must only write to the sites of their own block.
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::forEachPatternBlock(const std::function<void(size_t, size_t)> &kernel) const
+{
+    // we want at least this many patterns per thread, otherwise the synchronization costs more than we gain
+    const size_t min_patterns_per_block = 128;
+
+    ThreadPool& pool = ThreadPool::threadPoolInstance();
+    size_t num_blocks = pool.getNumberOfThreads();
+    if ( pool.isWorkerThread() == true )
+    {
+        num_blocks = 1;
+    }
+    num_blocks = std::min( num_blocks, pattern_block_size / min_patterns_per_block );
+
+    if ( num_blocks <= 1 )
+    {
+        kernel(0, pattern_block_size);
+    }
+    else
+    {
+        size_t num_patterns_in_block = pattern_block_size;
+        pool.parallelFor( num_blocks, [&](size_t block)
+        {
+            size_t pattern_start = ( block     * num_patterns_in_block) / num_blocks;
+            size_t pattern_end   = ((block+1)  * num_patterns_in_block) / num_blocks;
+            kernel(pattern_start, pattern_end);
+        });
+    }
+
+}
+
+
 template<class charType>
 std::vector<size_t> RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getIncludedSiteIndices( void )
 {
@@ -2217,6 +2317,46 @@ std::vector<size_t> RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::ge
 }
 
 
+/**
+ * Get the size of the partial likelihood buffer (in doubles).
+ * In single precision the buffer starts with the float partial likelihoods of all nodes
+ * (which take the space of activeLikelihoodOffset doubles) followed by the double partial likelihoods of the root,
+ * because we sum the root likelihoods in double precision.
+ */
+template<class charType>
+size_t RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getPartialLikelihoodBufferSize( void ) const
+{
+
+    if ( use_single_precision == true )
+    {
+        return activeLikelihoodOffset + 2*nodeOffset;
+    }
+
+    return 2*activeLikelihoodOffset;
+}
+
+
+template<class charType>
+double* RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getRootPartialLikelihoods( size_t root_index ) const
+{
+
+    if ( use_single_precision == true )
+    {
+        return partialLikelihoods + activeLikelihoodOffset + activeLikelihood[root_index]*nodeOffset;
+    }
+
+    return partialLikelihoods + activeLikelihood[root_index]*activeLikelihoodOffset + root_index*nodeOffset;
+}
+
+
+template<class charType>
+float* RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getSinglePrecisionPartialLikelihoods( size_t node_index ) const
+{
+
+    return reinterpret_cast<float*>( partialLikelihoods ) + activeLikelihood[node_index]*activeLikelihoodOffset + node_index*nodeOffset;
+}
+
+
 
 template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getRootFrequencies( std::vector<std::vector<double> >& rf ) const
@@ -2343,6 +2483,9 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::keepSpecializatio
     // reset the ln probability
     this->storedLnProb = this->lnProb;
 
+    // the current rate matrices are accepted
+    stored_rate_matrix_generation = rate_matrix_generation;
+
     // reset all flags
     for (std::vector<bool>::iterator it = this->dirty_nodes.begin(); it != this->dirty_nodes.end(); ++it)
     {
@@ -2627,12 +2770,12 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::resizeLikelihoodV
     {
 
         // we resize the partial likelihood vectors to the new dimensions
-        delete [] partialLikelihoods;
+        BufferPool::bufferPoolInstance().release( partialLikelihoods );
 
-        partialLikelihoods = new double[2*activeLikelihoodOffset];
+        partialLikelihoods = BufferPool::bufferPoolInstance().allocate( getPartialLikelihoodBufferSize() );
 
         // reinitialize likelihood vectors
-        for (size_t i = 0; i < 2*activeLikelihoodOffset; i++)
+        for (size_t i = 0; i < getPartialLikelihoodBufferSize(); i++)
         {
             partialLikelihoods[i] = 0.0;
         }
@@ -2642,9 +2785,9 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::resizeLikelihoodV
     if ( useMarginalLikelihoods == true )
     {
         // we resize the partial likelihood vectors to the new dimensions
-        delete [] marginalLikelihoods;
+        BufferPool::bufferPoolInstance().release( marginalLikelihoods );
 
-        marginalLikelihoods = new double[activeLikelihoodOffset];
+        marginalLikelihoods = BufferPool::bufferPoolInstance().allocate( activeLikelihoodOffset );
 
         // reinitialize likelihood vectors
         for (size_t i = 0; i < activeLikelihoodOffset; i++)
@@ -2654,7 +2797,13 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::resizeLikelihoodV
 
     }
 
-    perNodeSiteLogScalingFactors = std::vector<std::vector< std::vector<double> > >(2, std::vector<std::vector<double> >(num_nodes, std::vector<double>(pattern_block_size, 0.0) ) );
+    // the log scaling factors are stored in a flat array indexed by [active][node][site]
+    activeScalingFactorOffset   =  num_nodes*pattern_block_size;
+    scalingFactorNodeOffset     =  pattern_block_size;
+
+    BufferPool::bufferPoolInstance().release( perNodeSiteLogScalingFactors );
+    perNodeSiteLogScalingFactors = BufferPool::bufferPoolInstance().allocate( 2*activeScalingFactorOffset );
+    std::fill(perNodeSiteLogScalingFactors, perNodeSiteLogScalingFactors + 2*activeScalingFactorOffset, 0.0);
     
     activePmatrixOffset         =  num_nodes * num_site_mixtures;
     pmatNodeOffset              =  num_site_mixtures;
@@ -2675,6 +2824,9 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::restoreSpecializa
     // reset the ln probability
     this->lnProb = this->storedLnProb;
 
+    // the rate matrices are restored, so are the cached transition probability matrices that belong to them
+    rate_matrix_generation = stored_rate_matrix_generation;
+
     // reset the flags
     for (std::vector<bool>::iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it)
     {
@@ -2714,67 +2866,147 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::restoreSpecializa
 
 }
 
+/**
+ * Lazy rescaling of the partial likelihoods of the sites [pattern_start,pattern_end) of a node.
+ * The scaling factors of the node are the sum of the scaling factors of its descendants (NULL if there are none).
+ * Only if the largest likelihood of a site is close to underflow, we multiply all likelihoods of the site
+ * by a power of two. This is exact and we only need the exponent of the maximum (no division and no log).
+ * The partial likelihoods are either double or single precision (realType).
+ */
 template<class charType>
-void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::scale( size_t node_index)
+template<class realType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::scalePatternsLazily(realType* p_node, double* node_scaling, const double* left_scaling, const double* right_scaling, const double* middle_scaling, size_t pattern_start, size_t pattern_end) const
 {
 
-    double* p_node = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+    // we rescale once the likelihoods are smaller than 2^-256 (2^-40 for single precision).
+    // The product of the children of an unscaled node must stay well above the smallest
+    // normal number (2^-126 for floats), so that the partial likelihoods never become denormal.
+    const double scaling_threshold = std::ldexp(1.0, sizeof(realType) < sizeof(double) ? -40 : -256);
 
-    if ( RbSettings::userSettings().getUseScaling() == true && node_index % RbSettings::userSettings().getScalingDensity() == 0 )
+    for (size_t site = pattern_start; site < pattern_end; ++site)
     {
-        // iterate over all mixture categories
-        for (size_t site = 0; site < this->pattern_block_size ; ++site)
+
+        double sf = 0.0;
+        if ( left_scaling   != NULL ) sf += left_scaling[site];
+        if ( right_scaling  != NULL ) sf += right_scaling[site];
+        if ( middle_scaling != NULL ) sf += middle_scaling[site];
+
+        // the max probability
+        double max = 0.0;
+        for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
         {
+            const realType* p_site_mixture = p_node + mixture*this->mixtureOffset + site*this->siteOffset;
+            for (size_t i = 0; i < this->num_chars; ++i)
+            {
+                max = std::max( max, double(p_site_mixture[i]) );
+            }
+        }
 
-            // the max probability
-            double max = 0.0;
+        // Don't rescale by zero or NaN.
+        if ( max > 0 && max < scaling_threshold )
+        {
+            int exponent = 0;
+            std::frexp( max, &exponent );
+            realType factor = realType( std::ldexp( 1.0, -exponent ) );
 
-            // compute the per site probabilities
             for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
             {
-                // get the pointers to the likelihood for this mixture category
-                size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
+                realType* p_site_mixture = p_node + mixture*this->mixtureOffset + site*this->siteOffset;
+                for (size_t i = 0; i < this->num_chars; ++i)
+                {
+                    p_site_mixture[i] *= factor;
+                }
+            }
+
+            sf -= exponent * RbConstants::LN2;
+        }
+
+        node_scaling[site] = sf;
+    }
+
+}
 
-                double* p_site_mixture = p_node + offset;
 
-                for ( size_t i=0; i<this->num_chars; ++i)
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::scale( size_t node_index)
+{
+
+    double* p_node = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+    double* node_scaling_factors = this->perNodeSiteLogScalingFactors + this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset;
+
+    if ( useLazyScaling() == true )
+    {
+        forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
+        {
+            if ( use_single_precision == true )
+            {
+                scalePatternsLazily(getSinglePrecisionPartialLikelihoods(node_index), node_scaling_factors, NULL, NULL, NULL, pattern_start, pattern_end);
+            }
+            else
+            {
+                scalePatternsLazily(p_node, node_scaling_factors, NULL, NULL, NULL, pattern_start, pattern_end);
+            }
+        });
+    }
+    else if ( RbSettings::userSettings().getUseScaling() == true && node_index % RbSettings::userSettings().getScalingDensity() == 0 )
+    {
+        // the sites are independent, so we rescale blocks of sites in parallel
+        forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
+        {
+            // iterate over all sites of this block
+            for (size_t site = pattern_start; site < pattern_end ; ++site)
+            {
+
+                // the max probability
+                double max = 0.0;
+
+                // compute the per site probabilities
+                for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
                 {
-                    if ( p_site_mixture[i] > max )
+                    // get the pointers to the likelihood for this mixture category
+                    size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
+
+                    double* p_site_mixture = p_node + offset;
+
+                    for ( size_t i=0; i<this->num_chars; ++i)
                     {
-                        max = p_site_mixture[i];
+                        if ( p_site_mixture[i] > max )
+                        {
+                            max = p_site_mixture[i];
+                        }
                     }
+
                 }
 
-            }
+                // Don't divide by zero or NaN.
+                if (not (max > 0)) continue;
 
-            // Don't divide by zero or NaN.
-            if (not (max > 0)) continue;
+                node_scaling_factors[site] = -log(max);
 
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = -log(max);
+                // compute the per site probabilities
+                for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+                {
+                    // get the pointers to the likelihood for this mixture category
+                    size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
 
-            // compute the per site probabilities
-            for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
-            {
-                // get the pointers to the likelihood for this mixture category
-                size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
+                    double* p_site_mixture = p_node + offset;
 
-                double* p_site_mixture = p_node + offset;
+                    for ( size_t i=0; i<this->num_chars; ++i)
+                    {
+                        p_site_mixture[i] /= max;
+                    }
 
-                for ( size_t i=0; i<this->num_chars; ++i)
-                {
-                    p_site_mixture[i] /= max;
                 }
 
             }
-
-        }
+        });
     }
     else if ( RbSettings::userSettings().getUseScaling() == true )
     {
         // iterate over all sites
         for (size_t site = 0; site < this->pattern_block_size ; ++site)
         {
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = 0;
+            node_scaling_factors[site] = 0;
         }
 
     }
@@ -2786,56 +3018,82 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::scale( size_t nod
 {
 
     double* p_node = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+    double*        node_scaling_factors    = this->perNodeSiteLogScalingFactors + this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset;
+    const double*  left_scaling_factors    = this->perNodeSiteLogScalingFactors + this->activeLikelihood[left]*this->activeScalingFactorOffset + left*this->scalingFactorNodeOffset;
+    const double*  right_scaling_factors   = this->perNodeSiteLogScalingFactors + this->activeLikelihood[right]*this->activeScalingFactorOffset + right*this->scalingFactorNodeOffset;
 
-    if ( RbSettings::userSettings().getUseScaling() == true && node_index % RbSettings::userSettings().getScalingDensity() == 0 )
+    if ( useLazyScaling() == true )
     {
-        // iterate over all mixture categories
-        for (size_t site = 0; site < this->pattern_block_size ; ++site)
+        // the likelihood kernel may have rescaled the node already while the values were in the cache
+        if ( scaled_in_kernel == false )
         {
-
-            // the max probability
-            double max = 0.0;
-
-            // compute the per site probabilities
-            for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+            forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
+            {
+                if ( use_single_precision == true )
+                {
+                    scalePatternsLazily(getSinglePrecisionPartialLikelihoods(node_index), node_scaling_factors, left_scaling_factors, right_scaling_factors, NULL, pattern_start, pattern_end);
+                }
+                else
+                {
+                    scalePatternsLazily(p_node, node_scaling_factors, left_scaling_factors, right_scaling_factors, NULL, pattern_start, pattern_end);
+                }
+            });
+        }
+        scaled_in_kernel = false;
+    }
+    else if ( RbSettings::userSettings().getUseScaling() == true && node_index % RbSettings::userSettings().getScalingDensity() == 0 )
+    {
+        // the sites are independent, so we rescale blocks of sites in parallel
+        forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
+        {
+            // iterate over all sites of this block
+            for (size_t site = pattern_start; site < pattern_end ; ++site)
             {
-                // get the pointers to the likelihood for this mixture category
-                size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
 
-                double*          p_site_mixture          = p_node + offset;
+                // the max probability
+                double max = 0.0;
 
-                for ( size_t i=0; i<this->num_chars; ++i)
+                // compute the per site probabilities
+                for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
                 {
-                    if ( p_site_mixture[i] > max )
+                    // get the pointers to the likelihood for this mixture category
+                    size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
+
+                    double*          p_site_mixture          = p_node + offset;
+
+                    for ( size_t i=0; i<this->num_chars; ++i)
                     {
-                        max = p_site_mixture[i];
+                        if ( p_site_mixture[i] > max )
+                        {
+                            max = p_site_mixture[i];
+                        }
+
                     }
 
                 }
 
-            }
+                // Don't divide by zero or NaN.
+                if (not (max > 0)) continue;
 
-            // Don't divide by zero or NaN.
-            if (not (max > 0)) continue;
+                node_scaling_factors[site] = left_scaling_factors[site] + right_scaling_factors[site] - log(max);
 
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]][left][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]][right][site] - log(max);
+                // compute the per site probabilities
+                for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+                {
+                    // get the pointers to the likelihood for this mixture category
+                    size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
 
-            // compute the per site probabilities
-            for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
-            {
-                // get the pointers to the likelihood for this mixture category
-                size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
+                    double* p_site_mixture = p_node + offset;
 
-                double* p_site_mixture = p_node + offset;
+                    for ( size_t i=0; i<this->num_chars; ++i)
+                    {
+                        p_site_mixture[i] /= max;
+                    }
 
-                for ( size_t i=0; i<this->num_chars; ++i)
-                {
-                    p_site_mixture[i] /= max;
                 }
 
             }
-
-        }
+        });
 
     }
     else if ( RbSettings::userSettings().getUseScaling() == true )
@@ -2843,7 +3101,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::scale( size_t nod
         // iterate over all mixture categories
         for (size_t site = 0; site < this->pattern_block_size ; ++site)
         {
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]][left][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]][right][site];
+            node_scaling_factors[site] = left_scaling_factors[site] + right_scaling_factors[site];
         }
 
     }
@@ -2856,62 +3114,89 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::scale( size_t nod
 {
 
     double* p_node = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+    double*        node_scaling_factors    = this->perNodeSiteLogScalingFactors + this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset;
+    const double*  left_scaling_factors    = this->perNodeSiteLogScalingFactors + this->activeLikelihood[left]*this->activeScalingFactorOffset + left*this->scalingFactorNodeOffset;
+    const double*  right_scaling_factors   = this->perNodeSiteLogScalingFactors + this->activeLikelihood[right]*this->activeScalingFactorOffset + right*this->scalingFactorNodeOffset;
+    const double*  middle_scaling_factors  = this->perNodeSiteLogScalingFactors + this->activeLikelihood[middle]*this->activeScalingFactorOffset + middle*this->scalingFactorNodeOffset;
 
-    if ( RbSettings::userSettings().getUseScaling() == true && node_index % RbSettings::userSettings().getScalingDensity() == 0 )
+    if ( useLazyScaling() == true )
     {
-        // iterate over all mixture categories
-        for (size_t site = 0; site < this->pattern_block_size ; ++site)
+        // the likelihood kernel may have rescaled the node already while the values were in the cache
+        if ( scaled_in_kernel == false )
         {
-
-            // the max probability
-            double max = 0.0;
-
-            // compute the per site probabilities
-            for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+            forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
+            {
+                if ( use_single_precision == true )
+                {
+                    scalePatternsLazily(getSinglePrecisionPartialLikelihoods(node_index), node_scaling_factors, left_scaling_factors, right_scaling_factors, middle_scaling_factors, pattern_start, pattern_end);
+                }
+                else
+                {
+                    scalePatternsLazily(p_node, node_scaling_factors, left_scaling_factors, right_scaling_factors, middle_scaling_factors, pattern_start, pattern_end);
+                }
+            });
+        }
+        scaled_in_kernel = false;
+    }
+    else if ( RbSettings::userSettings().getUseScaling() == true && node_index % RbSettings::userSettings().getScalingDensity() == 0 )
+    {
+        // the sites are independent, so we rescale blocks of sites in parallel
+        forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
+        {
+            // iterate over all sites of this block
+            for (size_t site = pattern_start; site < pattern_end ; ++site)
             {
-                // get the pointers to the likelihood for this mixture category
-                size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
 
-                double* p_site_mixture = p_node + offset;
+                // the max probability
+                double max = 0.0;
 
-                for ( size_t i=0; i<this->num_chars; ++i)
+                // compute the per site probabilities
+                for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
                 {
-                    if ( p_site_mixture[i] > max )
+                    // get the pointers to the likelihood for this mixture category
+                    size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
+
+                    double* p_site_mixture = p_node + offset;
+
+                    for ( size_t i=0; i<this->num_chars; ++i)
                     {
-                        max = p_site_mixture[i];
+                        if ( p_site_mixture[i] > max )
+                        {
+                            max = p_site_mixture[i];
+                        }
                     }
+
                 }
 
-            }
+                // Don't divide by zero or NaN.
+                if (not (max > 0)) continue;
 
-            // Don't divide by zero or NaN.
-            if (not (max > 0)) continue;
+                node_scaling_factors[site] = left_scaling_factors[site] + right_scaling_factors[site] + middle_scaling_factors[site] - log(max);
 
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]][left][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]][right][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[middle]][middle][site] - log(max);
+                // compute the per site probabilities
+                for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+                {
+                    // get the pointers to the likelihood for this mixture category
+                    size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
 
-            // compute the per site probabilities
-            for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
-            {
-                // get the pointers to the likelihood for this mixture category
-                size_t offset = mixture*this->mixtureOffset + site*this->siteOffset;
+                    double* p_site_mixture = p_node + offset;
 
-                double* p_site_mixture = p_node + offset;
+                    for ( size_t i=0; i<this->num_chars; ++i)
+                    {
+                        p_site_mixture[i] /= max;
+                    }
 
-                for ( size_t i=0; i<this->num_chars; ++i)
-                {
-                    p_site_mixture[i] /= max;
                 }
 
             }
-
-        }
+        });
     }
     else if ( RbSettings::userSettings().getUseScaling() == true )
     {
         // iterate over all mixture categories
         for (size_t site = 0; site < this->pattern_block_size ; ++site)
         {
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]][left][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]][right][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[middle]][middle][site];
+            node_scaling_factors[site] = left_scaling_factors[site] + right_scaling_factors[site] + middle_scaling_factors[site];
         }
 
     }
@@ -3134,7 +3419,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setMcmcMode(bool
     // free old memory
     if ( in_mcmc_mode == true )
     {
-        delete [] partialLikelihoods;
+        BufferPool::bufferPoolInstance().release( partialLikelihoods );
         partialLikelihoods = NULL;
     }
 
@@ -3194,6 +3479,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setRateMatrix(con
     // set the value
     homogeneous_rate_matrix = rm;
     num_matrices = 1;
+    rate_matrix_generation = stored_rate_matrix_generation = ++num_rate_matrix_generations;
 
     this->resizeLikelihoodVectors();
 
@@ -3231,6 +3517,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setRateMatrix(con
     // set the value
     heterogeneous_rate_matrices = rm;
     num_matrices = rm == NULL ? 1 : rm->getValue().size();
+    rate_matrix_generation = stored_rate_matrix_generation = ++num_rate_matrix_generations;
 
     this->resizeLikelihoodVectors();
 
@@ -3353,11 +3640,66 @@ template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setUseMarginalLikelihoods(bool tf)
 {
 
+    if ( tf == true && use_single_precision == true )
+    {
+        throw RbException("Marginal likelihoods are not available with single-precision partial likelihoods.");
+    }
+
     this->useMarginalLikelihoods = tf;
     this->resizeLikelihoodVectors();
 
 }
 
+
+/**
+ * Store the partial likelihoods in single precision. This halves the memory and the memory bandwidth
+ * needed for large alignments. The scaling factors and the likelihoods of the root are still computed in double precision.
+ * Only the likelihood computation supports single precision (e.g. no ancestral state reconstruction).
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setUseSinglePrecision(bool tf)
+{
+
+    if ( tf == true && useMarginalLikelihoods == true )
+    {
+        throw RbException("Marginal likelihoods are not available with single-precision partial likelihoods.");
+    }
+
+    // we need to reallocate the partial likelihoods
+    if ( in_mcmc_mode == true )
+    {
+        BufferPool::bufferPoolInstance().release( partialLikelihoods );
+        partialLikelihoods = NULL;
+    }
+
+    use_single_precision = tf;
+
+    if ( in_mcmc_mode == true )
+    {
+        resizeLikelihoodVectors();
+    }
+
+    // all partial likelihoods need to be recomputed
+    for (std::vector<bool>::iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it)
+    {
+        (*it) = true;
+    }
+
+}
+
+/**
+ * Keep up to n transition probability matrices in a cache, so that we do not need to exponentiate
+ * the rate matrix again for a branch length (and rate) that we have seen before. A size of 0 disables the cache.
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setTransitionProbabilityCacheSize(size_t n)
+{
+
+    pmatrix_cache.setCapacity( n );
+
+}
+
+
 template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setUseSiteMatrices(bool use_sm, const TypedDagNode< Simplex > *s)
 {
@@ -3455,7 +3797,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeRootLikeli
     size_t node_index = root.getIndex();
 
     // get the pointers to the partial likelihoods of the left and right subtree
-    double*   p_node  = this->partialLikelihoods + this->activeLikelihood[node_index] * this->activeLikelihoodOffset  + node_index*this->nodeOffset;
+    double*   p_node  = this->getRootPartialLikelihoods( node_index );
 
     // create a vector for the per mixture likelihoods
     // we need this vector to sum over the different mixture likelihoods
@@ -3553,12 +3895,12 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeRootLikeli
                         ftotal += f[this->invariant_site_index[site][c]];
                     }
 
-                    rv[site] = log( prob_invariant * ftotal + oneMinusPInv * per_mixture_Likelihoods[site] / exp(this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site]) ) * *patterns;
+                    rv[site] = log( prob_invariant * ftotal + oneMinusPInv * per_mixture_Likelihoods[site] / exp(this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site]) ) * *patterns;
                 }
                 else
                 {
                     rv[site] = log( oneMinusPInv * per_mixture_Likelihoods[site] ) * *patterns;
-                    rv[site] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] * *patterns;
+                    rv[site] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] * *patterns;
                 }
 
             }
@@ -3594,7 +3936,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeRootLikeli
 
             if ( RbSettings::userSettings().getUseScaling() == true )
             {
-                rv[site] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] * *patterns;
+                rv[site] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] * *patterns;
             }
 
         }
@@ -3614,7 +3956,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeRootLikeli
     size_t node_index = root.getIndex();
 
     // get the pointers to the partial likelihoods of the left and right subtree
-    double*   p_node  = this->partialLikelihoods + this->activeLikelihood[node_index] * this->activeLikelihoodOffset  + node_index*this->nodeOffset;
+    double*   p_node  = this->getRootPartialLikelihoods( node_index );
 
     // create a vector for the per mixture likelihoods
     // we need this vector to sum over the different mixture likelihoods
@@ -3713,7 +4055,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeRootLikeli
 
                     if ( RbSettings::userSettings().getUseScaling() == true )
                     {
-                        rv[site][site_rate_index * num_site_matrices + matrix] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] * *patterns;
+                        rv[site][site_rate_index * num_site_matrices + matrix] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] * *patterns;
                     }
 
                 }
@@ -3734,7 +4076,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeRootLikeli
 
                 if ( RbSettings::userSettings().getUseScaling() == true )
                 {
-                    rv[site][mixture] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] * *patterns;
+                    rv[site][mixture] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] * *patterns;
                 }
             }
 
@@ -3755,7 +4097,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeRootLikeli
     size_t node_index = root.getIndex();
 
     // get the pointers to the partial likelihoods of the left and right subtree
-    double*   p_node  = this->partialLikelihoods + this->activeLikelihood[node_index] * this->activeLikelihoodOffset  + node_index*this->nodeOffset;
+    double*   p_node  = this->getRootPartialLikelihoods( node_index );
 
     size_t num_site_matrices = num_site_mixtures/num_site_rates;
 
@@ -3868,7 +4210,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeRootLikeli
 
                 if ( RbSettings::userSettings().getUseScaling() == true )
                 {
-                    rv[site][site_rate_index] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] * *patterns;
+                    rv[site][site_rate_index] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] * *patterns;
                 }
 
             }
@@ -3887,7 +4229,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeRootLikeli
 
                 if ( RbSettings::userSettings().getUseScaling() == true )
                 {
-                    rv[site][site_rate_index] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] * *patterns;
+                    rv[site][site_rate_index] -= this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] * *patterns;
                 }
             }
 
@@ -4035,6 +4377,13 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::touchSpecializati
         this->storedLnProb = this->lnProb;
     }
 
+    // new rate matrices need new cached transition probability matrices
+    // we need a new generation for every touch because the rate matrices may change several times without a keep in between (e.g. setValue outside of an MCMC)
+    if ( affecter == homogeneous_rate_matrix || affecter == heterogeneous_rate_matrices )
+    {
+        rate_matrix_generation = ++num_rate_matrix_generations;
+    }
+
 
     // if the topology wasn't the culprit for the touch, then we just flag everything as dirty
     if ( affecter == heterogeneous_clock_rates )
@@ -4267,17 +4616,34 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionP
 
 
 /*
- * Update the transition probability matrices for the branch attached to the given node index.
+ * Should we only rescale the likelihoods when they are close to underflow (see scalePatternsLazily)?
+ * Single-precision likelihoods underflow quickly, so we always rescale them.
+ * Derived classes that do their own scaling return false.
  */
 template<class charType>
-void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionProbabilityMatrix(size_t node_idx)
+bool RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::useLazyScaling( void ) const
+{
+
+    if ( use_single_precision == true )
+    {
+        return true;
+    }
+
+    return RbSettings::userSettings().getUseScaling() == true && RbSettings::userSettings().getUseLazyScaling() == true;
+}
+
+
+/*
+ * Get the start and end age of the branch attached to the given node index and the clock rate of the branch
+ * (rescaled by the proportion of invariant sites).
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getBranchAgesAndRate(size_t node_idx, double &start_age, double &end_age, double &rate) const
 {
     const TopologyNode* node = tau->getValue().getNodes()[node_idx];
-    
-    if (node->isRoot()) throw RbException("dnPhyloCTMC called updateTransitionProbabilityMatrix for the root node\n");
-    
-    // second, get the clock rate for the branch
-    double rate = 1.0;
+
+    // get the clock rate for the branch
+    rate = 1.0;
     if ( this->branch_heterogeneous_clock_rates == true )
     {
         rate = this->heterogeneous_clock_rates->getValue()[node_idx];
@@ -4286,81 +4652,61 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionP
     {
         rate = this->homogeneous_clock_rate->getValue();
     }
-    
+
     // we rescale the rate by the inverse of the proportion of invariant sites
     rate /= ( 1.0 - getPInv() );
-    
-    double end_age = node->getAge();
-    
+
+    end_age = node->getAge();
+
     // if the tree is not a time tree, then the age will be not a number
     if ( RbMath::isFinite(end_age) == false )
     {
         // we assume by default that the end is at time 0
         end_age = 0.0;
     }
-    double start_age = end_age + node->getBranchLength();
-    
-    // first, get the rate matrix for this branch
-    RateMatrix_JC jc(this->num_chars);
-    const RateGenerator *rm = &jc;
-    
-    size_t pmat_offset = this->active_pmatrices[node_idx] * this->activePmatrixOffset + node_idx * this->pmatNodeOffset;
-    
-    if (this->branch_heterogeneous_substitution_matrices == false )
-    {
-        for (size_t matrix = 0; matrix < this->num_matrices; ++matrix)
-        {
-            if ( this->heterogeneous_rate_matrices != NULL )
-            {
-                rm = &this->heterogeneous_rate_matrices->getValue()[matrix];
-            }
-            else if ( this->homogeneous_rate_matrix != NULL )
-            {
-                rm = &this->homogeneous_rate_matrix->getValue();
-            }
+    start_age = end_age + node->getBranchLength();
 
-	    // The rm can change behind our back if the user redefines it.
-	    if (rm->size() != num_chars)
-		throw RbException()<<"Rate generator with "<<rm->size()<<" states does not match data with "<<num_chars<<" states";
+}
 
-            for (size_t j = 0; j < this->num_site_rates; ++j)
-            {
-                double r = 1.0;
-                if ( this->rate_variation_across_sites == true )
-                {
-                    r = this->site_rates->getValue()[j];
-                }
-                
-                rm->calculateTransitionProbabilities( start_age, end_age,  rate * r, this->pmatrices[pmat_offset + j * this->num_matrices + matrix] );
-            }
-        }
+
+/*
+ * Get the rate matrix for the given matrix index (or for the branch of the given node if the rate matrices are branch heterogeneous).
+ * If no rate matrix was specified we use the Jukes-Cantor matrix.
+ */
+template<class charType>
+const RevBayesCore::RateGenerator* RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getRateGenerator(size_t index, const RateGenerator* jc) const
+{
+    const RateGenerator *rm = jc;
+
+    if ( this->heterogeneous_rate_matrices != NULL )
+    {
+        rm = &this->heterogeneous_rate_matrices->getValue()[index];
     }
-    else
+    else if ( this->homogeneous_rate_matrix != NULL )
     {
-        if ( this->heterogeneous_rate_matrices != NULL )
-        {
-            rm = &this->heterogeneous_rate_matrices->getValue()[node_idx];
-        }
-        else if ( this->homogeneous_rate_matrix != NULL )
-        {
-            rm = &this->homogeneous_rate_matrix->getValue();
-        }
+        rm = &this->homogeneous_rate_matrix->getValue();
+    }
 
-	// The rm can change behind our back if the user redefines it.
-	if (rm->size() != num_chars)
-	    throw RbException()<<"Rate generator with "<<rm->size()<<" states does not match data with "<<num_chars<<" states";
+    // The rm can change behind our back if the user redefines it.
+    if (rm->size() != num_chars)
+        throw RbException()<<"Rate generator with "<<rm->size()<<" states does not match data with "<<num_chars<<" states";
 
-	for (size_t j = 0; j < this->num_site_rates; ++j)
-        {
-            double r = 1.0;
-            if ( this->rate_variation_across_sites == true )
-            {
-                r = this->site_rates->getValue()[j];
-            }
-            
-            rm->calculateTransitionProbabilities( start_age, end_age,  rate * r, this->pmatrices[pmat_offset + j] );
-        }
-    }
+    return rm;
+}
+
+
+/*
+ * Update the transition probability matrices for the branch attached to the given node index.
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionProbabilityMatrix(size_t node_idx)
+{
+    const TopologyNode* node = tau->getValue().getNodes()[node_idx];
+    
+    if (node->isRoot()) throw RbException("dnPhyloCTMC called updateTransitionProbabilityMatrix for the root node\n");
+    
+    std::vector<size_t> branches( 1, node_idx );
+    updateTransitionProbabilityMatrices( branches );
 }
 
 
@@ -4371,16 +4717,18 @@ template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionProbabilityMatrices( void )
 {
     
-    std::vector<TopologyNode*> nodes = tau->getValue().getNodes();
-        
-    for (std::vector<TopologyNode*>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+    const std::vector<TopologyNode*>& nodes = tau->getValue().getNodes();
+    
+    // collect the branches that need new matrices, so that we can compute them together
+    std::vector<size_t> dirty_branches;
+    for (std::vector<TopologyNode*>::const_iterator it = nodes.begin(); it != nodes.end(); ++it)
     {
         size_t node_index = (*it)->getIndex();
         if (pmat_dirty_nodes[node_index] == true)
         {
             if ((*it)->isRoot() == false)
             {
-                updateTransitionProbabilityMatrix(node_index);
+                dirty_branches.push_back( node_index );
             }
 
             // mark as computed
@@ -4388,6 +4736,135 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionP
         }
     }
     
+    if ( dirty_branches.empty() == false )
+    {
+        updateTransitionProbabilityMatrices( dirty_branches );
+    }
+    
+}
+
+
+/*
+ * Update the transition probability matrices for the branches attached to the given node indices.
+ * We pass all (branch, site rate) pairs that use the same rate matrix to the rate matrix at once,
+ * so that it can share the work between them (e.g., the eigen decomposition is used for all matrices in one sweep).
+ * If the cache is enabled, we only compute the matrices that are not in the cache and add them afterwards.
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionProbabilityMatrices(const std::vector<size_t> &branches)
+{
+    
+    // get the ages and clock rates of all branches
+    size_t num_branches = branches.size();
+    std::vector<double> branch_start_ages( num_branches );
+    std::vector<double> branch_end_ages( num_branches );
+    std::vector<double> branch_rates( num_branches );
+    for (size_t b = 0; b < num_branches; ++b)
+    {
+        getBranchAgesAndRate( branches[b], branch_start_ages[b], branch_end_ages[b], branch_rates[b] );
+    }
+    
+    // get the site specific rates
+    std::vector<double> r( this->num_site_rates, 1.0 );
+    if ( this->rate_variation_across_sites == true )
+    {
+        for (size_t j = 0; j < this->num_site_rates; ++j)
+        {
+            r[j] = this->site_rates->getValue()[j];
+        }
+    }
+    
+    // we use the Jukes-Cantor matrix if no rate matrix was specified
+    RateMatrix_JC jc(this->num_chars);
+    
+    // the batch of matrices for one rate matrix
+    std::vector<double> start_ages;
+    std::vector<double> end_ages;
+    std::vector<double> rates;
+    std::vector<TransitionProbabilityMatrix*> P;
+    
+    if (this->branch_heterogeneous_substitution_matrices == false )
+    {
+        start_ages.reserve( num_branches * this->num_site_rates );
+        end_ages.reserve( num_branches * this->num_site_rates );
+        rates.reserve( num_branches * this->num_site_rates );
+        P.reserve( num_branches * this->num_site_rates );
+        
+        for (size_t matrix = 0; matrix < this->num_matrices; ++matrix)
+        {
+            const RateGenerator *rm = getRateGenerator( matrix, &jc );
+            
+            start_ages.clear();
+            end_ages.clear();
+            rates.clear();
+            P.clear();
+            for (size_t b = 0; b < num_branches; ++b)
+            {
+                size_t pmat_offset = this->active_pmatrices[branches[b]] * this->activePmatrixOffset + branches[b] * this->pmatNodeOffset;
+                for (size_t j = 0; j < this->num_site_rates; ++j)
+                {
+                    TransitionProbabilityMatrix &pm = this->pmatrices[pmat_offset + j * this->num_matrices + matrix];
+                    if ( pmatrix_cache.isEnabled() == true && pmatrix_cache.get( rate_matrix_generation, matrix, branch_start_ages[b], branch_end_ages[b], branch_rates[b] * r[j], pm ) == true )
+                    {
+                        continue;
+                    }
+                    
+                    start_ages.push_back( branch_start_ages[b] );
+                    end_ages.push_back( branch_end_ages[b] );
+                    rates.push_back( branch_rates[b] * r[j] );
+                    P.push_back( &pm );
+                }
+            }
+            
+            if ( P.empty() == false )
+            {
+                rm->calculateTransitionProbabilitiesBatch( start_ages, end_ages, rates, P );
+            }
+            
+            for (size_t i = 0; i < P.size() && pmatrix_cache.isEnabled() == true; ++i)
+            {
+                pmatrix_cache.put( rate_matrix_generation, matrix, start_ages[i], end_ages[i], rates[i], *P[i] );
+            }
+        }
+    }
+    else
+    {
+        // each branch has its own rate matrix, so we can only share the work between the site rates
+        for (size_t b = 0; b < num_branches; ++b)
+        {
+            const RateGenerator *rm = getRateGenerator( branches[b], &jc );
+            
+            start_ages.clear();
+            end_ages.clear();
+            rates.clear();
+            P.clear();
+            size_t pmat_offset = this->active_pmatrices[branches[b]] * this->activePmatrixOffset + branches[b] * this->pmatNodeOffset;
+            for (size_t j = 0; j < this->num_site_rates; ++j)
+            {
+                // the rate matrix of a branch is identified by the index of the branch
+                TransitionProbabilityMatrix &pm = this->pmatrices[pmat_offset + j];
+                if ( pmatrix_cache.isEnabled() == true && pmatrix_cache.get( rate_matrix_generation, branches[b], branch_start_ages[b], branch_end_ages[b], branch_rates[b] * r[j], pm ) == true )
+                {
+                    continue;
+                }
+                
+                start_ages.push_back( branch_start_ages[b] );
+                end_ages.push_back( branch_end_ages[b] );
+                rates.push_back( branch_rates[b] * r[j] );
+                P.push_back( &pm );
+            }
+            
+            if ( P.empty() == false )
+            {
+                rm->calculateTransitionProbabilitiesBatch( start_ages, end_ages, rates, P );
+            }
+            
+            for (size_t i = 0; i < P.size() && pmatrix_cache.isEnabled() == true; ++i)
+            {
+                pmatrix_cache.put( rate_matrix_generation, branches[b], start_ages[i], end_ages[i], rates[i], *P[i] );
+            }
+        }
+    }
 }
 
 #endif
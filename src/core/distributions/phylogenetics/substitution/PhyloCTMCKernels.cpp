@@ -0,0 +1,357 @@
+#include "PhyloCTMCKernels.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+/*
+ * Runtime CPU dispatch: the compiler emits one version of each kernel per target and the
+ * dynamic loader picks the best one for the machine we are running on (requires ifunc support,
+ * hence we only enable it for x86-64 Linux).
+ */
+#if defined(__x86_64__) && defined(__linux__) && defined(__has_attribute)
+    #if __has_attribute(target_clones)
+        #define RB_KERNEL_DISPATCH __attribute__((target_clones("avx512f","avx2","default")))
+    #endif
+#endif
+
+#ifndef RB_KERNEL_DISPATCH
+    #define RB_KERNEL_DISPATCH
+#endif
+
+#if defined(__GNUC__)
+    #define RB_RESTRICT __restrict__
+#else
+    #define RB_RESTRICT
+#endif
+
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    // below this number of states the plain row-by-row loops are faster (unless the number of states is known at compile time)
+    const size_t MIN_VECTORIZED_STATES = 8;
+
+    // the largest value we accept as a probability (to allow for rounding errors)
+    template <class realType>
+    inline double maxProbability(void)
+    {
+        return 1.0 + 1E5 * std::numeric_limits<realType>::epsilon();
+    }
+
+    /*
+     * Compute p_node[c1] = sum_c2 tp(c1,c2) * p_c2[c2] for all starting states c1.
+     * If N is not 0, then it is the number of states known at compile time, which allows the compiler to
+     * unroll the loops and to use full vector registers without remainder loops; otherwise num_chars is used.
+     * We loop over the terminal states c2 and update all starting states with unit stride (which is vectorized).
+     * In both branches the sum for each starting state is accumulated in the order c2 = 0,1,...,
+     * so both give the same result.
+     * The partial likelihoods and the matrix are either both double or both single precision.
+     */
+    template <class realType, size_t N>
+    inline void multiplyTransposedMatrix(const realType* RB_RESTRICT tp_transposed, const realType* RB_RESTRICT p_c2, realType* RB_RESTRICT p_node, size_t num_chars)
+    {
+
+        const size_t n = ( N == 0 ? num_chars : N );
+
+        if ( N == 0 && n < MIN_VECTORIZED_STATES )
+        {
+            for (size_t c1 = 0; c1 < n; ++c1)
+            {
+                realType sum = 0.0;
+
+                const realType* tp_c2 = tp_transposed + c1;
+                for (size_t c2 = 0; c2 < n; ++c2)
+                {
+                    sum += p_c2[c2] * *tp_c2;
+                    tp_c2 += n;
+                }
+
+                p_node[c1] = sum;
+            }
+        }
+        else
+        {
+            for (size_t c1 = 0; c1 < n; ++c1)
+            {
+                p_node[c1] = 0.0;
+            }
+
+            const realType* tp_c2 = tp_transposed;
+            for (size_t c2 = 0; c2 < n; ++c2)
+            {
+                realType w = p_c2[c2];
+                for (size_t c1 = 0; c1 < n; ++c1)
+                {
+                    p_node[c1] += w * tp_c2[c1];
+                }
+                tp_c2 += n;
+            }
+        }
+
+    }
+
+
+    template <class realType, size_t N>
+    inline void computeInternalNodeSites(const realType* RB_RESTRICT tp_transposed, const realType* RB_RESTRICT p_left, const realType* RB_RESTRICT p_right, realType* RB_RESTRICT p_node, realType* RB_RESTRICT scratch, size_t num_chars, size_t num_sites, size_t site_offset)
+    {
+
+        const size_t n = ( N == 0 ? num_chars : N );
+
+        // the product of the descendant likelihoods for each terminal state
+        // (on the stack if we know the number of states, otherwise in the buffer of the caller)
+        realType p_c2_fixed[ N == 0 ? 1 : N ];
+        realType* p_c2 = ( N == 0 ? scratch : p_c2_fixed );
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+
+            for (size_t c2 = 0; c2 < n; ++c2)
+            {
+                p_c2[c2] = p_left[c2] * p_right[c2];
+            }
+
+            multiplyTransposedMatrix<realType, N>( tp_transposed, p_c2, p_node, n );
+
+            for (size_t c1 = 0; c1 < n; ++c1)
+            {
+                assert(std::isnan(p_node[c1]) || (0 <= p_node[c1] and p_node[c1] <= maxProbability<realType>()));
+            }
+
+            // increment the pointers to the next site
+            p_left+=site_offset; p_right+=site_offset; p_node+=site_offset;
+
+        }
+
+    }
+
+
+    template <class realType, size_t N>
+    inline void computeInternalNodeSites(const realType* RB_RESTRICT tp_transposed, const realType* RB_RESTRICT p_left, const realType* RB_RESTRICT p_right, const realType* RB_RESTRICT p_middle, realType* RB_RESTRICT p_node, realType* RB_RESTRICT scratch, size_t num_chars, size_t num_sites, size_t site_offset)
+    {
+
+        const size_t n = ( N == 0 ? num_chars : N );
+
+        // the product of the descendant likelihoods for each terminal state
+        // (on the stack if we know the number of states, otherwise in the buffer of the caller)
+        realType p_c2_fixed[ N == 0 ? 1 : N ];
+        realType* p_c2 = ( N == 0 ? scratch : p_c2_fixed );
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+
+            for (size_t c2 = 0; c2 < n; ++c2)
+            {
+                p_c2[c2] = p_left[c2] * p_middle[c2] * p_right[c2];
+            }
+
+            multiplyTransposedMatrix<realType, N>( tp_transposed, p_c2, p_node, n );
+
+            for (size_t c1 = 0; c1 < n; ++c1)
+            {
+                assert(std::isnan(p_node[c1]) || (0 <= p_node[c1] and p_node[c1] <= maxProbability<realType>()));
+            }
+
+            // increment the pointers to the next site
+            p_left+=site_offset; p_middle+=site_offset; p_right+=site_offset; p_node+=site_offset;
+
+        }
+
+    }
+
+
+    /*
+     * Compute the likelihoods of the root for each starting state, i.e. the product of the descendant likelihoods
+     * and the root frequencies. The likelihoods of the root are always stored in double precision,
+     * whereas the likelihoods of the descendants can be single precision.
+     */
+    template <class realType, size_t N>
+    inline void computeRootSites(const double* RB_RESTRICT f, const realType* RB_RESTRICT p_left, const realType* RB_RESTRICT p_right, double* RB_RESTRICT p_node, size_t num_chars, size_t num_sites, size_t site_offset)
+    {
+
+        const size_t n = ( N == 0 ? num_chars : N );
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+
+            for (size_t c = 0; c < n; ++c)
+            {
+                // add the probability of starting from this state
+                p_node[c] = double(p_left[c]) * p_right[c] * f[c];
+
+                assert(std::isnan(p_node[c]) || (0.0 <= p_node[c] and p_node[c] <= 1.00000000001));
+            }
+
+            // increment the pointers to the next site
+            p_left+=site_offset; p_right+=site_offset; p_node+=site_offset;
+
+        }
+
+    }
+
+
+    template <class realType, size_t N>
+    inline void computeRootSites(const double* RB_RESTRICT f, const realType* RB_RESTRICT p_left, const realType* RB_RESTRICT p_right, const realType* RB_RESTRICT p_middle, double* RB_RESTRICT p_node, size_t num_chars, size_t num_sites, size_t site_offset)
+    {
+
+        const size_t n = ( N == 0 ? num_chars : N );
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+
+            for (size_t c = 0; c < n; ++c)
+            {
+                // add the probability of starting from this state
+                p_node[c] = double(p_left[c]) * p_right[c] * p_middle[c] * f[c];
+
+                assert(std::isnan(p_node[c]) || (0.0 <= p_node[c] and p_node[c] <= 1.00000000001));
+            }
+
+            // increment the pointers to the next site
+            p_left+=site_offset; p_middle+=site_offset; p_right+=site_offset; p_node+=site_offset;
+
+        }
+
+    }
+
+}
+
+
+/*
+ * Call the kernel instantiated for the number of states if we have one (binary, nucleotides,
+ * PoMo with a virtual population size of 2 or 10, amino acids and codons),
+ * and the kernel for a runtime number of states otherwise.
+ */
+#define RB_DISPATCH_NUM_CHARS( KERNEL, REAL, ... )                  \
+    switch ( num_chars )                                            \
+    {                                                               \
+        case  2: KERNEL<REAL, 2>( __VA_ARGS__ ); break;             \
+        case  4: KERNEL<REAL, 4>( __VA_ARGS__ ); break;             \
+        case 10: KERNEL<REAL, 10>( __VA_ARGS__ ); break;            \
+        case 20: KERNEL<REAL, 20>( __VA_ARGS__ ); break;            \
+        case 58: KERNEL<REAL, 58>( __VA_ARGS__ ); break;            \
+        case 61: KERNEL<REAL, 61>( __VA_ARGS__ ); break;            \
+        default: KERNEL<REAL, 0>( __VA_ARGS__ ); break;             \
+    }
+
+
+void PhyloCTMCKernels::transposeMatrix(const double* tp, double* tp_transposed, size_t num_chars)
+{
+
+    for (size_t c1 = 0; c1 < num_chars; ++c1)
+    {
+        for (size_t c2 = 0; c2 < num_chars; ++c2)
+        {
+            tp_transposed[c2*num_chars+c1] = tp[c1*num_chars+c2];
+        }
+    }
+
+}
+
+
+void PhyloCTMCKernels::transposeMatrix(const double* tp, float* tp_transposed, size_t num_chars)
+{
+
+    for (size_t c1 = 0; c1 < num_chars; ++c1)
+    {
+        for (size_t c2 = 0; c2 < num_chars; ++c2)
+        {
+            tp_transposed[c2*num_chars+c1] = float( tp[c1*num_chars+c2] );
+        }
+    }
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeInternalNodeLikelihood(const double* tp_transposed, const double* p_left, const double* p_right, double* p_node, double* scratch, size_t num_chars, size_t num_sites, size_t site_offset)
+{
+
+    RB_DISPATCH_NUM_CHARS( computeInternalNodeSites, double, tp_transposed, p_left, p_right, p_node, scratch, num_chars, num_sites, site_offset )
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeInternalNodeLikelihood(const float* tp_transposed, const float* p_left, const float* p_right, float* p_node, float* scratch, size_t num_chars, size_t num_sites, size_t site_offset)
+{
+
+    RB_DISPATCH_NUM_CHARS( computeInternalNodeSites, float, tp_transposed, p_left, p_right, p_node, scratch, num_chars, num_sites, site_offset )
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeInternalNodeLikelihood(const double* tp_transposed, const double* p_left, const double* p_right, const double* p_middle, double* p_node, double* scratch, size_t num_chars, size_t num_sites, size_t site_offset)
+{
+
+    RB_DISPATCH_NUM_CHARS( computeInternalNodeSites, double, tp_transposed, p_left, p_right, p_middle, p_node, scratch, num_chars, num_sites, site_offset )
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeInternalNodeLikelihood(const float* tp_transposed, const float* p_left, const float* p_right, const float* p_middle, float* p_node, float* scratch, size_t num_chars, size_t num_sites, size_t site_offset)
+{
+
+    RB_DISPATCH_NUM_CHARS( computeInternalNodeSites, float, tp_transposed, p_left, p_right, p_middle, p_node, scratch, num_chars, num_sites, site_offset )
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeTipLikelihood(const double* tp_transposed, const double* observed, double* p_node, size_t num_chars)
+{
+
+    // unobserved states have weight 0 and hence do not change the sums
+    RB_DISPATCH_NUM_CHARS( multiplyTransposedMatrix, double, tp_transposed, observed, p_node, num_chars )
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeTipLikelihood(const float* tp_transposed, const float* observed, float* p_node, size_t num_chars)
+{
+
+    // unobserved states have weight 0 and hence do not change the sums
+    RB_DISPATCH_NUM_CHARS( multiplyTransposedMatrix, float, tp_transposed, observed, p_node, num_chars )
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeRootLikelihood(const double* f, const double* p_left, const double* p_right, double* p_node, size_t num_chars, size_t num_sites, size_t site_offset)
+{
+
+    RB_DISPATCH_NUM_CHARS( computeRootSites, double, f, p_left, p_right, p_node, num_chars, num_sites, site_offset )
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeRootLikelihood(const double* f, const float* p_left, const float* p_right, double* p_node, size_t num_chars, size_t num_sites, size_t site_offset)
+{
+
+    RB_DISPATCH_NUM_CHARS( computeRootSites, float, f, p_left, p_right, p_node, num_chars, num_sites, site_offset )
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeRootLikelihood(const double* f, const double* p_left, const double* p_right, const double* p_middle, double* p_node, size_t num_chars, size_t num_sites, size_t site_offset)
+{
+
+    RB_DISPATCH_NUM_CHARS( computeRootSites, double, f, p_left, p_right, p_middle, p_node, num_chars, num_sites, site_offset )
+
+}
+
+
+RB_KERNEL_DISPATCH
+void PhyloCTMCKernels::computeRootLikelihood(const double* f, const float* p_left, const float* p_right, const float* p_middle, double* p_node, size_t num_chars, size_t num_sites, size_t site_offset)
+{
+
+    RB_DISPATCH_NUM_CHARS( computeRootSites, float, f, p_left, p_right, p_middle, p_node, num_chars, num_sites, site_offset )
+
+}
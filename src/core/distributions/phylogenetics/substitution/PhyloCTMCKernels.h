@@ -0,0 +1,76 @@
+#ifndef PhyloCTMCKernels_H
+#define PhyloCTMCKernels_H
+
+#include <cstddef>
+#include <vector>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Vectorized inner loops of the pruning algorithm for an arbitrary number of states.
+     *
+     * The functions in this namespace compute the partial likelihoods of a contiguous
+     * range of sites (patterns) for one mixture category. They work on the transposed transition
+     * probability matrix, i.e. tp_transposed[c2*num_chars+c1] = P(c1 -> c2), so that the innermost
+     * loop runs over the starting states with unit stride and can be vectorized without
+     * changing the order of the floating-point summation. Hence the results are identical to the
+     * scalar loops.
+     *
+     * For the common numbers of states (2, 4, 10, 20, 58 and 61) the kernels are instantiated with the
+     * number of states as a compile-time constant, so that the compiler can fully unroll and vectorize the
+     * loops over states. Other state spaces use the kernels with a runtime number of states.
+     *
+     * On x86-64 Linux the kernels are compiled for several instruction sets (AVX-512, AVX2 and the
+     * baseline) and the best version for the current CPU is selected at load time.
+     *
+     * All kernels also exist for single-precision partial likelihoods (and matrices), which fit twice as many
+     * values into the cache and into each vector register.
+     *
+     * The internal node kernels need a buffer of num_chars values from the caller, which is only used if
+     * the number of states is not known at compile time. The callers take this buffer and the transposed
+     * matrices from threadBuffer(), so that they do not allocate memory for every block of sites.
+     */
+    namespace PhyloCTMCKernels {
+
+        void        transposeMatrix(const double* tp, double* tp_transposed, size_t num_chars);                                                                                                                 //!< Compute the transposed transition probability matrix
+        void        computeInternalNodeLikelihood(const double* tp_transposed, const double* p_left, const double* p_right, double* p_node, double* scratch, size_t num_chars, size_t num_sites, size_t site_offset);                  //!< Partial likelihoods of a node with two descendants
+        void        computeInternalNodeLikelihood(const double* tp_transposed, const double* p_left, const double* p_right, const double* p_middle, double* p_node, double* scratch, size_t num_chars, size_t num_sites, size_t site_offset); //!< Partial likelihoods of a node with three descendants
+        void        computeRootLikelihood(const double* f, const double* p_left, const double* p_right, double* p_node, size_t num_chars, size_t num_sites, size_t site_offset);                                     //!< Likelihoods of a root with two descendants
+        void        computeRootLikelihood(const double* f, const double* p_left, const double* p_right, const double* p_middle, double* p_node, size_t num_chars, size_t num_sites, size_t site_offset);              //!< Likelihoods of a root with three descendants
+        void        computeTipLikelihood(const double* tp_transposed, const double* observed, double* p_node, size_t num_chars);                                                                                 //!< Partial likelihoods of a single site for a (weighted) ambiguous tip observation
+
+        // single precision
+        void        transposeMatrix(const double* tp, float* tp_transposed, size_t num_chars);                                                                                                                  //!< Compute the transposed transition probability matrix in single precision
+        void        computeInternalNodeLikelihood(const float* tp_transposed, const float* p_left, const float* p_right, float* p_node, float* scratch, size_t num_chars, size_t num_sites, size_t site_offset);                      //!< Partial likelihoods of a node with two descendants
+        void        computeInternalNodeLikelihood(const float* tp_transposed, const float* p_left, const float* p_right, const float* p_middle, float* p_node, float* scratch, size_t num_chars, size_t num_sites, size_t site_offset);  //!< Partial likelihoods of a node with three descendants
+        void        computeRootLikelihood(const double* f, const float* p_left, const float* p_right, double* p_node, size_t num_chars, size_t num_sites, size_t site_offset);                                        //!< Likelihoods of a root with two descendants (in double precision)
+        void        computeRootLikelihood(const double* f, const float* p_left, const float* p_right, const float* p_middle, double* p_node, size_t num_chars, size_t num_sites, size_t site_offset);                 //!< Likelihoods of a root with three descendants (in double precision)
+        void        computeTipLikelihood(const float* tp_transposed, const float* observed, float* p_node, size_t num_chars);                                                                                    //!< Partial likelihoods of a single site for a (weighted) ambiguous tip observation
+
+        template <class realType>
+        realType*   threadBuffer(size_t size);                                                                                                                                                                  //!< Scratch memory of at least size values that belongs to the current thread
+
+    }
+
+}
+
+
+/**
+ * Get scratch memory for the transposed matrices and the kernel buffer.
+ * Every thread keeps one buffer per precision, which only grows, so we do not allocate memory for every
+ * block of sites. The memory may be overwritten by the next call from the same thread.
+ */
+template <class realType>
+realType* RevBayesCore::PhyloCTMCKernels::threadBuffer(size_t size)
+{
+    static thread_local std::vector<realType> buffer;
+
+    if ( buffer.size() < size )
+    {
+        buffer.resize( size );
+    }
+
+    return buffer.data();
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <cassert>
 #include "AbstractPhyloCTMCSiteHomogeneous.h"
 #include "DnaState.h"
+#include "PhyloCTMCKernels.h"
 #include "RateMatrix.h"
 #include "RbVector.h"
 #include "TopologyNode.h"
@@ -34,7 +35,19 @@ namespace RevBayesCore {
 
     private:
 
+        // the kernels for double or single-precision partial likelihoods (realType)
+        template <class realType>
+        void                                                computeRootSites(double* p, const realType* p_left, const realType* p_right, double* root_scaling, const double* left_scaling, const double* right_scaling);
+        template <class realType>
+        void                                                computeRootSites(double* p, const realType* p_left, const realType* p_right, const realType* p_middle, double* root_scaling, const double* left_scaling, const double* right_scaling, const double* middle_scaling);
+        template <class realType>
+        void                                                computeInternalNodeSites(size_t pmat_offset, realType* p_node, const realType* p_left, const realType* p_right, double* node_scaling, const double* left_scaling, const double* right_scaling);
+        template <class realType>
+        void                                                computeInternalNodeSites(size_t pmat_offset, realType* p_node, const realType* p_left, const realType* p_right, const realType* p_middle, double* node_scaling, const double* left_scaling, const double* right_scaling, const double* middle_scaling);
+        template <class realType>
+        void                                                computeTipSites(const TopologyNode &node, size_t node_index, realType* p_node);
 
+        static const size_t                                 SCALING_CHUNK_SIZE = 64;                                                                    //!< The number of sites that we compute before rescaling them (lazy scaling)
 
     };
 
@@ -77,68 +90,65 @@ template<class charType>
 void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeRootLikelihood( size_t root, size_t left, size_t right)
 {
 
-    // get the pointers to the partial likelihoods of the left and right subtree
-          double* p        = this->partialLikelihoods + this->activeLikelihood[root]  * this->activeLikelihoodOffset + root  * this->nodeOffset;
-    const double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]  * this->activeLikelihoodOffset + left  * this->nodeOffset;
-    const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right] * this->activeLikelihoodOffset + right * this->nodeOffset;
+    // get the pointers to the scaling factors of the root and the left and right subtree
+          double* root_scaling   = this->perNodeSiteLogScalingFactors + this->activeLikelihood[root]  * this->activeScalingFactorOffset + root  * this->scalingFactorNodeOffset;
+    const double* left_scaling   = this->perNodeSiteLogScalingFactors + this->activeLikelihood[left]  * this->activeScalingFactorOffset + left  * this->scalingFactorNodeOffset;
+    const double* right_scaling  = this->perNodeSiteLogScalingFactors + this->activeLikelihood[right] * this->activeScalingFactorOffset + right * this->scalingFactorNodeOffset;
 
-    // create a vector for the per mixture likelihoods
-    // we need this vector to sum over the different mixture likelihoods
-    std::vector<double> per_mixture_Likelihoods = std::vector<double>(this->num_patterns,0.0);
+    // the likelihoods of the root are always stored in double precision
+    double* p = this->getRootPartialLikelihoods( root );
 
-    // get pointers the likelihood for both subtrees
-          double*   p_mixture          = p;
-    const double*   p_mixture_left     = p_left;
-    const double*   p_mixture_right    = p_right;
+    if ( this->use_single_precision == true )
+    {
+        computeRootSites( p, this->getSinglePrecisionPartialLikelihoods(left), this->getSinglePrecisionPartialLikelihoods(right), root_scaling, left_scaling, right_scaling );
+    }
+    else
+    {
+        const double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]  * this->activeLikelihoodOffset + left  * this->nodeOffset;
+        const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right] * this->activeLikelihoodOffset + right * this->nodeOffset;
+        computeRootSites( p, p_left, p_right, root_scaling, left_scaling, right_scaling );
+    }
+
+}
+
+
+template<class charType>
+template<class realType>
+void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeRootSites( double* p, const realType* p_left, const realType* p_right, double* root_scaling, const double* left_scaling, const double* right_scaling )
+{
+
+    // with lazy scaling we rescale each block of sites directly after computing it
+    bool lazy_scaling = this->useLazyScaling();
 
     // get the root frequencies
     std::vector<std::vector<double> >   ff;
     this->getRootFrequencies(ff);
 
-    // iterate over all mixture categories
-    for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+    // compute the likelihoods for each block of sites (possibly in parallel)
+    this->forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
     {
-        // get the root frequencies
-        const std::vector<double> &f                    = ff[mixture % ff.size()];
-        assert(f.size() == this->num_chars);
-        std::vector<double>::const_iterator f_end       = f.end();
-        std::vector<double>::const_iterator f_begin     = f.begin();
-
-        // get pointers to the likelihood for this mixture category
-              double*   p_site_mixture          = p_mixture;
-        const double*   p_site_mixture_left     = p_mixture_left;
-        const double*   p_site_mixture_right    = p_mixture_right;
-        // iterate over all sites
-        for (size_t site = 0; site < this->pattern_block_size; ++site)
+        // iterate over all mixture categories
+        for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
         {
-            // get the pointer to the stationary frequencies
-            std::vector<double>::const_iterator f_j             = f_begin;
-            // get the pointers to the likelihoods for this site and mixture category
-                  double* p_site_j        = p_site_mixture;
-            const double* p_site_left_j   = p_site_mixture_left;
-            const double* p_site_right_j  = p_site_mixture_right;
-            // iterate over all starting states
-            for (; f_j != f_end; ++f_j)
-            {
-                // add the probability of starting from this state
-                *p_site_j = *p_site_left_j * *p_site_right_j * *f_j;
-
-                assert(isnan(*p_site_j) || (0.0 <= *p_site_j and *p_site_j <= 1.00000000001));
-
-                // increment pointers
-                ++p_site_j; ++p_site_left_j; ++p_site_right_j;
-            }
+            // get the root frequencies
+            const std::vector<double> &f = ff[mixture % ff.size()];
+            assert(f.size() == this->num_chars);
 
-            // increment the pointers to the next site
-            p_site_mixture+=this->siteOffset; p_site_mixture_left+=this->siteOffset; p_site_mixture_right+=this->siteOffset;
+            // get the pointers to the likelihood for this mixture category
+            size_t offset = mixture*this->mixtureOffset + pattern_start*this->siteOffset;
 
-        } // end-for over all sites (=patterns)
+            // compute the per site probabilities
+            PhyloCTMCKernels::computeRootLikelihood( f.data(), p_left + offset, p_right + offset, p + offset, this->num_chars, pattern_end - pattern_start, this->siteOffset );
 
-        // increment the pointers to the next mixture category
-        p_mixture+=this->mixtureOffset; p_mixture_left+=this->mixtureOffset; p_mixture_right+=this->mixtureOffset;
+        } // end-for over all mixtures (=rate categories)
 
-    } // end-for over all mixtures (=rate categories)
+        if ( lazy_scaling == true )
+        {
+            this->scalePatternsLazily(p, root_scaling, left_scaling, right_scaling, NULL, pattern_start, pattern_end);
+        }
+    });
 
+    this->scaled_in_kernel = lazy_scaling;
 
 }
 
@@ -147,69 +157,67 @@ template<class charType>
 void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeRootLikelihood( size_t root, size_t left, size_t right, size_t middle)
 {
 
-    // get the pointers to the partial likelihoods of the left and right subtree
-          double* p        = this->partialLikelihoods + this->activeLikelihood[root]   * this->activeLikelihoodOffset + root   * this->nodeOffset;
-    const double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]   * this->activeLikelihoodOffset + left   * this->nodeOffset;
-    const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right]  * this->activeLikelihoodOffset + right  * this->nodeOffset;
-    const double* p_middle = this->partialLikelihoods + this->activeLikelihood[middle] * this->activeLikelihoodOffset + middle * this->nodeOffset;
+    // get the pointers to the scaling factors of the root and the left, right and middle subtree
+          double* root_scaling   = this->perNodeSiteLogScalingFactors + this->activeLikelihood[root]   * this->activeScalingFactorOffset + root   * this->scalingFactorNodeOffset;
+    const double* left_scaling   = this->perNodeSiteLogScalingFactors + this->activeLikelihood[left]   * this->activeScalingFactorOffset + left   * this->scalingFactorNodeOffset;
+    const double* right_scaling  = this->perNodeSiteLogScalingFactors + this->activeLikelihood[right]  * this->activeScalingFactorOffset + right  * this->scalingFactorNodeOffset;
+    const double* middle_scaling = this->perNodeSiteLogScalingFactors + this->activeLikelihood[middle] * this->activeScalingFactorOffset + middle * this->scalingFactorNodeOffset;
+
+    // the likelihoods of the root are always stored in double precision
+    double* p = this->getRootPartialLikelihoods( root );
+
+    if ( this->use_single_precision == true )
+    {
+        computeRootSites( p, this->getSinglePrecisionPartialLikelihoods(left), this->getSinglePrecisionPartialLikelihoods(right), this->getSinglePrecisionPartialLikelihoods(middle), root_scaling, left_scaling, right_scaling, middle_scaling );
+    }
+    else
+    {
+        const double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]   * this->activeLikelihoodOffset + left   * this->nodeOffset;
+        const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right]  * this->activeLikelihoodOffset + right  * this->nodeOffset;
+        const double* p_middle = this->partialLikelihoods + this->activeLikelihood[middle] * this->activeLikelihoodOffset + middle * this->nodeOffset;
+        computeRootSites( p, p_left, p_right, p_middle, root_scaling, left_scaling, right_scaling, middle_scaling );
+    }
+
+}
+
+
+template<class charType>
+template<class realType>
+void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeRootSites( double* p, const realType* p_left, const realType* p_right, const realType* p_middle, double* root_scaling, const double* left_scaling, const double* right_scaling, const double* middle_scaling )
+{
 
-    // get pointers the likelihood for both subtrees
-          double*   p_mixture          = p;
-    const double*   p_mixture_left     = p_left;
-    const double*   p_mixture_right    = p_right;
-    const double*   p_mixture_middle   = p_middle;
+    // with lazy scaling we rescale each block of sites directly after computing it
+    bool lazy_scaling = this->useLazyScaling();
 
     // get the root frequencies
     std::vector<std::vector<double> >   ff;
     this->getRootFrequencies(ff);
 
-    // iterate over all mixture categories
-    for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+    // compute the likelihoods for each block of sites (possibly in parallel)
+    this->forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
     {
-        
-        // get the root frequencies
-        const std::vector<double> &f                    = ff[mixture % ff.size()];
-        assert(f.size() == this->num_chars);
-        std::vector<double>::const_iterator f_end       = f.end();
-        std::vector<double>::const_iterator f_begin     = f.begin();
-
-        // get pointers to the likelihood for this mixture category
-              double*   p_site_mixture          = p_mixture;
-        const double*   p_site_mixture_left     = p_mixture_left;
-        const double*   p_site_mixture_right    = p_mixture_right;
-        const double*   p_site_mixture_middle   = p_mixture_middle;
-        // iterate over all sites
-        for (size_t site = 0; site < this->pattern_block_size; ++site)
+        // iterate over all mixture categories
+        for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
         {
+            // get the root frequencies
+            const std::vector<double> &f = ff[mixture % ff.size()];
+            assert(f.size() == this->num_chars);
 
-            // get the pointer to the stationary frequencies
-            std::vector<double>::const_iterator f_j = f_begin;
-            // get the pointers to the likelihoods for this site and mixture category
-                  double* p_site_j        = p_site_mixture;
-            const double* p_site_left_j   = p_site_mixture_left;
-            const double* p_site_right_j  = p_site_mixture_right;
-            const double* p_site_middle_j = p_site_mixture_middle;
-            // iterate over all starting states
-            for (; f_j != f_end; ++f_j)
-            {
-                // add the probability of starting from this state
-                *p_site_j = *p_site_left_j * *p_site_right_j * *p_site_middle_j * *f_j;
+            // get the pointers to the likelihood for this mixture category
+            size_t offset = mixture*this->mixtureOffset + pattern_start*this->siteOffset;
 
-                assert(isnan(*p_site_j) || (0.0 <= *p_site_j and *p_site_j <= 1.00000000001));
+            // compute the per site probabilities
+            PhyloCTMCKernels::computeRootLikelihood( f.data(), p_left + offset, p_right + offset, p_middle + offset, p + offset, this->num_chars, pattern_end - pattern_start, this->siteOffset );
 
-                // increment pointers
-                ++p_site_j; ++p_site_left_j; ++p_site_right_j; ++p_site_middle_j;
-            }
-
-            // increment the pointers to the next site
-            p_site_mixture+=this->siteOffset; p_site_mixture_left+=this->siteOffset; p_site_mixture_right+=this->siteOffset; p_site_mixture_middle+=this->siteOffset;
-
-        } // end-for over all sites (=patterns)
+        } // end-for over all mixtures (=rate categories)
 
-        // increment the pointers to the next mixture category
-        p_mixture+=this->mixtureOffset; p_mixture_left+=this->mixtureOffset; p_mixture_right+=this->mixtureOffset; p_mixture_middle+=this->mixtureOffset;
+        if ( lazy_scaling == true )
+        {
+            this->scalePatternsLazily(p, root_scaling, left_scaling, right_scaling, middle_scaling, pattern_start, pattern_end);
+        }
+    });
 
-    } // end-for over all mixtures (=rate categories)
+    this->scaled_in_kernel = lazy_scaling;
 
 }
 
@@ -222,58 +230,73 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeInternalNodeLikeli
 //    this->updateTransitionProbabilities( node_index );
     size_t pmat_offset = this->active_pmatrices[node_index] * this->activePmatrixOffset + node_index * this->pmatNodeOffset;
 
-    // get the pointers to the partial likelihoods for this node and the two descendant subtrees
-    const double*   p_left  = this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
-    const double*   p_right = this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
-    double*         p_node  = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+    // get the pointers to the scaling factors for this node and the two descendant subtrees
+    double*         node_scaling    = this->perNodeSiteLogScalingFactors + this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset;
+    const double*   left_scaling    = this->perNodeSiteLogScalingFactors + this->activeLikelihood[left]*this->activeScalingFactorOffset + left*this->scalingFactorNodeOffset;
+    const double*   right_scaling   = this->perNodeSiteLogScalingFactors + this->activeLikelihood[right]*this->activeScalingFactorOffset + right*this->scalingFactorNodeOffset;
 
-    // iterate over all mixture categories
-    for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+    if ( this->use_single_precision == true )
     {
-        // the transition probability matrix for this mixture category
-//        const double*    tp_begin                = this->transition_prob_matrices[mixture].theMatrix;
-        const double* tp_begin = this->pmatrices[pmat_offset + mixture].theMatrix;
-
-        // get the pointers to the likelihood for this mixture category
-        size_t offset = mixture*this->mixtureOffset;
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-        // compute the per site probabilities
-        for (size_t site = 0; site < this->pattern_block_size ; ++site)
-        {
+        computeInternalNodeSites( pmat_offset, this->getSinglePrecisionPartialLikelihoods(node_index), this->getSinglePrecisionPartialLikelihoods(left), this->getSinglePrecisionPartialLikelihoods(right), node_scaling, left_scaling, right_scaling );
+    }
+    else
+    {
+        // get the pointers to the partial likelihoods for this node and the two descendant subtrees
+        const double*   p_left  = this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
+        const double*   p_right = this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
+        double*         p_node  = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+        computeInternalNodeSites( pmat_offset, p_node, p_left, p_right, node_scaling, left_scaling, right_scaling );
+    }
 
-            // get the pointers for this mixture category and this site
-            const double*       tp_a    = tp_begin;
-            // iterate over the possible starting states
-            for (size_t c1 = 0; c1 < this->num_chars; ++c1)
-            {
-                // temporary variable
-                double sum = 0.0;
+}
 
-                // iterate over all possible terminal states
-                for (size_t c2 = 0; c2 < this->num_chars; ++c2 )
-                {
-                    sum += p_site_mixture_left[c2] * p_site_mixture_right[c2] * tp_a[c2];
 
-                } // end-for over all distination character
+template<class charType>
+template<class realType>
+void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeInternalNodeSites(size_t pmat_offset, realType* p_node, const realType* p_left, const realType* p_right, double* node_scaling, const double* left_scaling, const double* right_scaling)
+{
+
+    // with lazy scaling we rescale the sites while they are still in the cache
+    bool lazy_scaling = this->useLazyScaling();
 
-                // store the likelihood for this starting state
-                p_site_mixture[c1] = sum;
+    // compute the likelihoods for each block of sites (possibly in parallel)
+    this->forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
+    {
+        // the transposed transition probability matrices of all mixture categories for the vectorized kernel,
+        // followed by the buffer that the kernel needs if the number of states is not known at compile time
+        size_t matrix_size = this->num_chars * this->num_chars;
+        realType* tp_transposed = PhyloCTMCKernels::threadBuffer<realType>( this->num_site_mixtures * matrix_size + this->num_chars );
+        realType* kernel_buffer = tp_transposed + this->num_site_mixtures * matrix_size;
+        for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+        {
+            PhyloCTMCKernels::transposeMatrix( this->pmatrices[pmat_offset + mixture].theMatrix, tp_transposed + mixture*matrix_size, this->num_chars );
+        }
 
-                assert(isnan(sum) || (0 <= sum and sum <= 1.00000000001));
+        // iterate over small chunks of sites, so that we can rescale a chunk before it leaves the cache
+        size_t chunk_size = ( lazy_scaling == true ? SCALING_CHUNK_SIZE : pattern_end - pattern_start );
+        for (size_t chunk_start = pattern_start; chunk_start < pattern_end; chunk_start += chunk_size)
+        {
+            size_t chunk_end = std::min( chunk_start + chunk_size, pattern_end );
 
-                // increment the pointers to the next starting state
-                tp_a+=this->num_chars;
+            // iterate over all mixture categories
+            for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+            {
+                // get the pointers to the likelihood for this mixture category
+                size_t offset = mixture*this->mixtureOffset + chunk_start*this->siteOffset;
 
-            } // end-for over all initial characters
+                // compute the per site probabilities
+                PhyloCTMCKernels::computeInternalNodeLikelihood( tp_transposed + mixture*matrix_size, p_left + offset, p_right + offset, p_node + offset, kernel_buffer, this->num_chars, chunk_end - chunk_start, this->siteOffset );
 
-            // increment the pointers to the next site
-            p_site_mixture_left+=this->siteOffset; p_site_mixture_right+=this->siteOffset; p_site_mixture+=this->siteOffset;
+            } // end-for over all mixtures (=rate-categories)
 
-        } // end-for over all sites (=patterns)
+            if ( lazy_scaling == true )
+            {
+                this->scalePatternsLazily(p_node, node_scaling, left_scaling, right_scaling, NULL, chunk_start, chunk_end);
+            }
+        }
+    });
 
-    } // end-for over all mixtures (=rate-categories)
+    this->scaled_in_kernel = lazy_scaling;
 
 }
 
@@ -286,60 +309,75 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeInternalNodeLikeli
 //    this->updateTransitionProbabilities( node_index );
     size_t pmat_offset = this->active_pmatrices[node_index] * this->activePmatrixOffset + node_index * this->pmatNodeOffset;
 
-    // get the pointers to the partial likelihoods for this node and the two descendant subtrees
-    const double*   p_left      = this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
-    const double*   p_middle    = this->partialLikelihoods + this->activeLikelihood[middle]*this->activeLikelihoodOffset + middle*this->nodeOffset;
-    const double*   p_right     = this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
-    double*         p_node      = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+    // get the pointers to the scaling factors for this node and the three descendant subtrees
+    double*         node_scaling    = this->perNodeSiteLogScalingFactors + this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset;
+    const double*   left_scaling    = this->perNodeSiteLogScalingFactors + this->activeLikelihood[left]*this->activeScalingFactorOffset + left*this->scalingFactorNodeOffset;
+    const double*   right_scaling   = this->perNodeSiteLogScalingFactors + this->activeLikelihood[right]*this->activeScalingFactorOffset + right*this->scalingFactorNodeOffset;
+    const double*   middle_scaling  = this->perNodeSiteLogScalingFactors + this->activeLikelihood[middle]*this->activeScalingFactorOffset + middle*this->scalingFactorNodeOffset;
 
-    // iterate over all mixture categories
-    for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+    if ( this->use_single_precision == true )
     {
-        // the transition probability matrix for this mixture category
-//        const double*    tp_begin                = this->transition_prob_matrices[mixture].theMatrix;
-        const double* tp_begin = this->pmatrices[pmat_offset + mixture].theMatrix;
-
-        // get the pointers to the likelihood for this mixture category
-        size_t offset = mixture*this->mixtureOffset;
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_middle   = p_middle + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-        // compute the per site probabilities
-        for (size_t site = 0; site < this->pattern_block_size ; ++site)
-        {
+        computeInternalNodeSites( pmat_offset, this->getSinglePrecisionPartialLikelihoods(node_index), this->getSinglePrecisionPartialLikelihoods(left), this->getSinglePrecisionPartialLikelihoods(right), this->getSinglePrecisionPartialLikelihoods(middle), node_scaling, left_scaling, right_scaling, middle_scaling );
+    }
+    else
+    {
+        // get the pointers to the partial likelihoods for this node and the three descendant subtrees
+        const double*   p_left      = this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
+        const double*   p_middle    = this->partialLikelihoods + this->activeLikelihood[middle]*this->activeLikelihoodOffset + middle*this->nodeOffset;
+        const double*   p_right     = this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
+        double*         p_node      = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+        computeInternalNodeSites( pmat_offset, p_node, p_left, p_right, p_middle, node_scaling, left_scaling, right_scaling, middle_scaling );
+    }
 
-            // get the pointers for this mixture category and this site
-            const double*       tp_a    = tp_begin;
-            // iterate over the possible starting states
-            for (size_t c1 = 0; c1 < this->num_chars; ++c1)
-            {
-                // temporary variable
-                double sum = 0.0;
+}
 
-                // iterate over all possible terminal states
-                for (size_t c2 = 0; c2 < this->num_chars; ++c2 )
-                {
-                    sum += p_site_mixture_left[c2] * p_site_mixture_middle[c2] * p_site_mixture_right[c2] * tp_a[c2];
 
-                } // end-for over all distination character
+template<class charType>
+template<class realType>
+void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeInternalNodeSites(size_t pmat_offset, realType* p_node, const realType* p_left, const realType* p_right, const realType* p_middle, double* node_scaling, const double* left_scaling, const double* right_scaling, const double* middle_scaling)
+{
+
+    // with lazy scaling we rescale the sites while they are still in the cache
+    bool lazy_scaling = this->useLazyScaling();
 
-                assert(isnan(sum) || (0 <= sum and sum <= 1.00000000001));
+    // compute the likelihoods for each block of sites (possibly in parallel)
+    this->forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
+    {
+        // the transposed transition probability matrices of all mixture categories for the vectorized kernel,
+        // followed by the buffer that the kernel needs if the number of states is not known at compile time
+        size_t matrix_size = this->num_chars * this->num_chars;
+        realType* tp_transposed = PhyloCTMCKernels::threadBuffer<realType>( this->num_site_mixtures * matrix_size + this->num_chars );
+        realType* kernel_buffer = tp_transposed + this->num_site_mixtures * matrix_size;
+        for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+        {
+            PhyloCTMCKernels::transposeMatrix( this->pmatrices[pmat_offset + mixture].theMatrix, tp_transposed + mixture*matrix_size, this->num_chars );
+        }
 
-                // store the likelihood for this starting state
-                p_site_mixture[c1] = sum;
+        // iterate over small chunks of sites, so that we can rescale a chunk before it leaves the cache
+        size_t chunk_size = ( lazy_scaling == true ? SCALING_CHUNK_SIZE : pattern_end - pattern_start );
+        for (size_t chunk_start = pattern_start; chunk_start < pattern_end; chunk_start += chunk_size)
+        {
+            size_t chunk_end = std::min( chunk_start + chunk_size, pattern_end );
 
-                // increment the pointers to the next starting state
-                tp_a+=this->num_chars;
+            // iterate over all mixture categories
+            for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+            {
+                // get the pointers to the likelihood for this mixture category
+                size_t offset = mixture*this->mixtureOffset + chunk_start*this->siteOffset;
 
-            } // end-for over all initial characters
+                // compute the per site probabilities
+                PhyloCTMCKernels::computeInternalNodeLikelihood( tp_transposed + mixture*matrix_size, p_left + offset, p_right + offset, p_middle + offset, p_node + offset, kernel_buffer, this->num_chars, chunk_end - chunk_start, this->siteOffset );
 
-            // increment the pointers to the next site
-            p_site_mixture_left+=this->siteOffset; p_site_mixture_middle+=this->siteOffset; p_site_mixture_right+=this->siteOffset; p_site_mixture+=this->siteOffset;
+            } // end-for over all mixtures (=rate-categories)
 
-        } // end-for over all sites (=patterns)
+            if ( lazy_scaling == true )
+            {
+                this->scalePatternsLazily(p_node, node_scaling, left_scaling, right_scaling, middle_scaling, chunk_start, chunk_end);
+            }
+        }
+    });
 
-    } // end-for over all mixtures (=rate-categories)
+    this->scaled_in_kernel = lazy_scaling;
 
 }
 
@@ -350,8 +388,24 @@ template<class charType>
 void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeTipLikelihood(const TopologyNode &node, size_t node_index)
 {
 
-    double* p_node = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
-    
+    if ( this->use_single_precision == true )
+    {
+        computeTipSites( node, node_index, this->getSinglePrecisionPartialLikelihoods(node_index) );
+    }
+    else
+    {
+        double* p_node = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
+        computeTipSites( node, node_index, p_node );
+    }
+
+}
+
+
+template<class charType>
+template<class realType>
+void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeTipSites(const TopologyNode &node, size_t node_index, realType* p_node)
+{
+
     // get the current correct tip index in case the whole tree change (after performing an empiricalTree Proposal)
     size_t data_tip_index = this->taxon_name_2_tip_index_map[ node.getName() ];
     const std::vector<bool> &gap_node = this->gap_matrix[data_tip_index];
@@ -367,123 +421,102 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeTipLikelihood(cons
 //    this->updateTransitionProbabilities( node_index );
     size_t pmat_offset = this->active_pmatrices[node_index] * this->activePmatrixOffset + node_index * this->pmatNodeOffset;
 
-    double* p_mixture = p_node;
-
-    // iterate over all mixture categories
-    for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
+    // compute the likelihoods for each block of sites (possibly in parallel)
+    this->forEachPatternBlock( [&](size_t pattern_start, size_t pattern_end)
     {
-        // the transition probability matrix for this mixture category
-//         const double* tp_begin = this->transition_prob_matrices[mixture].theMatrix;
-        const double* tp_begin = this->pmatrices[pmat_offset + mixture].theMatrix;
+        realType* p_mixture = p_node + pattern_start*this->siteOffset;
 
-        // get the pointer to the likelihoods for this site and mixture category
-        double* p_site_mixture = p_mixture;
+        // the transposed transition probability matrix and the observed states for the vectorized kernel
+        bool use_kernel = this->using_ambiguous_characters == true || this->using_weighted_characters == true;
+        realType* tp_transposed = ( use_kernel ? PhyloCTMCKernels::threadBuffer<realType>( (this->num_chars + 1) * this->num_chars ) : NULL );
+        realType* observed      = ( use_kernel ? tp_transposed + this->num_chars * this->num_chars : NULL );
 
-        // iterate over all sites
-        for (size_t site = 0; site != this->pattern_block_size; ++site)
+        // iterate over all mixture categories
+        for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
         {
-
-            // is this site a gap?
-            if ( gap_node[site] )
+            // the transition probability matrix for this mixture category
+//         const double* tp_begin = this->transition_prob_matrices[mixture].theMatrix;
+            const double* tp_begin = this->pmatrices[pmat_offset + mixture].theMatrix;
+            if ( use_kernel == true )
             {
-                // since this is a gap we need to assume that the actual state could have been any state
-
-                // iterate over all initial states for the transitions
-                for (size_t c1 = 0; c1 < this->num_chars; ++c1)
-                {
+                PhyloCTMCKernels::transposeMatrix( tp_begin, tp_transposed, this->num_chars );
+            }
 
-                    // store the likelihood
-                    p_site_mixture[c1] = 1.0;
+            // get the pointer to the likelihoods for this site and mixture category
+            realType* p_site_mixture = p_mixture;
 
-                }
-            }
-            else // we have observed a character
+            // iterate over all sites
+            for (size_t site = pattern_start; site != pattern_end; ++site)
             {
 
-                // iterate over all possible initial states
-                for (size_t c1 = 0; c1 < this->num_chars; ++c1)
+                // is this site a gap?
+                if ( gap_node[site] )
                 {
+                    // since this is a gap we need to assume that the actual state could have been any state
 
-                    if ( this->using_ambiguous_characters == true && this->using_weighted_characters == false)
+                    // iterate over all initial states for the transitions
+                    for (size_t c1 = 0; c1 < this->num_chars; ++c1)
                     {
-                        // compute the likelihood that we had a transition from state c1 to the observed state org_val
-                        // note, the observed state could be ambiguous!
-                        const RbBitSet &val = amb_char_node[site];
-
-                        // get the pointer to the transition probabilities for the terminal states
-                        const double* d  = tp_begin+(this->num_chars*c1);
-
-                        double tmp = 0.0;
-
-                        for ( size_t i=0; i<this->num_chars; ++i )
-                        {
-                            // check whether we observed this state
-                            if ( val.test(i) == true )
-                            {
-                                // add the probability
-                                tmp += *d;
-                            }
-
-                            // increment the pointer to the next transition probability
-                            ++d;
-                        } // end-while over all observed states for this character
 
                         // store the likelihood
-                        p_site_mixture[c1] = tmp;
-                        
-                    }
-                    else if ( this->using_weighted_characters == true )
-                    {
-                        // compute the likelihood that we had a transition from state c1 to the observed state org_val
-                        // note, the observed state could be ambiguous!
-//                        const RbBitSet &val = amb_char_node[site];
-                        size_t this_site_index = site_indices[site];
-                        const RbBitSet &val = this->value->getCharacter(char_data_node_index, this_site_index).getState();
-
-                        // get the pointer to the transition probabilities for the terminal states
-                        const double* d = tp_begin+(this->num_chars*c1);
-
-                        double tmp = 0.0;
-                        const std::vector< double >& weights = this->value->getCharacter(char_data_node_index, this_site_index).getWeights();
-                        for ( size_t i=0; i<this->num_chars; ++i )
-                        {
-                            // check whether we observed this state
-                            if ( val.test(i) == true )
-                            {
-                                // add the probability
-                                tmp += *d * weights[i] ;
-                            }
-
-                            // increment the pointer to the next transition probability
-                            ++d;
-                        } // end-while over all observed states for this character
+                        p_site_mixture[c1] = 1.0;
 
-                        // store the likelihood
-                        p_site_mixture[c1] = tmp;
-                        
                     }
-                    else // no ambiguous characters in use
+                }
+                else if ( this->using_ambiguous_characters == true && this->using_weighted_characters == false )
+                {
+                    // compute the likelihood that we had a transition from each state c1 to the observed state
+                    // note, the observed state could be ambiguous!
+                    const RbBitSet &val = amb_char_node[site];
+                    for ( size_t i=0; i<this->num_chars; ++i )
                     {
-                        unsigned long org_val = char_node[site];
+                        observed[i] = ( val.test(i) == true ? 1.0 : 0.0 );
+                    }
 
-                        // store the likelihood
-                        p_site_mixture[c1] = tp_begin[c1*this->num_chars+org_val];
+                    // sum the transition probabilities over all observed states
+                    PhyloCTMCKernels::computeTipLikelihood( tp_transposed, observed, p_site_mixture, this->num_chars );
 
+                }
+                else if ( this->using_weighted_characters == true )
+                {
+                    // compute the likelihood that we had a transition from each state c1 to the observed state
+                    // note, the observed state could be ambiguous!
+                    size_t this_site_index = site_indices[site];
+                    const RbBitSet &val = this->value->getCharacter(char_data_node_index, this_site_index).getState();
+                    const std::vector< double >& weights = this->value->getCharacter(char_data_node_index, this_site_index).getWeights();
+                    for ( size_t i=0; i<this->num_chars; ++i )
+                    {
+                        observed[i] = realType( val.test(i) == true ? weights[i] : 0.0 );
                     }
 
-                } // end-for over all possible initial character for the branch
+                    // sum the weighted transition probabilities over all observed states
+                    PhyloCTMCKernels::computeTipLikelihood( tp_transposed, observed, p_site_mixture, this->num_chars );
+
+                }
+                else // no ambiguous characters in use
+                {
+                    unsigned long org_val = char_node[site];
+
+                    // iterate over all possible initial states
+                    for (size_t c1 = 0; c1 < this->num_chars; ++c1)
+                    {
+                        // store the likelihood
+                        p_site_mixture[c1] = realType( tp_begin[c1*this->num_chars+org_val] );
+
+                    } // end-for over all possible initial character for the branch
 
-            } // end-if a gap state
+                } // end-if a gap state
 
-            // increment the pointers to next site
-            p_site_mixture+=this->siteOffset;
+                // increment the pointers to next site
+                p_site_mixture+=this->siteOffset;
 
-        } // end-for over all sites/patterns in the sequence
+            } // end-for over all sites/patterns in the sequence
 
-        // increment the pointers to next mixture category
-        p_mixture+=this->mixtureOffset;
+            // increment the pointers to next mixture category
+            p_mixture+=this->mixtureOffset;
 
-    } // end-for over all mixture categories
+        } // end-for over all mixture categories
+    });
 
 }
 
@@ -93,9 +93,9 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::resizeLikelihoodVectors( void
     if ( in_mcmc_mode == true )
     {
         // we resize the partial likelihood vectors to the new dimensions
-        delete [] partialLikelihoods;
+        BufferPool::bufferPoolInstance().release( partialLikelihoods );
 
-        partialLikelihoods = new double[2*activeLikelihoodOffset];
+        partialLikelihoods = BufferPool::bufferPoolInstance().allocate( 2*activeLikelihoodOffset );
 
         // reinitialize likelihood vectors
         for (size_t i = 0; i < 2*activeLikelihoodOffset; i++)
@@ -1327,7 +1327,7 @@ double RevBayesCore::PhyloCTMCSiteHomogeneousDollo::getScaledNodeWeights(const T
 
     const double* p_node  = partialLikelihoods + activeLikelihood[node_index] * activeLikelihoodOffset  + node_index*nodeOffset + pattern*siteOffset;
 
-    double logScalingFactor = perNodeSiteLogScalingFactors[activeLikelihood[node_index]][node_index][pattern];
+    double logScalingFactor = perNodeSiteLogScalingFactors[activeLikelihood[node_index]*activeScalingFactorOffset + node_index*scalingFactorNodeOffset + pattern];
 
     //otherwise, it is an ancestral node so we add the integrated likelihood
     for (size_t mixture = 0; mixture < num_site_mixtures; ++mixture)
@@ -1402,7 +1402,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::scale( size_t node_index)
 
             }
 
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = -log(max);
+            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] = -log(max);
 
 
             // compute the per site probabilities
@@ -1427,7 +1427,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::scale( size_t node_index)
         // iterate over all mixture categories
         for (size_t site = 0; site < this->pattern_block_size ; ++site)
         {
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = 0;
+            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] = 0;
         }
 
     }
@@ -1465,7 +1465,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::scale( size_t node_index, size
 
             }
 
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]][left][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]][right][site] - log(max);
+            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]*this->activeScalingFactorOffset + left*this->scalingFactorNodeOffset + site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]*this->activeScalingFactorOffset + right*this->scalingFactorNodeOffset + site] - log(max);
 
 
             // compute the per site probabilities
@@ -1490,7 +1490,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::scale( size_t node_index, size
         // iterate over all mixture categories
         for (size_t site = 0; site < this->pattern_block_size ; ++site)
         {
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]][left][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]][right][site];
+            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]*this->activeScalingFactorOffset + left*this->scalingFactorNodeOffset + site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]*this->activeScalingFactorOffset + right*this->scalingFactorNodeOffset + site];
         }
 
     }
@@ -1527,7 +1527,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::scale( size_t node_index, size
 
             }
 
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]][left][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]][right][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[middle]][middle][site] - log(max);
+            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]*this->activeScalingFactorOffset + left*this->scalingFactorNodeOffset + site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]*this->activeScalingFactorOffset + right*this->scalingFactorNodeOffset + site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[middle]*this->activeScalingFactorOffset + middle*this->scalingFactorNodeOffset + site] - log(max);
 
 
             // compute the per site probabilities
@@ -1552,7 +1552,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::scale( size_t node_index, size
         // iterate over all mixture categories
         for (size_t site = 0; site < this->pattern_block_size ; ++site)
         {
-            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]][node_index][site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]][left][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]][right][site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[middle]][middle][site];
+            this->perNodeSiteLogScalingFactors[this->activeLikelihood[node_index]*this->activeScalingFactorOffset + node_index*this->scalingFactorNodeOffset + site] = this->perNodeSiteLogScalingFactors[this->activeLikelihood[left]*this->activeScalingFactorOffset + left*this->scalingFactorNodeOffset + site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[right]*this->activeScalingFactorOffset + right*this->scalingFactorNodeOffset + site] + this->perNodeSiteLogScalingFactors[this->activeLikelihood[middle]*this->activeScalingFactorOffset + middle*this->scalingFactorNodeOffset + site];
         }
 
     }
@@ -1772,3 +1772,13 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::simulate( const TopologyNode &
     }
 
 }
+
+
+/*
+ * The Dollo model uses its own scaling of the likelihoods, hence we never rescale lazily.
+ */
+bool RevBayesCore::PhyloCTMCSiteHomogeneousDollo::useLazyScaling( void ) const
+{
+
+    return false;
+}
@@ -81,6 +81,7 @@ template <class valueType> class TypedDagNode;
             void                                                scale(size_t i, size_t l, size_t r, size_t m);
             virtual void                                        simulate( const TopologyNode &node, std::vector<StandardState> &taxa, size_t rateIndex, std::map<size_t, size_t>& charCounts);
             void                                                updateTransitionProbabilityMatrices(void);
+            bool                                                useLazyScaling(void) const;                                             //!< We always use our own scaling
         };
 
 }
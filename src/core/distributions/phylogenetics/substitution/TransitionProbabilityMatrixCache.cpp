@@ -0,0 +1,173 @@
+#include "TransitionProbabilityMatrixCache.h"
+
+#include <cstring>
+#include <functional>
+
+using namespace RevBayesCore;
+
+
+TransitionProbabilityMatrixCache::TransitionProbabilityMatrixCache(size_t c) :
+    capacity( c ),
+    num_hits( 0 ),
+    num_misses( 0 )
+{
+
+}
+
+
+TransitionProbabilityMatrixCache::TransitionProbabilityMatrixCache(const TransitionProbabilityMatrixCache &c) :
+    capacity( c.capacity ),
+    num_hits( 0 ),
+    num_misses( 0 )
+{
+    // the matrices belong to the rate matrices of the original, so a copy starts empty
+}
+
+
+TransitionProbabilityMatrixCache& TransitionProbabilityMatrixCache::operator=(const TransitionProbabilityMatrixCache &c)
+{
+
+    if ( this != &c )
+    {
+        clear();
+        capacity    = c.capacity;
+        num_hits    = 0;
+        num_misses  = 0;
+    }
+
+    return *this;
+}
+
+
+bool TransitionProbabilityMatrixCache::Key::operator==(const Key &k) const
+{
+    return generation == k.generation && matrix == k.matrix && start_age == k.start_age && end_age == k.end_age && rate == k.rate;
+}
+
+
+size_t TransitionProbabilityMatrixCache::KeyHash::operator()(const Key &k) const
+{
+
+    // combine the hashes as in boost::hash_combine
+    size_t h = std::hash<size_t>()( k.generation );
+    h ^= std::hash<size_t>()( k.matrix )     + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<double>()( k.start_age )  + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<double>()( k.end_age )    + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<double>()( k.rate )       + 0x9e3779b9 + (h << 6) + (h >> 2);
+
+    return h;
+}
+
+
+void TransitionProbabilityMatrixCache::clear( void )
+{
+
+    index.clear();
+    entries.clear();
+
+}
+
+
+void TransitionProbabilityMatrixCache::evict( void )
+{
+
+    while ( entries.size() > capacity )
+    {
+        index.erase( entries.back().first );
+        entries.pop_back();
+    }
+
+}
+
+
+bool TransitionProbabilityMatrixCache::get(size_t generation, size_t matrix, double start_age, double end_age, double rate, TransitionProbabilityMatrix &P)
+{
+
+    Key k = { generation, matrix, start_age, end_age, rate };
+    std::unordered_map<Key, EntryList::iterator, KeyHash>::iterator it = index.find( k );
+
+    if ( it == index.end() )
+    {
+        ++num_misses;
+        return false;
+    }
+
+    ++num_hits;
+
+    // move the matrix to the front of the list (most recently used)
+    entries.splice( entries.begin(), entries, it->second );
+
+    const TransitionProbabilityMatrix &cached = it->second->second;
+    std::memcpy( P.theMatrix, cached.theMatrix, cached.nElements*sizeof(double) );
+
+    return true;
+}
+
+
+size_t TransitionProbabilityMatrixCache::getCapacity( void ) const
+{
+    return capacity;
+}
+
+
+size_t TransitionProbabilityMatrixCache::getNumberOfHits( void ) const
+{
+    return num_hits;
+}
+
+
+size_t TransitionProbabilityMatrixCache::getNumberOfMisses( void ) const
+{
+    return num_misses;
+}
+
+
+bool TransitionProbabilityMatrixCache::isEnabled( void ) const
+{
+    return capacity > 0;
+}
+
+
+void TransitionProbabilityMatrixCache::put(size_t generation, size_t matrix, double start_age, double end_age, double rate, const TransitionProbabilityMatrix &P)
+{
+
+    if ( capacity == 0 )
+    {
+        return;
+    }
+
+    Key k = { generation, matrix, start_age, end_age, rate };
+    std::unordered_map<Key, EntryList::iterator, KeyHash>::iterator it = index.find( k );
+
+    if ( it != index.end() )
+    {
+        // overwrite the old matrix and mark it as most recently used
+        it->second->second = P;
+        entries.splice( entries.begin(), entries, it->second );
+    }
+    else if ( entries.size() == capacity )
+    {
+        // reuse the memory of the least recently used matrix
+        EntryList::iterator last = --entries.end();
+        index.erase( last->first );
+        last->first  = k;
+        last->second = P;
+        entries.splice( entries.begin(), entries, last );
+        index[k] = entries.begin();
+    }
+    else
+    {
+        entries.push_front( std::make_pair(k, P) );
+        index[k] = entries.begin();
+    }
+
+}
+
+
+void TransitionProbabilityMatrixCache::setCapacity(size_t c)
+{
+
+    capacity = c;
+    evict();
+
+}
@@ -0,0 +1,71 @@
+#ifndef TransitionProbabilityMatrixCache_H
+#define TransitionProbabilityMatrixCache_H
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+#include "TransitionProbabilityMatrix.h"
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Least-recently-used cache of transition probability matrices.
+     *
+     * The phylogenetic CTMC often needs the same transition probability matrix again,
+     * e.g. when a branch returns to a previous length or when the likelihood is recomputed
+     * from scratch outside of an MCMC. Each matrix is identified by the generation of the rate matrix
+     * (a number that changes whenever the rate matrix changes), the index of the rate matrix
+     * and the start age, end age and rate of the branch. Exponentiating a matrix costs O(n^3),
+     * whereas a cache hit only copies the n^2 probabilities.
+     *
+     * The cache holds at most a given number of matrices and evicts the least recently used matrix.
+     * A capacity of 0 disables the cache.
+     */
+    class TransitionProbabilityMatrixCache {
+
+    public:
+        TransitionProbabilityMatrixCache(size_t c = 0);                                                                 //!< Construct a cache for at most c matrices
+        TransitionProbabilityMatrixCache(const TransitionProbabilityMatrixCache &c);                                    //!< Copy constructor (the copy starts empty)
+
+        TransitionProbabilityMatrixCache&           operator=(const TransitionProbabilityMatrixCache &c);               //!< Assignment operator (the copy starts empty)
+
+        void                                        clear(void);                                                        //!< Remove all matrices (but keep the counters)
+        bool                                        get(size_t generation, size_t matrix, double start_age, double end_age, double rate, TransitionProbabilityMatrix &P);          //!< Copy the matrix into P if it is in the cache
+        size_t                                      getCapacity(void) const;                                            //!< The maximum number of matrices
+        size_t                                      getNumberOfHits(void) const;
+        size_t                                      getNumberOfMisses(void) const;
+        bool                                        isEnabled(void) const;                                              //!< Is the capacity larger than 0?
+        void                                        put(size_t generation, size_t matrix, double start_age, double end_age, double rate, const TransitionProbabilityMatrix &P);    //!< Store a copy of the matrix
+        void                                        setCapacity(size_t c);                                              //!< Set the maximum number of matrices (evicts matrices if necessary)
+
+    private:
+
+        struct Key {
+            size_t                                  generation;
+            size_t                                  matrix;
+            double                                  start_age;
+            double                                  end_age;
+            double                                  rate;
+
+            bool                                    operator==(const Key &k) const;
+        };
+
+        struct KeyHash {
+            size_t                                  operator()(const Key &k) const;
+        };
+
+        typedef std::list< std::pair<Key, TransitionProbabilityMatrix> >                    EntryList;
+
+        void                                        evict(void);                                                        //!< Remove the least recently used matrices until we are within the capacity
+
+        size_t                                      capacity;
+        size_t                                      num_hits;
+        size_t                                      num_misses;
+        EntryList                                   entries;                                                            //!< The matrices, most recently used first
+        std::unordered_map<Key, EntryList::iterator, KeyHash>                               index;                      //!< The position of each matrix in the list
+    };
+
+}
+
+#endif
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstddef>
 #include <cmath>
 #include <iostream>
@@ -13,10 +14,13 @@
 #include "RandomNumberGenerator.h"
 #include "RbConstants.h"
 #include "RbMathCombinatorialFunctions.h"
+#include "StochasticNode.h"
 #include "TopologyNode.h"
 #include "RbException.h"
 #include "Taxon.h"
 #include "Tree.h"
+#include "TreeChangeEventHandler.h"
+#include "TreeChangeEventMessage.h"
 #include "TypedDagNode.h"
 #include "TypedDistribution.h"
 
@@ -28,7 +32,11 @@ AbstractMultispeciesCoalescent::AbstractMultispeciesCoalescent(const TypedDagNod
     taxa(t),
     species_tree( sp ),
     num_taxa( taxa.size() ),
-    log_tree_topology_prob (0.0)
+    log_tree_topology_prob (0.0),
+    num_incompatible_gene_nodes( 0 ),
+    cache_branch_probabilities( true ),
+    all_gene_nodes_dirty( true ),
+    species_tree_dirty( true )
 {
     // add the parameters to our set (in the base class)
     // in that way other class can easily access the set of our parameters
@@ -45,14 +53,43 @@ AbstractMultispeciesCoalescent::AbstractMultispeciesCoalescent(const TypedDagNod
 
     log_tree_topology_prob = (num_taxa - 1) * RbConstants::LN2 - 2.0 * ln_fact - std::log( num_taxa ) ;
 
-    redrawValue();
+    simulateTree();
+
+    value->getTreeChangeEventHandler().addListener( this );
+}
+
+
+AbstractMultispeciesCoalescent::AbstractMultispeciesCoalescent(const AbstractMultispeciesCoalescent &d) : TypedDistribution<Tree>( d ),
+    taxa( d.taxa ),
+    species_tree( d.species_tree ),
+    num_taxa( d.num_taxa ),
+    log_tree_topology_prob( d.log_tree_topology_prob ),
+    individuals_per_branch( d.individuals_per_branch ),
+    gene_node_branches( d.gene_node_branches ),
+    incompatible_gene_nodes( d.incompatible_gene_nodes ),
+    num_incompatible_gene_nodes( d.num_incompatible_gene_nodes ),
+    coalescences_per_branch( d.coalescences_per_branch ),
+    lineages_per_branch( d.lineages_per_branch ),
+    ln_probs_per_branch( d.ln_probs_per_branch ),
+    dirty_branches( d.dirty_branches ),
+    cache_branch_probabilities( d.cache_branch_probabilities ),
+    dirty_gene_nodes( d.dirty_gene_nodes ),
+    dirty_gene_node_indices( d.dirty_gene_node_indices ),
+    all_gene_nodes_dirty( d.all_gene_nodes_dirty ),
+    species_ages( d.species_ages ),
+    species_parents( d.species_parents ),
+    species_tree_dirty( d.species_tree_dirty )
+{
 
+    // the base class cloned the gene tree, so we need to listen to the clone
+    value->getTreeChangeEventHandler().addListener( this );
 }
 
 
 AbstractMultispeciesCoalescent::~AbstractMultispeciesCoalescent()
 {
 
+    value->getTreeChangeEventHandler().removeListener( this );
 }
 
 
@@ -129,9 +166,38 @@ void AbstractMultispeciesCoalescent::buildRandomBinaryTree(std::vector<TopologyN
 }
 
 
+/**
+ * Compute the log-probability of the gene tree. We first move the gene nodes that changed (or whose species branches changed)
+ * to their new species branches and then recompute the species branches that are dirty or got a different number of lineages.
+ */
 double AbstractMultispeciesCoalescent::computeLnProbability( void )
 {
-    resetTipAllocations();
+
+    if ( species_tree_dirty == true && all_gene_nodes_dirty == false )
+    {
+        updateSpeciesBranches();
+    }
+
+    if ( all_gene_nodes_dirty == true )
+    {
+        resetTipAllocations();
+    }
+    else
+    {
+        for (size_t i=0; i<dirty_gene_node_indices.size(); ++i)
+        {
+            size_t index = dirty_gene_node_indices[i];
+            updateGeneNodeBranch( value->getNode( index ), true );
+            dirty_gene_nodes[index] = false;
+        }
+        dirty_gene_node_indices.clear();
+    }
+
+    // a gene node coalesced before the species of its children came together
+    if ( num_incompatible_gene_nodes > 0 )
+    {
+        return RbConstants::Double::neginf;
+    }
 
     // variable declarations and initialization
     double ln_prob_coal = 0;
@@ -152,122 +218,107 @@ double AbstractMultispeciesCoalescent::drawNe( size_t index )
 }
 
 
-double AbstractMultispeciesCoalescent::recursivelyComputeLnProbability( const RevBayesCore::TopologyNode &species_node )
+/**
+ * The gene tree informs us that this node has changed. We remember the node and move it to its new species branch
+ * when we compute the probability the next time. If the topology changed, then we allocate all gene nodes again.
+ */
+void AbstractMultispeciesCoalescent::fireTreeChangeEvent(const TopologyNode &n, const unsigned& m)
 {
 
-    double ln_prob_coal = 0;
-
-    if ( species_node.isTip() == false )
+    size_t index = n.getIndex();
+    if ( m == TreeChangeEventMessage::TOPOLOGY || index >= dirty_gene_nodes.size() )
     {
-        individuals_per_branch[ species_node.getIndex() ].clear();
-
-        for (size_t i=0; i<species_node.getNumberOfChildren(); ++i)
-        {
-            ln_prob_coal += recursivelyComputeLnProbability( species_node.getChild(i) );
-        }
+        all_gene_nodes_dirty = true;
     }
-
-//    const TopologyNode *species_parent_node = NULL;
-    double species_age = species_node.getAge();
-    double parent_species_age = RbConstants::Double::inf;
-
-    //        double branchLength = RbConstants::Double::inf;
-    if ( species_node.isRoot() == false )
+    else if ( dirty_gene_nodes[index] == false )
     {
-        const TopologyNode &species_parent_node = species_node.getParent();
-        parent_species_age = species_parent_node.getAge();
+        dirty_gene_nodes[index] = true;
+        dirty_gene_node_indices.push_back( index );
     }
 
-    // create a local copy of the individuals per branch
-    const std::set<const TopologyNode*> &initial_individuals = individuals_per_branch[species_node.getIndex()];
-    std::set<const TopologyNode*> remaining_individuals = initial_individuals;
+}
 
-    // get all coalescent events among the individuals
-    std::vector<double> coal_times;
 
+/**
+ * Compute the log-probability of the coalescences in the species branch and all branches below it.
+ * The lineages that enter a species branch are the individuals of the species and the lineages that leave its children.
+ * We only recompute the coalescent probability of the branch if it is dirty or if the number of lineages changed
+ * (unless the derived class does not allow us to cache the probabilities).
+ */
+double AbstractMultispeciesCoalescent::recursivelyComputeLnProbability( const RevBayesCore::TopologyNode &species_node )
+{
 
-    std::map<double, const TopologyNode *> coal_times_2_nodes;
-    for ( std::set<const TopologyNode*>::iterator it = remaining_individuals.begin(); it != remaining_individuals.end(); ++it)
-    {
-        const TopologyNode *ind = (*it);
-        if ( ind->isRoot() == false )
-        {
-            const TopologyNode &parent = ind->getParent();
-            double parent_age = parent.getAge();
-            coal_times_2_nodes[ parent_age ] = &parent;
-        }
-    }
+    double ln_prob_coal = 0;
+
+    size_t index = species_node.getIndex();
+    size_t num_lineages = individuals_per_branch[index];
 
-    double current_time = species_age;
-    while ( current_time < parent_species_age && coal_times_2_nodes.size() > 0 )
+    for (size_t i=0; i<species_node.getNumberOfChildren(); ++i)
     {
+        const TopologyNode &child = species_node.getChild(i);
+        ln_prob_coal += recursivelyComputeLnProbability( child );
 
-        const TopologyNode *parent = coal_times_2_nodes.begin()->second;
-        double parent_age = parent->getAge();
-        current_time = parent_age;
+        size_t child_index = child.getIndex();
+        num_lineages += lineages_per_branch[child_index] - coalescences_per_branch[child_index].size();
+    }
 
-        if ( parent_age < parent_species_age )
-        { //Coalescence in the species tree branch
+    if ( cache_branch_probabilities == false || dirty_branches[index] == true || num_lineages != lineages_per_branch[index] )
+    {
+        lineages_per_branch[index] = num_lineages;
+        ln_probs_per_branch[index] = 0.0;
 
-            // get the left and right child of the parent
-            const TopologyNode *left = &parent->getChild( 0 );
-            const TopologyNode *right = &parent->getChild( 1 );
-            if ( remaining_individuals.find( left ) == remaining_individuals.end() || remaining_individuals.find( right ) == remaining_individuals.end() )
+        if ( num_lineages > 1 )
+        {
+            double species_age = species_node.getAge();
+            double parent_species_age = RbConstants::Double::inf;
+            if ( species_node.isRoot() == false )
             {
-                // one of the children does not belong to this species tree branch
-                return RbConstants::Double::neginf;
+                parent_species_age = species_node.getParent().getAge();
             }
 
-            //We remove the coalescent event and the coalesced lineages
-            coal_times_2_nodes.erase( coal_times_2_nodes.begin() );
-            remaining_individuals.erase( remaining_individuals.find( left ) );
-            remaining_individuals.erase( remaining_individuals.find( right ) );
-
-            //We insert the parent in the vector of lineages in this branch
-            remaining_individuals.insert( parent );
-            if ( parent->isRoot() == false )
+            // get all coalescent events among the individuals
+            const std::set<size_t> &coalescences = coalescences_per_branch[index];
+            std::vector<double> coal_times;
+            coal_times.reserve( coalescences.size() );
+            for (std::set<size_t>::const_iterator it = coalescences.begin(); it != coalescences.end(); ++it)
             {
-                const TopologyNode *grand_parent = &parent->getParent();
-                coal_times_2_nodes[ grand_parent->getAge() ] = grand_parent;
+                coal_times.push_back( value->getNode( *it ).getAge() );
             }
+            std::sort( coal_times.begin(), coal_times.end() );
 
-            coal_times.push_back( parent_age );
-
-
-        } //End if coalescence in the species tree branch
-        else
-        { //No more coalescences in this species tree branch
-
-            // jump out of the while loop
-            //                currentTime = speciesAge;
-            break;
+            ln_probs_per_branch[index] = computeLnCoalescentProbability(num_lineages, coal_times, species_age, parent_species_age, index, species_node.isRoot() == false);
         }
 
+        dirty_branches[index] = false;
+    }
 
-    } // end of while loop
+    return ln_prob_coal + ln_probs_per_branch[index];
+}
 
-    if ( initial_individuals.size() > 1 )
-    {
-        ln_prob_coal += computeLnCoalescentProbability(initial_individuals.size(), coal_times, species_age, parent_species_age, species_node.getIndex(), species_node.isRoot() == false);
-    }
 
+/**
+ * Allocate the gene nodes below and including this node to their species branches, children first.
+ */
+void AbstractMultispeciesCoalescent::recursivelyUpdateGeneNodeBranches( const TopologyNode &n )
+{
 
-    // merge the two sets of individuals that go into the next species
-    if ( species_node.isRoot() == false )
+    for (size_t i=0; i<n.getNumberOfChildren(); ++i)
     {
-        std::set<const TopologyNode *> &incoming_lineages = individuals_per_branch[ species_node.getParent().getIndex() ];
-        incoming_lineages.insert( remaining_individuals.begin(), remaining_individuals.end());
+        recursivelyUpdateGeneNodeBranches( n.getChild(i) );
     }
 
-    return ln_prob_coal;
+    updateGeneNodeBranch( n, false );
 }
 
 
 void AbstractMultispeciesCoalescent::redrawValue( void )
 {
 
+    value->getTreeChangeEventHandler().removeListener( this );
+
     simulateTree();
 
+    value->getTreeChangeEventHandler().addListener( this );
 }
 
 
@@ -296,8 +347,36 @@ void AbstractMultispeciesCoalescent::resetTipAllocations( void )
         individual_names_2_species_names[name] = it->getSpeciesName();
     }
 
+    size_t num_species_nodes = sp.getNumberOfNodes();
+    size_t num_gene_nodes = value->getNumberOfNodes();
+
+    individuals_per_branch      = std::vector<size_t>(num_species_nodes, 0);
+    coalescences_per_branch     = std::vector< std::set<size_t> >(num_species_nodes, std::set<size_t>() );
+    lineages_per_branch         = std::vector<size_t>(num_species_nodes, 0);
+    ln_probs_per_branch         = std::vector<double>(num_species_nodes, 0.0);
+    dirty_branches              = std::vector<bool>(num_species_nodes, true);
+    gene_node_branches          = std::vector<size_t>(num_gene_nodes, RbConstants::Size_t::max);
+    incompatible_gene_nodes     = std::vector<bool>(num_gene_nodes, false);
+    num_incompatible_gene_nodes = 0;
+    dirty_gene_nodes            = std::vector<bool>(num_gene_nodes, false);
+    dirty_gene_node_indices.clear();
+    all_gene_nodes_dirty        = false;
+
+    // remember the species tree for which we allocated the gene nodes
+    species_ages    = std::vector<double>(num_species_nodes, 0.0);
+    species_parents = std::vector<size_t>(num_species_nodes, RbConstants::Size_t::max);
+    for (size_t i=0; i<num_species_nodes; ++i)
+    {
+        const TopologyNode &species_node = sp.getNode( i );
+        species_ages[i] = species_node.getAge();
+        if ( species_node.isRoot() == false )
+        {
+            species_parents[i] = species_node.getParent().getIndex();
+        }
+    }
+    species_tree_dirty = false;
+
     // create a map for the individuals to branches
-    individuals_per_branch = std::vector< std::set< const TopologyNode* > >(sp.getNumberOfNodes(), std::set< const TopologyNode* >() );
     for (size_t i=0; i<num_taxa; ++i)
     {
 //        const std::string &tip_name = it->getName();
@@ -306,9 +385,43 @@ void AbstractMultispeciesCoalescent::resetTipAllocations( void )
         const std::string &species_name = individual_names_2_species_names[ individual_name ];
 
         TopologyNode *species_node = species_names_2_species_nodes[species_name];
-        individuals_per_branch[ species_node->getIndex() ].insert( &n );
+        if ( species_node == NULL )
+        {
+            throw RbException("Could not match the individual " + individual_name + " to any of the tips in the species tree.");
+        }
+        gene_node_branches[i] = species_node->getIndex();
+        ++individuals_per_branch[ species_node->getIndex() ];
     }
 
+    // now allocate the coalescences
+    recursivelyUpdateGeneNodeBranches( value->getRoot() );
+
+}
+
+
+/**
+ * The move of a rejected proposal is undone by changing the gene tree back, which informs us again about the changed nodes.
+ * Thus, we do not store the probabilities of the species branches and only need to check the parameters again.
+ */
+void AbstractMultispeciesCoalescent::restoreSpecialization(const DagNode *restorer)
+{
+
+    if ( restorer == this->dag_node )
+    {
+        // the gene tree was restored without telling us which nodes changed
+        if ( dirty_gene_node_indices.empty() == true )
+        {
+            all_gene_nodes_dirty = true;
+        }
+    }
+    else if ( restorer == species_tree )
+    {
+        species_tree_dirty = true;
+    }
+    else
+    {
+        dirty_branches = std::vector<bool>(dirty_branches.size(), true);
+    }
 
 }
 
@@ -319,9 +432,13 @@ void AbstractMultispeciesCoalescent::resetTipAllocations( void )
 void AbstractMultispeciesCoalescent::setValue(Tree *v, bool f )
 {
 
+    value->getTreeChangeEventHandler().removeListener( this );
+
     // delegate to super class
     TypedDistribution<Tree>::setValue(v, f);
 
+    value->getTreeChangeEventHandler().addListener( this );
+
     resetTipAllocations();
 
 }
@@ -487,6 +604,176 @@ void AbstractMultispeciesCoalescent::swapParameterInternal(const DagNode *oldP,
     if ( oldP == species_tree )
     {
         species_tree = static_cast<const TypedDagNode< Tree >* >( newP );
+        all_gene_nodes_dirty = true;
+    }
+
+}
+
+
+/**
+ * If the gene tree was touched, then it told us which nodes changed; otherwise we allocate all gene nodes again.
+ * If the species tree was touched, then we compare it to the ages and parents of the species nodes when we compute the probability.
+ * Any other parameter (e.g., the population sizes) changes the probabilities of all species branches.
+ */
+void AbstractMultispeciesCoalescent::touchSpecialization(const DagNode *toucher, bool touchAll)
+{
+
+    if ( toucher == this->dag_node )
+    {
+        if ( touchAll == true || dirty_gene_node_indices.empty() == true )
+        {
+            all_gene_nodes_dirty = true;
+        }
+    }
+    else if ( toucher == species_tree )
+    {
+        species_tree_dirty = true;
+    }
+    else
+    {
+        dirty_branches = std::vector<bool>(dirty_branches.size(), true);
+    }
+
+}
+
+
+/**
+ * Move the gene node to the species branch in which it coalesces: the lineages of its children meet in the most recent common
+ * ancestor of the branches of the children, and the gene node is in the branch of the oldest ancestor that is not older than the gene node.
+ * If the gene node moved to another branch, then its parent might have moved too.
+ *
+ * \param[in]    n               The gene node.
+ * \param[in]    update_parent   Whether to update the parent if the branch of the gene node changed.
+ */
+void AbstractMultispeciesCoalescent::updateGeneNodeBranch( const TopologyNode &n, bool update_parent )
+{
+
+    // the individuals stay in their species
+    if ( n.isTip() == true )
+    {
+        return;
+    }
+
+    const Tree &sp = species_tree->getValue();
+    size_t index = n.getIndex();
+    double age = n.getAge();
+
+    // find the species in which the lineages of the children meet
+    const TopologyNode *species_node = NULL;
+    for (size_t i=0; i<n.getNumberOfChildren(); ++i)
+    {
+        const TopologyNode *child_species_node = &sp.getNode( gene_node_branches[ n.getChild(i).getIndex() ] );
+        if ( species_node == NULL )
+        {
+            species_node = child_species_node;
+        }
+
+        while ( species_node != child_species_node )
+        {
+            if ( species_node->isRoot() == false && species_node->getAge() <= child_species_node->getAge() )
+            {
+                species_node = &species_node->getParent();
+            }
+            else
+            {
+                child_species_node = &child_species_node->getParent();
+            }
+        }
+    }
+
+    // the gene node cannot coalesce before the lineages of its children met
+    bool incompatible = ( age < species_node->getAge() );
+    if ( incompatible != incompatible_gene_nodes[index] )
+    {
+        incompatible_gene_nodes[index] = incompatible;
+        if ( incompatible == true )
+        {
+            ++num_incompatible_gene_nodes;
+        }
+        else
+        {
+            --num_incompatible_gene_nodes;
+        }
+    }
+
+    while ( species_node->isRoot() == false && age >= species_node->getParent().getAge() )
+    {
+        species_node = &species_node->getParent();
+    }
+    size_t branch = species_node->getIndex();
+
+    // the coalescence time within the branch might have changed
+    dirty_branches[branch] = true;
+
+    size_t old_branch = gene_node_branches[index];
+    if ( branch != old_branch )
+    {
+        if ( old_branch != RbConstants::Size_t::max )
+        {
+            coalescences_per_branch[old_branch].erase( index );
+            dirty_branches[old_branch] = true;
+        }
+        coalescences_per_branch[branch].insert( index );
+        gene_node_branches[index] = branch;
+
+        if ( update_parent == true && n.isRoot() == false )
+        {
+            updateGeneNodeBranch( n.getParent(), true );
+        }
+    }
+
+}
+
+
+/**
+ * Compare the species tree to the species tree for which we allocated the gene nodes.
+ * If the topology changed, then we allocate all gene nodes again. If only the age of a species node changed,
+ * then only the gene nodes in the branch of the species node and in the branches of its children can move,
+ * and only these branches need to be recomputed.
+ */
+void AbstractMultispeciesCoalescent::updateSpeciesBranches( void )
+{
+
+    const Tree &sp = species_tree->getValue();
+    size_t num_species_nodes = sp.getNumberOfNodes();
+
+    bool topology_changed = ( num_species_nodes != species_ages.size() );
+    for (size_t i=0; i<num_species_nodes && topology_changed == false; ++i)
+    {
+        const TopologyNode &species_node = sp.getNode( i );
+        size_t parent = ( species_node.isRoot() == true ? RbConstants::Size_t::max : species_node.getParent().getIndex() );
+        topology_changed = ( parent != species_parents[i] );
+    }
+
+    if ( topology_changed == true )
+    {
+        all_gene_nodes_dirty = true;
+        return;
+    }
+
+    std::vector<size_t> gene_nodes;
+    for (size_t i=0; i<num_species_nodes; ++i)
+    {
+        const TopologyNode &species_node = sp.getNode( i );
+        if ( species_node.getAge() != species_ages[i] )
+        {
+            species_ages[i] = species_node.getAge();
+
+            dirty_branches[i] = true;
+            gene_nodes.insert( gene_nodes.end(), coalescences_per_branch[i].begin(), coalescences_per_branch[i].end() );
+            for (size_t j=0; j<species_node.getNumberOfChildren(); ++j)
+            {
+                size_t child_index = species_node.getChild(j).getIndex();
+                dirty_branches[child_index] = true;
+                gene_nodes.insert( gene_nodes.end(), coalescences_per_branch[child_index].begin(), coalescences_per_branch[child_index].end() );
+            }
+        }
+    }
+
+    for (size_t i=0; i<gene_nodes.size(); ++i)
+    {
+        updateGeneNodeBranch( value->getNode( gene_nodes[i] ), true );
     }
 
+    species_tree_dirty = false;
 }
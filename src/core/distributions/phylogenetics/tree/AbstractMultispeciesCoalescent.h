@@ -1,8 +1,12 @@
 #ifndef AbstractMultispeciesCoalescent_H
 #define AbstractMultispeciesCoalescent_H
 
+#include <set>
+#include <vector>
+
 #include "RbVector.h"
 #include "Tree.h"
+#include "TreeChangeEventListener.h"
 #include "TypedDagNode.h"
 #include "TypedDistribution.h"
 
@@ -10,14 +14,27 @@ namespace RevBayesCore {
     
     class Clade;
     
-    class AbstractMultispeciesCoalescent : public TypedDistribution<Tree> {
+    /**
+     * @brief Base class of the multispecies coalescent of a gene tree within a species tree.
+     *
+     * Every node of the gene tree coalesces in one branch of the species tree, and the probability of the gene tree is the
+     * sum of the coalescent probabilities of the branches. We keep the branch of every gene node, the number of lineages
+     * that enter every species branch and the coalescent probability of every species branch.
+     * The gene tree tells us which of its nodes changed, and the species tree is compared to the ages it had when we computed
+     * the probabilities. Thus, when we compute the probability again, we only move the changed gene nodes to their new branches
+     * and only recompute the species branches in which a coalescence or the number of lineages changed.
+     * If a rejected move is undone, the gene tree reports the changes again, so we do not need to store any probabilities.
+     */
+    class AbstractMultispeciesCoalescent : public TypedDistribution<Tree>, public TreeChangeEventListener {
         
     public:
         AbstractMultispeciesCoalescent(const TypedDagNode<Tree> *st, const std::vector<Taxon> &t);
+        AbstractMultispeciesCoalescent(const AbstractMultispeciesCoalescent &d);
         virtual                                            ~AbstractMultispeciesCoalescent(void);                                                                       //!< Virtual destructor
         
         // public member functions
         double                                              computeLnProbability(void);
+        void                                                fireTreeChangeEvent(const TopologyNode &n, const unsigned& m=0);                                    //!< The gene tree has changed
         void                                                redrawValue(void);
         virtual void                                        setValue(Tree *v, bool f=false);                                                                    //!< Set the current value, e.g. attach an observation (clamp)
 
@@ -26,7 +43,9 @@ namespace RevBayesCore {
 
     protected:
         // Parameter management functions
+        void                                                restoreSpecialization(const DagNode *restorer);
         void                                                swapParameterInternal(const DagNode *oldP, const DagNode *newP);            //!< Swap a parameter
+        void                                                touchSpecialization(const DagNode *toucher, bool touchAll);
         virtual double                                      computeLnCoalescentProbability(size_t k, const std::vector<double> &t, double a, double b, size_t index, bool f) = 0;
         virtual double                                      drawNe(size_t index);
 
@@ -34,8 +53,11 @@ namespace RevBayesCore {
         void                                                attachTimes(Tree *psi, std::vector<TopologyNode *> &tips, size_t index, const std::vector<double> &times);
         void                                                buildRandomBinaryTree(std::vector<TopologyNode *> &tips);
         double                                              recursivelyComputeLnProbability(const TopologyNode &n);
+        void                                                recursivelyUpdateGeneNodeBranches(const TopologyNode &n);
         void                                                resetTipAllocations(void);
         void                                                simulateTree(void);
+        void                                                updateGeneNodeBranch(const TopologyNode &n, bool update_parent);
+        void                                                updateSpeciesBranches(void);
         
         // members
         std::vector<Taxon>                                  taxa;
@@ -43,7 +65,21 @@ namespace RevBayesCore {
         size_t                                              num_taxa;
         double                                              log_tree_topology_prob;
         
-        std::vector< std::set< const TopologyNode* > >      individuals_per_branch;
+        std::vector<size_t>                                 individuals_per_branch;                                 //!< The number of individuals sampled from every species
+        std::vector<size_t>                                 gene_node_branches;                                     //!< The species branch in which every gene node coalesces
+        std::vector<bool>                                   incompatible_gene_nodes;                                //!< Gene nodes that are younger than the species that their children come from
+        size_t                                              num_incompatible_gene_nodes;
+        std::vector< std::set<size_t> >                     coalescences_per_branch;                                //!< The gene nodes that coalesce in every species branch
+        std::vector<size_t>                                 lineages_per_branch;                                    //!< The number of gene lineages that enter every species branch
+        std::vector<double>                                 ln_probs_per_branch;                                    //!< The coalescent probability of every species branch
+        std::vector<bool>                                   dirty_branches;
+        bool                                                cache_branch_probabilities;                             //!< Can we reuse the probabilities of clean branches? (false if computeLnCoalescentProbability keeps state between branches)
+        std::vector<bool>                                   dirty_gene_nodes;
+        std::vector<size_t>                                 dirty_gene_node_indices;
+        bool                                                all_gene_nodes_dirty;
+        std::vector<double>                                 species_ages;                                           //!< The ages of the species nodes when we computed the probabilities
+        std::vector<size_t>                                 species_parents;                                        //!< The parents of the species nodes when we computed the probabilities
+        bool                                                species_tree_dirty;
 
     };
     
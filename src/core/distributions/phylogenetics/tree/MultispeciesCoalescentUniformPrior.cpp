@@ -22,6 +22,10 @@ using namespace RevBayesCore;
 MultispeciesCoalescentUniformPrior::MultispeciesCoalescentUniformPrior(const TypedDagNode<Tree> *sp, const std::vector<Taxon> &t) : AbstractMultispeciesCoalescent(sp, t)
 {
     fn = 0.0;
+
+    // the coalescent probability of a branch depends on fn, which is accumulated over all branches,
+    // so we need to recompute every branch every time
+    cache_branch_probabilities = false;
 }
 
 
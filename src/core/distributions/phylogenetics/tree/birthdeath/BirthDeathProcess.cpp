@@ -1,15 +1,20 @@
 #include <cstddef>
 #include <cmath>
 #include <iosfwd>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "Clade.h"
 #include "BirthDeathProcess.h"
 #include "RbMathCombinatorialFunctions.h"
+#include "RbConstants.h"
+#include "RbException.h"
 #include "RbMathLogic.h"
 #include "StochasticNode.h"
 #include "TopologyNode.h"
+#include "TreeChangeEventHandler.h"
+#include "TreeChangeEventMessage.h"
 #include "AbstractBirthDeathProcess.h"
 #include "AbstractRootedTreeDistribution.h"
 #include "RbBitSet.h"
@@ -44,13 +49,38 @@ BirthDeathProcess::BirthDeathProcess(const TypedDagNode<double> *ra, const Typed
     rho( rh ),
     sampling_mixture_proportion( mp ),
     sampling_strategy( ss ),
-    incomplete_clades( ic )
+    incomplete_clades( ic ),
+    all_nodes_dirty( true ),
+    speciation_terms_dirty( true ),
+    stored_speciation_terms_dirty( true ),
+    speciation_terms_sum( 0.0 ),
+    stored_speciation_terms_sum( 0.0 ),
+    speciation_terms_origin( RbConstants::Double::nan ),
+    speciation_terms_present( RbConstants::Double::nan ),
+    speciation_terms_sampling_probability( RbConstants::Double::nan ),
+    stored_speciation_terms_origin( RbConstants::Double::nan ),
+    stored_speciation_terms_present( RbConstants::Double::nan ),
+    stored_speciation_terms_sampling_probability( RbConstants::Double::nan )
 {
     
     addParameter( rho );
 }
 
 
+/**
+ * Destructor. We need to remove ourselves from the listeners of the tree.
+ */
+BirthDeathProcess::~BirthDeathProcess( void )
+{
+    
+    if ( value != NULL )
+    {
+        value->getTreeChangeEventHandler().removeListener( this );
+    }
+    
+}
+
+
 /**
  * Compute the log-transformed probability of the current value under the current parameter values.
  *
@@ -62,9 +92,6 @@ double BirthDeathProcess::computeLnProbabilityTimes( void ) const
     // variable declarations and initialization
     double ln_prob_times = 0;
     
-    // retrieved the speciation times
-    recomputeDivergenceTimesSinceOrigin();
-    
     double sampling_probability = 1.0;
     if ( sampling_strategy == "uniform" ) 
     {
@@ -84,24 +111,22 @@ double BirthDeathProcess::computeLnProbabilityTimes( void ) const
     
     size_t num_taxa = value->getNumberOfTips();
 
-    for (size_t i = 1; i < num_taxa-1; ++i)
+    if ( num_taxa > 2 && RbMath::isFinite(ln_prob_times) == false )
     {
-        if ( RbMath::isFinite(ln_prob_times) == false )
-        {
-            return RbConstants::Double::nan;
-        }
-        
-        // We will only multiply here the probability densities of the speciation events
-        ln_prob_times += lnSpeciationRate(divergence_times[i]);
+        return RbConstants::Double::nan;
     }
-    // add the P1 for ALL speciation events
-    ln_prob_times += lnP1(present_time,sampling_probability);
+    
+    // multiply the probability densities of the speciation events and the P1 of ALL speciation events
+    ln_prob_times += updateSpeciationTerms(process_age->getValue(), present_time, sampling_probability);
+    ln_prob_times -= log(sampling_probability) * (num_taxa-2);
     
     // if we assume diversified sampling, we need to multiply with the probability that all missing species happened after the last speciation event
     if ( sampling_strategy == "diversified" ) 
     {
         // We use equation (5) of Hoehna et al. "Inferring Speciation and Extinction Rates under Different Sampling Schemes"
-        double last_event = divergence_times[divergence_times.size()-1];
+        // the last event is the youngest speciation event (or the root if there is none)
+        double youngest_age = ( speciation_ages.empty() ? root_age : *speciation_ages.begin() );
+        double last_event = process_age->getValue() - youngest_age;
         
         double p_0_T = 1.0 - pSurvival(0,present_time,1.0)          * exp( rateIntegral(0,present_time) );
         double p_0_t = 1.0 - pSurvival(last_event,present_time,1.0) * exp( rateIntegral(last_event,present_time) );
@@ -157,73 +182,63 @@ double BirthDeathProcess::computeLnProbabilityTimes( void ) const
 }
 
 
-size_t BirthDeathProcess::getNumberOfTaxaAtPresent( void ) const
+/**
+ * The tree informs us that this node has changed. We only remember the node and check its age when
+ * we compute the probability the next time. If the topology changed, the nodes may have been renumbered,
+ * so we check all nodes.
+ */
+void BirthDeathProcess::fireTreeChangeEvent(const TopologyNode &n, const unsigned& m)
 {
     
-    size_t num_taxa_present = value->getNumberOfTips();
-    
-    // now iterate over the vector of missing species per clade
-    for (size_t i=0; i<incomplete_clades.size(); ++i)
+    size_t index = n.getIndex();
+    if ( m == TreeChangeEventMessage::TOPOLOGY || index >= dirty_nodes.size() )
     {
-        int m = incomplete_clades[i].getNumberMissingTaxa();
-        num_taxa_present += m;
+        all_nodes_dirty = true;
+    }
+    else if ( dirty_nodes[index] == false )
+    {
+        dirty_nodes[index] = true;
+        dirty_node_indices.push_back( index );
     }
     
-    return num_taxa_present;
 }
 
 
-double BirthDeathProcess::lnP1(double end, double r) const
+size_t BirthDeathProcess::getNumberOfTaxaAtPresent( void ) const
 {
     
-    double ln_p = 0;
-    double log_r = log(r);
-    prepareSurvivalProbability(end,r);
-    prepareRateIntegral(end);
+    size_t num_taxa_present = value->getNumberOfTips();
     
-    size_t num_taxa = value->getNumberOfTips();
-
-    for (size_t i = 0; i < num_taxa-2; ++i)
+    // now iterate over the vector of missing species per clade
+    for (size_t i=0; i<incomplete_clades.size(); ++i)
     {
-        // get the survival probability
-        double a = log_p_survival[i];
-        double b = rate_integral[i];
-        
-        // compute the probability of observing/sampling exactly one lineage
-        ln_p += 2.0 * a + b;
+        int m = incomplete_clades[i].getNumberMissingTaxa();
+        num_taxa_present += m;
     }
-    ln_p -= log_r * (num_taxa-2);
-    
-    return ln_p;
     
+    return num_taxa_present;
 }
 
 
-void BirthDeathProcess::prepareRateIntegral(double end) const
+/**
+ * Keep the current speciation terms, i.e., they become the terms that we restore.
+ */
+void BirthDeathProcess::keepSpecialization(const DagNode *affecter)
 {
-    size_t num_taxa = value->getNumberOfTips();
     
-    rate_integral  = std::vector<double>(num_taxa-2,0.0);
-
-    for (size_t i = 1; i < num_taxa-1; ++i)
-    {
-        double t = divergence_times[i];
-        rate_integral[i-1] = rateIntegral(t, end);
-    }
-
-}
-
-void BirthDeathProcess::prepareSurvivalProbability(double end, double r) const
-{
-    size_t num_taxa = value->getNumberOfTips();
+    AbstractRootedTreeDistribution::keepSpecialization(affecter);
     
-    log_p_survival = std::vector<double>(num_taxa-2,0.0);
-
-    for (size_t i = 1; i < num_taxa-1; ++i)
+    for (size_t i=0; i<changed_node_indices.size(); ++i)
     {
-        double t = divergence_times[i];
-        log_p_survival[i-1] = log( pSurvival(t,end,r) );
+        changed_nodes[ changed_node_indices[i] ] = false;
     }
+    changed_node_indices.clear();
+    
+    stored_speciation_terms_sum                 = speciation_terms_sum;
+    stored_speciation_terms_dirty               = speciation_terms_dirty;
+    stored_speciation_terms_origin              = speciation_terms_origin;
+    stored_speciation_terms_present             = speciation_terms_present;
+    stored_speciation_terms_sampling_probability = speciation_terms_sampling_probability;
     
 }
 
@@ -384,6 +399,45 @@ void BirthDeathProcess::restoreSpecialization(const DagNode *affecter)
 {
     
     AbstractRootedTreeDistribution::restoreSpecialization(affecter);
+    
+    // switch the changed nodes back to the slots of the kept terms
+    bool use_sorted_ages = ( sampling_strategy == "diversified" && stored_speciation_terms_dirty == false );
+    for (size_t i=0; i<changed_node_indices.size(); ++i)
+    {
+        size_t index = changed_node_indices[i];
+        if ( use_sorted_ages == true )
+        {
+            double age = speciation_term_ages[2*index + active_speciation_term[index]];
+            double stored_age = speciation_term_ages[2*index + 1 - active_speciation_term[index]];
+            std::multiset<double>::iterator it = speciation_ages.find( age );
+            if ( it != speciation_ages.end() )
+            {
+                speciation_ages.erase( it );
+            }
+            if ( stored_age != RbConstants::Double::neginf )
+            {
+                speciation_ages.insert( stored_age );
+            }
+        }
+        active_speciation_term[index] = 1 - active_speciation_term[index];
+        changed_nodes[index] = false;
+    }
+    changed_node_indices.clear();
+    
+    speciation_terms_sum                    = stored_speciation_terms_sum;
+    speciation_terms_dirty                  = stored_speciation_terms_dirty;
+    speciation_terms_origin                 = stored_speciation_terms_origin;
+    speciation_terms_present                = stored_speciation_terms_present;
+    speciation_terms_sampling_probability   = stored_speciation_terms_sampling_probability;
+    
+    // the tree is back in the state of the kept terms
+    for (size_t i=0; i<dirty_node_indices.size(); ++i)
+    {
+        dirty_nodes[ dirty_node_indices[i] ] = false;
+    }
+    dirty_node_indices.clear();
+    all_nodes_dirty = false;
+    
     if ( affecter == this->dag_node )
     {
         incomplete_clade_ages.clear();
@@ -437,6 +491,13 @@ void BirthDeathProcess::touchSpecialization(const DagNode *affecter, bool touchA
     AbstractRootedTreeDistribution::touchSpecialization(affecter, touchAll);
     if ( affecter == this->dag_node )
     {
+        // if the tree changed without telling us which nodes changed (e.g., it was assigned as a whole),
+        // then we need to check all nodes
+        if ( touchAll == true || dirty_node_indices.empty() == true )
+        {
+            all_nodes_dirty = true;
+        }
+        
         incomplete_clade_ages.clear();
         incomplete_clade_ages.resize(incomplete_clades.size());
         
@@ -450,5 +511,179 @@ void BirthDeathProcess::touchSpecialization(const DagNode *affecter, bool touchA
         }
 
     }
+    else
+    {
+        // a parameter changed, so all speciation terms change
+        speciation_terms_dirty = true;
+    }
+    
+}
+
+
+/**
+ * Recompute the speciation term of the node if its age changed since we computed its term.
+ * Tips and the root are no speciation events and have a term of 0.
+ * The new term goes to the other slot of the node, so that we can restore the kept term.
+ *
+ * \return True if the old or the new term is not finite, so that we cannot update the sum of the terms.
+ */
+bool BirthDeathProcess::updateSpeciationTerm(size_t index) const
+{
+    
+    const TopologyNode &n = value->getNode( index );
+    
+    double age = RbConstants::Double::neginf;
+    if ( n.isInternal() == true && n.isRoot() == false )
+    {
+        age = n.getAge();
+    }
+    
+    size_t offset = 2*index + active_speciation_term[index];
+    if ( speciation_terms_dirty == false && age == speciation_term_ages[offset] )
+    {
+        return false;
+    }
+    
+    double term = 0.0;
+    if ( age != RbConstants::Double::neginf )
+    {
+        double t = speciation_terms_origin - age;
+        term = lnSpeciationRate(t) + 2.0 * log( pSurvival(t, speciation_terms_present, speciation_terms_sampling_probability) ) + rateIntegral(t, speciation_terms_present);
+    }
+    
+    double old_age  = speciation_term_ages[offset];
+    double old_term = speciation_terms[offset];
+    
+    if ( changed_nodes[index] == false )
+    {
+        active_speciation_term[index] = 1 - active_speciation_term[index];
+        offset = 2*index + active_speciation_term[index];
+        changed_nodes[index] = true;
+        changed_node_indices.push_back( index );
+    }
+    speciation_term_ages[offset]    = age;
+    speciation_terms[offset]        = term;
+    
+    // if all terms are recomputed, then the sum and the sorted ages are rebuilt afterwards
+    if ( speciation_terms_dirty == true )
+    {
+        return false;
+    }
+    
+    if ( sampling_strategy == "diversified" )
+    {
+        std::multiset<double>::iterator it = speciation_ages.find( old_age );
+        if ( it != speciation_ages.end() )
+        {
+            speciation_ages.erase( it );
+        }
+        if ( age != RbConstants::Double::neginf )
+        {
+            speciation_ages.insert( age );
+        }
+    }
+    
+    if ( RbMath::isFinite(old_term) == false || RbMath::isFinite(term) == false )
+    {
+        return true;
+    }
+    speciation_terms_sum += term - old_term;
+    
+    return false;
+}
+
+
+/**
+ * Bring the speciation terms up to date and return their sum, i.e., the sum over all speciation events of
+ * the log speciation rate and the log-probability of observing exactly one lineage (without the sampling probability).
+ * If a parameter, the origin or the present changed, then we recompute all terms. Otherwise, we only recompute the terms
+ * of the nodes that the tree reported as changed, or compare the ages of all nodes if the tree was replaced.
+ *
+ * \param[in]    origin      The time of the process.
+ * \param[in]    present     The present time, i.e., the end of the process.
+ * \param[in]    r           The sampling probability.
+ *
+ * \return The sum of the speciation terms.
+ */
+double BirthDeathProcess::updateSpeciationTerms(double origin, double present, double r) const
+{
+    
+    // we need to be informed about the changes of the current tree
+    BirthDeathProcess *listener = const_cast<BirthDeathProcess*>( this );
+    if ( value->getTreeChangeEventHandler().isListening( listener ) == false )
+    {
+        value->getTreeChangeEventHandler().addListener( listener );
+        all_nodes_dirty = true;
+    }
+    
+    size_t num_nodes = value->getNumberOfNodes();
+    if ( active_speciation_term.size() != num_nodes )
+    {
+        speciation_terms        = std::vector<double>(2*num_nodes, 0.0);
+        speciation_term_ages    = std::vector<double>(2*num_nodes, RbConstants::Double::nan);
+        active_speciation_term  = std::vector<size_t>(num_nodes, 0);
+        changed_nodes           = std::vector<bool>(num_nodes, false);
+        changed_node_indices.clear();
+        dirty_nodes             = std::vector<bool>(num_nodes, false);
+        dirty_node_indices.clear();
+        
+        speciation_terms_dirty          = true;
+        stored_speciation_terms_dirty   = true;
+    }
+    
+    if ( origin != speciation_terms_origin || present != speciation_terms_present || r != speciation_terms_sampling_probability )
+    {
+        speciation_terms_origin                 = origin;
+        speciation_terms_present                = present;
+        speciation_terms_sampling_probability   = r;
+        speciation_terms_dirty                  = true;
+    }
+    
+    bool recompute_sum = speciation_terms_dirty;
+    if ( speciation_terms_dirty == true || all_nodes_dirty == true )
+    {
+        for (size_t i=0; i<num_nodes; ++i)
+        {
+            recompute_sum |= updateSpeciationTerm( i );
+        }
+    }
+    else
+    {
+        for (size_t i=0; i<dirty_node_indices.size(); ++i)
+        {
+            recompute_sum |= updateSpeciationTerm( dirty_node_indices[i] );
+        }
+    }
+    
+    if ( speciation_terms_dirty == true && sampling_strategy == "diversified" )
+    {
+        speciation_ages.clear();
+        for (size_t i=0; i<num_nodes; ++i)
+        {
+            double age = speciation_term_ages[2*i + active_speciation_term[i]];
+            if ( age != RbConstants::Double::neginf )
+            {
+                speciation_ages.insert( age );
+            }
+        }
+    }
+    
+    if ( recompute_sum == true )
+    {
+        speciation_terms_sum = 0.0;
+        for (size_t i=0; i<num_nodes; ++i)
+        {
+            speciation_terms_sum += speciation_terms[2*i + active_speciation_term[i]];
+        }
+    }
+    
+    for (size_t i=0; i<dirty_node_indices.size(); ++i)
+    {
+        dirty_nodes[ dirty_node_indices[i] ] = false;
+    }
+    dirty_node_indices.clear();
+    all_nodes_dirty         = false;
+    speciation_terms_dirty  = false;
     
+    return speciation_terms_sum;
 }
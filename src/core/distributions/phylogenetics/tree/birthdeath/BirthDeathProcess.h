@@ -1,8 +1,11 @@
 #ifndef BirthDeathProcess_H
 #define BirthDeathProcess_H
 
+#include <set>
+
 #include "Taxon.h"
 #include "Tree.h"
+#include "TreeChangeEventListener.h"
 #include "TypedDagNode.h"
 #include "AbstractBirthDeathProcess.h"
 
@@ -16,12 +19,18 @@ namespace RevBayesCore {
      *
      * @brief Declaration of the abstract Birth-Death process class.
      *
+     * The log-density of the divergence times is a sum over the interior nodes (except the root) of a term that only
+     * depends on the age of the node. We keep these terms per node and listen to the tree change events,
+     * so that only the terms of the nodes whose age changed are recomputed (e.g., after a node-time slide).
+     * All terms are recomputed when a parameter or the root age changed.
+     * As for the partial likelihoods of the PhyloCTMC, each node has two slots so that we can restore the terms of a rejected move.
+     *
      * @copyright Copyright 2009-
      * @author The RevBayes Development Core Team (Sebastian Hoehna)
      * @since 2014-01-17, version 1.0
      *
      */
-    class BirthDeathProcess : public AbstractBirthDeathProcess {
+    class BirthDeathProcess : public AbstractBirthDeathProcess, public TreeChangeEventListener {
 
     public:
         BirthDeathProcess(const TypedDagNode<double> *ro,
@@ -32,14 +41,18 @@ namespace RevBayesCore {
                           const std::string &cdt,
                           const std::vector<Taxon> &tn,
                           Tree *t);
+        virtual                                            ~BirthDeathProcess(void);
 
         // pure virtual member functions
         virtual BirthDeathProcess*                          clone(void) const = 0;                                                      //!< Create an independent clone
 
+        void                                                fireTreeChangeEvent(const TopologyNode &n, const unsigned& m=0);            //!< The age of this node may have changed
+
 
     protected:
         // Parameter management functions
         void                                                swapParameterInternal(const DagNode *oldP, const DagNode *newP);            //!< Swap a parameter
+        virtual void                                        keepSpecialization(const DagNode *affecter);
         virtual void                                        restoreSpecialization(const DagNode *restorer);
         virtual void                                        touchSpecialization(const DagNode *toucher, bool touchAll);
 
@@ -48,20 +61,17 @@ namespace RevBayesCore {
         virtual double                                      rateIntegral(double t_low, double t_high) const = 0;                        //!< Compute the rate integral.
         virtual double                                      computeProbabilitySurvival(double start, double end) const = 0;             //!< Compute the probability of survival of the process (without incomplete taxon sampling).
 
-        virtual void                                        prepareRateIntegral(double end) const;                                      //!< Compute the rate integral.
-        virtual void                                        prepareSurvivalProbability(double end, double r) const;                     //!< Compute the rate integral.
-        
-        
         // helper functions
         virtual double                                      computeLnProbabilityTimes(void) const;                                      //!< Compute the log-transformed probability of the current value.
         size_t                                              getNumberOfTaxaAtPresent(void) const;
-        double                                              lnP1(double T, double r) const;
         double                                              lnP1(double t, double T, double r) const;
         double                                              lnProbNumTaxa(size_t n, double start, double end, bool MRCA) const;         //!< Compute the log-transformed probability of the number of taxa.
         double                                              lnProbSurvival(double start, double end) const;                             //!< Compute the probability of survival of the process (without incomplete taxon sampling).
         double                                              lnProbSurvival(double start, double end, double r) const;                   //!< Compute the probability of survival of the process including uniform taxon sampling.
         double                                              pSurvival(double start, double end) const;                                  //!< Compute the probability of survival of the process (without incomplete taxon sampling).
         double                                              pSurvival(double start, double end, double r) const;                        //!< Compute the probability of survival of the process including uniform taxon sampling.
+        bool                                                updateSpeciationTerm(size_t index) const;                                   //!< Recompute the speciation term of the node if its age changed.
+        double                                              updateSpeciationTerms(double origin, double present, double r) const;      //!< Recompute the changed speciation terms and return their sum.
 
         // members
         const TypedDagNode<double>*                         rho;                                                                        //!< Sampling probability of each species.
@@ -71,8 +81,26 @@ namespace RevBayesCore {
         std::vector<Clade>                                  incomplete_clades;                                                          //!< Topological constrains.
         std::vector<double>                                 incomplete_clade_ages;                                                      //!< Topological constrains.
         
-        mutable std::vector<double>                         log_p_survival;                                                             //!< Topological constrains.
-        mutable std::vector<double>                         rate_integral;                                                              //!< Topological constrains.
+        // the cached log-densities of the speciation events
+        mutable std::vector<double>                         speciation_terms;                                                           //!< Two slots per node with the log-density of the speciation event.
+        mutable std::vector<double>                         speciation_term_ages;                                                       //!< The node age for which the term in the same slot was computed.
+        mutable std::vector<size_t>                         active_speciation_term;                                                     //!< The active slot of each node.
+        mutable std::vector<bool>                           changed_nodes;                                                              //!< Nodes whose active slot changed since the last keep.
+        mutable std::vector<size_t>                         changed_node_indices;
+        mutable std::vector<bool>                           dirty_nodes;                                                                //!< Nodes whose age may have changed since the last computation.
+        mutable std::vector<size_t>                         dirty_node_indices;
+        mutable std::multiset<double>                       speciation_ages;                                                            //!< The sorted ages of the speciation events (only used for diversified sampling).
+        mutable bool                                        all_nodes_dirty;                                                            //!< Compare the ages of all nodes, e.g., because the tree was replaced.
+        mutable bool                                        speciation_terms_dirty;                                                     //!< Recompute all terms, e.g., because a parameter changed.
+        mutable bool                                        stored_speciation_terms_dirty;
+        mutable double                                      speciation_terms_sum;
+        mutable double                                      stored_speciation_terms_sum;
+        mutable double                                      speciation_terms_origin;                                                    //!< The origin, present and sampling probability of the cached terms.
+        mutable double                                      speciation_terms_present;
+        mutable double                                      speciation_terms_sampling_probability;
+        mutable double                                      stored_speciation_terms_origin;
+        mutable double                                      stored_speciation_terms_present;
+        mutable double                                      stored_speciation_terms_sampling_probability;
         
         
     };
@@ -59,6 +59,8 @@ namespace RevBayesCore {
         mutable std::vector<double>                         rate_change_times;
         mutable std::vector<double>                         birth;
         mutable std::vector<double>                         death;
+        std::vector<double>                                 log_p_survival;
+        std::vector<double>                                 rate_integral;
 
     };
     
@@ -2601,7 +2601,12 @@ if ( abs(root*root - x) > 1.0e-15) {
 	help_strings[string("srGelmanRubin")][string("name")] = string(R"(srGelmanRubin)");
 	help_strings[string("srGeweke")][string("name")] = string(R"(srGeweke)");
 	help_strings[string("srMaxIteration")][string("name")] = string(R"(srMaxIteration)");
+	help_strings[string("srMaxTime")][string("description")] = string(R"(Stops the analysis once it has run for the given amount of time.)");
+	help_strings[string("srMaxTime")][string("details")] = string(R"(The elapsed time is checked at the end of a generation. When the replicates of an analysis run concurrently (parallelRuns=TRUE), they only wait for each other at least every 100 generations, so the time is checked only then and the analysis can run up to 100 generations longer than it would otherwise.)");
 	help_strings[string("srMaxTime")][string("name")] = string(R"(srMaxTime)");
+	help_arrays[string("srMaxTime")][string("see_also")].push_back(string(R"(mcmc)"));
+	help_arrays[string("srMaxTime")][string("see_also")].push_back(string(R"(mcmcmc)"));
+	help_strings[string("srMaxTime")][string("title")] = string(R"(Stopping rule based on the run time)");
 	help_strings[string("srMinESS")][string("name")] = string(R"(srMinESS)");
 	help_strings[string("srStationarity")][string("name")] = string(R"(srStationarity)");
 	help_strings[string("stdev")][string("name")] = string(R"(stdev)");
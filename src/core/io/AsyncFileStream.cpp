@@ -0,0 +1,179 @@
+#include "AsyncFileStream.h"
+
+#include <fstream>
+
+#include "AsyncFileWriter.h"
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    // hand the output to the I/O thread once this many characters were collected, even without a flush
+    const size_t max_chunk_size = 1 << 16;
+
+}
+
+
+AsyncFileStream::AsyncFileStream( void ) : std::iostream( NULL )
+{
+
+    rdbuf( &buffer );
+}
+
+
+AsyncFileStream::~AsyncFileStream( void )
+{
+
+    if ( is_open() == true )
+    {
+        close();
+    }
+
+}
+
+
+void AsyncFileStream::close( void )
+{
+
+    if ( buffer.file == NULL )
+    {
+        setstate( std::ios_base::failbit );
+        return;
+    }
+
+    waitUntilWritten();
+
+    buffer.file->close();
+    buffer.file.reset();
+
+}
+
+
+bool AsyncFileStream::is_open( void ) const
+{
+
+    return buffer.file != NULL && buffer.file->is_open();
+}
+
+
+/**
+ * Open the file. The file is opened on the calling thread, so that a failure is noticed immediately.
+ */
+void AsyncFileStream::open(const std::string &fn, std::ios_base::openmode mode)
+{
+
+    if ( is_open() == true )
+    {
+        setstate( std::ios_base::failbit );
+        return;
+    }
+
+    buffer.file = std::make_shared<std::ofstream>( fn, mode | std::ios_base::out );
+    buffer.position = 0;
+
+    if ( buffer.file->is_open() == false )
+    {
+        buffer.file.reset();
+        setstate( std::ios_base::failbit );
+    }
+    else
+    {
+        clear();
+    }
+
+}
+
+
+/**
+ * Wait until all output is in the file. If the I/O thread could not write it, the stream is set bad.
+ */
+void AsyncFileStream::waitUntilWritten( void )
+{
+
+    // hand over the output even if the stream is in a failed state
+    buffer.pubsync();
+    AsyncFileWriter::asyncFileWriterInstance().waitUntilWritten();
+
+    if ( buffer.file != NULL && buffer.file->fail() == true )
+    {
+        setstate( std::ios_base::badbit );
+    }
+
+}
+
+
+AsyncFileStream::Buffer::Buffer( void ) :
+    position( 0 )
+{
+
+}
+
+
+AsyncFileStream::Buffer::int_type AsyncFileStream::Buffer::overflow(int_type c)
+{
+
+    if ( traits_type::eq_int_type( c, traits_type::eof() ) == false )
+    {
+        data.push_back( traits_type::to_char_type( c ) );
+        ++position;
+
+        if ( data.size() >= max_chunk_size )
+        {
+            sync();
+        }
+    }
+
+    return traits_type::not_eof( c );
+}
+
+
+/**
+ * The monitors move to the end of the file before they write. All output goes to the end of the file,
+ * so we only report the current position.
+ */
+std::streampos AsyncFileStream::Buffer::seekoff(std::streamoff off, std::ios_base::seekdir dir, std::ios_base::openmode /*which*/)
+{
+
+    if ( off == 0 && dir != std::ios_base::beg )
+    {
+        return std::streampos( position );
+    }
+
+    return std::streampos( std::streamoff(-1) );
+}
+
+
+int AsyncFileStream::Buffer::sync( void )
+{
+
+    if ( data.empty() == true )
+    {
+        return 0;
+    }
+
+    if ( file == NULL )
+    {
+        return -1;
+    }
+
+    AsyncFileWriter::asyncFileWriterInstance().write( file, std::move(data) );
+    data.clear();
+
+    return 0;
+}
+
+
+std::streamsize AsyncFileStream::Buffer::xsputn(const char *s, std::streamsize n)
+{
+
+    data.append( s, n );
+    position += n;
+
+    if ( data.size() >= max_chunk_size )
+    {
+        sync();
+    }
+
+    return n;
+}
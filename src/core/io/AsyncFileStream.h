@@ -0,0 +1,63 @@
+#ifndef AsyncFileStream_H
+#define AsyncFileStream_H
+
+#include <cstddef>
+#include <ios>
+#include <iosfwd>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Output file stream that writes on the I/O thread of the AsyncFileWriter.
+     *
+     * The stream collects the formatted output in memory. When the stream is flushed (e.g., by std::endl
+     * or at the end of a sample), the collected output is handed to the AsyncFileWriter as one chunk,
+     * which writes it to the file on its own thread. Hence, a flush does not wait for the file system.
+     * close() and waitUntilWritten() wait until all output of the stream is in the file.
+     *
+     * Apart from that, the stream is used like a std::fstream that is only written to.
+     */
+    class AsyncFileStream : public std::iostream {
+
+    public:
+        AsyncFileStream(void);
+        virtual                                    ~AsyncFileStream(void);                                      //!< Closes the stream
+
+        void                                        close(void);                                                //!< Write all output and close the file
+        bool                                        is_open(void) const;
+        void                                        open(const std::string &fn, std::ios_base::openmode mode = std::ios_base::out);
+        void                                        waitUntilWritten(void);                                     //!< Wait until all output is in the file
+
+    private:
+        AsyncFileStream(const AsyncFileStream &s);                                                              //!< The stream cannot be copied
+        AsyncFileStream&                            operator=(const AsyncFileStream &s);
+
+        class Buffer : public std::streambuf {
+
+        public:
+            Buffer(void);
+
+            std::shared_ptr<std::ofstream>          file;
+            std::streamoff                          position;                                                   //!< The number of characters written through this buffer
+
+        protected:
+            int_type                                overflow(int_type c);
+            std::streampos                          seekoff(std::streamoff off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+            int                                     sync(void);
+            std::streamsize                         xsputn(const char *s, std::streamsize n);
+
+        private:
+            std::string                             data;                                                       //!< The output since the last flush
+        };
+
+        Buffer                                      buffer;
+    };
+
+}
+
+#endif
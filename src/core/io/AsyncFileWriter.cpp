@@ -0,0 +1,158 @@
+#include "AsyncFileWriter.h"
+
+#include <cstdlib>
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    // the number of chunks that can wait in the ring buffer
+    const size_t ring_capacity = 1024;
+
+}
+
+
+/** Default constructor */
+AsyncFileWriter::AsyncFileWriter(void) :
+    ring( ring_capacity ),
+    first_chunk( 0 ),
+    num_chunks( 0 ),
+    num_pending( 0 ),
+    stopped( false )
+{
+
+    std::atexit( &AsyncFileWriter::writeAtExit );
+}
+
+
+void AsyncFileWriter::ioLoop( void )
+{
+
+    // the stream that was written to since it was flushed the last time
+    std::shared_ptr<std::ostream> unflushed;
+
+    std::unique_lock<std::mutex> lock( mutex );
+    while ( true )
+    {
+        chunk_available.wait( lock, [&]{ return num_chunks > 0 || stopped == true; } );
+
+        // we only stop once all chunks are written
+        if ( num_chunks == 0 )
+        {
+            return;
+        }
+
+        Chunk chunk = std::move( ring[first_chunk] );
+        ring[first_chunk] = Chunk();
+        first_chunk = (first_chunk + 1) % ring.size();
+        --num_chunks;
+        space_available.notify_one();
+
+        lock.unlock();
+
+        // several streams may write to the same file (e.g., the monitors of the chains of an MCMCMC),
+        // so the previous stream must be flushed before another stream appends to the end of the file
+        if ( unflushed != NULL && unflushed != chunk.stream )
+        {
+            unflushed->flush();
+        }
+        chunk.stream->seekp( 0, std::ios_base::end );
+        chunk.stream->write( chunk.data.data(), chunk.data.size() );
+        unflushed = chunk.stream;
+        chunk = Chunk();
+
+        lock.lock();
+
+        // flush the file when there is nothing else to do
+        if ( num_chunks == 0 )
+        {
+            lock.unlock();
+            unflushed->flush();
+            unflushed.reset();
+            lock.lock();
+        }
+
+        --num_pending;
+        if ( num_pending == 0 )
+        {
+            all_written.notify_all();
+        }
+    }
+
+}
+
+
+/**
+ * Write all chunks that are still in the ring buffer and join the I/O thread.
+ */
+void AsyncFileWriter::stop( void )
+{
+
+    std::unique_lock<std::mutex> lock( mutex );
+    all_written.wait( lock, [&]{ return num_pending == 0; } );
+
+    stopped = true;
+    chunk_available.notify_one();
+
+    lock.unlock();
+
+    if ( io_thread.joinable() == true )
+    {
+        io_thread.join();
+    }
+
+}
+
+
+/**
+ * Wait until all chunks that were added so far are written and flushed.
+ */
+void AsyncFileWriter::waitUntilWritten( void )
+{
+
+    std::unique_lock<std::mutex> lock( mutex );
+    all_written.wait( lock, [&]{ return num_pending == 0; } );
+}
+
+
+/**
+ * Add a chunk to the ring buffer. The I/O thread is started with the first chunk.
+ * Once the I/O thread was stopped at exit, the chunk is written directly.
+ */
+void AsyncFileWriter::write(const std::shared_ptr<std::ostream> &o, std::string &&data)
+{
+
+    std::unique_lock<std::mutex> lock( mutex );
+
+    if ( stopped == true )
+    {
+        o->seekp( 0, std::ios_base::end );
+        o->write( data.data(), data.size() );
+        o->flush();
+
+        return;
+    }
+
+    if ( io_thread.joinable() == false )
+    {
+        io_thread = std::thread( &AsyncFileWriter::ioLoop, this );
+    }
+
+    space_available.wait( lock, [&]{ return num_chunks < ring.size(); } );
+
+    Chunk &chunk = ring[(first_chunk + num_chunks) % ring.size()];
+    chunk.stream = o;
+    chunk.data   = std::move( data );
+    ++num_chunks;
+    ++num_pending;
+
+    chunk_available.notify_one();
+}
+
+
+void AsyncFileWriter::writeAtExit( void )
+{
+
+    asyncFileWriterInstance().stop();
+}
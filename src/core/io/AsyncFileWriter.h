@@ -0,0 +1,72 @@
+#ifndef AsyncFileWriter_H
+#define AsyncFileWriter_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief AsyncFileWriter class declaration
+     * The class AsyncFileWriter owns a dedicated I/O thread that writes chunks of output to their files.
+     * Producers (e.g., the file monitors on the sampling threads) put their chunks into a bounded ring buffer
+     * and continue immediately, so a slow file system does not stall the sampler. If the ring buffer is full,
+     * the producer waits until the I/O thread made space. The chunks of a file are written in the order in which
+     * they were added, always at the end of the file, and a stream is flushed before the I/O thread writes for
+     * another stream or when the ring buffer runs empty. Hence, several streams can append to the same file.
+     * A failed write sets the error state of the file stream, which the owner can check after waitUntilWritten().
+     *
+     * The writer is never destroyed, so that streams can still be closed while static objects are destroyed
+     * at exit. When the program exits, all chunks that are still in the ring buffer are written and the I/O
+     * thread is joined. Chunks that are added after that (e.g., by static objects closing their streams) are
+     * written directly by the calling thread.
+     *
+     */
+    class AsyncFileWriter {
+
+    public:
+        static AsyncFileWriter&                     asyncFileWriterInstance(void)                                                           //!< Return a reference to the singleton writer
+                                                    {
+                                                        static AsyncFileWriter* singleAsyncFileWriter = new AsyncFileWriter();
+                                                        return *singleAsyncFileWriter;
+                                                    }
+
+        void                                        waitUntilWritten(void);                                                                 //!< Wait until all chunks are written and flushed
+        void                                        write(const std::shared_ptr<std::ostream> &o, std::string &&data);                     //!< Add a chunk for the stream to the ring buffer
+
+    private:
+                                                    AsyncFileWriter(void);                                                                  //!< Default constructor
+                                                    AsyncFileWriter(const AsyncFileWriter&);                                                //!< Copy constructor
+                                                    AsyncFileWriter& operator=(const AsyncFileWriter&);                                     //!< Assignment operator
+
+        struct Chunk {
+            std::shared_ptr<std::ostream>           stream;
+            std::string                             data;
+        };
+
+        void                                        ioLoop(void);                                                                           //!< Main function of the I/O thread
+        void                                        stop(void);                                                                             //!< Write all chunks and join the I/O thread
+        static void                                 writeAtExit(void);
+
+        std::vector<Chunk>                          ring;
+        size_t                                      first_chunk;
+        size_t                                      num_chunks;                                                                             //!< The number of chunks in the ring buffer
+        size_t                                      num_pending;                                                                            //!< The number of chunks that are not yet written and flushed
+        bool                                        stopped;                                                                                //!< Was the I/O thread stopped at exit?
+
+        std::mutex                                  mutex;
+        std::condition_variable                     chunk_available;
+        std::condition_variable                     space_available;
+        std::condition_variable                     all_written;
+        std::thread                                 io_thread;
+    };
+
+}
+
+#endif
@@ -0,0 +1,243 @@
+#include "BinaryTraceCodec.h"
+
+#include <cstring>
+
+#include "RbException.h"
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    std::uint64_t doubleToBits(double x)
+    {
+        std::uint64_t bits;
+        std::memcpy( &bits, &x, sizeof(bits) );
+        return bits;
+    }
+
+
+    double bitsToDouble(std::uint64_t bits)
+    {
+        double x;
+        std::memcpy( &x, &bits, sizeof(x) );
+        return x;
+    }
+
+
+    void checkRemaining(const char *p, const char *end, size_t n)
+    {
+        if ( p > end || size_t(end - p) < n )
+        {
+            throw RbException("Unexpected end of data in binary trace file. The file may be truncated.");
+        }
+    }
+
+}
+
+
+/**
+ * The integers are stored as the zigzag encoded difference to the previous value,
+ * so that small steps in either direction need few bytes.
+ */
+void BinaryTraceCodec::decodeIntegers(const char* &p, const char *end, size_t n, std::vector<double> &v)
+{
+
+    std::int64_t previous = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::uint64_t z = getVarint( p, end );
+        std::int64_t delta = std::int64_t(z >> 1) ^ -std::int64_t(z & 1);
+        previous += delta;
+        v.push_back( double(previous) );
+    }
+
+}
+
+
+void BinaryTraceCodec::decodeReals(const char* &p, const char *end, size_t n, std::vector<double> &v)
+{
+
+    std::uint64_t previous = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        checkRemaining( p, end, 1 );
+        unsigned char control = static_cast<unsigned char>( *p++ );
+        size_t leading  = control >> 4;
+        size_t trailing = control & 0x0F;
+        if ( leading + trailing > 8 )
+        {
+            throw RbException("Corrupt real value in binary trace file.");
+        }
+
+        size_t num_bytes = 8 - leading - trailing;
+        checkRemaining( p, end, num_bytes );
+
+        std::uint64_t x = 0;
+        for (size_t k = 0; k < num_bytes; ++k)
+        {
+            x = (x << 8) | static_cast<unsigned char>( *p++ );
+        }
+        if ( num_bytes > 0 )
+        {
+            x <<= 8 * trailing;
+        }
+
+        previous ^= x;
+        v.push_back( bitsToDouble(previous) );
+    }
+
+}
+
+
+void BinaryTraceCodec::decodeStrings(const char* &p, const char *end, size_t n, std::vector<std::string> &v)
+{
+
+    std::string previous = "";
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::uint64_t length = getVarint( p, end );
+
+        // a zero length means that the value did not change
+        if ( length > 0 )
+        {
+            checkRemaining( p, end, length - 1 );
+            previous.assign( p, length - 1 );
+            p += length - 1;
+        }
+        v.push_back( previous );
+    }
+
+}
+
+
+void BinaryTraceCodec::encodeIntegers(std::string &buf, const std::vector<std::int64_t> &v)
+{
+
+    std::int64_t previous = 0;
+    for (std::int64_t x: v)
+    {
+        std::int64_t delta = x - previous;
+        putVarint( buf, (std::uint64_t(delta) << 1) ^ std::uint64_t(delta >> 63) );
+        previous = x;
+    }
+
+}
+
+
+/**
+ * Each real number is XOR-ed with the previous one. Successive samples of a parameter usually share
+ * the sign, exponent and high mantissa bits, or are identical if the proposal was rejected, so the XOR
+ * has leading and trailing zero bytes. These are only counted in a control byte and the other bytes
+ * are stored as they are.
+ */
+void BinaryTraceCodec::encodeReals(std::string &buf, const std::vector<double> &v)
+{
+
+    std::uint64_t previous = 0;
+    for (double d: v)
+    {
+        std::uint64_t bits = doubleToBits( d );
+        std::uint64_t x = bits ^ previous;
+        previous = bits;
+
+        if ( x == 0 )
+        {
+            buf.push_back( char(8 << 4) );
+            continue;
+        }
+
+        size_t leading = 0;
+        while ( ((x >> (56 - 8 * leading)) & 0xFF) == 0 )
+        {
+            ++leading;
+        }
+        size_t trailing = 0;
+        while ( ((x >> (8 * trailing)) & 0xFF) == 0 )
+        {
+            ++trailing;
+        }
+
+        buf.push_back( char((leading << 4) | trailing) );
+        for (size_t k = 7 - leading; k + 1 > trailing; --k)
+        {
+            buf.push_back( char((x >> (8 * k)) & 0xFF) );
+        }
+    }
+
+}
+
+
+void BinaryTraceCodec::encodeStrings(std::string &buf, const std::vector<std::string> &v)
+{
+
+    const std::string *previous = NULL;
+    for (const std::string &s: v)
+    {
+        if ( previous != NULL && *previous == s )
+        {
+            putVarint( buf, 0 );
+        }
+        else
+        {
+            putVarint( buf, s.size() + 1 );
+            buf.append( s );
+        }
+        previous = &s;
+    }
+
+}
+
+
+std::string BinaryTraceCodec::getString(const char* &p, const char *end)
+{
+
+    std::uint64_t length = getVarint( p, end );
+    checkRemaining( p, end, length );
+
+    std::string s( p, length );
+    p += length;
+
+    return s;
+}
+
+
+std::uint64_t BinaryTraceCodec::getVarint(const char* &p, const char *end)
+{
+
+    std::uint64_t v = 0;
+    for (size_t shift = 0; shift < 64; shift += 7)
+    {
+        checkRemaining( p, end, 1 );
+        unsigned char byte = static_cast<unsigned char>( *p++ );
+        v |= std::uint64_t(byte & 0x7F) << shift;
+        if ( (byte & 0x80) == 0 )
+        {
+            return v;
+        }
+    }
+
+    throw RbException("Corrupt integer in binary trace file.");
+}
+
+
+void BinaryTraceCodec::putString(std::string &buf, const std::string &s)
+{
+
+    putVarint( buf, s.size() );
+    buf.append( s );
+
+}
+
+
+void BinaryTraceCodec::putVarint(std::string &buf, std::uint64_t v)
+{
+
+    while ( v >= 0x80 )
+    {
+        buf.push_back( char((v & 0x7F) | 0x80) );
+        v >>= 7;
+    }
+    buf.push_back( char(v) );
+
+}
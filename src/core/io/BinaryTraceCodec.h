@@ -0,0 +1,47 @@
+#ifndef BinaryTraceCodec_H
+#define BinaryTraceCodec_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Encoding of the binary trace format.
+     *
+     * A binary trace file starts with a header (the magic bytes, the format version, the comment lines,
+     * and the name and type of each column) followed by blocks of rows. Within a block the values are
+     * stored column by column and each column chunk is compressed on its own:
+     *  - integer columns (e.g., the iteration) store the zigzag encoded difference to the previous value as a varint,
+     *  - real columns store the XOR with the previous value without its leading and trailing zero bytes,
+     *    so a value that did not change (e.g., a rejected proposal) only costs a single byte,
+     *  - string columns (e.g., trees) store a single byte if the value did not change.
+     * Each block starts with the byte size of its chunks, so a reader can skip the columns it does not need.
+     * The header may be repeated when a run appends to an existing file.
+     */
+    namespace BinaryTraceCodec {
+
+        enum ColumnType { INTEGER = 0, REAL = 1, STRING = 2 };
+
+        const std::string           magic = std::string("RBTRACE\0", 8);                                    //!< The first bytes of every binary trace file
+        const std::uint64_t         version = 1;
+        const char                  block_marker = 'B';                                                     //!< The first byte of every block
+
+        void                        decodeIntegers(const char* &p, const char *end, size_t n, std::vector<double> &v);     //!< Decode n integers and append them to v
+        void                        decodeReals(const char* &p, const char *end, size_t n, std::vector<double> &v);
+        void                        decodeStrings(const char* &p, const char *end, size_t n, std::vector<std::string> &v);
+        void                        encodeIntegers(std::string &buf, const std::vector<std::int64_t> &v);
+        void                        encodeReals(std::string &buf, const std::vector<double> &v);
+        void                        encodeStrings(std::string &buf, const std::vector<std::string> &v);
+        std::string                 getString(const char* &p, const char *end);
+        std::uint64_t               getVarint(const char* &p, const char *end);                             //!< Read a variable length unsigned integer
+        void                        putString(std::string &buf, const std::string &s);
+        void                        putVarint(std::string &buf, std::uint64_t v);                           //!< Write a variable length unsigned integer
+
+    }
+
+}
+
+#endif
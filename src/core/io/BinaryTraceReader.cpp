@@ -0,0 +1,403 @@
+#include "BinaryTraceReader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "RbException.h"
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    bool readVarint(std::istream &in, std::uint64_t &v)
+    {
+        v = 0;
+        for (size_t shift = 0; shift < 64; shift += 7)
+        {
+            int byte = in.get();
+            if ( byte == EOF )
+            {
+                return false;
+            }
+            v |= std::uint64_t(byte & 0x7F) << shift;
+            if ( (byte & 0x80) == 0 )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+
+    bool readString(std::istream &in, std::string &s)
+    {
+        std::uint64_t length = 0;
+        if ( readVarint(in, length) == false )
+        {
+            return false;
+        }
+
+        s.resize( length );
+        in.read( &s[0], length );
+
+        return size_t(in.gcount()) == length;
+    }
+
+}
+
+
+BinaryTraceReader::BinaryTraceReader(const path &fn) :
+    file_name( fn ),
+    num_rows( 0 )
+{
+
+    in_file.open( fn.string(), std::ios::in | std::ios::binary );
+
+    if ( !in_file )
+    {
+        throw RbException()<<"Could not open file "<<fn;
+    }
+
+    in_file.seekg( 0, std::ios::end );
+    std::streamoff file_size = in_file.tellg();
+    in_file.seekg( 0, std::ios::beg );
+
+    if ( readHeader() == false )
+    {
+        throw RbException()<<"File "<<fn<<" is not a valid binary trace file.";
+    }
+
+    // index the blocks
+    while ( true )
+    {
+        int c = in_file.peek();
+        if ( c == EOF )
+        {
+            break;
+        }
+
+        // a run that appended to the file wrote the header again
+        if ( c == BinaryTraceCodec::magic[0] )
+        {
+            if ( readHeader() == false )
+            {
+                break;
+            }
+            continue;
+        }
+
+        if ( c != BinaryTraceCodec::block_marker )
+        {
+            throw RbException()<<"Corrupt block in binary trace file "<<fn<<".";
+        }
+        in_file.get();
+
+        Block b;
+        std::uint64_t rows = 0;
+        if ( readVarint(in_file, rows) == false )
+        {
+            break;
+        }
+
+        bool complete = true;
+        for (size_t j = 0; j < column_names.size(); ++j)
+        {
+            std::uint64_t size = 0;
+            complete = readVarint(in_file, size);
+            if ( complete == false )
+            {
+                break;
+            }
+            b.chunk_sizes.push_back( size );
+        }
+        if ( complete == false )
+        {
+            break;
+        }
+
+        std::streamoff offset = in_file.tellg();
+        for (size_t j = 0; j < column_names.size(); ++j)
+        {
+            b.chunk_offsets.push_back( offset );
+            offset += b.chunk_sizes[j];
+        }
+
+        // the last block may not be written completely yet
+        if ( offset > file_size )
+        {
+            break;
+        }
+
+        b.first_row = num_rows;
+        b.num_rows  = rows;
+        num_rows += rows;
+        blocks.push_back( b );
+
+        in_file.seekg( offset );
+    }
+
+    // clear the end-of-file state so that we can seek to the blocks
+    in_file.clear();
+
+    DecodedChunk empty;
+    empty.block = blocks.size();
+    decoded_chunks.assign( column_names.size(), empty );
+
+}
+
+
+void BinaryTraceReader::decodeChunk(size_t b, size_t j, std::vector<double> &numbers, std::vector<std::string> &strings) const
+{
+
+    const Block &block = blocks[b];
+
+    std::string buf( block.chunk_sizes[j], '\0' );
+    in_file.clear();
+    in_file.seekg( block.chunk_offsets[j] );
+    in_file.read( &buf[0], buf.size() );
+    if ( size_t(in_file.gcount()) != buf.size() )
+    {
+        throw RbException()<<"Could not read block "<<(b+1)<<" of binary trace file "<<file_name<<".";
+    }
+
+    const char *p   = buf.data();
+    const char *end = p + buf.size();
+    if ( column_types[j] == BinaryTraceCodec::INTEGER )
+    {
+        BinaryTraceCodec::decodeIntegers( p, end, block.num_rows, numbers );
+    }
+    else if ( column_types[j] == BinaryTraceCodec::REAL )
+    {
+        BinaryTraceCodec::decodeReals( p, end, block.num_rows, numbers );
+    }
+    else
+    {
+        BinaryTraceCodec::decodeStrings( p, end, block.num_rows, strings );
+    }
+
+}
+
+
+const BinaryTraceReader::DecodedChunk& BinaryTraceReader::getChunk(size_t i, size_t j) const
+{
+
+    if ( i >= num_rows || j >= column_names.size() )
+    {
+        throw RbException()<<"Cannot access row "<<(i+1)<<" and column "<<(j+1)<<" of binary trace file "<<file_name<<" with "<<num_rows<<" rows and "<<column_names.size()<<" columns.";
+    }
+
+    // find the last block that starts at or before row i
+    auto it = std::upper_bound( blocks.begin(), blocks.end(), i, [](size_t row, const Block &b) { return row < b.first_row; } );
+    size_t b = size_t( it - blocks.begin() ) - 1;
+
+    DecodedChunk &chunk = decoded_chunks[j];
+    if ( chunk.block != b )
+    {
+        chunk.numbers.clear();
+        chunk.strings.clear();
+        decodeChunk( b, j, chunk.numbers, chunk.strings );
+        chunk.block = b;
+    }
+
+    return chunk;
+}
+
+
+const std::vector<std::string>& BinaryTraceReader::getColumnNames( void ) const
+{
+    return column_names;
+}
+
+
+BinaryTraceCodec::ColumnType BinaryTraceReader::getColumnType(size_t j) const
+{
+    return column_types[j];
+}
+
+
+const std::vector<std::string>& BinaryTraceReader::getComments( void ) const
+{
+    return comments;
+}
+
+
+size_t BinaryTraceReader::getNumberOfColumns( void ) const
+{
+    return column_names.size();
+}
+
+
+size_t BinaryTraceReader::getNumberOfRows( void ) const
+{
+    return num_rows;
+}
+
+
+/**
+ * Get a single value as a number.
+ * Values of string columns are converted as in the delimited trace readers.
+ */
+double BinaryTraceReader::getNumber(size_t i, size_t j) const
+{
+
+    const DecodedChunk &chunk = getChunk( i, j );
+    size_t k = i - blocks[chunk.block].first_row;
+
+    if ( column_types[j] == BinaryTraceCodec::STRING )
+    {
+        return atof( chunk.strings[k].c_str() );
+    }
+
+    return chunk.numbers[k];
+}
+
+
+std::vector<double> BinaryTraceReader::getNumbers(size_t j) const
+{
+
+    if ( j >= column_names.size() )
+    {
+        throw RbException()<<"Cannot access column "<<(j+1)<<" of binary trace file "<<file_name<<" with "<<column_names.size()<<" columns.";
+    }
+
+    std::vector<double> numbers;
+    numbers.reserve( num_rows );
+    std::vector<std::string> strings;
+    for (size_t b = 0; b < blocks.size(); ++b)
+    {
+        decodeChunk( b, j, numbers, strings );
+    }
+
+    for (auto& s: strings)
+    {
+        numbers.push_back( atof( s.c_str() ) );
+    }
+
+    return numbers;
+}
+
+
+const std::string& BinaryTraceReader::getString(size_t i, size_t j) const
+{
+
+    if ( j < column_types.size() && column_types[j] != BinaryTraceCodec::STRING )
+    {
+        throw RbException()<<"Column '"<<column_names[j]<<"' of binary trace file "<<file_name<<" does not contain strings.";
+    }
+
+    const DecodedChunk &chunk = getChunk( i, j );
+
+    return chunk.strings[i - blocks[chunk.block].first_row];
+}
+
+
+std::vector<std::string> BinaryTraceReader::getStrings(size_t j) const
+{
+
+    if ( j >= column_names.size() || column_types[j] != BinaryTraceCodec::STRING )
+    {
+        throw RbException()<<"Column "<<(j+1)<<" of binary trace file "<<file_name<<" does not contain strings.";
+    }
+
+    std::vector<double> numbers;
+    std::vector<std::string> strings;
+    strings.reserve( num_rows );
+    for (size_t b = 0; b < blocks.size(); ++b)
+    {
+        decodeChunk( b, j, numbers, strings );
+    }
+
+    return strings;
+}
+
+
+bool BinaryTraceReader::isBinaryTraceFile(const path &fn)
+{
+
+    std::ifstream in( fn.string(), std::ios::in | std::ios::binary );
+    if ( !in )
+    {
+        return false;
+    }
+
+    std::string bytes( BinaryTraceCodec::magic.size(), '\0' );
+    in.read( &bytes[0], bytes.size() );
+
+    return size_t(in.gcount()) == bytes.size() && bytes == BinaryTraceCodec::magic;
+}
+
+
+/**
+ * Read a header. The columns of a repeated header have to match those of the first one.
+ */
+bool BinaryTraceReader::readHeader( void )
+{
+
+    std::string bytes( BinaryTraceCodec::magic.size(), '\0' );
+    in_file.read( &bytes[0], bytes.size() );
+    if ( size_t(in_file.gcount()) != bytes.size() || bytes != BinaryTraceCodec::magic )
+    {
+        return false;
+    }
+
+    std::uint64_t version = 0;
+    if ( readVarint(in_file, version) == false )
+    {
+        return false;
+    }
+    if ( version > BinaryTraceCodec::version )
+    {
+        throw RbException()<<"Binary trace file "<<file_name<<" was written by a newer version of RevBayes.";
+    }
+
+    std::uint64_t num_comments = 0;
+    if ( readVarint(in_file, num_comments) == false )
+    {
+        return false;
+    }
+    std::vector<std::string> header_comments( num_comments );
+    for (auto& comment: header_comments)
+    {
+        if ( readString(in_file, comment) == false )
+        {
+            return false;
+        }
+    }
+
+    std::uint64_t num_columns = 0;
+    if ( readVarint(in_file, num_columns) == false )
+    {
+        return false;
+    }
+    std::vector<std::string> names( num_columns );
+    std::vector<BinaryTraceCodec::ColumnType> types( num_columns );
+    for (size_t j = 0; j < num_columns; ++j)
+    {
+        int type = in_file.get();
+        if ( type == EOF || readString(in_file, names[j]) == false )
+        {
+            return false;
+        }
+        if ( type > BinaryTraceCodec::STRING )
+        {
+            throw RbException()<<"Unknown column type in binary trace file "<<file_name<<".";
+        }
+        types[j] = BinaryTraceCodec::ColumnType( type );
+    }
+
+    if ( column_names.empty() == true )
+    {
+        comments     = header_comments;
+        column_names = names;
+        column_types = types;
+    }
+    else if ( names != column_names || types != column_types )
+    {
+        throw RbException()<<"Binary trace file "<<file_name<<" contains samples with different columns.";
+    }
+
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef BinaryTraceReader_H
+#define BinaryTraceReader_H
+
+#include <cstddef>
+#include <fstream>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "BinaryTraceCodec.h"
+#include "RbFileManager.h"
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Reader for binary trace files.
+     *
+     * The reader parses the header and indexes the blocks of the file when it is constructed.
+     * Columns are only decompressed when they are requested, either as a whole or one value at a time.
+     * For single values, the last decoded block of each column is kept, so reading a trace row by row
+     * only needs memory for one block per column.
+     * An incomplete block at the end of the file (e.g., of a run that is still writing) is ignored.
+     *
+     * The reader keeps an open file stream and is therefore not thread safe.
+     */
+    class BinaryTraceReader {
+
+    public:
+        BinaryTraceReader(const path &fn);                                                                      //!< Read the header and index the blocks
+
+        const std::vector<std::string>&             getColumnNames(void) const;
+        BinaryTraceCodec::ColumnType                getColumnType(size_t j) const;
+        const std::vector<std::string>&             getComments(void) const;                                    //!< The comment lines of the header (e.g., the version)
+        size_t                                      getNumberOfColumns(void) const;
+        size_t                                      getNumberOfRows(void) const;
+        double                                      getNumber(size_t i, size_t j) const;                        //!< The value of row i in column j
+        std::vector<double>                         getNumbers(size_t j) const;                                 //!< All values of column j
+        const std::string&                          getString(size_t i, size_t j) const;                        //!< The value of row i in column j
+        std::vector<std::string>                    getStrings(size_t j) const;                                 //!< All values of column j
+
+        static bool                                 isBinaryTraceFile(const path &fn);                          //!< Does the file start with the magic bytes of a binary trace?
+
+    private:
+
+        struct Block {
+            size_t                                  first_row;
+            size_t                                  num_rows;
+            std::vector<std::streamoff>             chunk_offsets;
+            std::vector<size_t>                     chunk_sizes;
+        };
+
+        struct DecodedChunk {
+            size_t                                  block;
+            std::vector<double>                     numbers;
+            std::vector<std::string>                strings;
+        };
+
+        BinaryTraceReader(const BinaryTraceReader &r);                                                          //!< The stream cannot be copied
+        BinaryTraceReader&                          operator=(const BinaryTraceReader &r);
+
+        void                                        decodeChunk(size_t b, size_t j, std::vector<double> &numbers, std::vector<std::string> &strings) const;
+        const DecodedChunk&                         getChunk(size_t i, size_t j) const;                         //!< The decoded chunk of column j that contains row i
+        bool                                        readHeader(void);                                           //!< Read a header at the current position of the stream
+
+        std::vector<Block>                          blocks;
+        std::vector<std::string>                    column_names;
+        std::vector<BinaryTraceCodec::ColumnType>   column_types;
+        std::vector<std::string>                    comments;
+        path                                        file_name;
+        size_t                                      num_rows;
+
+        mutable std::vector<DecodedChunk>           decoded_chunks;                                             //!< The last decoded chunk of each column
+        mutable std::ifstream                       in_file;
+    };
+
+}
+
+#endif
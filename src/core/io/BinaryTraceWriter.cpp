@@ -0,0 +1,235 @@
+#include "BinaryTraceWriter.h"
+
+#include <ostream>
+
+#include "RbException.h"
+
+using namespace RevBayesCore;
+
+
+BinaryTraceWriter::BinaryTraceWriter(size_t n) :
+    current_column( 0 ),
+    num_rows( 0 ),
+    rows_per_block( n > 0 ? n : 1 )
+{
+
+}
+
+
+/**
+ * The rows that are not written yet belong to the stream of the original writer,
+ * so a copy only gets the columns.
+ */
+BinaryTraceWriter::BinaryTraceWriter(const BinaryTraceWriter &w) :
+    current_column( 0 ),
+    num_rows( 0 ),
+    rows_per_block( w.rows_per_block )
+{
+
+    for (auto& c: w.columns)
+    {
+        addColumn( c.name, c.type );
+    }
+
+}
+
+
+BinaryTraceWriter& BinaryTraceWriter::operator=(const BinaryTraceWriter &w)
+{
+
+    if ( this != &w )
+    {
+        clear();
+        rows_per_block = w.rows_per_block;
+
+        for (auto& c: w.columns)
+        {
+            addColumn( c.name, c.type );
+        }
+    }
+
+    return *this;
+}
+
+
+void BinaryTraceWriter::addColumn(const std::string &n, BinaryTraceCodec::ColumnType t)
+{
+
+    if ( num_rows > 0 || current_column > 0 )
+    {
+        throw RbException("Cannot add a column to a binary trace after rows were added.");
+    }
+
+    Column c;
+    c.name = n;
+    c.type = t;
+    columns.push_back( c );
+
+}
+
+
+void BinaryTraceWriter::addInteger(std::int64_t v)
+{
+    nextColumn( BinaryTraceCodec::INTEGER ).integers.push_back( v );
+}
+
+
+void BinaryTraceWriter::addReal(double v)
+{
+    nextColumn( BinaryTraceCodec::REAL ).reals.push_back( v );
+}
+
+
+void BinaryTraceWriter::addString(const std::string &v)
+{
+    nextColumn( BinaryTraceCodec::STRING ).strings.push_back( v );
+}
+
+
+void BinaryTraceWriter::clear( void )
+{
+
+    columns.clear();
+    current_column = 0;
+    num_rows = 0;
+
+}
+
+
+void BinaryTraceWriter::endRow(std::ostream &o)
+{
+
+    if ( current_column != columns.size() )
+    {
+        throw RbException()<<"A row of the binary trace has "<<current_column<<" values but the trace has "<<columns.size()<<" columns.";
+    }
+
+    current_column = 0;
+    ++num_rows;
+
+    if ( num_rows >= rows_per_block )
+    {
+        flush( o );
+    }
+
+}
+
+
+/**
+ * Compress the complete rows into a block and write it.
+ * A row that is not finished (e.g., because adding a value failed) is discarded.
+ */
+void BinaryTraceWriter::flush(std::ostream &o)
+{
+
+    for (size_t j = 0; j < current_column; ++j)
+    {
+        Column &c = columns[j];
+        if ( c.type == BinaryTraceCodec::INTEGER )
+        {
+            c.integers.pop_back();
+        }
+        else if ( c.type == BinaryTraceCodec::REAL )
+        {
+            c.reals.pop_back();
+        }
+        else
+        {
+            c.strings.pop_back();
+        }
+    }
+    current_column = 0;
+
+    if ( num_rows == 0 )
+    {
+        return;
+    }
+
+    std::vector<std::string> chunks( columns.size() );
+    for (size_t j = 0; j < columns.size(); ++j)
+    {
+        Column &c = columns[j];
+        if ( c.type == BinaryTraceCodec::INTEGER )
+        {
+            BinaryTraceCodec::encodeIntegers( chunks[j], c.integers );
+            c.integers.clear();
+        }
+        else if ( c.type == BinaryTraceCodec::REAL )
+        {
+            BinaryTraceCodec::encodeReals( chunks[j], c.reals );
+            c.reals.clear();
+        }
+        else
+        {
+            BinaryTraceCodec::encodeStrings( chunks[j], c.strings );
+            c.strings.clear();
+        }
+    }
+
+    std::string block( 1, BinaryTraceCodec::block_marker );
+    BinaryTraceCodec::putVarint( block, num_rows );
+    for (auto& chunk: chunks)
+    {
+        BinaryTraceCodec::putVarint( block, chunk.size() );
+    }
+
+    o.write( block.data(), block.size() );
+    for (auto& chunk: chunks)
+    {
+        o.write( chunk.data(), chunk.size() );
+    }
+    o.flush();
+
+    num_rows = 0;
+
+}
+
+
+size_t BinaryTraceWriter::getNumberOfColumns( void ) const
+{
+    return columns.size();
+}
+
+
+BinaryTraceWriter::Column& BinaryTraceWriter::nextColumn(BinaryTraceCodec::ColumnType t)
+{
+
+    if ( current_column >= columns.size() )
+    {
+        throw RbException()<<"Cannot add more than "<<columns.size()<<" values to a row of the binary trace.";
+    }
+
+    Column &c = columns[current_column];
+    if ( c.type != t )
+    {
+        throw RbException()<<"The value added to column '"<<c.name<<"' of the binary trace has the wrong type.";
+    }
+    ++current_column;
+
+    return c;
+}
+
+
+void BinaryTraceWriter::writeHeader(std::ostream &o, const std::vector<std::string> &comments) const
+{
+
+    std::string header = BinaryTraceCodec::magic;
+    BinaryTraceCodec::putVarint( header, BinaryTraceCodec::version );
+
+    BinaryTraceCodec::putVarint( header, comments.size() );
+    for (auto& comment: comments)
+    {
+        BinaryTraceCodec::putString( header, comment );
+    }
+
+    BinaryTraceCodec::putVarint( header, columns.size() );
+    for (auto& c: columns)
+    {
+        header.push_back( char(c.type) );
+        BinaryTraceCodec::putString( header, c.name );
+    }
+
+    o.write( header.data(), header.size() );
+    o.flush();
+
+}
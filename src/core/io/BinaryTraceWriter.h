@@ -0,0 +1,59 @@
+#ifndef BinaryTraceWriter_H
+#define BinaryTraceWriter_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "BinaryTraceCodec.h"
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Writer for binary trace files.
+     *
+     * The writer knows the name and type of each column. The values of a row are added column by column
+     * and the rows are kept in memory until a block is full. Then the block is compressed (see BinaryTraceCodec)
+     * and written to the stream at once. Call flush() before the stream is closed to write the remaining rows.
+     */
+    class BinaryTraceWriter {
+
+    public:
+        BinaryTraceWriter(size_t n = 100);                                                                      //!< Constructor with the number of rows per block
+        BinaryTraceWriter(const BinaryTraceWriter &w);                                                          //!< Copy the columns but not the rows of the original
+
+        BinaryTraceWriter&                          operator=(const BinaryTraceWriter &w);
+
+        void                                        addColumn(const std::string &n, BinaryTraceCodec::ColumnType t);
+        void                                        addInteger(std::int64_t v);                                 //!< Add the value of the next column of the current row
+        void                                        addReal(double v);
+        void                                        addString(const std::string &v);
+        void                                        clear(void);                                                //!< Remove all columns and rows
+        void                                        endRow(std::ostream &o);                                    //!< Finish the current row and write a block if it is full
+        void                                        flush(std::ostream &o);                                     //!< Write the rows that are not written yet
+        size_t                                      getNumberOfColumns(void) const;
+        void                                        writeHeader(std::ostream &o, const std::vector<std::string> &comments) const;
+
+    private:
+
+        struct Column {
+            std::string                             name;
+            BinaryTraceCodec::ColumnType            type;
+            std::vector<std::int64_t>               integers;
+            std::vector<double>                     reals;
+            std::vector<std::string>                strings;
+        };
+
+        Column&                                     nextColumn(BinaryTraceCodec::ColumnType t);
+
+        std::vector<Column>                         columns;
+        size_t                                      current_column;
+        size_t                                      num_rows;                                                   //!< The number of complete rows that are not written yet
+        size_t                                      rows_per_block;
+    };
+
+}
+
+#endif
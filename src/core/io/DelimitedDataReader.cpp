@@ -11,13 +11,16 @@
 
 using namespace RevBayesCore;
 
-DelimitedDataReader::DelimitedDataReader(const path &fn, std::string d, size_t lines_skipped) :
+DelimitedDataReader::DelimitedDataReader(const path &fn, std::string d, size_t lines_skipped, bool read) :
     filename(fn), 
     delimiter(d),
     chars()
 {
 
-    readData( lines_skipped );
+    if ( read == true )
+    {
+        readData( lines_skipped );
+    }
     
 }
 
@@ -0,0 +1,311 @@
+#include "TraceTable.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <utility>
+
+#include "BinaryTraceReader.h"
+#include "RbException.h"
+#include "StringUtilities.h"
+#include "TraceNumeric.h"
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    /**
+     * Parse the field [begin,end) like atof, i.e., a field that does not start with a number is 0.
+     */
+    double parseValue(const char *begin, const char *end)
+    {
+
+        char *parsed_end = NULL;
+        double d = strtod( begin, &parsed_end );
+
+        if ( parsed_end == begin )
+        {
+            return 0.0;
+        }
+        else if ( parsed_end > end )
+        {
+            // the number continued into the delimiter, so we parse the field on its own
+            return atof( std::string( begin, end ).c_str() );
+        }
+
+        return d;
+    }
+
+}
+
+
+TraceTable::TraceTable( void )
+{
+
+}
+
+
+void TraceTable::addColumn(const std::string &n, std::vector<double> &&v)
+{
+
+    if ( columns.empty() == false && columns[0].size() != v.size() )
+    {
+        throw RbException()<<"Cannot add column '"<<n<<"' with "<<v.size()<<" values to a trace table with "<<columns[0].size()<<" rows.";
+    }
+
+    column_names.push_back( n );
+    columns.push_back( std::move(v) );
+}
+
+
+void TraceTable::clear( void )
+{
+
+    column_names.clear();
+    columns.clear();
+    file_name = path();
+}
+
+
+const std::vector<double>& TraceTable::getColumn(size_t j) const
+{
+
+    if ( j >= columns.size() )
+    {
+        throw RbException()<<"Cannot access column "<<(j+1)<<" of a trace table with "<<columns.size()<<" columns.";
+    }
+
+    return columns[j];
+}
+
+
+const std::vector<std::string>& TraceTable::getColumnNames( void ) const
+{
+
+    return column_names;
+}
+
+
+const path& TraceTable::getFileName( void ) const
+{
+
+    return file_name;
+}
+
+
+size_t TraceTable::getNumberOfColumns( void ) const
+{
+
+    return columns.size();
+}
+
+
+size_t TraceTable::getNumberOfRows( void ) const
+{
+
+    return columns.empty() ? 0 : columns[0].size();
+}
+
+
+/**
+ * Move the columns [first_column,num_columns) into new traces that are appended to the vector.
+ * The values are not copied. Afterwards, the table is empty.
+ */
+void TraceTable::moveToTraces(std::vector<TraceNumeric> &traces, size_t first_column)
+{
+
+    traces.reserve( traces.size() + (columns.size() > first_column ? columns.size() - first_column : 0) );
+
+    for (size_t j=first_column; j<columns.size(); ++j)
+    {
+        traces.push_back( TraceNumeric() );
+
+        TraceNumeric& t = traces.back();
+        t.setParameterName( column_names[j] );
+        t.setFileName( file_name );
+        t.setValues( std::move(columns[j]) );
+    }
+
+    clear();
+}
+
+
+/**
+ * Read the file into the table, replacing the current columns.
+ *
+ * \param[in]     fn          The name of the file.
+ * \param[in]     delim       The delimiter between the columns of a text file (empty for any whitespace).
+ * \param[in]     thinning    Only keep every thinning-th row.
+ */
+void TraceTable::readFile(const path &fn, const std::string &delim, size_t thinning)
+{
+
+    clear();
+    file_name = fn;
+
+    if ( thinning == 0 )
+    {
+        thinning = 1;
+    }
+
+    if ( BinaryTraceReader::isBinaryTraceFile( fn ) == true )
+    {
+        readBinaryFile( thinning );
+    }
+    else
+    {
+        readTextFile( delim, thinning );
+    }
+
+}
+
+
+void TraceTable::readBinaryFile(size_t thinning)
+{
+
+    BinaryTraceReader reader( file_name );
+
+    for (size_t j=0; j<reader.getNumberOfColumns(); ++j)
+    {
+        std::vector<double> values = reader.getNumbers(j);
+
+        if ( thinning > 1 )
+        {
+            size_t k = 0;
+            for (size_t i=0; i<values.size(); i+=thinning)
+            {
+                values[k++] = values[i];
+            }
+            values.resize( k );
+            values.shrink_to_fit();
+        }
+
+        addColumn( reader.getColumnNames()[j], std::move(values) );
+    }
+
+}
+
+
+/**
+ * Read a delimited text file. Each line is split in place and its fields are parsed directly into the columns,
+ * so that no strings are kept for the values.
+ * The delimiter has the same meaning as for StringUtilities::stringSplit.
+ */
+void TraceTable::readTextFile(const std::string &delim, size_t thinning)
+{
+
+    std::ifstream in_stream( file_name.string() );
+    if ( not in_stream )
+    {
+        throw RbException()<<"Could not open file "<<file_name;
+    }
+
+    bool has_header_been_read = false;
+    bool is_incomplete = false;
+    size_t incomplete_line = 0;
+    size_t line_number = 0;
+    size_t num_samples = 0;
+    std::string line;
+
+    while ( safeGetline( in_stream, line ) )
+    {
+        ++line_number;
+
+        // skip empty lines and comments
+        size_t first_nonspace = line.find_first_not_of( " \t\r\n" );
+        if ( first_nonspace == std::string::npos || line[0] == '#' )
+        {
+            continue;
+        }
+
+        // we assume a header at the first line of the file
+        if ( has_header_been_read == false )
+        {
+            std::vector<std::string> names;
+            StringUtilities::stringSplit( line, delim, names, true );
+
+            column_names = names;
+            columns.resize( names.size() );
+            has_header_been_read = true;
+
+            continue;
+        }
+
+        // only the last line may be incomplete
+        if ( is_incomplete == true )
+        {
+            throw RbException()<<"Line "<<incomplete_line<<" of file "<<file_name<<" has fewer values than the "<<columns.size()<<" columns of the header.";
+        }
+
+        // increase our sample counter
+        ++num_samples;
+
+        // we need to check if we skip this sample in case of thinning
+        if ( (num_samples-1) % thinning > 0 )
+        {
+            continue;
+        }
+
+        // split the line in place and add the values to the columns
+        const char* pos = line.c_str();
+        const char* line_end = pos + line.size();
+        size_t num_fields = 0;
+        while ( true )
+        {
+            const char* field_end = NULL;
+            if ( delim.empty() == true )
+            {
+                while ( pos < line_end && isspace( (unsigned char)*pos ) )
+                {
+                    ++pos;
+                }
+                if ( pos == line_end )
+                {
+                    break;
+                }
+
+                field_end = pos;
+                while ( field_end < line_end && isspace( (unsigned char)*field_end ) == false )
+                {
+                    ++field_end;
+                }
+            }
+            else
+            {
+                field_end = std::search( pos, line_end, delim.begin(), delim.end() );
+            }
+
+            if ( num_fields == columns.size() )
+            {
+                throw RbException()<<"Line "<<line_number<<" of file "<<file_name<<" has more values than the "<<columns.size()<<" columns of the header.";
+            }
+            columns[num_fields].push_back( parseValue( pos, field_end ) );
+            ++num_fields;
+
+            if ( field_end == line_end )
+            {
+                break;
+            }
+            pos = field_end + (delim.empty() ? 0 : delim.size());
+        }
+
+        if ( num_fields < columns.size() )
+        {
+            // remove the values of this line again
+            for (size_t j=0; j<num_fields; ++j)
+            {
+                columns[j].pop_back();
+            }
+            is_incomplete = true;
+            incomplete_line = line_number;
+        }
+    }
+
+    for (size_t j=0; j<columns.size(); ++j)
+    {
+        columns[j].shrink_to_fit();
+    }
+
+}
@@ -0,0 +1,53 @@
+#ifndef TraceTable_H
+#define TraceTable_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "RbFileManager.h"
+
+namespace RevBayesCore {
+
+    class TraceNumeric;
+
+    /**
+     * @brief Column store of the numeric traces of one file.
+     *
+     * The values of every column are kept in one contiguous vector, so that reading a trace with thousands
+     * of columns (e.g., the rates of every branch) does not keep a string for every cell, as the
+     * DelimitedDataReader does. Text files are split in place and the values are parsed directly into their columns.
+     * Binary trace files are read column by column.
+     *
+     * The columns can be moved into TraceNumeric objects without copying the values.
+     * As for the other trace readers, empty lines and lines starting with '#' are skipped, and the first line is the header.
+     * An incomplete last line (e.g., of a run that is still writing) is ignored.
+     */
+    class TraceTable {
+
+    public:
+        TraceTable(void);
+
+        void                                        addColumn(const std::string &n, std::vector<double> &&v);   //!< Append a column with the given values
+        void                                        clear(void);
+        const std::vector<double>&                  getColumn(size_t j) const;
+        const std::vector<std::string>&             getColumnNames(void) const;
+        const path&                                 getFileName(void) const;
+        size_t                                      getNumberOfColumns(void) const;
+        size_t                                      getNumberOfRows(void) const;
+        void                                        moveToTraces(std::vector<TraceNumeric> &traces, size_t first_column = 0);  //!< Append the columns from first_column on as traces (the table is empty afterwards)
+        void                                        readFile(const path &fn, const std::string &delim = "", size_t thinning = 1); //!< Read a text or binary trace file, keeping every thinning-th row
+
+    private:
+
+        void                                        readBinaryFile(size_t thinning);
+        void                                        readTextFile(const std::string &delim, size_t thinning);
+
+        std::vector<std::string>                    column_names;
+        std::vector<std::vector<double> >           columns;
+        path                                        file_name;
+    };
+
+}
+
+#endif
@@ -6,6 +6,9 @@
 
 using namespace RevBayesCore;
 
+thread_local RandomNumberGenerator* RandomNumberFactory::thread_generator = NULL;
+
+
 /** Default constructor */
 RandomNumberFactory::RandomNumberFactory(void)
 {
@@ -28,3 +31,34 @@ void RandomNumberFactory::deleteRandomNumberGenerator(RandomNumberGenerator* r)
     
     delete r;
 }
+
+
+/** Get the random number object that is used on the current thread instead of the global one */
+RandomNumberGenerator* RandomNumberFactory::getThreadRandomNumberGenerator( void )
+{
+    
+    return thread_generator;
+}
+
+
+/** Use the given random number object instead of the global one on the current thread (NULL resets to the global one) */
+void RandomNumberFactory::setThreadRandomNumberGenerator(RandomNumberGenerator* r)
+{
+    
+    thread_generator = r;
+}
+
+
+RandomNumberStreamScope::RandomNumberStreamScope(RandomNumberGenerator* r) :
+    previous_generator( RandomNumberFactory::getThreadRandomNumberGenerator() )
+{
+    
+    RandomNumberFactory::setThreadRandomNumberGenerator( r );
+}
+
+
+RandomNumberStreamScope::~RandomNumberStreamScope( void )
+{
+    
+    RandomNumberFactory::setThreadRandomNumberGenerator( previous_generator );
+}
@@ -3,6 +3,7 @@
 #ifndef RandomNumberFactory_H
 #define RandomNumberFactory_H
 
+#include <cstddef>
 #include <set>
 
 namespace RevBayesCore {
@@ -20,6 +21,13 @@ namespace RevBayesCore {
      * class has two seeds it manages: one is a global seed and the other is
      * is a so called local seed.
      *
+     * Code that runs on several threads (e.g. the chains of an MCMCMC) can install
+     * its own random number object for the current thread. GLOBAL_RNG then returns
+     * this object on that thread, so that the threads neither share nor race on the
+     * global random number object. Usually these objects are independent streams split
+     * from the global one (see RandomNumberGenerator::split) and are installed with a
+     * RandomNumberStreamScope.
+     *
      */
     class RandomNumberFactory {
 
@@ -30,7 +38,9 @@ namespace RevBayesCore {
                                                         return singleRandomNumberFactory;
                                                     }
 		void                                        deleteRandomNumberGenerator(RandomNumberGenerator* r);                                 //!< Return a random number object to the pool
-		RandomNumberGenerator*                      getGlobalRandomNumberGenerator(void) { return seedGenerator; }                         //!< Return a pointer to the global random number object
+		RandomNumberGenerator*                      getGlobalRandomNumberGenerator(void) { return thread_generator != NULL ? thread_generator : seedGenerator; }    //!< Return a pointer to the global random number object (or the one set for the current thread)
+        static RandomNumberGenerator*               getThreadRandomNumberGenerator(void);                                                  //!< Return the random number object of the current thread (NULL if the global one is used)
+        static void                                 setThreadRandomNumberGenerator(RandomNumberGenerator* r);                             //!< Use r instead of the global random number object on the current thread (NULL to reset)
 
 	private:
                                                     RandomNumberFactory(void);                                                             //!< Default constructor
@@ -39,6 +49,28 @@ namespace RevBayesCore {
                                                    ~RandomNumberFactory(void);                                                             //!< Destructor
 		RandomNumberGenerator*                      seedGenerator;                                                                         //!< A random number object that generates seeds
 		std::set<RandomNumberGenerator*>            allocatedRandomNumbers;                                                                //!< The pool of random number objects
+        static thread_local RandomNumberGenerator*  thread_generator;                                                                      //!< The random number object of the current thread, if any
+    };
+    
+    
+    /**
+     * @brief Install a random number object as the current one of this thread for the lifetime of the scope.
+     *
+     * Moves, proposals, distributions etc. draw from GLOBAL_RNG, so they automatically use the stream of
+     * the chain, stone or replicate that is currently executed on this thread.
+     * The previous random number object of the thread is restored when the scope ends (also if an exception is thrown).
+     */
+    class RandomNumberStreamScope {
+        
+    public:
+                                                    RandomNumberStreamScope(RandomNumberGenerator* r);                                      //!< Use r on this thread
+                                                   ~RandomNumberStreamScope(void);                                                          //!< Restore the previous random number object of this thread
+        
+    private:
+                                                    RandomNumberStreamScope(const RandomNumberStreamScope&);                                //!< Prevent copy
+                                                    RandomNumberStreamScope& operator=(const RandomNumberStreamScope&);                     //!< Prevent assignment
+        
+        RandomNumberGenerator*                      previous_generator;
     };
 }
 
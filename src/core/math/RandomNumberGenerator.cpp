@@ -11,7 +11,12 @@ using namespace RevBayesCore;
 
 /** Default constructor calling time to get the initial seeds */
 RandomNumberGenerator::RandomNumberGenerator(void) :
-        zeroone( boost::mt19937() )
+        zeroone( boost::mt19937() ),
+        counter_based( false ),
+        stream_key( 0 ),
+        stream_index( 0 ),
+        block_counter( 0 ),
+        block_position( 4 )
 {
     
     seed = getNewSeed();
@@ -24,6 +29,27 @@ RandomNumberGenerator::RandomNumberGenerator(void) :
 }
 
 
+/**
+ * Constructor of a counter-based stream.
+ * All streams with the same key but different indices are independent.
+ *
+ * \param[in]    k    The key, e.g. drawn from another generator with getNewStreamKey().
+ * \param[in]    s    The index of the stream.
+ */
+RandomNumberGenerator::RandomNumberGenerator(std::uint64_t k, std::uint64_t s) :
+        last_u( 0.0 ),
+        zeroone( boost::mt19937() ),
+        seed( (unsigned int)(k % RbConstants::Integer::max) ),
+        counter_based( true ),
+        stream_key( k ),
+        stream_index( s ),
+        block_counter( 0 ),
+        block_position( 4 )
+{
+    
+}
+
+
 /* Get the seed values */
 unsigned int RandomNumberGenerator::getNewSeed( void ) const
 {
@@ -40,6 +66,21 @@ unsigned int RandomNumberGenerator::getNewSeed( void ) const
 }
 
 
+/**
+ * Draw a 64-bit key for new streams.
+ * The key is drawn from this generator, so repeated calls give different keys
+ * and the keys are reproducible if the seed of this generator is set.
+ */
+std::uint64_t RandomNumberGenerator::getNewStreamKey( void )
+{
+    
+    std::uint64_t hi = std::uint64_t( uniform01() * 4294967296.0 );
+    std::uint64_t lo = std::uint64_t( uniform01() * 4294967296.0 );
+    
+    return (hi << 32) | lo;
+}
+
+
 /* Get the seed values */
 unsigned int RandomNumberGenerator::getSeed( void ) const
 {
@@ -47,10 +88,95 @@ unsigned int RandomNumberGenerator::getSeed( void ) const
 }
 
 
+/* Get the index of the stream */
+std::uint64_t RandomNumberGenerator::getStreamIndex( void ) const
+{
+    return stream_index;
+}
+
+
+bool RandomNumberGenerator::isCounterBased( void ) const
+{
+    return counter_based;
+}
+
+
+/**
+ * Compute the next block of four 32-bit integers with the Philox4x32-10 bijection
+ * (Salmon et al. 2011, Parallel random numbers: as easy as 1, 2, 3).
+ * The 128-bit counter consists of the block counter (low 64 bits) and the stream index (high 64 bits).
+ */
+void RandomNumberGenerator::nextPhiloxBlock( void )
+{
+    
+    const std::uint32_t M0 = 0xD2511F53;
+    const std::uint32_t M1 = 0xCD9E8D57;
+    const std::uint32_t W0 = 0x9E3779B9;
+    const std::uint32_t W1 = 0xBB67AE85;
+    
+    std::uint32_t c0 = std::uint32_t( block_counter );
+    std::uint32_t c1 = std::uint32_t( block_counter >> 32 );
+    std::uint32_t c2 = std::uint32_t( stream_index );
+    std::uint32_t c3 = std::uint32_t( stream_index >> 32 );
+    std::uint32_t k0 = std::uint32_t( stream_key );
+    std::uint32_t k1 = std::uint32_t( stream_key >> 32 );
+    
+    for (size_t round = 0; round < 10; ++round)
+    {
+        std::uint64_t p0 = std::uint64_t(M0) * c0;
+        std::uint64_t p1 = std::uint64_t(M1) * c2;
+        
+        std::uint32_t hi0 = std::uint32_t( p0 >> 32 );
+        std::uint32_t lo0 = std::uint32_t( p0 );
+        std::uint32_t hi1 = std::uint32_t( p1 >> 32 );
+        std::uint32_t lo1 = std::uint32_t( p1 );
+        
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        
+        k0 += W0;
+        k1 += W1;
+    }
+    
+    block[0] = c0;
+    block[1] = c1;
+    block[2] = c2;
+    block[3] = c3;
+    
+    ++block_counter;
+    block_position = 0;
+    
+}
+
+
+std::uint32_t RandomNumberGenerator::nextPhiloxInteger( void )
+{
+    
+    if ( block_position == 4 )
+    {
+        nextPhiloxBlock();
+    }
+    
+    return block[block_position++];
+}
+
+
 /** Set the seed of the random number generator */
 void RandomNumberGenerator::setSeed(unsigned int s)
 {
 
+    if ( counter_based == true )
+    {
+        // restart the stream with the new key
+        seed            = s % RbConstants::Integer::max;
+        stream_key      = seed;
+        block_counter   = 0;
+        block_position  = 4;
+        return;
+    }
+    
     boost::mt19937 rng;
     seed = s % RbConstants::Integer::max; //see constructor for explanation of this
     rng.seed( seed );
@@ -59,6 +185,25 @@ void RandomNumberGenerator::setSeed(unsigned int s)
 }
 
 
+/**
+ * Create n new independent streams. They share one key drawn from this generator and have the indices 0,...,n-1.
+ * The caller owns the new generators.
+ */
+std::vector<RandomNumberGenerator*> RandomNumberGenerator::split(size_t n)
+{
+    
+    std::uint64_t key = getNewStreamKey();
+    
+    std::vector<RandomNumberGenerator*> streams( n, NULL );
+    for (size_t i = 0; i < n; ++i)
+    {
+        streams[i] = new RandomNumberGenerator( key, i );
+    }
+    
+    return streams;
+}
+
+
 /*!
  *
  * \brief Uniform[0,1) random variable.
@@ -67,6 +212,16 @@ void RandomNumberGenerator::setSeed(unsigned int s)
  */
 double RandomNumberGenerator::uniform01(void)
 {
+    if ( counter_based == true )
+    {
+        // use 53 random bits for the mantissa
+        std::uint64_t a = nextPhiloxInteger() >> 5;
+        std::uint64_t b = nextPhiloxInteger() >> 6;
+        last_u = (a * 67108864.0 + b) * (1.0 / 9007199254740992.0);
+        
+        return last_u;
+    }
+    
     last_u = zeroone();
 
 	// Returns a pseudo-random number between 0 and 1.
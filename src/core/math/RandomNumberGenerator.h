@@ -3,26 +3,56 @@
 
 #include <boost/random/uniform_01.hpp>
 #include <boost/random/mersenne_twister.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace RevBayesCore {
 
+    /**
+     * @brief Random number generator.
+     *
+     * A generator is either a Mersenne twister (the global generator and the default constructor)
+     * or one stream of a counter-based Philox4x32-10 generator.
+     * A Philox stream is identified by a 64-bit key and a 64-bit stream index.
+     * The i-th number of a stream is computed directly from (key, stream, i), so streams with
+     * different indices never overlap and do not depend on each other or on the order in which they are used.
+     * Hence, a generator can be split into independent streams, e.g. one per chain, stone or replicate,
+     * which can then be used concurrently on several threads (see RandomNumberFactory).
+     */
     class RandomNumberGenerator {
 
     public:
 
                                                     RandomNumberGenerator(void);                            //!< Default constructor using time seed
+                                                    RandomNumberGenerator(std::uint64_t k, std::uint64_t s);    //!< Constructor of the s-th counter-based stream for key k
                                             
         // Regular functions
         unsigned int                                getNewSeed(void) const;                                 //!< Get the new seed values
+        std::uint64_t                               getNewStreamKey(void);                                  //!< Draw a key for new streams from this generator
         unsigned int                                getSeed(void) const;                                    //!< Get the seed values
+        std::uint64_t                               getStreamIndex(void) const;                             //!< Get the index of the stream (0 for the Mersenne twister)
+        bool                                        isCounterBased(void) const;                             //!< Is this generator a counter-based stream?
         void                                        setSeed(unsigned int s);                                //!< Set the seeds of the RNG
+        std::vector<RandomNumberGenerator*>         split(size_t n);                                        //!< Create n new independent streams (the caller owns them)
         double                                      uniform01(void);                                        //!< Get a random [0,1) var
 
     private:
         
+        void                                        nextPhiloxBlock(void);                                  //!< Compute the next four random 32-bit integers of the stream
+        std::uint32_t                               nextPhiloxInteger(void);                                //!< Get the next random 32-bit integer of the stream
+        
         double                                      last_u;
         boost::uniform_01<boost::mt19937>           zeroone;
         unsigned int seed;
+        
+        // the counter-based stream
+        bool                                        counter_based;
+        std::uint64_t                               stream_key;
+        std::uint64_t                               stream_index;
+        std::uint64_t                               block_counter;
+        std::uint32_t                               block[4];
+        size_t                                      block_position;
 
     };
 }
@@ -2,6 +2,7 @@
 
 #include <string>
 
+#include "RbException.h"
 #include "RbFileManager.h"
 #include "Cloneable.h"
 
@@ -15,6 +16,7 @@ AbstractFileMonitor::AbstractFileMonitor(DagNode *n, unsigned long g, const path
     filename( fname ),
     working_file_name( fname ),
     append(ap),
+    binary( false ),
     flatten( true ),
     write_version( wv )
 {}
@@ -25,6 +27,7 @@ AbstractFileMonitor::AbstractFileMonitor(const std::vector<DagNode *> &n, unsign
     filename( fname ),
     working_file_name( fname ),
     append(ap),
+    binary( false ),
     flatten( true ),
     write_version( wv )
 {}
@@ -36,6 +39,7 @@ AbstractFileMonitor::AbstractFileMonitor(const AbstractFileMonitor &f) : Monitor
     filename            = f.filename;
     working_file_name   = f.working_file_name;
     append              = f.append;
+    binary              = f.binary;
     flatten             = f.flatten;
     write_version       = f.write_version;
     
@@ -72,6 +76,26 @@ void AbstractFileMonitor::closeStream()
 }
 
 
+/**
+ * Wait until all output is written to the file.
+ * The output is written on the I/O thread, so this is where we find out whether writing failed.
+ */
+void AbstractFileMonitor::flushStream( void )
+{
+    if ( out_stream.is_open() == false )
+    {
+        return;
+    }
+
+    out_stream.waitUntilWritten();
+
+    if ( out_stream.bad() == true )
+    {
+        throw RbException()<<"Could not write the output of the monitor to file "<<working_file_name<<".";
+    }
+}
+
+
 bool AbstractFileMonitor::isFileMonitor( void ) const
 {
     return true;
@@ -81,17 +105,19 @@ bool AbstractFileMonitor::isFileMonitor( void ) const
 void AbstractFileMonitor::openStream( bool reopen )
 {
     createDirectoryForFile( working_file_name );
-            
+
+    std::ios_base::openmode mode = ( binary == true ? std::fstream::binary : std::ios_base::openmode() );
+
     // open the stream to the file
     if ( append == true || reopen == true )
     {
-        out_stream.open( working_file_name.string(), std::fstream::in | std::fstream::out | std::fstream::app);
+        out_stream.open( working_file_name.string(), std::fstream::in | std::fstream::out | std::fstream::app | mode);
     }
     else
     {
-        out_stream.open( working_file_name.string(), std::fstream::out);
+        out_stream.open( working_file_name.string(), std::fstream::out | mode);
         out_stream.close();
-        out_stream.open( working_file_name.string(), std::fstream::in | std::fstream::out);
+        out_stream.open( working_file_name.string(), std::fstream::in | std::fstream::out | mode);
     }
         
 }
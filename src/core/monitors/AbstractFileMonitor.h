@@ -3,6 +3,7 @@
 
 #include <fstream>
 #include <vector>
+#include "AsyncFileStream.h"
 #include "RbFileManager.h"
 
 #include "Monitor.h"
@@ -40,14 +41,16 @@ class DagNode;
 
         // functions you may want to overwrite
         virtual void                        closeStream(void);
+        virtual void                        flushStream(void);  //!< Wait until all output is in the file
     
     protected:
-        std::fstream                        out_stream;  //!< output file stream
+        AsyncFileStream                     out_stream;  //!< output file stream, which is written by the I/O thread of the AsyncFileWriter
         
         // parameters
         path                                filename;  //!< input name of the output file
         path                                working_file_name;  //!< actual output file name, including extension if applicable
         bool                                append;  //!< whether to append to an existing file
+        bool                                binary;  //!< whether the file is opened in binary mode (e.g., for binary traces)
         bool                                flatten;  //!< whether vectors should be flattened in the output (i.e each element treated as a separate variable)
         bool                                write_version;  //!< whether to write the version
         
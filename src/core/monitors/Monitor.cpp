@@ -194,6 +194,14 @@ void Monitor::closeStream( void )
 {}
 
 
+/**
+ * Write all output that is buffered by the monitor, e.g., before a checkpoint.
+ * Overwrite this method for specialized behavior.
+ */
+void Monitor::flushStream( void )
+{}
+
+
 /**
  * Combine output from different runs of the analysis.
  * Overwrite this method for specialized behavior.
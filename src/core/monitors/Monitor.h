@@ -41,6 +41,7 @@ namespace RevBayesCore {
         virtual void                                combineReplicates(size_t n, MonteCarloAnalysisOptions::TraceCombinationTypes);  //!< Combine results from several replicate analyses
         virtual void                                disable(void);  //!< Disable this monitor
         virtual void                                enable(void);  //!< Enable this monitor
+        virtual void                                flushStream(void);  //!< Write all buffered output
         virtual bool                                isEnabled(void) const;  //!< Is the monitor currently enabled?
         virtual bool                                isScreenMonitor(void) const;  //!< Is this a screen monitor?
         virtual bool                                isFileMonitor(void) const;  //!< Is this a file monitor?
@@ -1,536 +1,970 @@
-#include "VariableMonitor.h"
-
-#include <fstream>
-#include <string>
-
-#include "DagNode.h"
-#include "Model.h"
-#include "RbException.h"
-#include "RbFileManager.h"
-#include "RbSettings.h"
-#include "RbVersion.h"
-#include "Cloneable.h"
-#include "StringUtilities.h"
-
-using namespace RevBayesCore;
-
-/* Constructor */
-VariableMonitor::VariableMonitor(DagNode *n, unsigned long g, const path &fname,
-                                 const SampleFormat& f, bool pp, bool l, bool pr, bool ap, bool wv) :
-    AbstractFileMonitor(n,g,fname,ap,wv),
-    posterior( pp ),
-    prior( pr ),
-    likelihood( l ),
-    format( f )
-{
-    
-}
-
-
-/* Constructor */
-VariableMonitor::VariableMonitor(const std::vector<DagNode *> &n, unsigned long g, const path &fname, const SampleFormat &f,
-                                 bool pp, bool l, bool pr, bool ap, bool wv) :
-    AbstractFileMonitor(n,g,fname,ap,wv),
-    posterior( pp ),
-    prior( pr ),
-    likelihood( l ),
-    format( f )
-{
-
-}
-
-
-/* Clone the object */
-VariableMonitor* VariableMonitor::clone(void) const
-{
-    return new VariableMonitor(*this);
-}
-
-/**
- * Print header for monitored values
- */
-void VariableMonitor::printHeader( void )
-{
-    if (not enabled) return;
-    
-    if (to<JSONFormat>(format))
-    {
-	std::vector<json> fields;
-	// print one column for the iteration number
-	fields.push_back("Iteration");
-
-	if ( posterior ) fields.push_back("Posterior");
-
-	if ( likelihood ) fields.push_back("Likelihood");
-
-	if ( prior ) fields.push_back("Prior");
-
-	json header;
-	header["fields"] = fields;
-	header["format"] = "MCON";
-	header["version"] = "0.1";
-	header["nested"] = true;
-	header["atomic"] = false;
-    
-	if ( write_version == true )
-	{
-	    RbVersion version;
-
-	    json rb;
-	    rb["version"] = version.getVersion();
-	    rb["branch"] = version.getGitBranch();
-	    rb["commit"] = version.getGitCommit();
-	    rb["builddate"] = version.getDate();
-	    // build date?
-	    header["RevBayes"] = rb;
-	}
-
-	out_stream.seekg(0, std::ios::end);
-	out_stream<<header<<std::endl;
-    }
-    else if (auto f = to<SeparatorFormat>(format))
-    {
-	auto& separator = f->separator;
-	out_stream.seekg(0, std::ios::end);
-
-	if ( write_version == true )
-	{
-	    RbVersion version;
-	    out_stream << "#RevBayes version (" + version.getVersion() + ")\n";
-	    out_stream << "#Build from " + version.getGitBranch() + " (" + version.getGitCommit() + ") on " + version.getDate() + "\n";
-	}
-
-	// print one column for the iteration number
-	out_stream << "Iteration";
-
-	if ( posterior == true )
-	{
-	    // add a separator before every new element
-	    out_stream << separator << "Posterior";
-	}
-
-	if ( likelihood == true )
-	{
-	    // add a separator before every new element
-	    out_stream << separator << "Likelihood";
-	}
-
-	if ( prior == true )
-	{
-	    // add a separator before every new element
-	    out_stream << separator << "Prior";
-	}
-
-	// print the headers for the variables
-	printFileHeader();
-
-	out_stream << std::endl;
-    }
-
-    out_stream.flush();
-}
-
-/**
- * Monitor
- */
-void VariableMonitor::monitor(unsigned long gen)
-{
-    if ( not enabled or gen % printgen != 0 ) return;
-
-    out_stream.seekg(0, std::ios::end);
-
-    if (to<SeparatorFormat>(format))
-    {
-        // print the iteration number "first", before we change the precision?
-        out_stream << gen;
-    }
-
-    std::streamsize previousPrecision = out_stream.precision();
-    std::ios_base::fmtflags previousFlags = out_stream.flags();
-    out_stream.precision(RbSettings::userSettings().getOutputPrecision());
-
-    double Posterior = 0;
-    double Likelihood = 0;
-    double Prior = 0;
-    if (posterior or likelihood or prior)
-    {
-	for (auto& node: model->getDagNodes())
-	{
-	    double Pr = node->getLnProbability();
-	    Posterior += Pr;
-	    if (node->isClamped())
-		Likelihood += Pr;
-	    else
-		Prior += Pr;
-	}
-    }
-        
-
-    if (to<JSONFormat>(format))
-    {
-	json line;
-
-	line["Iteration"] = gen;
-        
-	if (Posterior) line["Posterior"] = Posterior;
-	if (Likelihood) line["Likelihood"] = Likelihood;
-	if (Prior) line["Prior"] = Prior;
-
-	for (auto& node: nodes)
-	{
-	    auto name = node->getName();
-	    if (name.empty())
-		name = std::to_string((uintptr_t)node);
-	    line[name] = node->getValueAsJSON();
-	}
-
-	out_stream << line << "\n";
-    }
-    else
-    {
-	auto& separator = to<SeparatorFormat>(format)->separator;
-
-        if ( posterior == true )
-        {
-            // add a separator before every new element
-            out_stream << separator << Posterior;
-        }
-
-        if ( likelihood == true )
-        {
-            // add a separator before every new element
-            out_stream << separator << Likelihood;
-        }
-
-        if ( prior == true )
-        {
-            // add a separator before every new element
-            out_stream << separator << Prior;
-        }
-        
-        monitorVariables( gen );
-
-        out_stream << std::endl;
-    }
-
-    out_stream.setf(previousFlags);
-    out_stream.precision(previousPrecision);
-    out_stream.flush();
-}
-
-/**
- * Print additional header for monitored values
- */
-void VariableMonitor::printFileHeader( void )
-{
-    auto& separator = to<SeparatorFormat>(format)->separator;
-
-    for (std::vector<DagNode *>::const_iterator it=nodes.begin(); it!=nodes.end(); ++it)
-    {
-        // add a separator before every new element
-        out_stream << separator;
-
-        const DagNode* the_node = *it;
-
-        // print the header
-        if (the_node->getName() != "")
-        {
-            the_node->printName(out_stream,separator, -1, true, flatten);
-        }
-        else
-        {
-            out_stream << "Unnamed";
-        }
-
-    }
-
-}
-
-/**
- * Monitor value at generation gen
- */
-void VariableMonitor::monitorVariables(unsigned long gen)
-{
-    auto& separator = to<SeparatorFormat>(format)->separator;
-
-    for (std::vector<DagNode*>::iterator i = nodes.begin(); i != nodes.end(); ++i)
-    {
-        // add a separator before every new element
-        out_stream << separator;
-
-        // get the node
-        DagNode *node = *i;
-
-        // print the value
-        node->printValue(out_stream, separator, -1, false, false, true, flatten);
-    }
-
-}
-
-/**
- * Combine output for the monitor.
- * Overwrite this method for specialized behavior.
- */
-void VariableMonitor::combineReplicates( size_t n_reps, MonteCarloAnalysisOptions::TraceCombinationTypes tc )
-{
-    if ( enabled == true and to<SeparatorFormat>(format))
-    {
-
-	auto & separator = to<SeparatorFormat>(format)->separator;
-
-        std::fstream combined_output_stream;
-
-        int sample_number = 0;
-
-        // open the stream to the file
-        combined_output_stream.open( filename.string(), std::fstream::out);
-        combined_output_stream.close();
-        combined_output_stream.open( filename.string(), std::fstream::in | std::fstream::out);
-
-        if ( tc == MonteCarloAnalysisOptions::SEQUENTIAL )
-        {
-            for (size_t i=0; i<n_reps; ++i)
-            {
-                std::stringstream ss;
-                ss << "_run_" << (i+1);
-                std::string s = ss.str();
-                path current_file_name = appendToStem(filename, s);
-
-                std::ifstream current_input_stream( current_file_name.string() );
-
-                if ( not current_input_stream )
-                {
-                    throw RbException()<<"Could not open file "<<current_file_name<<".";
-                }
-
-                std::string read_line = "";
-                size_t lines_skipped = 0;
-                size_t lines_to_skip = ( write_version == true ? 3 : 1 );
-                while (std::getline(current_input_stream,read_line))
-                {
-                    ++lines_skipped;
-                    if ( lines_skipped < lines_to_skip)
-                    {
-                        if ( i == 0 )
-                        {
-                            // write output
-                            combined_output_stream << read_line;
-
-                            // add a new line
-                            combined_output_stream << std::endl;
-                        }
-                        continue;
-                    }
-                    else if ( lines_skipped == lines_to_skip )
-                    {
-
-                        if ( i == 0 )
-                        {
-                            std::vector<std::string> fields;
-                            StringUtilities::stringSplit(read_line, separator, fields);
-
-                            // write output
-                            combined_output_stream << fields[0];
-
-                            // add a separator before every new element
-                            combined_output_stream << separator;
-                            combined_output_stream << "Replicate_ID";
-
-                            for (size_t j=1; j<fields.size(); ++j)
-                            {
-                                // add a separator before every new element
-                                combined_output_stream << separator;
-
-                                // write output
-                                combined_output_stream << fields[j];
-                            }
-
-                            // add a new line
-                            combined_output_stream << std::endl;
-                        }
-                        continue;
-
-                    }
-
-                    std::vector<std::string> fields;
-                    StringUtilities::stringSplit(read_line, separator, fields);
-
-                    // add the current sample number
-                    combined_output_stream << sample_number;
-
-                    // add a separator before every new element
-                    combined_output_stream << separator;
-                    combined_output_stream << i;
-
-                    ++sample_number;
-                    for (size_t j=1; j<fields.size(); ++j)
-                    {
-                        // add a separator before every new element
-                        combined_output_stream << separator;
-
-                        // write output
-                        combined_output_stream << fields[j];
-                    }
-                    // add a new line
-                    combined_output_stream << std::endl;
-
-                }
-
-                current_input_stream.close();
-
-            }
-
-        }
-        else if ( tc == MonteCarloAnalysisOptions::MIXED )
-        {
-            std::vector< std::ifstream* > input_streams;
-
-            for (size_t i=0; i<n_reps; ++i)
-            {
-                std::stringstream ss;
-                ss << "_run_" << (i+1);
-                std::string s = ss.str();
-
-                path current_file_name = appendToStem(filename, s);
-
-                std::ifstream * current_input_stream = new std::ifstream( current_file_name.string() );
-
-                if ( not *current_input_stream )
-                {
-                    throw RbException()<<"Could not open file "<<current_file_name<<".";
-                }
-
-                input_streams.push_back( current_input_stream );
-            }
-
-            std::vector<std::string> read_lines(n_reps,"");
-            size_t lines_skipped = 0;
-            size_t lines_to_skip = ( write_version == true ? 3 : 1 );
-            while ( std::getline(*input_streams[0],read_lines[0]) )
-            {
-                for (size_t i=1; i<n_reps; ++i)
-                {
-                    if ( !(std::getline(*input_streams[i],read_lines[i])) )
-                    {
-                        throw RbException("Cannot merge output trace files with unequal number of lines.");
-                    }
-                }
-
-                ++lines_skipped;
-                if ( lines_skipped < lines_to_skip)
-                {
-                    // write output
-                    combined_output_stream << read_lines[0];
-
-                    // add a new line
-                    combined_output_stream << std::endl;
-                    continue;
-                }
-                else if ( lines_skipped == lines_to_skip )
-                {
-                    std::vector<std::string> fields;
-                    StringUtilities::stringSplit(read_lines[0], separator, fields);
-
-                    // write output
-                    combined_output_stream << fields[0];
-
-                    // add a separator before every new element
-                    combined_output_stream << separator;
-                    combined_output_stream << "Replicate_ID";
-
-                    for (size_t j=1; j<fields.size(); ++j)
-                    {
-                        // add a separator before every new element
-                        combined_output_stream << separator;
-
-                        // write output
-                        combined_output_stream << fields[j];
-                    }
-
-                    // add a new line
-                    combined_output_stream << std::endl;
-                    continue;
-
-                }
-
-
-                for (size_t i=0; i<n_reps; ++i)
-                {
-                    std::vector<std::string> fields;
-                    StringUtilities::stringSplit(read_lines[i], separator, fields);
-
-                    // add the current sample number
-                    combined_output_stream << sample_number;
-
-                    // add a separator before every new element
-                    combined_output_stream << separator;
-                    combined_output_stream << i;
-
-                    ++sample_number;
-                    for (size_t j=1; j<fields.size(); ++j)
-                    {
-                        // add a separator before every new element
-                        combined_output_stream << separator;
-
-                        // write output
-                        combined_output_stream << fields[j];
-                    }
-
-                    // add a new line
-                    combined_output_stream << std::endl;
-
-                }
-
-            }
-
-            for (size_t i=0; i<n_reps; ++i)
-            {
-                input_streams[i]->close();
-                delete input_streams[i];
-            }
-
-        }
-
-        combined_output_stream.close();
-
-    }
-
-}
-
-/**
- * Set flag about whether to print the likelihood.
- *
- * \param[in]   tf   Flag if the likelihood should be printed.
- */
-void VariableMonitor::setPrintLikelihood(bool tf)
-{
-
-    likelihood = tf;
-
-}
-
-
-/**
- * Set flag about whether to print the posterior probability.
- *
- * \param[in]   tf   Flag if the posterior probability should be printed.
- */
-void VariableMonitor::setPrintPosterior(bool tf)
-{
-
-    posterior = tf;
-
-}
-
-
-/**
- * Set flag about whether to print the prior probability.
- *
- * \param[in]   tf   Flag if the prior probability should be printed.
- */
-void VariableMonitor::setPrintPrior(bool tf)
-{
-
-    prior = tf;
-
-}
+#include "VariableMonitor.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "BinaryTraceReader.h"
+#include "DagNode.h"
+#include "Model.h"
+#include "RbException.h"
+#include "RbFileManager.h"
+#include "RbSettings.h"
+#include "RbVersion.h"
+#include "Cloneable.h"
+#include "StringUtilities.h"
+#include "TraceContinuousReader.h"
+#include "TraceNumeric.h"
+
+using namespace RevBayesCore;
+
+/* Constructor */
+VariableMonitor::VariableMonitor(DagNode *n, unsigned long g, const path &fname,
+                                 const SampleFormat& f, bool pp, bool l, bool pr, bool ap, bool wv) :
+    AbstractFileMonitor(n,g,fname,ap,wv),
+    posterior( pp ),
+    prior( pr ),
+    likelihood( l ),
+    format( f )
+{
+    binary = ( to<BinaryFormat>(format) != nullptr );
+}
+
+
+/* Constructor */
+VariableMonitor::VariableMonitor(const std::vector<DagNode *> &n, unsigned long g, const path &fname, const SampleFormat &f,
+                                 bool pp, bool l, bool pr, bool ap, bool wv) :
+    AbstractFileMonitor(n,g,fname,ap,wv),
+    posterior( pp ),
+    prior( pr ),
+    likelihood( l ),
+    format( f )
+{
+    binary = ( to<BinaryFormat>(format) != nullptr );
+}
+
+
+VariableMonitor::~VariableMonitor( void )
+{
+    // the destructor of the base class cannot write the buffered samples of a binary trace
+    if ( out_stream.is_open() )
+    {
+        closeStream();
+    }
+}
+
+
+/**
+ * Add the current sample to the running statistics that a stopping rule observes.
+ * The statistics have the same columns as a reader of the file, i.e., all columns except the iteration.
+ * The values were collected by monitorVariables() while the sample was written, so that we extract them only once.
+ */
+void VariableMonitor::addSampleToOnlineTrace( void )
+{
+    if ( online_trace->state == OnlineTrace::FAILED ) return;
+
+    const std::vector<double> &sample = online_sample;
+
+    if ( online_sample_complete == false )
+    {
+        // a derived monitor wrote other columns, so the stopping rule has to read the file instead
+        online_trace->columns.clear();
+        online_trace->state = OnlineTrace::FAILED;
+        return;
+    }
+
+    if ( online_trace->state == OnlineTrace::WAITING )
+    {
+        online_trace->columns.clear();
+
+        // a resumed run continues the samples that are already in the file, so we read these once
+        if ( reopened == true && exists(working_file_name) == true && file_size(working_file_name) > 0 )
+        {
+            TraceContinuousReader reader = TraceContinuousReader( working_file_name );
+            std::vector<TraceNumeric> &data = reader.getTraces();
+
+            online_trace->columns.resize( data.size() );
+            for (size_t j = 0; j < data.size(); ++j)
+            {
+                for (double v: data[j].getValues())
+                {
+                    online_trace->columns[j].addValue( v );
+                }
+            }
+        }
+        else
+        {
+            online_trace->columns.resize( sample.size() );
+        }
+
+        online_trace->state = OnlineTrace::ACTIVE;
+    }
+
+    if ( sample.size() != online_trace->columns.size() )
+    {
+        // the number of columns changed, so the stopping rule has to read the file instead
+        online_trace->columns.clear();
+        online_trace->state = OnlineTrace::FAILED;
+        return;
+    }
+
+    for (size_t j = 0; j < sample.size(); ++j)
+    {
+        online_trace->columns[j].addValue( sample[j] );
+    }
+}
+
+
+/* Clone the object */
+VariableMonitor* VariableMonitor::clone(void) const
+{
+    return new VariableMonitor(*this);
+}
+
+/**
+ * Close the stream. The samples of a binary trace that are not written yet are written first.
+ */
+void VariableMonitor::closeStream( void )
+{
+    if ( to<BinaryFormat>(format) and out_stream.is_open() )
+    {
+        out_stream.seekg(0, std::ios::end);
+        binary_writer.flush( out_stream );
+    }
+
+    AbstractFileMonitor::closeStream();
+}
+
+
+/**
+ * Write all samples, including those of a binary trace that do not fill a block yet.
+ */
+void VariableMonitor::flushStream( void )
+{
+    if ( to<BinaryFormat>(format) and out_stream.is_open() )
+    {
+        out_stream.seekg(0, std::ios::end);
+        binary_writer.flush( out_stream );
+    }
+
+    AbstractFileMonitor::flushStream();
+}
+
+
+/**
+ * Print header for monitored values
+ */
+void VariableMonitor::printHeader( void )
+{
+    if (not enabled) return;
+    
+    if (to<JSONFormat>(format))
+    {
+	std::vector<json> fields;
+	// print one column for the iteration number
+	fields.push_back("Iteration");
+
+	if ( posterior ) fields.push_back("Posterior");
+
+	if ( likelihood ) fields.push_back("Likelihood");
+
+	if ( prior ) fields.push_back("Prior");
+
+	json header;
+	header["fields"] = fields;
+	header["format"] = "MCON";
+	header["version"] = "0.1";
+	header["nested"] = true;
+	header["atomic"] = false;
+    
+	if ( write_version == true )
+	{
+	    RbVersion version;
+
+	    json rb;
+	    rb["version"] = version.getVersion();
+	    rb["branch"] = version.getGitBranch();
+	    rb["commit"] = version.getGitCommit();
+	    rb["builddate"] = version.getDate();
+	    // build date?
+	    header["RevBayes"] = rb;
+	}
+
+	out_stream.seekg(0, std::ios::end);
+	out_stream<<header<<std::endl;
+    }
+    else if (auto f = to<SeparatorFormat>(format))
+    {
+	auto& separator = f->separator;
+	out_stream.seekg(0, std::ios::end);
+
+	if ( write_version == true )
+	{
+	    RbVersion version;
+	    out_stream << "#RevBayes version (" + version.getVersion() + ")\n";
+	    out_stream << "#Build from " + version.getGitBranch() + " (" + version.getGitCommit() + ") on " + version.getDate() + "\n";
+	}
+
+	// print one column for the iteration number
+	out_stream << "Iteration";
+
+	if ( posterior == true )
+	{
+	    // add a separator before every new element
+	    out_stream << separator << "Posterior";
+	}
+
+	if ( likelihood == true )
+	{
+	    // add a separator before every new element
+	    out_stream << separator << "Likelihood";
+	}
+
+	if ( prior == true )
+	{
+	    // add a separator before every new element
+	    out_stream << separator << "Prior";
+	}
+
+	// print the headers for the variables
+	printFileHeader();
+
+	out_stream << std::endl;
+    }
+    else if (to<BinaryFormat>(format))
+    {
+        out_stream.seekg(0, std::ios::end);
+
+        std::vector<std::string> comments;
+        if ( write_version == true )
+        {
+            RbVersion version;
+            comments.push_back( "#RevBayes version (" + version.getVersion() + ")" );
+            comments.push_back( "#Build from " + version.getGitBranch() + " (" + version.getGitCommit() + ") on " + version.getDate() );
+        }
+
+        setUpBinaryColumns();
+        binary_writer.writeHeader( out_stream, comments );
+    }
+
+    out_stream.flush();
+}
+
+/**
+ * Monitor
+ */
+void VariableMonitor::monitor(unsigned long gen)
+{
+    if ( not enabled or gen % printgen != 0 ) return;
+
+    out_stream.seekg(0, std::ios::end);
+
+    if (to<SeparatorFormat>(format))
+    {
+        // print the iteration number "first", before we change the precision?
+        out_stream << gen;
+    }
+
+    std::streamsize previousPrecision = out_stream.precision();
+    std::ios_base::fmtflags previousFlags = out_stream.flags();
+    out_stream.precision(RbSettings::userSettings().getOutputPrecision());
+
+    double Posterior = 0;
+    double Likelihood = 0;
+    double Prior = 0;
+    if (posterior or likelihood or prior)
+    {
+	for (auto& node: model->getDagNodes())
+	{
+	    double Pr = node->getLnProbability();
+	    Posterior += Pr;
+	    if (node->isClamped())
+		Likelihood += Pr;
+	    else
+		Prior += Pr;
+	}
+    }
+        
+
+    // collect the numbers of the sample while we write it, if a stopping rule observes our file
+    collect_online_sample = ( online_trace != NULL && online_trace->state != OnlineTrace::FAILED && not to<JSONFormat>(format) );
+    online_sample_complete = false;
+    if ( collect_online_sample == true )
+    {
+        online_sample.clear();
+        if ( posterior == true )
+        {
+            online_sample.push_back( Posterior );
+        }
+        if ( likelihood == true )
+        {
+            online_sample.push_back( Likelihood );
+        }
+        if ( prior == true )
+        {
+            online_sample.push_back( Prior );
+        }
+    }
+
+    if (to<JSONFormat>(format))
+    {
+	json line;
+
+	line["Iteration"] = gen;
+        
+	if (Posterior) line["Posterior"] = Posterior;
+	if (Likelihood) line["Likelihood"] = Likelihood;
+	if (Prior) line["Prior"] = Prior;
+
+	for (auto& node: nodes)
+	{
+	    auto name = node->getName();
+	    if (name.empty())
+		name = std::to_string((uintptr_t)node);
+	    line[name] = node->getValueAsJSON();
+	}
+
+	out_stream << line << "\n";
+    }
+    else if (to<BinaryFormat>(format))
+    {
+        // a resumed run does not print the header again, so we may still need to set up the columns
+        if ( binary_writer.getNumberOfColumns() == 0 )
+        {
+            setUpBinaryColumns();
+        }
+
+        binary_writer.addInteger( gen );
+
+        if ( posterior == true )
+        {
+            binary_writer.addReal( Posterior );
+        }
+
+        if ( likelihood == true )
+        {
+            binary_writer.addReal( Likelihood );
+        }
+
+        if ( prior == true )
+        {
+            binary_writer.addReal( Prior );
+        }
+
+        monitorVariables( gen );
+
+        // the row is only written when its block is full
+        binary_writer.endRow( out_stream );
+    }
+    else
+    {
+	auto& separator = to<SeparatorFormat>(format)->separator;
+
+        if ( posterior == true )
+        {
+            // add a separator before every new element
+            out_stream << separator << Posterior;
+        }
+
+        if ( likelihood == true )
+        {
+            // add a separator before every new element
+            out_stream << separator << Likelihood;
+        }
+
+        if ( prior == true )
+        {
+            // add a separator before every new element
+            out_stream << separator << Prior;
+        }
+        
+        monitorVariables( gen );
+
+        out_stream << std::endl;
+    }
+
+    if ( collect_online_sample == true )
+    {
+        addSampleToOnlineTrace();
+    }
+
+    out_stream.setf(previousFlags);
+    out_stream.precision(previousPrecision);
+    out_stream.flush();
+}
+
+
+/**
+ * Open the stream. If a stopping rule observes our file, then we also add all samples to its running statistics.
+ */
+void VariableMonitor::openStream( bool reopen )
+{
+    AbstractFileMonitor::openStream( reopen );
+
+    online_trace = OnlineTraceRegistry::onlineTraceRegistryInstance().getTrace( working_file_name );
+    reopened = reopen;
+}
+
+/**
+ * Print additional header for monitored values
+ */
+void VariableMonitor::printFileHeader( void )
+{
+    auto& separator = to<SeparatorFormat>(format)->separator;
+
+    for (std::vector<DagNode *>::const_iterator it=nodes.begin(); it!=nodes.end(); ++it)
+    {
+        // add a separator before every new element
+        out_stream << separator;
+
+        const DagNode* the_node = *it;
+
+        // print the header
+        if (the_node->getName() != "")
+        {
+            the_node->printName(out_stream,separator, -1, true, flatten);
+        }
+        else
+        {
+            out_stream << "Unnamed";
+        }
+
+    }
+
+}
+
+/**
+ * Monitor value at generation gen
+ */
+void VariableMonitor::monitorVariables(unsigned long gen)
+{
+    if ( to<BinaryFormat>(format) )
+    {
+        std::vector<double> values;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            DagNode *node = nodes[i];
+
+            if ( binary_node_numeric[i] == true )
+            {
+                // numeric values are stored without formatting them
+                values.clear();
+                node->getValueAsNumbers( values );
+                if ( values.size() != binary_node_columns[i] )
+                {
+                    throw RbException()<<"The number of values of variable '"<<node->getName()<<"' changed from "<<binary_node_columns[i]<<" to "<<values.size()<<", but the binary format needs a fixed number of columns.";
+                }
+
+                for (double v: values)
+                {
+                    binary_writer.addReal( v );
+                }
+
+                if ( collect_online_sample == true )
+                {
+                    online_sample.insert( online_sample.end(), values.begin(), values.end() );
+                }
+            }
+            else
+            {
+                std::stringstream ss;
+                node->printValue(ss, "\t", -1, false, false, true, flatten);
+
+                if ( binary_node_columns[i] == 1 )
+                {
+                    binary_writer.addString( ss.str() );
+                    if ( collect_online_sample == true )
+                    {
+                        online_sample.push_back( atof( ss.str().c_str() ) );
+                    }
+                    continue;
+                }
+
+                std::vector<std::string> fields;
+                StringUtilities::stringSplit(ss.str(), "\t", fields);
+                if ( fields.size() != binary_node_columns[i] )
+                {
+                    throw RbException()<<"The number of values of variable '"<<node->getName()<<"' changed from "<<binary_node_columns[i]<<" to "<<fields.size()<<", but the binary format needs a fixed number of columns.";
+                }
+
+                for (auto& field: fields)
+                {
+                    binary_writer.addString( field );
+                    if ( collect_online_sample == true )
+                    {
+                        online_sample.push_back( atof( field.c_str() ) );
+                    }
+                }
+            }
+        }
+
+        online_sample_complete = true;
+
+        return;
+    }
+
+    auto& separator = to<SeparatorFormat>(format)->separator;
+
+    for (std::vector<DagNode*>::iterator i = nodes.begin(); i != nodes.end(); ++i)
+    {
+        // add a separator before every new element
+        out_stream << separator;
+
+        // get the node
+        DagNode *node = *i;
+
+        if ( collect_online_sample == true )
+        {
+            // we print the value once and read the numbers back from the printed value, as a reader of the file does
+            std::stringstream ss;
+            ss.copyfmt( out_stream );
+            node->printValue(ss, separator, -1, false, false, true, flatten);
+
+            const std::string &value = ss.str();
+            out_stream << value;
+
+            std::vector<std::string> fields;
+            StringUtilities::stringSplit(value, separator, fields);
+            for (auto& field: fields)
+            {
+                online_sample.push_back( atof( field.c_str() ) );
+            }
+        }
+        else
+        {
+            // print the value
+            node->printValue(out_stream, separator, -1, false, false, true, flatten);
+        }
+    }
+
+    online_sample_complete = true;
+
+}
+
+/**
+ * Combine output for the monitor.
+ * Overwrite this method for specialized behavior.
+ */
+void VariableMonitor::combineReplicates( size_t n_reps, MonteCarloAnalysisOptions::TraceCombinationTypes tc )
+{
+    if ( enabled == true and to<BinaryFormat>(format) )
+    {
+        combineBinaryReplicates( n_reps, tc );
+        return;
+    }
+
+    if ( enabled == true and to<SeparatorFormat>(format))
+    {
+
+	auto & separator = to<SeparatorFormat>(format)->separator;
+
+        std::fstream combined_output_stream;
+
+        int sample_number = 0;
+
+        // open the stream to the file
+        combined_output_stream.open( filename.string(), std::fstream::out);
+        combined_output_stream.close();
+        combined_output_stream.open( filename.string(), std::fstream::in | std::fstream::out);
+
+        if ( tc == MonteCarloAnalysisOptions::SEQUENTIAL )
+        {
+            for (size_t i=0; i<n_reps; ++i)
+            {
+                std::stringstream ss;
+                ss << "_run_" << (i+1);
+                std::string s = ss.str();
+                path current_file_name = appendToStem(filename, s);
+
+                std::ifstream current_input_stream( current_file_name.string() );
+
+                if ( not current_input_stream )
+                {
+                    throw RbException()<<"Could not open file "<<current_file_name<<".";
+                }
+
+                std::string read_line = "";
+                size_t lines_skipped = 0;
+                size_t lines_to_skip = ( write_version == true ? 3 : 1 );
+                while (std::getline(current_input_stream,read_line))
+                {
+                    ++lines_skipped;
+                    if ( lines_skipped < lines_to_skip)
+                    {
+                        if ( i == 0 )
+                        {
+                            // write output
+                            combined_output_stream << read_line;
+
+                            // add a new line
+                            combined_output_stream << std::endl;
+                        }
+                        continue;
+                    }
+                    else if ( lines_skipped == lines_to_skip )
+                    {
+
+                        if ( i == 0 )
+                        {
+                            std::vector<std::string> fields;
+                            StringUtilities::stringSplit(read_line, separator, fields);
+
+                            // write output
+                            combined_output_stream << fields[0];
+
+                            // add a separator before every new element
+                            combined_output_stream << separator;
+                            combined_output_stream << "Replicate_ID";
+
+                            for (size_t j=1; j<fields.size(); ++j)
+                            {
+                                // add a separator before every new element
+                                combined_output_stream << separator;
+
+                                // write output
+                                combined_output_stream << fields[j];
+                            }
+
+                            // add a new line
+                            combined_output_stream << std::endl;
+                        }
+                        continue;
+
+                    }
+
+                    std::vector<std::string> fields;
+                    StringUtilities::stringSplit(read_line, separator, fields);
+
+                    // add the current sample number
+                    combined_output_stream << sample_number;
+
+                    // add a separator before every new element
+                    combined_output_stream << separator;
+                    combined_output_stream << i;
+
+                    ++sample_number;
+                    for (size_t j=1; j<fields.size(); ++j)
+                    {
+                        // add a separator before every new element
+                        combined_output_stream << separator;
+
+                        // write output
+                        combined_output_stream << fields[j];
+                    }
+                    // add a new line
+                    combined_output_stream << std::endl;
+
+                }
+
+                current_input_stream.close();
+
+            }
+
+        }
+        else if ( tc == MonteCarloAnalysisOptions::MIXED )
+        {
+            std::vector< std::ifstream* > input_streams;
+
+            for (size_t i=0; i<n_reps; ++i)
+            {
+                std::stringstream ss;
+                ss << "_run_" << (i+1);
+                std::string s = ss.str();
+
+                path current_file_name = appendToStem(filename, s);
+
+                std::ifstream * current_input_stream = new std::ifstream( current_file_name.string() );
+
+                if ( not *current_input_stream )
+                {
+                    throw RbException()<<"Could not open file "<<current_file_name<<".";
+                }
+
+                input_streams.push_back( current_input_stream );
+            }
+
+            std::vector<std::string> read_lines(n_reps,"");
+            size_t lines_skipped = 0;
+            size_t lines_to_skip = ( write_version == true ? 3 : 1 );
+            while ( std::getline(*input_streams[0],read_lines[0]) )
+            {
+                for (size_t i=1; i<n_reps; ++i)
+                {
+                    if ( !(std::getline(*input_streams[i],read_lines[i])) )
+                    {
+                        throw RbException("Cannot merge output trace files with unequal number of lines.");
+                    }
+                }
+
+                ++lines_skipped;
+                if ( lines_skipped < lines_to_skip)
+                {
+                    // write output
+                    combined_output_stream << read_lines[0];
+
+                    // add a new line
+                    combined_output_stream << std::endl;
+                    continue;
+                }
+                else if ( lines_skipped == lines_to_skip )
+                {
+                    std::vector<std::string> fields;
+                    StringUtilities::stringSplit(read_lines[0], separator, fields);
+
+                    // write output
+                    combined_output_stream << fields[0];
+
+                    // add a separator before every new element
+                    combined_output_stream << separator;
+                    combined_output_stream << "Replicate_ID";
+
+                    for (size_t j=1; j<fields.size(); ++j)
+                    {
+                        // add a separator before every new element
+                        combined_output_stream << separator;
+
+                        // write output
+                        combined_output_stream << fields[j];
+                    }
+
+                    // add a new line
+                    combined_output_stream << std::endl;
+                    continue;
+
+                }
+
+
+                for (size_t i=0; i<n_reps; ++i)
+                {
+                    std::vector<std::string> fields;
+                    StringUtilities::stringSplit(read_lines[i], separator, fields);
+
+                    // add the current sample number
+                    combined_output_stream << sample_number;
+
+                    // add a separator before every new element
+                    combined_output_stream << separator;
+                    combined_output_stream << i;
+
+                    ++sample_number;
+                    for (size_t j=1; j<fields.size(); ++j)
+                    {
+                        // add a separator before every new element
+                        combined_output_stream << separator;
+
+                        // write output
+                        combined_output_stream << fields[j];
+                    }
+
+                    // add a new line
+                    combined_output_stream << std::endl;
+
+                }
+
+            }
+
+            for (size_t i=0; i<n_reps; ++i)
+            {
+                input_streams[i]->close();
+                delete input_streams[i];
+            }
+
+        }
+
+        combined_output_stream.close();
+
+    }
+
+}
+
+/**
+ * Combine the binary traces of the replicates in the same way as the delimited traces:
+ * the iteration is replaced by the sample number and the replicate is added as a second column.
+ */
+void VariableMonitor::combineBinaryReplicates( size_t n_reps, MonteCarloAnalysisOptions::TraceCombinationTypes tc )
+{
+    std::vector< std::unique_ptr<BinaryTraceReader> > readers;
+    for (size_t i=0; i<n_reps; ++i)
+    {
+        std::stringstream ss;
+        ss << "_run_" << (i+1);
+        path current_file_name = appendToStem(filename, ss.str());
+
+        readers.push_back( std::make_unique<BinaryTraceReader>( current_file_name ) );
+
+        if ( readers[i]->getColumnNames() != readers[0]->getColumnNames() )
+        {
+            throw RbException()<<"Cannot merge binary trace files with different columns.";
+        }
+        if ( tc == MonteCarloAnalysisOptions::MIXED && readers[i]->getNumberOfRows() != readers[0]->getNumberOfRows() )
+        {
+            throw RbException("Cannot merge output trace files with unequal number of lines.");
+        }
+    }
+
+    const BinaryTraceReader& first = *readers[0];
+    size_t num_columns = first.getNumberOfColumns();
+    if ( num_columns == 0 )
+    {
+        return;
+    }
+
+    BinaryTraceWriter writer;
+    writer.addColumn( first.getColumnNames()[0], BinaryTraceCodec::INTEGER );
+    writer.addColumn( "Replicate_ID", BinaryTraceCodec::INTEGER );
+    for (size_t j=1; j<num_columns; ++j)
+    {
+        writer.addColumn( first.getColumnNames()[j], first.getColumnType(j) );
+    }
+
+    std::fstream combined_output_stream;
+    combined_output_stream.open( filename.string(), std::fstream::out | std::fstream::binary );
+    writer.writeHeader( combined_output_stream, first.getComments() );
+
+    long sample_number = 0;
+    auto addSample = [&](size_t rep, size_t i)
+    {
+        const BinaryTraceReader& reader = *readers[rep];
+
+        writer.addInteger( sample_number );
+        writer.addInteger( rep );
+        ++sample_number;
+
+        for (size_t j=1; j<num_columns; ++j)
+        {
+            if ( reader.getColumnType(j) == BinaryTraceCodec::INTEGER )
+            {
+                writer.addInteger( std::int64_t( reader.getNumber(i, j) ) );
+            }
+            else if ( reader.getColumnType(j) == BinaryTraceCodec::REAL )
+            {
+                writer.addReal( reader.getNumber(i, j) );
+            }
+            else
+            {
+                writer.addString( reader.getString(i, j) );
+            }
+        }
+
+        writer.endRow( combined_output_stream );
+    };
+
+    if ( tc == MonteCarloAnalysisOptions::SEQUENTIAL )
+    {
+        for (size_t rep=0; rep<n_reps; ++rep)
+        {
+            for (size_t i=0; i<readers[rep]->getNumberOfRows(); ++i)
+            {
+                addSample( rep, i );
+            }
+        }
+    }
+    else if ( tc == MonteCarloAnalysisOptions::MIXED )
+    {
+        for (size_t i=0; i<first.getNumberOfRows(); ++i)
+        {
+            for (size_t rep=0; rep<n_reps; ++rep)
+            {
+                addSample( rep, i );
+            }
+        }
+    }
+
+    writer.flush( combined_output_stream );
+    combined_output_stream.close();
+}
+
+
+/**
+ * Set up the columns of the binary trace: the iteration, the probabilities, and then the columns of each variable.
+ * Variables with numeric values get one real column per element and all other variables
+ * (e.g., trees) are stored as the strings that the delimited format would contain.
+ */
+void VariableMonitor::setUpBinaryColumns( void )
+{
+    binary_writer.clear();
+    binary_node_columns.clear();
+    binary_node_numeric.clear();
+
+    binary_writer.addColumn( "Iteration", BinaryTraceCodec::INTEGER );
+
+    if ( posterior == true )
+    {
+        binary_writer.addColumn( "Posterior", BinaryTraceCodec::REAL );
+    }
+
+    if ( likelihood == true )
+    {
+        binary_writer.addColumn( "Likelihood", BinaryTraceCodec::REAL );
+    }
+
+    if ( prior == true )
+    {
+        binary_writer.addColumn( "Prior", BinaryTraceCodec::REAL );
+    }
+
+    for (auto& node: nodes)
+    {
+        std::vector<std::string> names;
+        if ( node->getName() != "" )
+        {
+            std::stringstream ss;
+            node->printName(ss, "\t", -1, true, flatten);
+            StringUtilities::stringSplit(ss.str(), "\t", names);
+        }
+        else
+        {
+            names.push_back( "Unnamed" );
+        }
+
+        std::vector<double> values;
+        bool numeric = node->getValueAsNumbers( values ) && values.size() == names.size();
+
+        for (auto& name: names)
+        {
+            binary_writer.addColumn( name, (numeric ? BinaryTraceCodec::REAL : BinaryTraceCodec::STRING) );
+        }
+        binary_node_columns.push_back( names.size() );
+        binary_node_numeric.push_back( numeric );
+    }
+
+}
+
+
+/**
+ * Set flag about whether to print the likelihood.
+ *
+ * \param[in]   tf   Flag if the likelihood should be printed.
+ */
+void VariableMonitor::setPrintLikelihood(bool tf)
+{
+
+    likelihood = tf;
+
+}
+
+
+/**
+ * Set flag about whether to print the posterior probability.
+ *
+ * \param[in]   tf   Flag if the posterior probability should be printed.
+ */
+void VariableMonitor::setPrintPosterior(bool tf)
+{
+
+    posterior = tf;
+
+}
+
+
+/**
+ * Set flag about whether to print the prior probability.
+ *
+ * \param[in]   tf   Flag if the prior probability should be printed.
+ */
+void VariableMonitor::setPrintPrior(bool tf)
+{
+
+    prior = tf;
+
+}
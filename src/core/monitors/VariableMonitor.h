@@ -2,13 +2,16 @@
 #define FileMonitor_H
 
 #include <cstddef>
+#include <memory>
 #include <vector>
 #include <iosfwd>
 #include "variant.h"
 
 #include "AbstractFileMonitor.h"
+#include "BinaryTraceWriter.h"
 #include "MonteCarloAnalysisOptions.h"
 #include "FileFormat.h"
+#include "OnlineTraceRegistry.h"
 
 namespace RevBayesCore {
 class DagNode;
@@ -19,13 +22,17 @@ class DagNode;
         // Constructors and Destructors
         VariableMonitor(DagNode *n, unsigned long g, const path &fname, const SampleFormat& f, bool pp=true, bool l=true, bool pr=true, bool ap=false, bool wv=true);                                                                //!< Constructor with single DAG node
         VariableMonitor(const std::vector<DagNode *> &n, unsigned long g, const path &fname, const SampleFormat& f, bool pp=true, bool l=true, bool pr=true, bool ap=false, bool wv=true);                                              //!< Constructor with vector of DAG node
+        virtual                                ~VariableMonitor(void);
 
         // basic methods
         VariableMonitor*                        clone(void) const;                                                  //!< Clone the object
         
         // monitor methods
+        virtual void                            closeStream(void);                                                  //!< Write the buffered samples of a binary trace before closing the stream
+        virtual void                            flushStream(void);                                                  //!< Write the buffered samples of a binary trace and wait until all output is in the file
         virtual void                            printHeader();
         virtual void                            monitor(unsigned long gen);
+        virtual void                            openStream(bool reopen);                                            //!< Open the stream and check whether a stopping rule observes the file
 
         virtual void                            printFileHeader();
         virtual void                            monitorVariables(unsigned long gen);
@@ -37,10 +44,24 @@ class DagNode;
         void                                    setPrintPrior(bool tf);
 
     protected:
+        void                                     addSampleToOnlineTrace(void);                                      //!< Add the current sample to the running statistics of the file
+        void                                     combineBinaryReplicates(size_t n_reps, MonteCarloAnalysisOptions::TraceCombinationTypes tc);
+        void                                     setUpBinaryColumns(void);                                          //!< Set up the columns of the binary trace for the monitored variables
+
         bool                                     posterior = true;
         bool                                     prior = true;
         bool                                     likelihood = true;
-	std::variant<SeparatorFormat,JSONFormat> format = SeparatorFormat("\t");
+	SampleFormat                             format = SeparatorFormat("\t");
+
+        BinaryTraceWriter                        binary_writer;
+        std::vector<size_t>                      binary_node_columns;                                               //!< The number of binary trace columns of each variable
+        std::vector<bool>                        binary_node_numeric;                                               //!< Is the variable stored as real numbers (or else as strings)?
+
+        std::shared_ptr<OnlineTrace>             online_trace;                                                      //!< The running statistics of the file for a stopping rule (NULL if no rule observes the file)
+        bool                                     reopened = false;                                                  //!< Was the stream reopened to continue a previous run?
+        bool                                     collect_online_sample = false;                                     //!< Does monitorVariables() collect the numbers of the current sample?
+        std::vector<double>                      online_sample;                                                     //!< The numbers of the current sample for the running statistics
+        bool                                     online_sample_complete = false;                                    //!< Did monitorVariables() collect all numbers of the current sample?
     };
     
 }
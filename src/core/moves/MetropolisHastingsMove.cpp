@@ -14,6 +14,8 @@
 #include "AbstractMove.h"
 #include "RbOrderedSet.h"
 #include "RbException.h"
+#include "RbSettings.h"
+#include "ThreadPool.h"
 
 using namespace RevBayesCore;
 
@@ -106,6 +108,98 @@ MetropolisHastingsMove* MetropolisHastingsMove::clone( void ) const
 }
 
 
+/**
+ * Compute the log probability ratios of the given nodes concurrently on the threads of the thread pool.
+ * The ratios are summed in the order of the nodes, so the result is the same as for the sequential computation.
+ * As in the sequential computation, a math error results in a ratio of -Inf.
+ *
+ * \param[in]    n   The nodes, which must not depend on each other.
+ *
+ * \return The sum of the log probability ratios.
+ */
+double MetropolisHastingsMove::computeLnProbabilityRatiosConcurrently( const std::vector<DagNode*> &n ) const
+{
+
+    std::vector<double> ln_ratios( n.size(), 0.0 );
+
+    ThreadPool::threadPoolInstance().parallelFor( n.size(), [&](size_t i) {
+
+        try
+        {
+            ln_ratios[i] = n[i]->getLnProbabilityRatio();
+        }
+        catch (const RbException &e)
+        {
+            if ( e.getExceptionType() != RbException::MATH_ERROR )
+            {
+                throw;
+            }
+            ln_ratios[i] = RbConstants::Double::neginf;
+        }
+
+    });
+
+    double ln_ratio = 0.0;
+    for (size_t i = 0; i < ln_ratios.size(); ++i)
+    {
+        ln_ratio += ln_ratios[i];
+    }
+
+    return ln_ratio;
+}
+
+
+/**
+ * Get the clamped affected nodes if their probabilities can be computed concurrently.
+ * This requires several threads and at least two clamped nodes. Furthermore, the values of the parents
+ * of these nodes must not be computed lazily during the concurrent computation, so we update them here.
+ * If any parent recomputes its value at every access, then we return an empty vector
+ * and all nodes are computed sequentially.
+ *
+ * \param[in]    affected   The nodes affected by this move.
+ *
+ * \return The nodes that can be computed concurrently (or an empty vector).
+ */
+std::vector<DagNode*> MetropolisHastingsMove::getConcurrentlyComputableNodes( const RbOrderedSet<DagNode*> &affected ) const
+{
+
+    std::vector<DagNode*> clamped_nodes;
+
+    const ThreadPool& pool = ThreadPool::threadPoolInstance();
+    if ( pool.getNumberOfThreads() < 2 || pool.isWorkerThread() == true )
+    {
+        return clamped_nodes;
+    }
+
+    for (RbOrderedSet<DagNode*>::const_iterator it = affected.begin(); it != affected.end(); ++it)
+    {
+        if ( (*it)->isClamped() == true )
+        {
+            clamped_nodes.push_back( *it );
+        }
+    }
+
+    if ( clamped_nodes.size() < 2 )
+    {
+        return std::vector<DagNode*>();
+    }
+
+    for (size_t i = 0; i < clamped_nodes.size(); ++i)
+    {
+        std::vector<const DagNode*> parents = clamped_nodes[i]->getParents();
+        for (size_t j = 0; j < parents.size(); ++j)
+        {
+            if ( parents[j]->updateValue() == false )
+            {
+                return std::vector<DagNode*>();
+            }
+        }
+    }
+
+    return clamped_nodes;
+}
+
+
 /**
  * Get moves' name of object
  *
@@ -417,6 +511,18 @@ void MetropolisHastingsMove::performMcmcMove( double prHeat, double lHeat, doubl
 
     }
 
+    // the likelihoods of the clamped affected nodes (e.g. the partitions sharing a tree) are independent
+    // so we may compute them concurrently
+    std::vector<DagNode*> concurrent_nodes;
+    if ( RbSettings::userSettings().getUseConcurrentLikelihoods() == true && RbMath::isAComputableNumber(ln_prior_ratio) && RbMath::isAComputableNumber(ln_likelihood_ratio) && RbMath::isAComputableNumber(ln_hastings_ratio) )
+    {
+        concurrent_nodes = getConcurrentlyComputableNodes( affected_nodes );
+        if ( concurrent_nodes.empty() == false )
+        {
+            ln_likelihood_ratio += computeLnProbabilityRatiosConcurrently( concurrent_nodes );
+        }
+    }
+
     // then we recompute the probability for all the affected nodes
     for (RbOrderedSet<DagNode*>::const_iterator it = affected_nodes.begin(); it != affected_nodes.end(); ++it)
     {
@@ -426,6 +532,12 @@ void MetropolisHastingsMove::performMcmcMove( double prHeat, double lHeat, doubl
         {
             if ( the_node->isClamped() )
             {
+                if ( concurrent_nodes.empty() == false )
+                {
+                    // we have already computed this node above
+                    continue;
+                }
+
                 try
                 {
                     ln_likelihood_ratio += the_node->getLnProbabilityRatio();
@@ -2,6 +2,7 @@
 #define MetropolisHastingsMove_H
 
 #include "AbstractMove.h"
+#include "RbOrderedSet.h"
 
 #include <set>
 #include <vector>
@@ -55,6 +56,9 @@ namespace RevBayesCore {
         
     private:
         
+        double                                                  computeLnProbabilityRatiosConcurrently(const std::vector<DagNode*> &n) const;          //!< Compute and sum the probability ratios of independent nodes on several threads
+        std::vector<DagNode*>                                   getConcurrentlyComputableNodes(const RbOrderedSet<DagNode*> &affected) const;          //!< Get the affected nodes whose probabilities can be computed concurrently
+        
         // parameters
         unsigned int                                            num_accepted_current_period;                            //!< Number of times accepted
         unsigned int                                            num_accepted_total;                                     //!< Number of times accepted
@@ -31,12 +31,17 @@ using namespace RevBayesCore;
  */
 EmpiricalTreeTopologyProposal::EmpiricalTreeTopologyProposal( StochasticNode<Tree> *t, const TraceTree &tt, double a ) : Proposal(),
     tree( t ),
-    trees( tt.getValues() ),
     alpha( a )
 {
     // tell the base class to add the node
     addNode( tree );
     
+    // copy the trees through objectAt so that traces streamed from a file are supported too
+    for (size_t i=0; i<tt.size(); ++i)
+    {
+        trees.push_back( tt.objectAt(i) );
+    }
+    
 }
 
 
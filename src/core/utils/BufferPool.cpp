@@ -0,0 +1,118 @@
+#include "BufferPool.h"
+
+#include <cassert>
+#include <new>
+
+using namespace RevBayesCore;
+
+
+/** Default constructor */
+BufferPool::BufferPool(void) :
+    cached_bytes( 0 )
+{
+
+}
+
+
+/** Destructor. Free all released buffers. */
+BufferPool::~BufferPool(void)
+{
+
+    clear();
+}
+
+
+/**
+ * Get a buffer of n doubles. If a buffer of this size was released before, then we reuse it.
+ * As with new double[n], the values are not initialized.
+ */
+double* BufferPool::allocate(size_t n)
+{
+
+    if ( n == 0 )
+    {
+        n = 1;
+    }
+
+    std::lock_guard<std::mutex> lock( pool_mutex );
+
+    double* buffer = NULL;
+
+    std::multimap<size_t, double*>::iterator it = free_buffers.find( n );
+    if ( it != free_buffers.end() )
+    {
+        buffer = it->second;
+        free_buffers.erase( it );
+        cached_bytes -= n * sizeof(double);
+    }
+    else
+    {
+        buffer = static_cast<double*>( ::operator new[]( n * sizeof(double), std::align_val_t( ALIGNMENT ) ) );
+    }
+
+    used_buffers.insert( std::make_pair( buffer, n ) );
+
+    return buffer;
+}
+
+
+/**
+ * Free all buffers that are currently not in use.
+ */
+void BufferPool::clear(void)
+{
+
+    std::lock_guard<std::mutex> lock( pool_mutex );
+
+    for (std::multimap<size_t, double*>::iterator it = free_buffers.begin(); it != free_buffers.end(); ++it)
+    {
+        freeBuffer( it->second );
+    }
+    free_buffers.clear();
+    cached_bytes = 0;
+
+}
+
+
+void BufferPool::freeBuffer(double *buffer)
+{
+
+    ::operator delete[]( buffer, std::align_val_t( ALIGNMENT ) );
+}
+
+
+/**
+ * Return a buffer that was obtained from allocate() to the pool.
+ */
+void BufferPool::release(double *buffer)
+{
+
+    if ( buffer == NULL )
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock( pool_mutex );
+
+    std::unordered_map<double*, size_t>::iterator it = used_buffers.find( buffer );
+    // this may be called from destructors, so we do not throw if the buffer is not ours
+    assert( it != used_buffers.end() );
+    if ( it == used_buffers.end() )
+    {
+        return;
+    }
+    size_t n = it->second;
+    used_buffers.erase( it );
+
+    // keep the buffer for later unless the pool is already too large
+    if ( cached_bytes + n * sizeof(double) <= MAX_CACHED_BYTES )
+    {
+        free_buffers.insert( std::make_pair( n, buffer ) );
+        cached_bytes += n * sizeof(double);
+    }
+    else
+    {
+        freeBuffer( buffer );
+    }
+
+}
@@ -0,0 +1,57 @@
+#ifndef BufferPool_H
+#define BufferPool_H
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief BufferPool class declaration
+     * The class BufferPool manages large, aligned buffers of doubles (e.g. the partial likelihood
+     * vectors of the phylogenetic CTMC). Buffers that are released are not freed but kept
+     * for the next request of the same size. Hence, objects that repeatedly allocate and free
+     * a buffer of the same size (for example when computing the likelihood outside of an MCMC)
+     * and clones of such objects share a few buffers instead of paying for the allocation and
+     * the page faults every time.
+     *
+     * The buffers are aligned to 64 bytes (a cache line and an AVX-512 register).
+     * Released buffers are freed once the pool holds more than MAX_CACHED_BYTES, and the
+     * analyses clear the pool when they finish. The pool is thread-safe.
+     */
+    class BufferPool {
+
+    public:
+        static BufferPool&                          bufferPoolInstance(void)                                                                //!< Return a reference to the singleton pool
+                                                    {
+                                                        // the pool is never destroyed because buffers may be released by static objects at exit
+                                                        static BufferPool* singleBufferPool = new BufferPool();
+                                                        return *singleBufferPool;
+                                                    }
+
+        double*                                     allocate(size_t n);                                                                     //!< Get an uninitialized buffer of n doubles
+        void                                        clear(void);                                                                            //!< Free all buffers that are not in use
+        void                                        release(double* buffer);                                                                //!< Return a buffer to the pool (NULL is ignored)
+
+        static const size_t                         ALIGNMENT = 64;
+        static const size_t                         MAX_CACHED_BYTES = size_t(1) << 28;
+
+    private:
+                                                    BufferPool(void);                                                                       //!< Default constructor
+                                                    BufferPool(const BufferPool&);                                                          //!< Copy constructor
+                                                    BufferPool& operator=(const BufferPool&);                                               //!< Assignment operator
+                                                   ~BufferPool(void);                                                                       //!< Destructor
+
+        void                                        freeBuffer(double* buffer);
+
+        std::mutex                                  pool_mutex;
+        std::multimap<size_t, double*>              free_buffers;                                                                           //!< Released buffers by size
+        std::unordered_map<double*, size_t>         used_buffers;                                                                           //!< The size of each buffer in use
+        size_t                                      cached_bytes;                                                                           //!< The total size of the released buffers
+    };
+
+}
+
+#endif
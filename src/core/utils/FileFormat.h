@@ -13,13 +13,17 @@ struct JSONFormat
 {
 };
 
+struct BinaryFormat
+{
+};
+
 /*
  * To add a new sample format 
  * 1. Create a struct FooFormat
  * 2. Add the struct to the SampleFormat std::variant type.
  */
 
-typedef std::variant<SeparatorFormat,JSONFormat> SampleFormat;
+typedef std::variant<SeparatorFormat,JSONFormat,BinaryFormat> SampleFormat;
 
 
 #endif
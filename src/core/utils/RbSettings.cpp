@@ -39,12 +39,30 @@ size_t RbSettings::getLineWidth( void ) const
     return lineWidth;
 }
 
+size_t RbSettings::getNumberOfThreads( void ) const
+{
+    // return the internal value
+    return numThreads;
+}
+
 size_t RbSettings::getScalingDensity( void ) const
 {
     // return the internal value
     return scalingDensity;
 }
 
+bool RbSettings::getUseConcurrentLikelihoods( void ) const
+{
+    // return the internal value
+    return useConcurrentLikelihoods;
+}
+
+bool RbSettings::getUseLazyScaling( void ) const
+{
+    // return the internal value
+    return useLazyScaling;
+}
+
 bool RbSettings::getUseScaling( void ) const
 {
     // return the internal value
@@ -83,10 +101,22 @@ std::string RbSettings::getOption(const std::string &key) const
     {
         return StringUtilities::to_string(scalingDensity);
     }
+    else if ( key == "numThreads" )
+    {
+        return StringUtilities::to_string(numThreads);
+    }
     else if ( key == "useScaling" )
     {
         return useScaling ? "true" : "false";
     }
+    else if ( key == "useLazyScaling" )
+    {
+        return useLazyScaling ? "true" : "false";
+    }
+    else if ( key == "useConcurrentLikelihoods" )
+    {
+        return useConcurrentLikelihoods ? "true" : "false";
+    }
     else if ( key == "collapseSampledAncestors" )
     {
         return collapseSampledAncestors ? "true" : "false";
@@ -128,6 +158,9 @@ void RbSettings::initializeUserSettings(void)
     moduleDir = "modules";      // the default module directory
     useScaling = true;          // the default useScaling
     scalingDensity = 1;         // the default scaling density
+    useLazyScaling = false;     // by default we scale every scalingDensity-th node
+    numThreads = 1;             // by default we do not use additional threads
+    useConcurrentLikelihoods = false;   // by default the nodes affected by a move are computed one after the other
     lineWidth = 160;            // the default line width
     tolerance = 10E-10;         // set default value for tolerance comparing doubles
     outputPrecision = 7;
@@ -170,6 +203,9 @@ void RbSettings::listOptions() const
     std::cout << "linewidth = " << lineWidth << std::endl;
     std::cout << "useScaling = " << (useScaling ? "true" : "false") << std::endl;
     std::cout << "scalingDensity = " << scalingDensity << std::endl;
+    std::cout << "useLazyScaling = " << (useLazyScaling ? "true" : "false") << std::endl;
+    std::cout << "numThreads = " << numThreads << std::endl;
+    std::cout << "useConcurrentLikelihoods = " << (useConcurrentLikelihoods ? "true" : "false") << std::endl;
     std::cout << "collapseSampledAncestors = " << (collapseSampledAncestors ? "true" : "false") << std::endl;
 }
 
@@ -206,6 +242,24 @@ void RbSettings::setUseScaling(bool w)
     writeUserSettings();
 }
 
+void RbSettings::setUseLazyScaling(bool w)
+{
+    // replace the internal value with this new value
+    useLazyScaling = w;
+
+    // save the current settings for the future.
+    writeUserSettings();
+}
+
+void RbSettings::setUseConcurrentLikelihoods(bool c)
+{
+    // replace the internal value with this new value
+    useConcurrentLikelihoods = c;
+
+    // save the current settings for the future.
+    writeUserSettings();
+}
+
 void RbSettings::setScalingDensity(size_t w)
 {
     // replace the internal value with this new value
@@ -216,6 +270,19 @@ void RbSettings::setScalingDensity(size_t w)
 }
 
 
+void RbSettings::setNumberOfThreads(size_t n)
+{
+    if (n < 1)
+        throw(RbException("numThreads must be an integer greater than 0"));
+
+    // replace the internal value with this new value
+    numThreads = n;
+
+    // save the current settings for the future.
+    writeUserSettings();
+}
+
+
 void RbSettings::setCollapseSampledAncestors(bool w)
 {
     // replace the internal value with this new value
@@ -262,6 +329,14 @@ void RbSettings::setOption(const std::string &key, const std::string &v, bool wr
     {
         useScaling = value == "true";
     }
+    else if ( key == "useLazyScaling" )
+    {
+        useLazyScaling = value == "true";
+    }
+    else if ( key == "useConcurrentLikelihoods" )
+    {
+        useConcurrentLikelihoods = value == "true";
+    }
     else if ( key == "scalingDensity" )
     {
         size_t w = atoi(value.c_str());
@@ -270,6 +345,14 @@ void RbSettings::setOption(const std::string &key, const std::string &v, bool wr
         
         scalingDensity = atoi(value.c_str());
     }
+    else if ( key == "numThreads" )
+    {
+        int n = atoi(value.c_str());
+        if (n < 1)
+            throw(RbException("numThreads must be an integer greater than 0"));
+
+        numThreads = n;
+    }
     else if ( key == "collapseSampledAncestors" )
     {
         collapseSampledAncestors = value == "true";
@@ -331,6 +414,9 @@ void RbSettings::writeUserSettings( void )
     writeStream << "linewidth=" << lineWidth << std::endl;
     writeStream << "useScaling=" << (useScaling ? "true" : "false") << std::endl;
     writeStream << "scalingDensity=" << scalingDensity << std::endl;
+    writeStream << "useLazyScaling=" << (useLazyScaling ? "true" : "false") << std::endl;
+    writeStream << "numThreads=" << numThreads << std::endl;
+    writeStream << "useConcurrentLikelihoods=" << (useConcurrentLikelihoods ? "true" : "false") << std::endl;
     writeStream << "collapseSampledAncestors=" << (collapseSampledAncestors ? "true" : "false") << std::endl;
     writeStream.close();
 
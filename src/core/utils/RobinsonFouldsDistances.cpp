@@ -0,0 +1,200 @@
+#include "RobinsonFouldsDistances.h"
+
+#include <algorithm>
+
+#include "RbException.h"
+#include "ThreadPool.h"
+#include "TopologyNode.h"
+#include "Tree.h"
+
+using namespace RevBayesCore;
+
+
+RobinsonFouldsDistances::RobinsonFouldsDistances( void )
+{
+
+}
+
+
+/**
+ * Add a tree and collect its clades.
+ * The clades are compared as rooted bipartitions of the taxa, so unrooted trees need to be rerooted consistently first.
+ */
+size_t RobinsonFouldsDistances::addTree(const Tree &t, long weight)
+{
+
+    std::vector<RbBitSet> clades;
+    t.getRoot().getAllClades( clades, t.getNumberOfTips(), true );
+
+    std::vector<size_t> ids;
+    ids.reserve( clades.size() );
+    for (auto& clade: clades)
+    {
+        auto it = clade_ids.find( clade );
+        if ( it == clade_ids.end() )
+        {
+            it = clade_ids.insert( std::make_pair(clade, clade_ids.size()) ).first;
+        }
+        ids.push_back( it->second );
+    }
+
+    // we compare the trees by merging their sorted clade IDs
+    std::sort( ids.begin(), ids.end() );
+    ids.erase( std::unique( ids.begin(), ids.end() ), ids.end() );
+
+    tree_clades.push_back( std::move(ids) );
+    weights.push_back( weight );
+
+    return tree_clades.size() - 1;
+}
+
+
+/**
+ * Compute the distribution of the distances between all pairs of samples.
+ * Entry d is the number of sample pairs with distance d, counting tree i as weight(i) samples.
+ * Pairs of samples of the same tree have distance 0.
+ */
+std::vector<double> RobinsonFouldsDistances::computeDistanceDistribution( void ) const
+{
+
+    size_t num_trees = tree_clades.size();
+
+    // the rows get shorter, so we assign every num_blocks-th row to the same block to balance the work
+    ThreadPool& pool = ThreadPool::threadPoolInstance();
+    size_t num_blocks = std::min( num_trees, 4 * pool.getNumberOfThreads() );
+
+    std::vector< std::vector<double> > block_counts( num_blocks );
+    pool.parallelFor( num_blocks, [&](size_t b)
+    {
+        std::vector<double>& counts = block_counts[b];
+
+        for (size_t i = b; i < num_trees; i += num_blocks)
+        {
+            double w_i = weights[i];
+
+            if ( counts.empty() == true )
+            {
+                counts.resize( 1, 0.0 );
+            }
+            counts[0] += w_i * (w_i - 1) / 2.0;
+
+            for (size_t j = i + 1; j < num_trees; ++j)
+            {
+                size_t d = size_t( getDistance(i, j) );
+                if ( d >= counts.size() )
+                {
+                    counts.resize( d + 1, 0.0 );
+                }
+                counts[d] += w_i * weights[j];
+            }
+        }
+    });
+
+    std::vector<double> distribution;
+    for (auto& counts: block_counts)
+    {
+        if ( counts.size() > distribution.size() )
+        {
+            distribution.resize( counts.size(), 0.0 );
+        }
+        for (size_t d = 0; d < counts.size(); ++d)
+        {
+            distribution[d] += counts[d];
+        }
+    }
+
+    return distribution;
+}
+
+
+/**
+ * Compute the distance of every pair of samples, counting tree i as weight(i) samples.
+ * The samples of a tree are treated as one consecutive block.
+ * The result has one entry per pair of samples, so prefer computeDistanceDistribution for large samples.
+ */
+std::vector<double> RobinsonFouldsDistances::computeDistances( void ) const
+{
+
+    size_t num_trees = tree_clades.size();
+
+    // compute the distances between the trees concurrently
+    std::vector< std::vector<double> > tree_distances( num_trees );
+    ThreadPool::threadPoolInstance().parallelFor( num_trees, [&](size_t i)
+    {
+        tree_distances[i].reserve( num_trees - i - 1 );
+        for (size_t j = i + 1; j < num_trees; ++j)
+        {
+            tree_distances[i].push_back( getDistance(i, j) );
+        }
+    });
+
+    // and then expand them to all pairs of samples
+    std::vector<double> distances;
+    for (size_t i = 0; i < num_trees; ++i)
+    {
+        for (long rep = 0; rep < weights[i]; ++rep)
+        {
+            // first we need to compare the tree to subsequent copies of itself
+            for (long k = rep + 1; k < weights[i]; ++k)
+            {
+                distances.push_back( 0.0 );
+            }
+
+            // then we compare it to copies of other trees
+            for (size_t j = i + 1; j < num_trees; ++j)
+            {
+                double d = tree_distances[i][j - i - 1];
+                distances.insert( distances.end(), size_t(weights[j]), d );
+            }
+        }
+    }
+
+    return distances;
+}
+
+
+/**
+ * The RF distance is the number of clades that are in exactly one of the two trees,
+ * i.e., all clades of both trees minus twice the number of shared clades.
+ */
+double RobinsonFouldsDistances::getDistance(size_t i, size_t j) const
+{
+
+    if ( i >= tree_clades.size() || j >= tree_clades.size() )
+    {
+        throw RbException("Tree index out of bounds in the Robinson-Foulds distance computation.");
+    }
+
+    const std::vector<size_t>& a = tree_clades[i];
+    const std::vector<size_t>& b = tree_clades[j];
+
+    // count the shared clades by merging the sorted clade IDs
+    size_t shared = 0;
+    auto it_a = a.begin();
+    auto it_b = b.begin();
+    while ( it_a != a.end() && it_b != b.end() )
+    {
+        if ( *it_a < *it_b )
+        {
+            ++it_a;
+        }
+        else if ( *it_b < *it_a )
+        {
+            ++it_b;
+        }
+        else
+        {
+            ++shared;
+            ++it_a;
+            ++it_b;
+        }
+    }
+
+    return double( a.size() + b.size() - 2 * shared );
+}
+
+
+size_t RobinsonFouldsDistances::getNumberOfTrees( void ) const
+{
+    return tree_clades.size();
+}
@@ -0,0 +1,47 @@
+#ifndef RobinsonFouldsDistances_H
+#define RobinsonFouldsDistances_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "RbBitSet.h"
+
+namespace RevBayesCore {
+
+    class Tree;
+
+    /**
+     * @brief Robinson-Foulds distances between all pairs of a set of trees.
+     *
+     * Every distinct clade of all trees gets an ID from a hash table (as in HashRF),
+     * and each tree is stored as the sorted vector of its clade IDs. The RF distance of two trees
+     * is then the number of IDs that are not shared, which we count by merging the two vectors.
+     * Hence the memory grows linearly with the number of trees, also if most clades are only found in
+     * a few trees. The rows of the pairwise comparisons are distributed over the thread pool.
+     *
+     * Each tree has a weight, e.g. the number of times that a topology was sampled. Instead of a vector
+     * with one entry per pair of samples, the distribution of the distances can be computed,
+     * which only needs memory proportional to the largest distance.
+     */
+    class RobinsonFouldsDistances {
+
+    public:
+        RobinsonFouldsDistances(void);
+
+        size_t                                      addTree(const Tree &t, long weight = 1);                    //!< Add a tree that represents weight samples and return its index
+        std::vector<double>                         computeDistanceDistribution(void) const;                    //!< The number of sample pairs for each distance
+        std::vector<double>                         computeDistances(void) const;                               //!< The distance of every pair of samples
+        double                                      getDistance(size_t i, size_t j) const;                      //!< The distance between the i-th and the j-th tree
+        size_t                                      getNumberOfTrees(void) const;
+
+    private:
+
+        std::unordered_map<RbBitSet, size_t, RbBitSetHash>  clade_ids;
+        std::vector< std::vector<size_t> >          tree_clades;                                                //!< The sorted clade IDs of each tree
+        std::vector<long>                           weights;
+    };
+
+}
+
+#endif
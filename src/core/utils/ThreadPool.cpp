@@ -0,0 +1,203 @@
+#include "ThreadPool.h"
+
+#include "RbSettings.h"
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    // flag whether the current thread is executing a task of a parallel loop
+    thread_local bool in_parallel_loop = false;
+
+}
+
+
+/** Default constructor */
+ThreadPool::ThreadPool(void) :
+    current_task( NULL ),
+    num_tasks( 0 ),
+    next_task( 0 ),
+    num_finished_tasks( 0 ),
+    generation( 0 ),
+    task_exception( nullptr ),
+    shutdown( false )
+{
+
+}
+
+
+/** Destructor. Stop and join all worker threads. */
+ThreadPool::~ThreadPool(void)
+{
+
+    resizePool( 1 );
+}
+
+
+/**
+ * Get the number of threads that a parallel loop will use, including the calling thread.
+ */
+size_t ThreadPool::getNumberOfThreads( void ) const
+{
+
+    size_t n = RbSettings::userSettings().getNumberOfThreads();
+
+    return ( n < 1 ? 1 : n );
+}
+
+
+bool ThreadPool::isWorkerThread( void ) const
+{
+
+    return in_parallel_loop;
+}
+
+
+/**
+ * Execute task(i) for all i in [0,n). The tasks are distributed dynamically over the worker threads
+ * and the calling thread. This function returns when all tasks are done. If any task throws an exception,
+ * then the first exception is re-thrown here after all other tasks are done.
+ */
+void ThreadPool::parallelFor(size_t n, const std::function<void(size_t)> &task)
+{
+
+    size_t num_threads = getNumberOfThreads();
+
+    // we run the loop serially if there is nothing to gain,
+    // or if we are already inside a parallel loop (nested loops), or if another thread is running a loop
+    std::unique_lock<std::mutex> loop_lock( loop_mutex, std::defer_lock );
+    if ( n < 2 || num_threads < 2 || in_parallel_loop == true || loop_lock.try_lock() == false )
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            task( i );
+        }
+        return;
+    }
+
+    // the user may have changed the number of threads since the last loop
+    if ( workers.size() != num_threads - 1 )
+    {
+        resizePool( num_threads );
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( task_mutex );
+        current_task        = &task;
+        num_tasks           = n;
+        next_task           = 0;
+        num_finished_tasks  = 0;
+        task_exception      = nullptr;
+        ++generation;
+    }
+    task_available.notify_all();
+
+    // the calling thread takes part in the work
+    in_parallel_loop = true;
+    runTasks();
+    in_parallel_loop = false;
+
+    std::unique_lock<std::mutex> lock( task_mutex );
+    task_finished.wait( lock, [this]{ return num_finished_tasks == num_tasks; } );
+    current_task = NULL;
+    std::exception_ptr e = task_exception;
+    task_exception = nullptr;
+    lock.unlock();
+
+    if ( e != nullptr )
+    {
+        std::rethrow_exception( e );
+    }
+
+}
+
+
+/**
+ * Stop all current worker threads and start n-1 new ones (the calling thread is the n-th thread).
+ */
+void ThreadPool::resizePool(size_t n)
+{
+
+    {
+        std::lock_guard<std::mutex> lock( task_mutex );
+        shutdown = true;
+    }
+    task_available.notify_all();
+
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i].join();
+    }
+    workers.clear();
+
+    shutdown = false;
+    for (size_t i = 1; i < n; ++i)
+    {
+        workers.push_back( std::thread( &ThreadPool::workerLoop, this ) );
+    }
+
+}
+
+
+/**
+ * Take tasks from the current loop and execute them until no tasks are left.
+ */
+void ThreadPool::runTasks( void )
+{
+
+    std::unique_lock<std::mutex> lock( task_mutex );
+    while ( next_task < num_tasks )
+    {
+        size_t index = next_task;
+        ++next_task;
+        const std::function<void(size_t)>* task = current_task;
+        lock.unlock();
+
+        std::exception_ptr e = nullptr;
+        try
+        {
+            (*task)( index );
+        }
+        catch (...)
+        {
+            e = std::current_exception();
+        }
+
+        lock.lock();
+        if ( e != nullptr && task_exception == nullptr )
+        {
+            task_exception = e;
+        }
+        ++num_finished_tasks;
+        if ( num_finished_tasks == num_tasks )
+        {
+            task_finished.notify_all();
+        }
+    }
+
+}
+
+
+void ThreadPool::workerLoop( void )
+{
+
+    in_parallel_loop = true;
+
+    std::unique_lock<std::mutex> lock( task_mutex );
+    size_t seen_generation = generation;
+    while ( true )
+    {
+        task_available.wait( lock, [&]{ return shutdown == true || generation != seen_generation; } );
+        if ( shutdown == true )
+        {
+            return;
+        }
+        seen_generation = generation;
+
+        lock.unlock();
+        runTasks();
+        lock.lock();
+    }
+
+}
@@ -0,0 +1,66 @@
+#ifndef ThreadPool_H
+#define ThreadPool_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief ThreadPool class declaration
+     * The class ThreadPool manages a set of worker threads that are shared by all
+     * computations within this process. Work is submitted as a loop over independent
+     * tasks [0,n) which are distributed over the worker threads and the calling thread.
+     *
+     * The number of threads is taken from the user settings (option "numThreads").
+     * A loop that is started from within a worker thread, or while another loop is
+     * running, is executed serially on the calling thread. Hence, nested parallel
+     * loops are safe but do not spawn additional work.
+     *
+     */
+    class ThreadPool {
+
+    public:
+        static ThreadPool&                          threadPoolInstance(void)                                                                //!< Return a reference to the singleton thread pool
+                                                    {
+                                                        static ThreadPool singleThreadPool;
+                                                        return singleThreadPool;
+                                                    }
+
+        size_t                                      getNumberOfThreads(void) const;                                                         //!< The number of threads (including the calling thread) used by a parallel loop
+        bool                                        isWorkerThread(void) const;                                                             //!< Are we currently executing inside a parallel loop?
+        void                                        parallelFor(size_t n, const std::function<void(size_t)> &task);                         //!< Execute task(i) for i in [0,n) and wait until all tasks are done
+
+    private:
+                                                    ThreadPool(void);                                                                       //!< Default constructor
+                                                    ThreadPool(const ThreadPool&);                                                          //!< Copy constructor
+                                                    ThreadPool& operator=(const ThreadPool&);                                               //!< Assignment operator
+                                                   ~ThreadPool(void);                                                                       //!< Destructor
+
+        void                                        resizePool(size_t n);                                                                   //!< Stop the current workers and start n-1 new ones
+        void                                        runTasks(void);                                                                         //!< Take tasks from the current loop until none are left
+        void                                        workerLoop(void);                                                                       //!< Main function of the worker threads
+
+        std::vector<std::thread>                    workers;
+        std::mutex                                  loop_mutex;                                                                             //!< Held by the thread that currently runs a parallel loop
+        std::mutex                                  task_mutex;                                                                             //!< Protects the state of the current loop
+        std::condition_variable                     task_available;
+        std::condition_variable                     task_finished;
+
+        const std::function<void(size_t)>*          current_task;
+        size_t                                      num_tasks;
+        size_t                                      next_task;
+        size_t                                      num_finished_tasks;
+        size_t                                      generation;
+        std::exception_ptr                          task_exception;
+        bool                                        shutdown;
+    };
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+
+    # TODO Split these up based on sub-package dependency
+INCLUDE_DIRECTORIES(
+    ${PROJECT_SOURCE_DIR}/core
+    ${PROJECT_SOURCE_DIR}/core/analysis
+    ${PROJECT_SOURCE_DIR}/core/analysis/mcmc
+    ${PROJECT_SOURCE_DIR}/core/analysis/mcmc/convergence
+    ${PROJECT_SOURCE_DIR}/core/analysis/mcmc/output
+    ${PROJECT_SOURCE_DIR}/core/analysis/stoppingRule
+    ${PROJECT_SOURCE_DIR}/core/dag
+    ${PROJECT_SOURCE_DIR}/core/datatypes
+    ${PROJECT_SOURCE_DIR}/core/datatypes/math
+    ${PROJECT_SOURCE_DIR}/core/datatypes/phylogenetics
+    ${PROJECT_SOURCE_DIR}/core/datatypes/phylogenetics/character
+    ${PROJECT_SOURCE_DIR}/core/datatypes/phylogenetics/characterdata
+    ${PROJECT_SOURCE_DIR}/core/datatypes/phylogenetics/characterhistory
+    ${PROJECT_SOURCE_DIR}/core/datatypes/phylogenetics/cladogeneticmatrix
+    ${PROJECT_SOURCE_DIR}/core/datatypes/phylogenetics/geography
+    ${PROJECT_SOURCE_DIR}/core/datatypes/phylogenetics/ratemap
+    ${PROJECT_SOURCE_DIR}/core/datatypes/phylogenetics/ratematrix
+    ${PROJECT_SOURCE_DIR}/core/datatypes/trees
+    ${PROJECT_SOURCE_DIR}/core/distributions
+    ${PROJECT_SOURCE_DIR}/core/distributions/events
+    ${PROJECT_SOURCE_DIR}/core/distributions/math
+    ${PROJECT_SOURCE_DIR}/core/distributions/phylogenetics
+    ${PROJECT_SOURCE_DIR}/core/distributions/phylogenetics/characterhistory
+    ${PROJECT_SOURCE_DIR}/core/distributions/phylogenetics/continuousCharacter
+    ${PROJECT_SOURCE_DIR}/core/distributions/phylogenetics/matrix
+    ${PROJECT_SOURCE_DIR}/core/distributions/phylogenetics/substitution
+    ${PROJECT_SOURCE_DIR}/core/distributions/phylogenetics/tree
+    ${PROJECT_SOURCE_DIR}/core/distributions/phylogenetics/tree/birthdeath
+    ${PROJECT_SOURCE_DIR}/core/distributions/phylogenetics/tree/coalescent
+    ${PROJECT_SOURCE_DIR}/core/distributions/phylogenetics/tree/coalescent/demography
+    ${PROJECT_SOURCE_DIR}/core/functions
+    ${PROJECT_SOURCE_DIR}/core/functions/builtin
+    ${PROJECT_SOURCE_DIR}/core/functions/distribution
+    ${PROJECT_SOURCE_DIR}/core/functions/math
+    ${PROJECT_SOURCE_DIR}/core/functions/phylogenetics
+    ${PROJECT_SOURCE_DIR}/core/functions/phylogenetics/cladogenetic
+    ${PROJECT_SOURCE_DIR}/core/functions/phylogenetics/ratemap
+    ${PROJECT_SOURCE_DIR}/core/functions/phylogenetics/ratematrix
+    ${PROJECT_SOURCE_DIR}/core/functions/phylogenetics/tree
+    ${PROJECT_SOURCE_DIR}/core/functions/popgen
+    ${PROJECT_SOURCE_DIR}/core/functions/vector
+    ${PROJECT_SOURCE_DIR}/core/help
+    ${PROJECT_SOURCE_DIR}/core/io
+    ${PROJECT_SOURCE_DIR}/core/math
+    ${PROJECT_SOURCE_DIR}/core/math/distributions
+    ${PROJECT_SOURCE_DIR}/core/monitors
+    ${PROJECT_SOURCE_DIR}/core/monitors/characterhistory
+    ${PROJECT_SOURCE_DIR}/core/moves
+    ${PROJECT_SOURCE_DIR}/core/moves/characterhistory
+    ${PROJECT_SOURCE_DIR}/core/moves/compound
+    ${PROJECT_SOURCE_DIR}/core/moves/mixture
+    ${PROJECT_SOURCE_DIR}/core/moves/proposal
+    ${PROJECT_SOURCE_DIR}/core/moves/proposal/matrix
+    ${PROJECT_SOURCE_DIR}/core/moves/proposal/mixture
+    ${PROJECT_SOURCE_DIR}/core/moves/proposal/scalar
+    ${PROJECT_SOURCE_DIR}/core/moves/proposal/simplex
+    ${PROJECT_SOURCE_DIR}/core/moves/proposal/tree
+    ${PROJECT_SOURCE_DIR}/core/moves/proposal/vector
+    ${PROJECT_SOURCE_DIR}/core/statistics
+    ${PROJECT_SOURCE_DIR}/core/statistics/mixture
+    ${PROJECT_SOURCE_DIR}/core/statistics/tree
+    ${PROJECT_SOURCE_DIR}/core/utils
+    ${PROJECT_SOURCE_DIR}/libs
+    ${PROJECT_SOURCE_DIR}/libs/json
+    ${PROJECT_SOURCE_DIR}/libs/lineedit
+    ${PROJECT_SOURCE_DIR}/libs/linenoise
+    ${PROJECT_SOURCE_DIR}/libs/ncl
+    ${PROJECT_SOURCE_DIR}/libs/range-v3
+    ${PROJECT_SOURCE_DIR}/libs/tensorphylo
+    ${PROJECT_SOURCE_DIR}/revlanguage
+    ${PROJECT_SOURCE_DIR}/revlanguage/analysis
+    ${PROJECT_SOURCE_DIR}/revlanguage/analysis/mcmc
+    ${PROJECT_SOURCE_DIR}/revlanguage/analysis/mcmc/output
+    ${PROJECT_SOURCE_DIR}/revlanguage/dag
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/basic
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/container
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/math
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/phylogenetics
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/phylogenetics/character
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/phylogenetics/characterdata
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/phylogenetics/characterhistory
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/phylogenetics/demography
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/phylogenetics/geography
+    ${PROJECT_SOURCE_DIR}/revlanguage/datatypes/phylogenetics/trees
+    ${PROJECT_SOURCE_DIR}/revlanguage/distributions
+    ${PROJECT_SOURCE_DIR}/revlanguage/distributions/math
+    ${PROJECT_SOURCE_DIR}/revlanguage/distributions/mixture
+    ${PROJECT_SOURCE_DIR}/revlanguage/distributions/phylogenetics
+    ${PROJECT_SOURCE_DIR}/revlanguage/distributions/phylogenetics/branchrate
+    ${PROJECT_SOURCE_DIR}/revlanguage/distributions/phylogenetics/character
+    ${PROJECT_SOURCE_DIR}/revlanguage/distributions/phylogenetics/matrix
+    ${PROJECT_SOURCE_DIR}/revlanguage/distributions/phylogenetics/tree
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/argument
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/argumentrules
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/basic
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/internal
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/io
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/math
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/math_helper
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/phylogenetics
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/phylogenetics/frequencies
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/phylogenetics/ratemap
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/phylogenetics/ratematrix
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/phylogenetics/tree
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/popgen
+    ${PROJECT_SOURCE_DIR}/revlanguage/functions/type_conversion
+    ${PROJECT_SOURCE_DIR}/revlanguage/monitors
+    ${PROJECT_SOURCE_DIR}/revlanguage/monitors/characterhistory
+    ${PROJECT_SOURCE_DIR}/revlanguage/moves
+    ${PROJECT_SOURCE_DIR}/revlanguage/moves/integer
+    ${PROJECT_SOURCE_DIR}/revlanguage/moves/matrix
+    ${PROJECT_SOURCE_DIR}/revlanguage/moves/mixture
+    ${PROJECT_SOURCE_DIR}/revlanguage/moves/scalar
+    ${PROJECT_SOURCE_DIR}/revlanguage/moves/simplex
+    ${PROJECT_SOURCE_DIR}/revlanguage/moves/tree
+    ${PROJECT_SOURCE_DIR}/revlanguage/moves/vector
+    ${PROJECT_SOURCE_DIR}/revlanguage/parser
+    ${PROJECT_SOURCE_DIR}/revlanguage/ui
+    ${PROJECT_SOURCE_DIR}/revlanguage/utils
+    ${PROJECT_SOURCE_DIR}/revlanguage/workspace
+ ${Boost_INCLUDE_DIR} )
+
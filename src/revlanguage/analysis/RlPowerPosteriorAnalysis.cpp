@@ -14,6 +14,7 @@
 #include "RevObject.h"
 #include "RealPos.h"
 #include "RevNullObject.h"
+#include "RlBoolean.h"
 #include "RlModel.h"
 #include "RlMonitor.h"
 #include "RlMove.h"
@@ -105,6 +106,7 @@ void PowerPosteriorAnalysis::constructInternalObject( void )
     const double                                    alpha   = static_cast<const RealPos &>( alphaVal->getRevObject() ).getValue();
     const int                                       sf      = (int)static_cast<const Natural &>( sampFreq->getRevObject() ).getValue();
     const int                                       k       = (int)static_cast<const Natural &>( proc_per_lik->getRevObject() ).getValue();
+    const bool                                      ps      = static_cast<const RlBoolean &>( parallel_stones->getRevObject() ).getValue();
 
     RevBayesCore::Mcmc *m = new RevBayesCore::Mcmc(mdl, mvs, mntr);
     m->setScheduleType( "random" );
@@ -128,6 +130,7 @@ void PowerPosteriorAnalysis::constructInternalObject( void )
 
     value->setPowers( beta );
     value->setSampleFreq( sf );
+    value->setParallelStones( ps );
 }
 
 
@@ -249,6 +252,7 @@ const MemberRules& PowerPosteriorAnalysis::getParameterRules(void) const
         member_rules.push_back( new ArgumentRule("alpha"      , RealPos::getClassTypeSpec()                 , "The alpha parameter of the beta distribution if no powers are specified.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RealPos(0.2) ) );
         member_rules.push_back( new ArgumentRule("sampleFreq" , Natural::getClassTypeSpec()                 , "The sampling frequency of the likelihood values.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural(100) ) );
         member_rules.push_back( new ArgumentRule("procPerLikelihood" , Natural::getClassTypeSpec()          , "Number of processors used to compute the likelihood.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural(1) ) );
+        member_rules.push_back( new ArgumentRule("parallelStones" , RlBoolean::getClassTypeSpec()           , "Should the stones of a process run concurrently on several threads (see the option 'numThreads')? Each stone then starts from the state after the burn-in and uses its own random number generator.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false) ) );
 
         rules_set = true;
     }
@@ -315,6 +319,10 @@ void PowerPosteriorAnalysis::setConstParameter(const std::string& name, const Re
     {
         proc_per_lik = var;
     }
+    else if ( name == "parallelStones" )
+    {
+        parallel_stones = var;
+    }
     else
     {
         RevObject::setConstParameter(name, var);
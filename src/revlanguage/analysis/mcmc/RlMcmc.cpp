@@ -24,6 +24,7 @@
 #include "RbVector.h"
 #include "RbVectorImpl.h"
 #include "RevPtr.h"
+#include "RlBoolean.h"
 #include "RevVariable.h"
 #include "RlMonteCarloAnalysis.h"
 
@@ -109,6 +110,7 @@ void Mcmc::constructInternalObject( void )
     }
     
     value = new RevBayesCore::MonteCarloAnalysis(m,nreps,ct);
+    value->setParallelReplicates( static_cast<const RlBoolean &>( parallel_runs->getRevObject() ).getValue() );
     
 }
 
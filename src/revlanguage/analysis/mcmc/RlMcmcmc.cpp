@@ -92,8 +92,9 @@ void Mcmcmc::constructInternalObject( void )
     double                                                  tht     = static_cast<const Probability &>( tune_heat_target->getRevObject() ).getValue();
     const std::string &                                     sm      = static_cast<const RlString &>( swap_method->getRevObject() ).getValue();
     const std::string &                                     smo     = static_cast<const RlString &>( swap_mode->getRevObject() ).getValue();
+    bool                                                    pc      = static_cast<const RlBoolean &>( parallel_chains->getRevObject() ).getValue();
     
-    RevBayesCore::Mcmcmc *m = new RevBayesCore::Mcmcmc(mdl, mvs, mntr, sched, nchains, si, delta, ntries, th, tht, sm, smo);
+    RevBayesCore::Mcmcmc *m = new RevBayesCore::Mcmcmc(mdl, mvs, mntr, sched, nchains, si, delta, ntries, th, tht, sm, smo, pc);
     
     if (heat_temps->getRevObject() != RevNullObject::getInstance())
     {
@@ -145,6 +146,7 @@ void Mcmcmc::constructInternalObject( void )
     }
     
     value = new RevBayesCore::MonteCarloAnalysis(m,nreps,ct);
+    value->setParallelReplicates( static_cast<const RlBoolean &>( parallel_runs->getRevObject() ).getValue() );
     
 }
 
@@ -220,6 +222,8 @@ const MemberRules& Mcmcmc::getParameterRules(void) const
         options_swapMode.push_back( "multiple" );
         memberRules.push_back( new OptionRule( "swapMode", new RlString("single"), options_swapMode, "Whether make a single attempt per swap interval or attempt multiple (= nchains-1 or choose(nchains,2) for neighbor or random swaps, respectively) times." ) );
         
+        memberRules.push_back( new ArgumentRule("parallelChains", RlBoolean::getClassTypeSpec(), "Should the chains of a process run concurrently on several threads (see the option 'numThreads')? Each chain then uses its own random number generator, which is split from the global one (see seed()). The runs are reproducible for a given seed, but these generators are not stored in checkpoints.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean( false ) ) );
+        
         rules_set = true;
     }
     
@@ -285,6 +289,10 @@ void Mcmcmc::setConstParameter(const std::string& name, const RevPtr<const RevVa
     {
         swap_mode = var;
     }
+    else if ( name == "parallelChains" )
+    {
+        parallel_chains = var;
+    }
     else
     {
         MonteCarloAnalysis::setConstParameter(name, var);
@@ -50,6 +50,7 @@ namespace RevLanguage {
         RevPtr<const RevVariable>                       tune_heat_target;
         RevPtr<const RevVariable>                       swap_method;
         RevPtr<const RevVariable>                       swap_mode;
+        RevPtr<const RevVariable>                       parallel_chains;
 
     };
     
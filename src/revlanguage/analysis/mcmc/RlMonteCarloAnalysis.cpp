@@ -243,6 +243,7 @@ const MemberRules& MonteCarloAnalysis::getParameterRules(void) const
         
         // the number of replicate runs (in parallel)
         member_rules.push_back( new ArgumentRule("nruns"   , Natural::getClassTypeSpec(), "The number of replicate analyses.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural(1) ) );
+        member_rules.push_back( new ArgumentRule("parallelRuns", RlBoolean::getClassTypeSpec(), "Should the replicate analyses of a process run concurrently on several threads (see the option 'numThreads')? Each replicate then uses its own random number generator, and time-based stopping rules are only checked at least every 100 generations.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false) ) );
         
         // the way how we combine several traces at the end of the run
         std::vector<std::string> options_combine;
@@ -340,6 +341,10 @@ void MonteCarloAnalysis::setConstParameter(const std::string& name, const RevPtr
     {
         num_runs = var;
     }
+    else if ( name == "parallelRuns")
+    {
+        parallel_runs = var;
+    }
     else if ( name == "combine")
     {
         combine_traces = var;
@@ -25,6 +25,8 @@
 #include "SemMin.h"
 #include "StationarityTest.h"
 #include "StringUtilities.h"
+#include "ThreadPool.h"
+#include "TraceTable.h"
 #include "TypeSpec.h"
 #include "ModelVector.h"
 #include "Argument.h"
@@ -167,31 +169,52 @@ RevPtr<RevVariable> BurninEstimationConvergenceAssessment::executeMethod(std::st
             // add the traces to our runs
             std::vector<RevBayesCore::TraceNumeric>& data = runs[p];
             
+            // estimate the burnin of all parameters in parallel
+            std::vector<size_t> parameter_burnins( data.size(), 0 );
+            RevBayesCore::ThreadPool::threadPoolInstance().parallelFor( data.size(), [&](size_t i)
+            {
+                parameter_burnins[i] = burninEst->estimateBurnin( data[i] );
+            });
+            
             size_t maxBurnin = 0;
             
             // find the max burnin
             for ( size_t i = 0; i < data.size(); ++i)
             {
-                size_t b = burninEst->estimateBurnin( data[i] );
-
-                if ( maxBurnin < b )
+                if ( maxBurnin < parameter_burnins[i] )
                 {
-                    maxBurnin = b;
+                    maxBurnin = parameter_burnins[i];
                 }
             }
             
-            bool failed = false;
-            size_t numFailedParams = 0;
+            // run the tests of all parameters in parallel and report the results afterwards
+            std::vector<int> geweke_stats( data.size(), 0 );
+            std::vector<int> ess_stats( data.size(), 0 );
+            std::vector<int> stationarity_stats( data.size(), 0 );
+            std::vector<int> heidelberger_stats( data.size(), 0 );
             for ( size_t i = 0; i < data.size(); ++i)
             {
                 data[i].setBurnin( maxBurnin );
+            }
+            RevBayesCore::ThreadPool::threadPoolInstance().parallelFor( data.size(), [&](size_t i)
+            {
                 data[i].computeStatistics();
                 
-                bool gewekeStat = gewekeTest->assessConvergence( data[i] );
-                bool essStat = essTest->assessConvergence( data[i] );
+                geweke_stats[i] = gewekeTest->assessConvergence( data[i] );
+                ess_stats[i] = essTest->assessConvergence( data[i] );
+                stationarity_stats[i] = stationarityTest->assessConvergence( data[i] );
+                heidelberger_stats[i] = heidelbergerTest->assessConvergence( data[i] );
+            });
+            
+            bool failed = false;
+            size_t numFailedParams = 0;
+            for ( size_t i = 0; i < data.size(); ++i)
+            {
+                bool gewekeStat = geweke_stats[i];
+                bool essStat = ess_stats[i];
 //                bool gelmanStat = gelmanRubinTest->assessConvergence( data[i] );
-                bool stationarityStat = stationarityTest->assessConvergence( data[i] );
-                bool heidelbergerStat = heidelbergerTest->assessConvergence( data[i] );
+                bool stationarityStat = stationarity_stats[i];
+                bool heidelbergerStat = heidelberger_stats[i];
                 bool failedParam = !gewekeStat || !stationarityStat || !heidelbergerStat || !essStat;
                 
                 if ( failedParam == true )
@@ -425,85 +448,23 @@ void BurninEstimationConvergenceAssessment::printValue(std::ostream &o, bool use
 
 
 
+/**
+ * Read the traces of a file. The iteration number is not added as a trace.
+ */
 void BurninEstimationConvergenceAssessment::readTrace(const RevBayesCore::path &fn, std::vector<RevBayesCore::TraceNumeric> &data)
 {
     
-    bool hasHeaderBeenRead = false;
-    
-    /* Open file */
-    std::ifstream inFile( fn.string() );
-    
-    if ( !inFile )
-        throw RbException()<<"Could not open file "<<fn;
-    
-    /* Initialize */
-    std::string commandLine;
+    RevBayesCore::TraceTable table;
+    table.readFile( fn, delimiter );
     
     size_t startIndex = 0;
-    
-    /* Command-processing loop */
-    while ( inFile.good() )
+    if ( table.getNumberOfColumns() > 0 && table.getColumnNames()[0] == "Iteration" )
     {
-        
-        // Read a line
-        std::string line;
-        RevBayesCore::safeGetline(inFile, line);
-        
-        // skip empty lines
-        //line = stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
-        if (line.length() == 0)
-        {
-            continue;
-        }
-        
-        
-        // removing comments
-        if (line[0] == '#')
-        {
-            continue;
-        }
-        
-        // splitting every line into its columns
-        std::vector<std::string> columns;
-        StringUtilities::stringSplit(line, delimiter, columns);
-        
-        // we assume a header at the first line of the file
-        if (!hasHeaderBeenRead)
-        {
-            
-            // do not add the iteration number as a trace
-            if ( columns[0] == "Iteration" )
-            {
-                startIndex = 1;
-            }
-            
-            for (size_t j=startIndex; j<columns.size(); j++)
-            {
-                RevBayesCore::TraceNumeric t;
-                
-                std::string parmName = columns[j];
-                t.setParameterName(parmName);
-                t.setFileName(fn);
-                
-                data.push_back( t );
-            }
-            
-            hasHeaderBeenRead = true;
-            
-            continue;
-        }
-        
-        // adding values to the Tracess
-        for (size_t j=startIndex; j<columns.size(); j++)
-        {
-            RevBayesCore::TraceNumeric& t = data[j-startIndex];
-            std::string tmp = columns[j];
-            double d = atof( tmp.c_str() );
-            t.addObject(d);
-        }
-        
+        startIndex = 1;
     }
     
+    table.moveToTraces( data, startIndex );
+    
 }
 
 
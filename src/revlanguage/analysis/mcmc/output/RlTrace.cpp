@@ -5,10 +5,13 @@
 
 #include "ArgumentRule.h"
 #include "ArgumentRules.h"
+#include "GelmanRubinTest.h"
+#include "GewekeTest.h"
 #include "MemberProcedure.h"
 #include "MethodTable.h"
 #include "ModelVector.h"
 #include "Natural.h"
+#include "OnlineTraceStatistics.h"
 #include "Probability.h"
 #include "RlUserInterface.h"
 #include "RlUtils.h"
@@ -16,12 +19,35 @@
 #include "RbException.h"
 #include "RevVariable.h"
 #include "RlBoolean.h"
+#include "Real.h"
+#include "RealPos.h"
 #include "TypeSpec.h"
+#include "WorkspaceVector.h"
 
 namespace RevLanguage { class Argument; }
 
 using namespace RevLanguage;
 
+
+namespace {
+
+    /**
+     * The running statistics of the values of a trace, as a stopping rule computes them while the trace is written.
+     */
+    RevBayesCore::OnlineTraceStatistics batchStatistics(const RevBayesCore::TraceNumeric &t)
+    {
+        RevBayesCore::OnlineTraceStatistics stats;
+        for (double v: t.getValues())
+        {
+            stats.addValue( v );
+        }
+        stats.setBurnin( t.getBurnin() );
+
+        return stats;
+    }
+
+}
+
 Trace::Trace() : WorkspaceToCoreWrapperObject<RevBayesCore::TraceNumeric>()
 {
 
@@ -106,6 +132,71 @@ RevPtr<RevVariable> Trace::executeMethod(std::string const &name, const std::vec
 
         return new RevVariable( new Natural( n ) );
     }
+    else if ( name == "getESS" )
+    {
+        found = true;
+
+        bool batches = static_cast<const RlBoolean &>( args[0].getVariable()->getRevObject() ).getValue();
+
+        double ess = ( batches == true ? batchStatistics( *value ).getESS() : this->value->getESS() );
+
+        return new RevVariable( new Real( ess ) );
+    }
+    else if ( name == "hasPassedGewekeTest" )
+    {
+        found = true;
+
+        double prob     = static_cast<const Probability &>( args[0].getVariable()->getRevObject() ).getValue();
+        double frac1    = static_cast<const Probability &>( args[1].getVariable()->getRevObject() ).getValue();
+        double frac2    = static_cast<const Probability &>( args[2].getVariable()->getRevObject() ).getValue();
+        bool batches    = static_cast<const RlBoolean &>( args[3].getVariable()->getRevObject() ).getValue();
+
+        RevBayesCore::GewekeTest test = RevBayesCore::GewekeTest( prob, frac1, frac2 );
+        bool passed = ( batches == true ? test.assessConvergence( batchStatistics( *value ) ) : test.assessConvergence( *value ) );
+
+        return new RevVariable( new RlBoolean( passed ) );
+    }
+    else if ( name == "hasPassedGelmanRubinTest" )
+    {
+        found = true;
+
+        const WorkspaceVector<Trace> &others = static_cast<const WorkspaceVector<Trace> &>( args[0].getVariable()->getRevObject() );
+        double R        = static_cast<const RealPos &>( args[1].getVariable()->getRevObject() ).getValue();
+        bool batches    = static_cast<const RlBoolean &>( args[2].getVariable()->getRevObject() ).getValue();
+
+        RevBayesCore::GelmanRubinTest test = RevBayesCore::GelmanRubinTest( R );
+        bool passed = false;
+        if ( batches == true )
+        {
+            std::vector<RevBayesCore::OnlineTraceStatistics> chains( 1, batchStatistics( *value ) );
+            for (size_t i = 0; i < others.size(); ++i)
+            {
+                chains.push_back( batchStatistics( others[i].getValue() ) );
+            }
+            passed = test.assessConvergence( chains );
+        }
+        else
+        {
+            std::vector<RevBayesCore::TraceNumeric> chains( 1, *value );
+            for (size_t i = 0; i < others.size(); ++i)
+            {
+                chains.push_back( others[i].getValue() );
+            }
+            passed = test.assessConvergence( chains );
+        }
+
+        return new RevVariable( new RlBoolean( passed ) );
+    }
+    else if ( name == "setValues" )
+    {
+        found = true;
+
+        const std::vector<double> &vals = static_cast<const ModelVector<Real> &>( args[0].getVariable()->getRevObject() ).getValue();
+
+        this->value->setValues( vals );
+
+        return NULL;
+    }
     else if (name == "summarize")
     {
         found = true;
@@ -224,6 +315,27 @@ void Trace::initMethods( void )
     ArgumentRules* getBurninArgRules = new ArgumentRules();
     this->methods.addFunction( new MemberProcedure( "getBurnin", Natural::getClassTypeSpec(), getBurninArgRules) );
 
+    ArgumentRules* getESSArgRules = new ArgumentRules();
+    getESSArgRules->push_back( new ArgumentRule("batches", RlBoolean::getClassTypeSpec(), "Use the batch-means estimate of the stopping rules instead of the autocorrelation of all samples?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false)) );
+    this->methods.addFunction( new MemberProcedure( "getESS", Real::getClassTypeSpec(), getESSArgRules) );
+
+    ArgumentRules* gewekeArgRules = new ArgumentRules();
+    gewekeArgRules->push_back( new ArgumentRule("prob", Probability::getClassTypeSpec(), "The significance level.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Probability(0.01)) );
+    gewekeArgRules->push_back( new ArgumentRule("frac1", Probability::getClassTypeSpec(), "The fraction of the samples at the beginning of the trace.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Probability(0.1)) );
+    gewekeArgRules->push_back( new ArgumentRule("frac2", Probability::getClassTypeSpec(), "The fraction of the samples at the end of the trace.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Probability(0.5)) );
+    gewekeArgRules->push_back( new ArgumentRule("batches", RlBoolean::getClassTypeSpec(), "Compare the batch means as the stopping rules do instead of all samples?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false)) );
+    this->methods.addFunction( new MemberProcedure( "hasPassedGewekeTest", RlBoolean::getClassTypeSpec(), gewekeArgRules) );
+
+    ArgumentRules* gelmanRubinArgRules = new ArgumentRules();
+    gelmanRubinArgRules->push_back( new ArgumentRule("traces", WorkspaceVector<Trace>::getClassTypeSpec(), "The traces of the same parameter in the other replicates.", ArgumentRule::BY_VALUE, ArgumentRule::ANY) );
+    gelmanRubinArgRules->push_back( new ArgumentRule("R", RealPos::getClassTypeSpec(), "The maximum potential scale reduction factor.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RealPos(1.01)) );
+    gelmanRubinArgRules->push_back( new ArgumentRule("batches", RlBoolean::getClassTypeSpec(), "Use the running sums of squares of the stopping rules instead of all samples?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false)) );
+    this->methods.addFunction( new MemberProcedure( "hasPassedGelmanRubinTest", RlBoolean::getClassTypeSpec(), gelmanRubinArgRules) );
+
+    ArgumentRules* setValuesArgRules = new ArgumentRules();
+    setValuesArgRules->push_back( new ArgumentRule("values", ModelVector<Real>::getClassTypeSpec(), "The new values of the trace.", ArgumentRule::BY_VALUE, ArgumentRule::ANY) );
+    this->methods.addFunction( new MemberProcedure( "setValues", RlUtils::Void, setValuesArgRules) );
+
     ArgumentRules* summarizeArgRules = new ArgumentRules();
     this->methods.addFunction( new MemberProcedure( "summarize", RlUtils::Void, summarizeArgRules) );
 
@@ -188,6 +188,23 @@ RevPtr<RevVariable> TraceTree::executeMethod(std::string const &name, const std:
         
         return new RevVariable( rl_dist );
     }
+    else if ( name == "computePairwiseRFDistanceDistribution" )
+    {
+        found = true;
+        
+        double tree_CI         = static_cast<const Probability &>( args[0].getVariable()->getRevObject() ).getValue();
+        bool verbose           = static_cast<const RlBoolean &>( args[1].getVariable()->getRevObject() ).getValue();
+        
+        std::vector<double> counts = this->value->computePairwiseRFDistanceDistribution(tree_CI, verbose);
+        
+        ModelVector<Natural> *rl_counts = new ModelVector<Natural>;
+        for (size_t i=0; i<counts.size(); ++i)
+        {
+            rl_counts->push_back( long(counts[i]) );
+        }
+        
+        return new RevVariable( rl_counts );
+    }
     else if ( name == "computeTreeLengths" )
     {
         found = true;
@@ -250,9 +267,9 @@ RevPtr<RevVariable> TraceTree::executeMethod(std::string const &name, const std:
         // get the tree which is the only argument for this method
         const RevBayesCore::Tree &current_tree = static_cast<const Tree &>( args[0].getVariable()->getRevObject() ).getValue();
         bool verbose = static_cast<const RlBoolean &>( args[1].getVariable()->getRevObject() ).getValue();
-        int f = this->value->getTopologyFrequency( current_tree, verbose );
+        double f = this->value->getTopologyFrequency( current_tree, verbose );
         
-        return new RevVariable( new Natural( f ) );
+        return new RevVariable( new Probability( f ) );
     }
     else if ( name == "getUniqueClades" )
     {
@@ -322,12 +339,11 @@ RevPtr<RevVariable> TraceTree::executeMethod(std::string const &name, const std:
         bool strict = static_cast<const RlBoolean &>( args[1].getVariable()->getRevObject() ).getValue();
         bool stem   = static_cast<const RlBoolean &>( args[2].getVariable()->getRevObject() ).getValue();
 
-        const std::vector<RevBayesCore::Tree>& trees = this->value->getValues();
-
         RevBayesCore::RbVector<double> ages;
 
-        RevBayesCore::RbBitSet bits = RevBayesCore::RbBitSet( this->value->getValues()[0].getNumberOfTips() );
-        const std::map<std::string, size_t>& taxon_map = this->value->getValues()[0].getTaxonBitSetMap();
+        // copy the taxon map because a streamed trace only keeps the most recently accessed tree
+        RevBayesCore::RbBitSet bits = RevBayesCore::RbBitSet( this->value->objectAt(0).getNumberOfTips() );
+        const std::map<std::string, size_t> taxon_map = this->value->objectAt(0).getTaxonBitSetMap();
         for ( size_t i=0; i<this_clade.size(); ++i )
         {
             RevBayesCore::Taxon t = this_clade.getTaxon(i);
@@ -338,12 +354,12 @@ RevPtr<RevVariable> TraceTree::executeMethod(std::string const &name, const std:
         }
         this_clade.setBitRepresentation( bits );
         
-        for (size_t i=this->value->getBurnin(); i<trees.size(); ++i)
+        for (size_t i=this->value->getBurnin(); i<this->value->size(); ++i)
         {
             // default age
             double age = -1;
             
-            const RevBayesCore::TopologyNode* mrca = trees[i].getRoot().getMrca( this_clade, strict );
+            const RevBayesCore::TopologyNode* mrca = this->value->objectAt(i).getRoot().getMrca( this_clade, strict );
             if ( mrca != NULL )
             {
                 if ( stem == false )
@@ -365,24 +381,24 @@ RevPtr<RevVariable> TraceTree::executeMethod(std::string const &name, const std:
     {
         found = true;
         
-        std::vector<RevBayesCore::Tree> trees = this->value->getValues();
         size_t start_index = this->value->getBurnin();
+        size_t num_trees   = this->value->size();
         
         if ( this->value->isClock() == true )
         {
             ModelVector<TimeTree> *rl_trees = new ModelVector<TimeTree>;
-            for (size_t i=start_index; i<trees.size(); ++i)
+            for (size_t i=start_index; i<num_trees; ++i)
             {
-                rl_trees->push_back( trees[i] );
+                rl_trees->push_back( this->value->objectAt(i) );
             }
             return new RevVariable( rl_trees );
         }
         else
         {
             ModelVector<BranchLengthTree> *rl_trees = new ModelVector<BranchLengthTree>;
-            for (size_t i=start_index; i<trees.size(); ++i)
+            for (size_t i=start_index; i<num_trees; ++i)
             {
-                rl_trees->push_back( trees[i] );
+                rl_trees->push_back( this->value->objectAt(i) );
             }
             return new RevVariable( rl_trees );
         }
@@ -514,7 +530,7 @@ void TraceTree::initMethods( void )
     ArgumentRules* getTopologyFrequencyArgRules = new ArgumentRules();
     getTopologyFrequencyArgRules->push_back( new ArgumentRule("tree", Tree::getClassTypeSpec(), "The tree.", ArgumentRule::BY_VALUE, ArgumentRule::ANY) );
     getTopologyFrequencyArgRules->push_back( new ArgumentRule("verbose", RlBoolean::getClassTypeSpec(), "Printing verbose output.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(true)) );
-    this->methods.addFunction( new MemberProcedure( "getTopologyFrequency", Natural::getClassTypeSpec(), getTopologyFrequencyArgRules) );
+    this->methods.addFunction( new MemberProcedure( "getTopologyFrequency", Probability::getClassTypeSpec(), getTopologyFrequencyArgRules) );
     
     
     ArgumentRules* is_covered_arg_rules = new ArgumentRules();
@@ -529,6 +545,11 @@ void TraceTree::initMethods( void )
     computePairwiseRFDistanceArgRules->push_back( new ArgumentRule("verbose", RlBoolean::getClassTypeSpec(), "Printing verbose output.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(true)) );
     this->methods.addFunction( new MemberProcedure( "computePairwiseRFDistances", ModelVector<RealPos>::getClassTypeSpec(), computePairwiseRFDistanceArgRules) );
     
+    ArgumentRules* computePairwiseRFDistanceDistributionArgRules = new ArgumentRules();
+    computePairwiseRFDistanceDistributionArgRules->push_back( new ArgumentRule("credibleTreeSetSize", Probability::getClassTypeSpec(), "The size of the credible set.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Probability(0.95)) );
+    computePairwiseRFDistanceDistributionArgRules->push_back( new ArgumentRule("verbose", RlBoolean::getClassTypeSpec(), "Printing verbose output.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(true)) );
+    this->methods.addFunction( new MemberProcedure( "computePairwiseRFDistanceDistribution", ModelVector<Natural>::getClassTypeSpec(), computePairwiseRFDistanceDistributionArgRules) );
+    
     ArgumentRules* computeTreeLengthsArgRules = new ArgumentRules();
     this->methods.addFunction( new MemberProcedure( "computeTreeLengths", ModelVector<RealPos>::getClassTypeSpec(), computeTreeLengthsArgRules) );
     
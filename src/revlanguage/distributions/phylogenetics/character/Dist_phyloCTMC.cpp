@@ -87,6 +87,8 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
     const std::string& code = static_cast<const RlString &>( coding->getRevObject() ).getValue();
     bool internal = static_cast<const RlBoolean &>( storeInternalNodes->getRevObject() ).getValue();
     bool gapmatch = static_cast<const RlBoolean &>( gapMatchClamped->getRevObject() ).getValue();
+    bool single_precision = static_cast<const RlString &>( precision->getRevObject() ).getValue() == "single";
+    size_t pmatrix_cache_size = size_t( static_cast<const Natural &>( transitionMatrixCacheSize->getRevObject() ).getValue() );
 
     RevBayesCore::TypedDagNode< RevBayesCore::RbVector<double> >* site_ratesNode = NULL;
     if ( site_rates != NULL && site_rates->getRevObject() != RevNullObject::getInstance() )
@@ -158,13 +160,28 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
         throw RbException( "Ascertainment bias correction only supported with Standard and Binary/Restriction datatypes" );
     }
 
+    if ( single_precision == true && (dt == "Binary" || dt == "Restriction" || code != "all") )
+    {
+        throw RbException( "Single-precision partial likelihoods are not supported with Binary/Restriction datatypes or with ascertainment bias correction" );
+    }
+
     if ( dt == "DNA" )
     {
-        RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<RevBayesCore::DnaState> *dist =
-        new RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<RevBayesCore::DnaState>(tau, true, n, ambig, internal, gapmatch);
+        RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<RevBayesCore::DnaState> *dist = NULL;
+        if ( single_precision == true )
+        {
+            // the specialized nucleotide kernels only exist in double precision
+            dist = new RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::DnaState>(tau, 4, true, n, ambig, internal, gapmatch);
+            dist->setUseSinglePrecision( true );
+        }
+        else
+        {
+            dist = new RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<RevBayesCore::DnaState>(tau, true, n, ambig, internal, gapmatch);
+        }
 
         // set the root frequencies (by default these are NULL so this is OK)
         dist->setRootFrequencies( rf );
+        dist->setTransitionProbabilityCacheSize( pmatrix_cache_size );
 
         // set the probability for invariant site (by default this p_inv=0.0)
         dist->setPInv( p_invNode );
@@ -231,10 +248,21 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
     }
     else if ( dt == "RNA" )
     {
-        RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<RevBayesCore::RnaState> *dist = new RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<RevBayesCore::RnaState>(tau, true, n, ambig, internal, gapmatch);
+        RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<RevBayesCore::RnaState> *dist = NULL;
+        if ( single_precision == true )
+        {
+            // the specialized nucleotide kernels only exist in double precision
+            dist = new RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::RnaState>(tau, 4, true, n, ambig, internal, gapmatch);
+            dist->setUseSinglePrecision( true );
+        }
+        else
+        {
+            dist = new RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<RevBayesCore::RnaState>(tau, true, n, ambig, internal, gapmatch);
+        }
 
         // set the root frequencies (by default these are NULL so this is OK)
         dist->setRootFrequencies( rf );
+        dist->setTransitionProbabilityCacheSize( pmatrix_cache_size );
 
         // set the probability for invariant site (by default this p_inv=0.0)
         dist->setPInv( p_invNode );
@@ -303,9 +331,11 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
     else if ( dt == "AA" || dt == "Protein" )
     {
         RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::AminoAcidState> *dist = new RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::AminoAcidState>(tau, 20, true, n, ambig, internal, gapmatch);
+        dist->setUseSinglePrecision( single_precision );
 
         // set the root frequencies (by default these are NULL so this is OK)
         dist->setRootFrequencies( rf );
+        dist->setTransitionProbabilityCacheSize( pmatrix_cache_size );
 
         // set the probability for invariant site (by default this p_inv=0.0)
         dist->setPInv( p_invNode );
@@ -373,9 +403,11 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
     else if ( dt == "Codon" )
     {
         RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::CodonState> *dist = new RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::CodonState>(tau, 61, true, n, ambig, internal, gapmatch);
+        dist->setUseSinglePrecision( single_precision );
         
         // set the root frequencies (by default these are NULL so this is OK)
         dist->setRootFrequencies( rf );
+        dist->setTransitionProbabilityCacheSize( pmatrix_cache_size );
         
         // set the probability for invariant site (by default this p_inv=0.0)
         dist->setPInv( p_invNode );
@@ -443,9 +475,11 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
     else if ( dt == "Doublet" )
     {
         auto dist = new RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::DoubletState>(tau, 16, true, n, ambig, internal, gapmatch);
+        dist->setUseSinglePrecision( single_precision );
 
         // set the root frequencies (by default these are NULL so this is OK)
         dist->setRootFrequencies( rf );
+        dist->setTransitionProbabilityCacheSize( pmatrix_cache_size );
 
         // set the probability for invariant site (by default this p_inv=0.0)
         dist->setPInv( p_invNode );
@@ -527,9 +561,11 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
         }
 
         RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::PoMoState> *dist = new RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::PoMoState>(tau, nChars, !true, n, ambig, internal, gapmatch);
+        dist->setUseSinglePrecision( single_precision );
 
         // set the root frequencies (by default these are NULL so this is OK)
         dist->setRootFrequencies( rf );
+        dist->setTransitionProbabilityCacheSize( pmatrix_cache_size );
 
         // set the probability for invariant site (by default this p_inv=0.0)
         dist->setPInv( p_invNode );
@@ -634,6 +670,7 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
         if(cd == RevBayesCore::AscertainmentBias::ALL)
         {
             dist = new RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::StandardState>(tau, nChars, true, n, ambig, internal, gapmatch);
+            dist->setUseSinglePrecision( single_precision );
         }
         else
         {
@@ -642,6 +679,7 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
 
         // set the root frequencies (by default these are NULL so this is OK)
         dist->setRootFrequencies( rf );
+        dist->setTransitionProbabilityCacheSize( pmatrix_cache_size );
 
         // set the probability for invariant site (by default this p_inv=0.0)
         dist->setPInv( p_invNode );
@@ -723,9 +761,11 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
         }
 
         RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::NaturalNumbersState> *dist = new RevBayesCore::PhyloCTMCSiteHomogeneous<RevBayesCore::NaturalNumbersState>(tau, n_chars, true, n, ambig, internal, gapmatch);
+        dist->setUseSinglePrecision( single_precision );
 
         // set the root frequencies (by default these are NULL so this is OK)
         dist->setRootFrequencies( rf );
+        dist->setTransitionProbabilityCacheSize( pmatrix_cache_size );
 
         // set the probability for invariant site (by default this p_inv=0.0)
         dist->setPInv( p_invNode );
@@ -871,6 +911,7 @@ RevBayesCore::TypedDistribution< RevBayesCore::AbstractHomologousDiscreteCharact
 
         // set the root frequencies (by default these are NULL so this is OK)
         dist->setRootFrequencies( rf );
+        dist->setTransitionProbabilityCacheSize( pmatrix_cache_size );
 
         // set the probability for invariant site (by default this p_inv=0.0)
         dist->setPInv( p_invNode );
@@ -1003,6 +1044,10 @@ MethodTable Dist_phyloCTMC::getDistributionMethods( void ) const
     
     methods.addFunction( new DistributionMemberFunction<Dist_phyloCTMC, ModelVector<RealPos> >( "siteRates", variable, siteRatesArgRules, true ) );
     
+    // the number of hits and misses of the transition probability matrix cache
+    ArgumentRules* transitionMatrixCacheStatisticsArgRules = new ArgumentRules();
+    methods.addFunction( new DistributionMemberFunction<Dist_phyloCTMC, ModelVector<Real> >( "transitionMatrixCacheStatistics", variable, transitionMatrixCacheStatisticsArgRules, true ) );
+    
     return methods;
 }
 
@@ -1066,6 +1111,13 @@ const MemberRules& Dist_phyloCTMC::getParameterRules(void) const
         
         dist_member_rules.push_back( new ArgumentRule( "gapMatchClamped", RlBoolean::getClassTypeSpec(), "Should we set the simulated character to be gap or missing if the corresponding character in the clamped matrix is gap or missing?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean( true ) ) );
 
+        std::vector<std::string> options_precision;
+        options_precision.push_back( "double" );
+        options_precision.push_back( "single" );
+        dist_member_rules.push_back( new OptionRule( "precision", new RlString("double"), options_precision, "Store the partial likelihoods in double or single precision. Single precision halves the memory for large alignments, but does not support ancestral states." ) );
+
+        dist_member_rules.push_back( new ArgumentRule( "transitionMatrixCacheSize", Natural::getClassTypeSpec(), "The number of transition probability matrices that we keep for reuse (0 disables the cache).", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural( 0L ) ) );
+
         rules_set = true;
     }
 
@@ -1223,6 +1275,14 @@ void Dist_phyloCTMC::setConstParameter(const std::string& name, const RevPtr<con
     {
         coding = var;
     }
+    else if ( name == "precision" )
+    {
+        precision = var;
+    }
+    else if ( name == "transitionMatrixCacheSize" )
+    {
+        transitionMatrixCacheSize = var;
+    }
     else
     {
         Distribution::setConstParameter(name, var);
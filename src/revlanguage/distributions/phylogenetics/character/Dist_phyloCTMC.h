@@ -69,6 +69,8 @@ class TypeSpec;
         RevPtr<const RevVariable>                       storeInternalNodes;
         RevPtr<const RevVariable>                       gapMatchClamped;
         RevPtr<const RevVariable>                       coding;
+        RevPtr<const RevVariable>                       precision;
+        RevPtr<const RevVariable>                       transitionMatrixCacheSize;
 
     };
 
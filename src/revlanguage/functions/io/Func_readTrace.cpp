@@ -29,6 +29,7 @@
 #include "RlFunction.h"
 #include "Trace.h"
 #include "TraceNumeric.h"
+#include "TraceTable.h"
 #include "TypeSpec.h"
 #include "WorkspaceToCoreWrapperObject.h"
 
@@ -88,89 +89,16 @@ RevPtr<RevVariable> Func_readTrace::execute( void )
 
     for (auto& filename: vectorOfFileNames)
     {
-        bool hasHeaderBeenRead = false;
-        
-        /* Open file */
-        std::ifstream inFile( filename.string() );
-        
-        if ( !inFile )
-            throw RbException()<<"Could not open file "<<filename;
-            
-        /* Initialize */
-        std::string commandLine;
         RBOUT("Processing file \"" + filename.string() + "\"");
-        size_t n_samples = 0;
-            
-        /* Command-processing loop */
-        while ( inFile.good() )
-        {
-                
-            // Read a line
-            std::string line;
-            RevBayesCore::safeGetline(inFile, line);
-                
-            // skip empty lines
-            //line = stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
-            if (line.length() == 0)
-            {
-                continue;
-            }
-                
-                
-            // removing comments
-            if (line[0] == '#')
-            {
-                continue;
-            }
-                
-            // splitting every line into its columns
-            std::vector<std::string> columns;
-            StringUtilities::stringSplit(line, delimiter, columns);
-                
-            // we assume a header at the first line of the file
-            if (!hasHeaderBeenRead)
-            {
-                    
-                for (size_t j=0; j<columns.size(); j++)
-                {
-                    RevBayesCore::TraceNumeric t;
-                        
-                    std::string parmName = columns[j];
-                    t.setParameterName(parmName);
-                    t.setFileName( filename );
-                        
-                    data.push_back( t );
-                }
-                    
-                hasHeaderBeenRead = true;
-                    
-                continue;
-            }
-            
-            
-            // increase our sample counter
-            ++n_samples;
-            
-            // we need to check if we skip this sample in case of thinning.
-            if ( (n_samples-1) % thinning > 0 )
-            {
-                continue;
-            }
-            
-            // adding values to the Tracess
-            for (size_t j=0; j<columns.size(); j++)
-            {
-                RevBayesCore::TraceNumeric& t = static_cast<RevBayesCore::TraceNumeric&>( data[j] );
-                std::string tmp = columns[j];
-                double d = atof( tmp.c_str() );
-                t.addObject(d);
-            }
-        }
+        
+        // the columns are read into a column store and then moved into the traces
+        RevBayesCore::TraceTable table;
+        table.readFile( filename, delimiter, thinning );
+        table.moveToTraces( data );
     }
     
     RevObject& b = args[2].getVariable()->getRevObject();
 
-    WorkspaceVector<Trace> *rv = new WorkspaceVector<Trace>();
     for (std::vector<RevBayesCore::TraceNumeric>::iterator it = data.begin(); it != data.end(); ++it)
     {
         int burnin = 0;
@@ -185,12 +113,14 @@ RevPtr<RevVariable> Func_readTrace::execute( void )
             burnin = int( floor( it->size()*burninFrac ) );
         }
 
-        it->computeStatistics();
-
-        Trace trace( *it );
-        trace.getValue().setBurnin(burnin);
+        it->setBurnin(burnin);
+    }
 
-        rv->push_back( trace );
+    // the mean, ESS and SEM of a column are computed when they are first needed
+    WorkspaceVector<Trace> *rv = new WorkspaceVector<Trace>();
+    for (std::vector<RevBayesCore::TraceNumeric>::iterator it = data.begin(); it != data.end(); ++it)
+    {
+        rv->push_back( Trace( *it ) );
     }
     
     // return the vector of traces
@@ -3,12 +3,14 @@
 #include <math.h>
 #include <cstddef>
 #include <map>
+#include <memory>
 #include <set>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "ArgumentRule.h"
+#include "BinaryTraceReader.h"
 #include "Delimiter.h"
 #include "ConstantNode.h"
 #include "ModelVector.h"
@@ -25,6 +27,7 @@
 #include "RlUserInterface.h"
 #include "StringUtilities.h"
 #include "TraceTree.h"
+#include "TreeTraceReader.h"
 #include "TreeUtilities.h"
 #include "Argument.h"
 #include "ArgumentRules.h"
@@ -84,6 +87,7 @@ RevPtr<RevVariable> Func_readTreeTrace::execute( void )
     size_t arg_index_offset    = 7;
     size_t arg_index_nexus     = 8;
     size_t arg_index_nruns     = 9;
+    size_t arg_index_streaming = 10;
 
     // get the information from the arguments for reading the file
     const std::string&  treetype = static_cast<const RlString&>( args[arg_index_tree_type].getVariable()->getRevObject() ).getValue();
@@ -94,6 +98,12 @@ RevPtr<RevVariable> Func_readTreeTrace::execute( void )
     long                offset   = static_cast<const Natural&>( args[arg_index_offset].getVariable()->getRevObject() ).getValue();
     bool                nexus    = static_cast<RlBoolean&>(args[arg_index_nexus].getVariable()->getRevObject()).getValue();
     long                nruns    = static_cast<const Natural&>( args[arg_index_nruns].getVariable()->getRevObject() ).getValue();
+    bool                stream   = static_cast<RlBoolean&>(args[arg_index_streaming].getVariable()->getRevObject()).getValue();
+
+    if ( nexus == true && stream == true )
+    {
+        throw RbException("Tree traces can only be streamed from delimited files and not from NEXUS files.");
+    }
 
     std::vector<RevBayesCore::path> vectorOfFileNames;
     
@@ -171,12 +181,12 @@ RevPtr<RevVariable> Func_readTreeTrace::execute( void )
     if ( treetype == "clock" )
     {
         if(nexus) rv = readTreesNexus(vectorOfFileNames, treetype, unroot_nonclock, thin, offset);
-        else rv = readTrees(vectorOfFileNames, sep, treetype, unroot_nonclock, thin, offset);
+        else rv = readTrees(vectorOfFileNames, sep, treetype, unroot_nonclock, thin, offset, stream);
     }
     else if ( treetype == "non-clock" )
     {
         if(nexus) rv = readTreesNexus(vectorOfFileNames, treetype, unroot_nonclock, thin, offset);
-        else rv = readTrees(vectorOfFileNames, sep, treetype, unroot_nonclock, thin, offset);
+        else rv = readTrees(vectorOfFileNames, sep, treetype, unroot_nonclock, thin, offset, stream);
         
         RevBayesCore::Clade og;
         if ( args[arg_index_outgroup].getVariable() != NULL && args[arg_index_outgroup].getVariable()->getRevObject() != RevNullObject::getInstance())
@@ -272,6 +282,8 @@ const ArgumentRules& Func_readTreeTrace::getArgumentRules( void ) const
 
         argumentRules.push_back( new ArgumentRule( "nruns", Natural::getClassTypeSpec(), "The number of trace files with the same basename (i.e. the number of filenames with pattern <file>_run_<n>.trees", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural( 1l ) ) );
 
+        argumentRules.push_back( new ArgumentRule( "streaming", RlBoolean::getClassTypeSpec(), "Should the trees be parsed from the file only when they are used, instead of keeping all trees in memory? Burnin and thinned samples are then never parsed.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false)) );
+
         rules_set = true;
     }
     
@@ -330,18 +342,51 @@ const TypeSpec& Func_readTreeTrace::getReturnType( void ) const
 }
 
 
-WorkspaceVector<TraceTree>* Func_readTreeTrace::readTrees(const std::vector<RevBayesCore::path> &vector_of_file_names, const std::string &delimiter, const std::string& treetype, bool unroot_nonclock, long thinning, long offset)
+WorkspaceVector<TraceTree>* Func_readTreeTrace::readTrees(const std::vector<RevBayesCore::path> &vector_of_file_names, const std::string &delimiter, const std::string& treetype, bool unroot_nonclock, long thinning, long offset, bool streaming)
 {
     bool clock = (treetype == "clock");
 
     std::vector<TraceTree> data;
     
+    if ( streaming == true )
+    {
+        // only index the samples; the trees are parsed when the trace is summarized
+        for (auto& fn: vector_of_file_names)
+        {
+            RBOUT( "Indexing file \"" + fn.string() + "\"");
+
+            std::shared_ptr<RevBayesCore::TreeTraceReader> reader = std::make_shared<RevBayesCore::TreeTraceReader>( fn, delimiter, clock, unroot_nonclock, thinning, offset );
+            data.push_back( TraceTree( RevBayesCore::TraceTree(clock, reader) ) );
+        }
+
+        return new WorkspaceVector<TraceTree>( data );
+    }
+    
     // Set up a map with the file name to be read as the key and the file type as the value. Note that we may not
     // read all of the files in the string called "vectorOfFileNames" because some of them may not be in a format
     // that can be read.
     std::map<RevBayesCore::path,std::string> file_ap;
     for (auto& fn: vector_of_file_names)
     {
+        // binary traces do not have lines, so we let the tree trace reader find the samples
+        if ( RevBayesCore::BinaryTraceReader::isBinaryTraceFile( fn ) == true )
+        {
+            RBOUT( "Processing file \"" + fn.string() + "\"");
+
+            RevBayesCore::TreeTraceReader reader( fn, delimiter, clock, unroot_nonclock, thinning, offset );
+
+            RevBayesCore::TraceTree t(clock);
+            t.setFileName(fn);
+            t.setParameterName( reader.getParameterName() );
+            for (size_t i = 0; i < reader.getNumberOfSamples(); ++i)
+            {
+                t.addObject( reader.getTree(i) );
+            }
+
+            data.push_back( TraceTree(t) );
+            continue;
+        }
+
         bool has_header_been_read = false;
         
         // let us quickly count the number of lines
@@ -68,7 +68,15 @@ void Mntr_File::constructInternalObject( void )
     bool app = static_cast<const RlBoolean &>( append->getRevObject() ).getValue();
     bool wv = static_cast<const RlBoolean &>( version->getRevObject() ).getValue();
 
-    SampleFormat Format = (fmt == "json") ? SampleFormat(JSONFormat()) : SampleFormat(SeparatorFormat(sep));
+    SampleFormat Format = SeparatorFormat(sep);
+    if ( fmt == "json" )
+    {
+        Format = JSONFormat();
+    }
+    else if ( fmt == "binary" )
+    {
+        Format = BinaryFormat();
+    }
     value = new RevBayesCore::VariableMonitor(n, (unsigned long)g, fn, Format, pp, l, pr, app, wv);
 }
 
@@ -118,7 +126,7 @@ const MemberRules& Mntr_File::getParameterRules(void) const
         memberRules.push_back( new ArgumentRule("posterior" , RlBoolean::getClassTypeSpec(), "Should we print the posterior probability as well?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(true) ) );
         memberRules.push_back( new ArgumentRule("likelihood", RlBoolean::getClassTypeSpec(), "Should we print the likelihood as well?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(true) ) );
         memberRules.push_back( new ArgumentRule("prior"     , RlBoolean::getClassTypeSpec(), "Should we print the prior probability as well?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(true) ) );
-        memberRules.push_back( new ArgumentRule("format"    , RlString::getClassTypeSpec(),  "Output format", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlString("separator") ) );
+        memberRules.push_back( new ArgumentRule("format"    , RlString::getClassTypeSpec(),  "Output format: 'separator', 'json', or 'binary' (compressed columns that are read by readTrace and readTreeTrace).", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlString("separator") ) );
 
         // add the rules from the base class
         const MemberRules &parentRules = FileMonitor::getParameterRules();
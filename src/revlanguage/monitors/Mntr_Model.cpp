@@ -62,7 +62,15 @@ void Mntr_Model::constructInternalObject( void )
         exclude_list.insert(excl[i]);
     }
 
-    SampleFormat Format = (fmt == "json") ? SampleFormat(JSONFormat()) : SampleFormat(SeparatorFormat(sep));
+    SampleFormat Format = SeparatorFormat(sep);
+    if ( fmt == "json" )
+    {
+        Format = JSONFormat();
+    }
+    else if ( fmt == "binary" )
+    {
+        Format = BinaryFormat();
+    }
     RevBayesCore::ModelMonitor *m = new RevBayesCore::ModelMonitor((unsigned long)g, fn, Format, exclude_list);
     
     // now set the flags
@@ -126,7 +134,7 @@ const MemberRules& Mntr_Model::getParameterRules(void) const
         memberRules.push_back( new ArgumentRule("prior"         , RlBoolean::getClassTypeSpec(), "Should we print the joint prior probability?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(true) ) );
         memberRules.push_back( new ArgumentRule("stochasticOnly", RlBoolean::getClassTypeSpec(), "Should we monitor stochastic variables only?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false) ) );
         memberRules.push_back( new ArgumentRule{"exclude", ModelVector<RlString>::getClassTypeSpec(), "Variables to exclude from the monitor", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new ModelVector<RlString>()});
-        memberRules.push_back( new ArgumentRule("format"        , RlString::getClassTypeSpec(),  "Output format", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlString("separator") ) );
+        memberRules.push_back( new ArgumentRule("format"        , RlString::getClassTypeSpec(),  "Output format: 'separator', 'json', or 'binary' (compressed columns that are read by readTrace and readTreeTrace).", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlString("separator") ) );
         
         // add the rules from the base class
         const MemberRules &parentRules = FileMonitor::getParameterRules();